@@ -3,36 +3,68 @@
 // at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
 
 #include "KMClassifierEvaluationTask.h"
+#include "KMPredictorEvaluationTask.h"
 #include "KMClusteringQuality.h"
 #include "KMLearningProject.h"
+#include "KMQuantileSketch.h"
 
 
 KMClassifierEvaluationTask::KMClassifierEvaluationTask()
 {
 	classifierEvaluation = NULL;
-	kmClassifierEvaluation = NULL;
 	kmGlobalCluster = NULL;
 	lReadInstancesForMedianComputation = 0;
-	evaluationInstances = NULL;
 	lInstancesWithMissingValues = 0;
 	lInstanceEvaluationNumber = 0;
 	odAttributesPartitions = NULL;
 	odAtomicModalities = NULL;
 	kmEvaluationClustering = NULL;
 	targetAttribute = NULL;
+	master_nDatabasePass = 1;
+	slave_trainedClassifier = NULL;
+	slave_bUpdateModalitiesProbs = false;
+
+	shared_oaEvaluationCentroids = new PLShared_ObjectArray(new PLShared_ContinuousVector);
+	output_oaClusters = new PLShared_ObjectArray(new PLShared_Cluster);
+	output_oaGroupedModalitiesFrequencies = new PLShared_ObjectArray(new PLShared_IntVector);
+	output_oaAtomicModalitiesFrequencies = new PLShared_ObjectArray(new PLShared_IntVector);
+	output_oaMedianSketches = new PLShared_ObjectArray(new PLShared_QuantileSketch);
+
+	DeclareSharedParameter(&shared_sEvaluationClassName);
+	DeclareSharedParameter(&shared_nDatabasePass);
+	DeclareSharedParameter(&shared_bMedianComputation);
+	DeclareSharedParameter(shared_oaEvaluationCentroids);
+	DeclareSharedParameter(&shared_svMajorityTargetValues);
+	DeclareSharedParameter(&shared_ivMajorityTargetIndexes);
+	DeclareTaskOutput(&output_lInstanceEvaluationNumber);
+	DeclareTaskOutput(&output_lInstancesWithMissingValues);
+	DeclareTaskOutput(&output_lReadInstancesForMedianComputation);
+	DeclareTaskOutput(output_oaClusters);
+	DeclareTaskOutput(output_oaGroupedModalitiesFrequencies);
+	DeclareTaskOutput(output_oaAtomicModalitiesFrequencies);
+	DeclareTaskOutput(output_oaMedianSketches);
+	DeclareTaskOutput(&output_svTargetValues);
+	DeclareTaskOutput(&output_ivConfusionMatrix);
 }
 
 KMClassifierEvaluationTask::~KMClassifierEvaluationTask()
 {
 	odGroupedModalitiesFrequencyTables.DeleteAll();
 	odAtomicModalitiesFrequencyTables.DeleteAll();
+	master_oaMedianSketches.DeleteAll();
+	slave_oaMedianSketches.DeleteAll();
 
-	if (evaluationInstances != NULL) {
-		evaluationInstances->DeleteAll();
-		delete evaluationInstances;
-	}
 	if (kmEvaluationClustering != NULL)
 		delete kmEvaluationClustering;
+
+	if (slave_trainedClassifier != NULL)
+		delete slave_trainedClassifier;
+
+	delete shared_oaEvaluationCentroids;
+	delete output_oaClusters;
+	delete output_oaGroupedModalitiesFrequencies;
+	delete output_oaAtomicModalitiesFrequencies;
+	delete output_oaMedianSketches;
 }
 
 
@@ -41,11 +73,6 @@ boolean KMClassifierEvaluationTask::Evaluate(KWPredictor* predictor,
 	KWPredictorEvaluation* requesterPredictorEvaluation)
 {
 	boolean bOk;
-	const longint lMinNecessaryMemory = 16 * 1024 * 1024;
-	KWObject* kwoObject;
-	longint nObject;
-	KWLearningSpec currentLearningSpec;
-	ALString sTmp;
 	KMTrainedClassifier* trainedPredictor;
 
 	require(predictor != NULL);
@@ -53,12 +80,6 @@ boolean KMClassifierEvaluationTask::Evaluate(KWPredictor* predictor,
 	require(evaluationDatabase != NULL);
 	require(evaluationDatabase->GetObjects()->GetSize() == 0);
 
-	// l'evaluation ne fait pas appel a la parallelisation, et se deroule entierement dans le master (i.e, on ne fait pas appel a RunDatabaseTask()  )
-
-	Timer timer;
-	timer.Start();
-
-
 	// Initialisation des variables necessaires pour l'evaluation
 
 	trainedPredictor = cast(KMTrainedClassifier*, predictor->GetTrainedClassifier());
@@ -71,26 +92,24 @@ boolean KMClassifierEvaluationTask::Evaluate(KWPredictor* predictor,
 
 	kmEvaluationClustering = clustering->Clone();
 
-	predictorEvaluation = requesterPredictorEvaluation;
-	InitializePredictorSharedVariables(predictor);
-
-	bOk = MasterInitialize(); // on n'utilise pas le service d'execution parallele des taches, donc on initialise nous-memes directement le maitre
-	if (not bOk) {
-		CleanPredictorSharedVariables();
-		return false;
-	}
-
 	kmGlobalCluster = kmEvaluationClustering->GetGlobalCluster();
 
 	assert(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute() != NULL);
 	assert(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute()->GetLoadIndex().IsValid());
 
 	lInstancesWithMissingValues = 0;
+	lInstanceEvaluationNumber = 0;
+	lReadInstancesForMedianComputation = 0;
+	master_oaMedianSketches.DeleteAll();
 
 	odAttributesPartitions = ((ObjectDictionary*)&kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions());
 	odAtomicModalities = ((ObjectDictionary*)&kmEvaluationClustering->GetAttributesPartitioningManager()->GetAtomicModalities());
 
-	lInstanceEvaluationNumber = 0;
+	if (kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions().GetCount() > 0)
+		InitializeModalitiesProbs();
+
+	targetAttribute = predictor->GetClass()->LookupAttribute(predictor->GetTargetAttributeName());
+	assert(targetAttribute != NULL);
 
 	/////////////////////////////////////////////////////////////////////
 	// Chargement de la base pour evaluation des criteres specifiques
@@ -98,182 +117,49 @@ boolean KMClassifierEvaluationTask::Evaluate(KWPredictor* predictor,
 	AddSimpleMessage(ALString("Evaluate database ") + evaluationDatabase->GetDatabaseName() +
 		ALString(" with predictor ") + predictor->GetObjectLabel());
 
-	// Debut de suivi de tache
-	TaskProgression::BeginTask();
-	TaskProgression::DisplayMainLabel("Evaluate database " + evaluationDatabase->GetDatabaseName());
-
-	targetAttribute = predictor->GetClass()->LookupAttribute(predictor->GetTargetAttributeName());
-	assert(targetAttribute != NULL);
-
-	const longint estimatedObjectsNumber = evaluationDatabase->GetEstimatedObjectNumber();
-
-	// Ouverture de la base en lecture
-	bOk = evaluationDatabase->OpenForRead();
-
-	const bool updateModalitiesProbs = (kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions().GetCount() > 0 ? true : false);
-
-	if (updateModalitiesProbs)
-		InitializeModalitiesProbs();
-
-	// Lecture d'objets dans la base
-	if (bOk)
-	{
-		boolean bComputeMedians = kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics();
-
-		int iReadPercentageForMedianComputation = KMPredictorEvaluation::ComputeReadPercentageForMedianComputation(kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics(),
-			estimatedObjectsNumber, trainedPredictor->GetPredictorClass());
-		if (GetLearningExpertMode() and bComputeMedians and iReadPercentageForMedianComputation < 100) {
-			AddWarning("Not enough memory : can't store 100% of database instances for median values computing. Median will be computed on "
-				+ ALString(IntToString(iReadPercentageForMedianComputation)) + "% of database. Other statistics will still be computed on 100% of database instances.");
-		}
-
-		lReadInstancesForMedianComputation = 0;
-
-		Global::ActivateErrorFlowControl();
+	predictorEvaluation = requesterPredictorEvaluation;
+	InitializePredictorSharedVariables(predictor);
+	shared_sEvaluationClassName.SetValue(evaluationDatabase->GetClassName());
 
-		nObject = 0;
-		while (not evaluationDatabase->IsEnd())
-		{
-			if (nObject % 100 == 0)
-			{
-				// Arret si plus assez de memoire
-				if (RMResourceManager::GetRemainingAvailableMemory() < lMinNecessaryMemory)
-				{
-					bOk = false;
-					AddError(sTmp + "Not enough memory: interrupted after evaluation of " + LongintToString(nObject) + " instances (remaining available memory = "
-						+ LongintToHumanReadableString(RMResourceManager::GetRemainingAvailableMemory()) + ", min necessary memory = " + LongintToHumanReadableString(lMinNecessaryMemory));
-					break;
-				}
-			}
+	// 1ere lecture de base : affectation des instances aux clusters, et maj des centroides d'evaluation MOYENNES (sans toucher aux centroides initiaux, issus du modele)
+	master_nDatabasePass = 1;
+	bOk = RunDatabaseTask(evaluationDatabase);
 
-			// controle memoire additionnel pour plus de securite (tenir compte de l'evolution de l'occupation memoire due a d'autres applications)
-			// Arret du stockage des instances en vue du calcul des medianes, si le seuil de memoire dispo est devenu dangereusement bas
-			if (bComputeMedians and nObject % 5 == 0 and RMResourceManager::GetRemainingAvailableMemory() < lMinNecessaryMemory * 2) {
+	if (bOk and lInstanceEvaluationNumber > 0) {
 
-				if (GetLearningExpertMode()) {
-					AddWarning("Not enough memory : can't store any more database instances for median values computing. Instances number stored so far : "
-						+ ALString(LongintToString(lReadInstancesForMedianComputation)) +
-						", total number of read instances : " + ALString(LongintToString(nObject)));
-				}
-				bComputeMedians = false;
-			}
+		if (kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics())
+			KMPredictorEvaluationTask::ComputeMedianValues(&master_oaMedianSketches, kmEvaluationClustering);
 
-			// Traitement d'un nouvel objet
-			kwoObject = evaluationDatabase->Read();
-
-			if (kwoObject != NULL)
-			{
-				nObject++;
-
-				// Mise a jour de l'evaluation : affecte l'instance au cluster correspondant, et maj, le cas echeant, des centroides d'evaluation MOYENNES (sans toucher aux centroides initiaux, issus du modele)
-				KMCluster* cluster = UpdateEvaluationFirstDatabaseRead(predictor, kwoObject, updateModalitiesProbs);
-
-				if (cluster == NULL) {
-					// pas d'affectation possible, passer a l'instance suivante
-					delete kwoObject;
-					continue;
-				}
-
-				bool bKeepInstanceForMedianComputing = false;
-
-				if (bComputeMedians) {
-
-					// On teste si on garde ou non l'exemple afin de calculer les medianes (valeurs par attributs)
-					// NB. si le cluster est encore vide a ce stade, on lui affecte l'instance sans faire de tirage aleatoire
-
-					if (cluster->GetCount() == 0)
-						bKeepInstanceForMedianComputing = true;
-					else {
-						const int nRandom = 1 + IthRandomInt(nObject, 99);
-						bKeepInstanceForMedianComputing = (nRandom <= iReadPercentageForMedianComputation ? true : false);
-					}
-				}
-
-				if (not bKeepInstanceForMedianComputing)
-					delete kwoObject;
-				else {
-					// stocker cette instance dans le cluster, afin d'effectuer par la suite le calcul des medianes
-					lReadInstancesForMedianComputation++;
-					cluster->AddInstance(kwoObject);
-					kmGlobalCluster->AddInstance(kwoObject);
-				}
-			}
+		// les resumes ayant servi au calcul des medianes sont maintenant inutiles (gain memoire)
+		master_oaMedianSketches.DeleteAll();
 
-			// Arret si erreur ou interruption
-			if (evaluationDatabase->IsError() or
-				(nObject % 100 == 0 and TaskProgression::IsInterruptionRequested()))
-			{
-				bOk = false;
-				break;
-			}
-		}
+		kmGlobalCluster->ComputeMajorityTargetValue(kmEvaluationClustering->GetTargetAttributeValues());
 
-		if (bOk) {
+		for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
+			kmEvaluationClustering->GetCluster(i)->ComputeMajorityTargetValue(kmEvaluationClustering->GetTargetAttributeValues());
 
-			if (kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics() and kmGlobalCluster->GetCount() > 0)
-				kmGlobalCluster->ComputeNativeAttributesContinuousMedianValues();
+		// recalculer les distances entre clusters, sur la base des centroides d'evaluation qui viennent d'etre calcules
+		kmEvaluationClustering->ComputeClustersCentersDistances(true);
 
-			kmGlobalCluster->ComputeMajorityTargetValue(kmEvaluationClustering->GetTargetAttributeValues());
+		if (kmEvaluationClustering->GetParameters()->GetSinglePassEvaluation()) {
 
+			// les stats qui dependent des centroides d'evaluation sont deduites des statistiques suffisantes de la 1ere lecture
+			// NB. la compacite a ete calculee lors de la 1ere lecture, par rapport aux centroides et classes majoritaires du modele
 			for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
-			{
-				KMCluster* c = cast(KMCluster*, kmEvaluationClustering->GetClusters()->GetAt(i));
-
-				if (c->GetCount() > 0) {
-					if (kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics())
-						c->ComputeNativeAttributesContinuousMedianValues();
-					c->DeleteAll(); // suppression des KWObject du cluster, ayant servi au calcul des medianes (gain memoire, car ils sont maintenant devenus inutiles)
-				}
-
-				c->ComputeMajorityTargetValue(kmEvaluationClustering->GetTargetAttributeValues());
+				kmEvaluationClustering->GetCluster(i)->ComputeDistancesFromSufficientStatistics(true);
 
-			}
-
-			// recalculer les distances entre clusters, sur la base des centroides d'evaluation qui viennent d'etre calcules
-			kmEvaluationClustering->ComputeClustersCentersDistances(true);
-
-			// 2eme lecture de base, afin de mettre a jour les stats qui dependent des centroides d'evaluation
-
-			evaluationDatabase->Close();
-			evaluationDatabase->OpenForRead();
-
-			nObject = 0;
-			while (not evaluationDatabase->IsEnd())
-			{
-				kwoObject = evaluationDatabase->Read();
-
-				if (kwoObject != NULL)
-				{
-					nObject++;
-
-					// Mise a jour de l'evaluation : affecte l'instance au cluster correspondant, et maj la somme des distances ainsi que les inerties intra, en fonction des nouveaux centroides
-					UpdateEvaluationSecondDatabaseRead(kwoObject);
-
-					delete kwoObject;
-
-				}
-
-				// Arret si erreur ou interruption
-				if (evaluationDatabase->IsError() or
-					(nObject % 100 == 0 and TaskProgression::IsInterruptionRequested()))
-				{
-					bOk = false;
-					break;
-				}
-			}
+			kmGlobalCluster->ComputeDistancesFromSufficientStatistics(false);
+		}
+		else {
+			// 2eme lecture de base, afin de mettre a jour les stats qui dependent des centroides d'evaluation et des classes majoritaires
+			master_nDatabasePass = 2;
+			bOk = RunDatabaseTask(evaluationDatabase);
 		}
-
-		Global::DesactivateErrorFlowControl();
-
-		TaskProgression::EndTask();
-
-		AddSimpleMessage(ALString("Evaluation instances number (with no missing values after preprocessing) : ") + LongintToString(lInstanceEvaluationNumber));
-		AddSimpleMessage(ALString("Instances with missing values : ") + LongintToString(kmEvaluationClustering->GetInstancesWithMissingValues()));
-
-		// Fermeture
-		bOk = evaluationDatabase->Close() and bOk;
 	}
 
+	AddSimpleMessage(ALString("Evaluation instances number (with no missing values after preprocessing) : ") + LongintToString(lInstanceEvaluationNumber));
+	AddSimpleMessage(ALString("Instances with missing values : ") + LongintToString(lInstancesWithMissingValues));
+
 	if (lInstanceEvaluationNumber > 0) {
 
 		kmGlobalCluster->FinalizeStatisticsUpdateFromInstances();
@@ -321,8 +207,6 @@ boolean KMClassifierEvaluationTask::Evaluate(KWPredictor* predictor,
 
 	}
 
-	bOk = MasterFinalize(bOk); // appele directement, car on n'utilise pas le service d'execution parallele des taches
-
 	CleanPredictorSharedVariables();
 
 	return bOk;
@@ -342,163 +226,297 @@ PLParallelTask* KMClassifierEvaluationTask::Create() const
 
 boolean KMClassifierEvaluationTask::MasterInitialize()
 {
-	// reimplemente car n'utilise pas le service de parallelisation de taches
-
-	boolean bOk = true;
-	int nTargetValue;
-	ALString sTmp;
-
-	require(masterConfMatrixEvaluation == NULL);
-	require(slaveConfusionMatrixEvaluation == NULL);
-	require(masterAucEvaluation == NULL);
-	require(masterInstanceEvaluationSampler == NULL);
-	require(evaluationInstances == NULL);
-
-	AddSimpleMessage("MLClusters internal version is " + ALString(INTERNAL_VERSION));
-
-	// Memorisation de la specialisation du rapport d'evaluation demandeur
-	classifierEvaluation = cast(KWClassifierEvaluation*, predictorEvaluation);
-	kmClassifierEvaluation = cast(KMClassifierEvaluation*, predictorEvaluation);
-	kmClassifierEvaluation->dCompressionRate = 0;
-
-	// Initialisation du service d'evaluation de la matrice de confusion
-	masterConfMatrixEvaluation = new KWConfusionMatrixEvaluation;
-	masterConfMatrixEvaluation->Initialize();
-	for (nTargetValue = 0; nTargetValue < shared_nTargetValueNumber; nTargetValue++)
-		masterConfMatrixEvaluation->AddPredictedTarget(shared_svPredictedModalities.GetAt(nTargetValue));
-
-
-	// Initialisation des courbes de lift pour l'ensemble des modalites
-	assert(kmClassifierEvaluation->oaAllLiftCurveValues.GetSize() == 0);
-	for (nTargetValue = 0; nTargetValue < shared_nTargetValueNumber; nTargetValue++)
-	{
-		// Arret et warning si le maximum de courbes est atteint
-		if (nTargetValue == nMaxLiftEvaluationNumber)
-		{
-			AddWarning(sTmp
-				+ "The lift curves will be computed only for " + IntToString(nMaxLiftEvaluationNumber)
-				+ " values (among " + IntToString(shared_nTargetValueNumber) + ")");
-			break;
-		}
-		kmClassifierEvaluation->oaAllLiftCurveValues.Add(new DoubleVector);
+	boolean bOk;
+
+	// les evaluations standard du classifieur (matrice de confusion, taux de compression, AUC, courbes de lift) ne sont mises a jour que lors de la 1ere lecture de base
+	if (master_nDatabasePass == 1) {
+		AddSimpleMessage("MLClusters internal version is " + ALString(INTERNAL_VERSION));
+		bOk = KWClassifierEvaluationTask::MasterInitialize();
 	}
+	else
+		bOk = KWDatabaseTask::MasterInitialize();
 
-	// Initialisation du compteur des echantillons d'evaluation des esclaves pour le calcul d'AUC et courbes de lift
-	nCurrentSample = 0;
+	shared_nDatabasePass = master_nDatabasePass;
+	shared_bMedianComputation = (master_nDatabasePass == 1 and kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics());
 
-	// Initialisation du service de calcul de l'AUC
-	evaluationInstances = new ObjectArray;
-	bIsAucEvaluated = shared_livProbAttributes.GetSize() > 0 and shared_nTargetValueNumber > 0;
-	masterAucEvaluation = new KWAucEvaluation;
-	masterAucEvaluation->SetTargetValueNumber(shared_nTargetValueNumber);
+	// lors de la 2eme lecture, les esclaves ont besoin des centroides d'evaluation et des classes majoritaires (ceux des clusters, puis ceux du cluster global)
+	shared_oaEvaluationCentroids->GetObjectArray()->DeleteAll();
+	shared_svMajorityTargetValues.GetStringVector()->SetSize(0);
+	shared_ivMajorityTargetIndexes.GetIntVector()->SetSize(0);
 
-	ensure(Check());
+	if (master_nDatabasePass == 2) {
+
+		for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++) {
+			KMCluster* c = kmEvaluationClustering->GetCluster(i);
+			shared_oaEvaluationCentroids->GetObjectArray()->Add(c->GetEvaluationCentroidValues().Clone());
+			shared_svMajorityTargetValues.GetStringVector()->Add(c->GetMajorityTargetValue());
+			shared_ivMajorityTargetIndexes.GetIntVector()->Add(c->GetMajorityTargetIndex());
+		}
+
+		shared_oaEvaluationCentroids->GetObjectArray()->Add(kmGlobalCluster->GetEvaluationCentroidValues().Clone());
+		shared_svMajorityTargetValues.GetStringVector()->Add(kmGlobalCluster->GetMajorityTargetValue());
+		shared_ivMajorityTargetIndexes.GetIntVector()->Add(kmGlobalCluster->GetMajorityTargetIndex());
+	}
 
 	return bOk;
 }
 
+boolean KMClassifierEvaluationTask::MasterAggregateResults()
+{
+	IntVector ivTargetValueIndexes;
+
+	lInstanceEvaluationNumber += output_lInstanceEvaluationNumber;
+	lInstancesWithMissingValues += output_lInstancesWithMissingValues;
+	lReadInstancesForMedianComputation += output_lReadInstancesForMedianComputation;
+
+	// les valeurs cibles de l'esclave (dont celles inconnues en apprentissage) sont referencees dans le clustering du maitre, et
+	// leurs index dans le maitre servent a agreger les probas cibles des clusters
+	const StringVector* svTargetValues = output_svTargetValues.GetConstStringVector();
+
+	for (int i = 0; i < svTargetValues->GetSize(); i++)
+		ivTargetValueIndexes.Add(kmEvaluationClustering->AddTargetAttributeValueIfNotExists(svTargetValues->GetAt(i)));
+
+	KMPredictorEvaluationTask::AggregateClusters(output_oaClusters->GetObjectArray(), ivTargetValueIndexes, kmEvaluationClustering);
+	KMPredictorEvaluationTask::AggregateFrequencyTables(output_oaGroupedModalitiesFrequencies->GetObjectArray(), odGroupedModalitiesFrequencyTables);
+	KMPredictorEvaluationTask::AggregateFrequencyTables(output_oaAtomicModalitiesFrequencies->GetObjectArray(), odAtomicModalitiesFrequencyTables);
+	KMPredictorEvaluationTask::AggregateMedianSketches(output_oaMedianSketches->GetObjectArray(), kmEvaluationClustering->GetParameters(), &master_oaMedianSketches);
+
+	// matrice de confusion specifique kmean (predit x reel, dans l'ordre des valeurs cibles de l'esclave)
+	const IntVector* ivConfusionMatrix = output_ivConfusionMatrix.GetConstIntVector();
+	const int nTargetValueNumber = svTargetValues->GetSize();
+
+	if (ivConfusionMatrix->GetSize() == nTargetValueNumber * nTargetValueNumber) {
+
+		for (int iPredicted = 0; iPredicted < nTargetValueNumber; iPredicted++) {
+			for (int iActual = 0; iActual < nTargetValueNumber; iActual++) {
+
+				const int nFrequency = ivConfusionMatrix->GetAt(iPredicted * nTargetValueNumber + iActual);
+
+				if (nFrequency > 0)
+					kmEvaluationClustering->UpdateConfusionMatrix(Symbol(svTargetValues->GetAt(iPredicted)), Symbol(svTargetValues->GetAt(iActual)), nFrequency);
+			}
+		}
+	}
+
+	// Appel a la methode ancetre
+	if (master_nDatabasePass == 1)
+		return KWClassifierEvaluationTask::MasterAggregateResults();
+	else
+		return KWDatabaseTask::MasterAggregateResults();
+}
+
 boolean KMClassifierEvaluationTask::MasterFinalize(boolean bProcessEndedCorrectly)
 {
-	// reimplemente car n'utilise pas le service de parallelisation de taches
+	boolean bOk;
+
+	if (master_nDatabasePass == 2)
+		return KWDatabaseTask::MasterFinalize(bProcessEndedCorrectly);
 
-	const int nPartileNumber = 1000;
-	boolean bOk = true;
-	int nLiftCurve;
-	int nPredictorTarget;
-	DoubleVector* dvLiftCurveValues;
+	KMClassifierEvaluation* kmClassifierEvaluation = cast(KMClassifierEvaluation*, predictorEvaluation);
 
-	assert(kmClassifierEvaluation != NULL);
+	bOk = KWClassifierEvaluationTask::MasterFinalize(bProcessEndedCorrectly);
+
+	// seules les instances sans valeur manquante K-Means sont evaluees
 	kmClassifierEvaluation->SetInstanceEvaluationNumber(lInstanceEvaluationNumber);
 
-	// Memorisation de la matrice de confusion
-	assert(masterConfMatrixEvaluation->Check());
-	masterConfMatrixEvaluation->ExportDataGridStats(&kmClassifierEvaluation->dgsConfusionMatrix);
-	kmClassifierEvaluation->dgsConfusionMatrix.ExportAttributePartFrequenciesAt(1, &kmClassifierEvaluation->ivActualModalityFrequencies);
-
-	// Calcul et memorisation des taux de prediction
-	kmClassifierEvaluation->dAccuracy = masterConfMatrixEvaluation->ComputeAccuracy();
-	kmClassifierEvaluation->dBalancedAccuracy = masterConfMatrixEvaluation->ComputeBalancedAccuracy();
-	kmClassifierEvaluation->dMajorityAccuracy = masterConfMatrixEvaluation->ComputeMajorityAccuracy();
-	kmClassifierEvaluation->dTargetEntropy = masterConfMatrixEvaluation->ComputeTargetEntropy();
-
-	// Calcul et memorisation du taux de compression
-	if (shared_livProbAttributes.GetSize() > 0 and kmClassifierEvaluation->lInstanceEvaluationNumber > 0)
-	{
-		// Normalisation par rapport a l'entropie cible
-		if (kmClassifierEvaluation->dTargetEntropy > 0) {
-			kmClassifierEvaluation->dCompressionRate = 1.0
-				- kmClassifierEvaluation->dCompressionRate
-				/ (kmClassifierEvaluation->lInstanceEvaluationNumber * kmClassifierEvaluation->dTargetEntropy);
-		}
-		else
-			kmClassifierEvaluation->dCompressionRate = 0;
+	return bOk;
+}
+
+boolean KMClassifierEvaluationTask::SlaveInitialize()
+{
+	boolean bOk;
+	KWClass* kwcEvaluationClass;
+
+	if (shared_nDatabasePass == 1)
+		bOk = KWClassifierEvaluationTask::SlaveInitialize();
+	else
+		bOk = KWDatabaseTask::SlaveInitialize();
+
+	// reconstitution du modele K-Means a partir du dictionnaire, deja prepare pour le deploiement par le maitre
+	if (bOk) {
 
-		// On arrondit si necessaire a 0
-		if (fabs(kmClassifierEvaluation->dCompressionRate)
-			< kmClassifierEvaluation->dTargetEntropy / kmClassifierEvaluation->lInstanceEvaluationNumber)
-			kmClassifierEvaluation->dCompressionRate = 0;
+		kwcEvaluationClass = KWClassDomain::GetCurrentDomain()->LookupClass(shared_sEvaluationClassName.GetValue());
+		assert(kwcEvaluationClass != NULL);
+
+		assert(shared_liTargetAttribute.GetValue().IsValid());
+		targetAttribute = kwcEvaluationClass->GetAttributeAtLoadIndex(shared_liTargetAttribute.GetValue());
+		assert(targetAttribute != NULL);
+
+		slave_trainedClassifier = new KMTrainedClassifier;
+		bOk = slave_trainedClassifier->CreateEvaluationClustering(kwcEvaluationClass) != NULL;
 	}
 
-	// Calcul de l'AUC s'il y y a des instances en evaluation
-	if (bIsAucEvaluated and lInstanceEvaluationNumber > 0)
-	{
-		masterAucEvaluation->SetInstanceEvaluations(evaluationInstances);
-		if (shared_livProbAttributes.GetSize() > 0 and masterAucEvaluation->GetTargetValueNumber() > 0)
-			kmClassifierEvaluation->dAUC = masterAucEvaluation->ComputeGlobalAUCValue();
+	return bOk;
+}
 
-		// Calcul des courbes de lift
-		for (nLiftCurve = 0; nLiftCurve < kmClassifierEvaluation->oaAllLiftCurveValues.GetSize(); nLiftCurve++)
-		{
-			dvLiftCurveValues = cast(DoubleVector*, kmClassifierEvaluation->oaAllLiftCurveValues.GetAt(nLiftCurve));
+boolean KMClassifierEvaluationTask::SlaveProcessExploitDatabase()
+{
+	boolean bOk;
 
-			// L'index de lift de la modalite est celui de la modalite directement, sauf si la derniere
-			// courbe memorise la courbe pour la modalite cible principale
-			nPredictorTarget = GetPredictorTargetIndexAtLiftCurveIndex(nLiftCurve);
+	// clustering d'evaluation de la portion de base, initialise a partir du modele
+	if (kmEvaluationClustering != NULL)
+		delete kmEvaluationClustering;
 
-			// Si l'on a avant la modalite cible est au debut
-			masterAucEvaluation->ComputeLiftCurveAt(nPredictorTarget, nPartileNumber, dvLiftCurveValues);
+	kmEvaluationClustering = slave_trainedClassifier->GetModelingClustering()->Clone();
+	kmGlobalCluster = kmEvaluationClustering->GetGlobalCluster();
+	odAttributesPartitions = ((ObjectDictionary*)&kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions());
+	odAtomicModalities = ((ObjectDictionary*)&kmEvaluationClustering->GetAttributesPartitioningManager()->GetAtomicModalities());
+
+	lInstanceEvaluationNumber = 0;
+	lInstancesWithMissingValues = 0;
+	lReadInstancesForMedianComputation = 0;
+	slave_oaMedianSketches.DeleteAll();
+	odGroupedModalitiesFrequencyTables.DeleteAll();
+	odAtomicModalitiesFrequencyTables.DeleteAll();
+
+	if (shared_nDatabasePass == 1) {
+
+		slave_bUpdateModalitiesProbs = (kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions().GetCount() > 0 ? true : false);
+
+		if (slave_bUpdateModalitiesProbs)
+			InitializeModalitiesProbs();
+
+		// en evaluation en une seule lecture, la compacite est calculee par rapport aux classes majoritaires du modele
+		if (kmEvaluationClustering->GetParameters()->GetSinglePassEvaluation()) {
+			for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
+				kmEvaluationClustering->GetCluster(i)->ComputeMajorityTargetValue(kmEvaluationClustering->GetTargetAttributeValues());
 		}
+
+		// Appel a la methode ancetre, qui parcourt les objets de la portion de base
+		bOk = KWClassifierEvaluationTask::SlaveProcessExploitDatabase();
 	}
+	else {
+		// centroides d'evaluation et classes majoritaires calcules par le maitre, a l'issue de la 1ere lecture
+		const ObjectArray* oaCentroids = shared_oaEvaluationCentroids->GetConstObjectArray();
+		const StringVector* svMajorityTargetValues = shared_svMajorityTargetValues.GetConstStringVector();
+		const IntVector* ivMajorityTargetIndexes = shared_ivMajorityTargetIndexes.GetConstIntVector();
+		assert(oaCentroids->GetSize() == kmEvaluationClustering->GetClusters()->GetSize() + 1);
+		assert(svMajorityTargetValues->GetSize() == oaCentroids->GetSize());
+		assert(ivMajorityTargetIndexes->GetSize() == oaCentroids->GetSize());
+
+		for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++) {
+			KMCluster* c = kmEvaluationClustering->GetCluster(i);
+			c->SetEvaluationCentroidValues(*cast(ContinuousVector*, oaCentroids->GetAt(i)));
+			c->SetMajorityTargetValue(svMajorityTargetValues->GetAt(i), ivMajorityTargetIndexes->GetAt(i));
+		}
 
+		const int nGlobal = oaCentroids->GetSize() - 1;
+		kmGlobalCluster->SetEvaluationCentroidValues(*cast(ContinuousVector*, oaCentroids->GetAt(nGlobal)));
+		kmGlobalCluster->SetMajorityTargetValue(svMajorityTargetValues->GetAt(nGlobal), ivMajorityTargetIndexes->GetAt(nGlobal));
 
-	// Nettoyage
-	kmClassifierEvaluation = NULL;
-	delete masterConfMatrixEvaluation;
-	masterConfMatrixEvaluation = NULL;
-	delete masterAucEvaluation;
-	masterAucEvaluation = NULL;
-	delete masterInstanceEvaluationSampler;
-	masterInstanceEvaluationSampler = NULL;
-	dMasterSamplingProb = -1.0;
-	nCurrentSample = -1;
-	oaAllInstanceEvaluationSamples.DeleteAll();
-
-	if (evaluationInstances != NULL) {
-		evaluationInstances->DeleteAll();
-		delete evaluationInstances;
-		evaluationInstances = NULL;
+		// Appel a la methode ancetre
+		bOk = KWDatabaseTask::SlaveProcessExploitDatabase();
+	}
+
+	// envoi des stats de la portion de base au maitre
+	if (bOk) {
+
+		output_lInstanceEvaluationNumber = lInstanceEvaluationNumber;
+		output_lInstancesWithMissingValues = lInstancesWithMissingValues;
+		output_lReadInstancesForMedianComputation = lReadInstancesForMedianComputation;
+
+		KMPredictorEvaluationTask::ExportClusters(kmEvaluationClustering, output_oaClusters->GetObjectArray());
+		KMPredictorEvaluationTask::ExportFrequencyTables(odGroupedModalitiesFrequencyTables, output_oaGroupedModalitiesFrequencies->GetObjectArray());
+		KMPredictorEvaluationTask::ExportFrequencyTables(odAtomicModalitiesFrequencyTables, output_oaAtomicModalitiesFrequencies->GetObjectArray());
+
+		// les resumes de quantiles sont transmis, et non recopies
+		for (int i = 0; i < slave_oaMedianSketches.GetSize(); i++)
+			output_oaMedianSketches->GetObjectArray()->Add(slave_oaMedianSketches.GetAt(i));
+		slave_oaMedianSketches.SetSize(0);
+
+		// valeurs cibles, dans l'ordre utilise par les probas cibles des clusters et par la matrice de confusion
+		const ObjectArray& oaTargetValues = kmEvaluationClustering->GetTargetAttributeValues();
+		StringVector* svTargetValues = output_svTargetValues.GetStringVector();
+		svTargetValues->SetSize(0);
+
+		for (int i = 0; i < oaTargetValues.GetSize(); i++)
+			svTargetValues->Add(cast(StringObject*, oaTargetValues.GetAt(i))->GetString());
+
+		// matrice de confusion specifique kmean, mise a plat (predit x reel)
+		const KWFrequencyTable* confusionMatrix = kmEvaluationClustering->GetConfusionMatrix();
+		IntVector* ivConfusionMatrix = output_ivConfusionMatrix.GetIntVector();
+		ivConfusionMatrix->SetSize(0);
+
+		if (confusionMatrix != NULL and confusionMatrix->GetFrequencyVectorNumber() == oaTargetValues.GetSize()) {
+
+			for (int iPredicted = 0; iPredicted < confusionMatrix->GetFrequencyVectorNumber(); iPredicted++) {
+
+				const IntVector* ivFrequencies = cast(KWDenseFrequencyVector*, confusionMatrix->GetFrequencyVectorAt(iPredicted))->GetFrequencyVector();
+				assert(ivFrequencies->GetSize() == oaTargetValues.GetSize());
+
+				for (int iActual = 0; iActual < ivFrequencies->GetSize(); iActual++)
+					ivConfusionMatrix->Add(ivFrequencies->GetAt(iActual));
+			}
+		}
 	}
 
 	return bOk;
 }
 
-KMCluster* KMClassifierEvaluationTask::UpdateEvaluationFirstDatabaseRead(KWPredictor* predictor, KWObject* kwoObject, const bool updateModalitiesProbs)
+boolean KMClassifierEvaluationTask::SlaveProcessExploitDatabaseObject(const KWObject* kwoObject)
+{
+	require(kwoObject != NULL);
+
+	if (shared_nDatabasePass == 2) {
+
+		// maj de la somme des distances, des inerties intra et de la compacite, en fonction des centroides d'evaluation
+		UpdateEvaluationSecondDatabaseRead(kwoObject);
+		return true;
+	}
+
+	KMCluster* cluster = UpdateEvaluationFirstDatabaseRead(kwoObject, slave_bUpdateModalitiesProbs);
+
+	// pas d'affectation possible : l'instance n'est pas evaluee
+	if (cluster == NULL)
+		return true;
+
+	// les valeurs de toutes les instances alimentent les resumes de quantiles, dont la taille est bornee quel que soit le volume de la base
+	if (shared_bMedianComputation) {
+		lReadInstancesForMedianComputation++;
+		KMPredictorEvaluationTask::UpdateMedianSketches(kwoObject, kmEvaluationClustering->GetParameters(),
+			(int)kwoObject->GetContinuousValueAt(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute()->GetLoadIndex()) - 1,
+			&slave_oaMedianSketches);
+	}
+
+	// Appel a la methode ancetre, pour les evaluations standard du classifieur
+	return KWClassifierEvaluationTask::SlaveProcessExploitDatabaseObject(kwoObject);
+}
+
+boolean KMClassifierEvaluationTask::SlaveFinalize(boolean bProcessEndedCorrectly)
+{
+	if (kmEvaluationClustering != NULL) {
+		delete kmEvaluationClustering;
+		kmEvaluationClustering = NULL;
+	}
+	kmGlobalCluster = NULL;
+	targetAttribute = NULL;
+	odAttributesPartitions = NULL;
+	odAtomicModalities = NULL;
+	odGroupedModalitiesFrequencyTables.DeleteAll();
+	odAtomicModalitiesFrequencyTables.DeleteAll();
+	slave_oaMedianSketches.DeleteAll();
+
+	// NB. le clustering d'evaluation reference les parametres du classifieur : il doit etre detruit avant lui
+	delete slave_trainedClassifier;
+	slave_trainedClassifier = NULL;
+
+	// Appel a la methode ancetre
+	if (shared_nDatabasePass == 1)
+		return KWClassifierEvaluationTask::SlaveFinalize(bProcessEndedCorrectly);
+	else
+		return KWDatabaseTask::SlaveFinalize(bProcessEndedCorrectly);
+}
+
+KMCluster* KMClassifierEvaluationTask::UpdateEvaluationFirstDatabaseRead(const KWObject* kwoObject, const bool updateModalitiesProbs)
 {
-	const Continuous cEpsilon = (Continuous)1e-6;
-	int nActualValueIndex;
-	int i;
 	Symbol sActualTargetValue;
 	Symbol sPredictedTargetValue;
-	Continuous cActualTargetValueProb;
-	KWClassifierInstanceEvaluation* instanceEvaluation;
 
-	require(predictor != NULL);
 	require(kwoObject != NULL);
 	require(targetAttribute != NULL);
-	require(kmClassifierEvaluation != NULL);
 
 	if (kmEvaluationClustering->GetParameters()->HasMissingKMeanValue(kwoObject)) {
-		kmEvaluationClustering->IncrementInstancesWithMissingValuesNumber();
+		lInstancesWithMissingValues++;
 		return NULL;
 	}
 
@@ -507,7 +525,7 @@ KMCluster* KMClassifierEvaluationTask::UpdateEvaluationFirstDatabaseRead(KWPredi
 
 	const int idCluster = (int)kwoObject->GetContinuousValueAt(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute()->GetLoadIndex()) - 1;
 
-	if (idCluster > kmEvaluationClustering->GetClusters()->GetSize()) {
+	if (idCluster < 0 or idCluster >= kmEvaluationClustering->GetClusters()->GetSize()) {
 		AddError("UpdateEvaluation : Cluster number " + ALString(IntToString(idCluster + 1)) + " does not exist.");
 		// ne doit pas arriver, sauf si on a utilis� par erreur un dico de modelisation en mode benchmark, a la place d'un dico natif
 		return NULL;
@@ -523,11 +541,15 @@ KMCluster* KMClassifierEvaluationTask::UpdateEvaluationFirstDatabaseRead(KWPredi
 	}
 
 	kmGlobalCluster->SetFrequency(kmGlobalCluster->GetFrequency() + 1);
+	if (kmEvaluationClustering->GetParameters()->GetSinglePassEvaluation())
+		kmGlobalCluster->UpdateEvaluationSufficientStatistics(kwoObject);
 	kmGlobalCluster->UpdateMeanCentroidValues(kwoObject, (ContinuousVector&)kmGlobalCluster->GetEvaluationCentroidValues());
 	kmGlobalCluster->UpdateNativeAttributesContinuousMeanValues(kwoObject);
 	kmGlobalCluster->UpdateTargetProbs((ObjectArray&)kmEvaluationClustering->GetTargetAttributeValues(), targetAttribute, kwoObject);
 
 	cluster->SetFrequency(cluster->GetFrequency() + 1);
+	if (kmEvaluationClustering->GetParameters()->GetSinglePassEvaluation())
+		cluster->UpdateEvaluationSufficientStatistics(kwoObject);
 	cluster->UpdateMeanCentroidValues(kwoObject, (ContinuousVector&)cluster->GetEvaluationCentroidValues());
 	cluster->UpdateNativeAttributesContinuousMeanValues(kwoObject);
 	cluster->UpdateTargetProbs((ObjectArray&)kmEvaluationClustering->GetTargetAttributeValues(), targetAttribute, kwoObject);
@@ -541,66 +563,12 @@ KMCluster* KMClassifierEvaluationTask::UpdateEvaluationFirstDatabaseRead(KWPredi
 	sPredictedTargetValue = kwoObject->GetSymbolValueAt(shared_liPredictionAttribute.GetValue());
 
 	// mise a jour de la matrice specifique kmean, qui servira a calculer les ARI par classes et NMI par classes
+	// NB. la matrice de confusion standard, le taux de compression et l'AUC sont mis a jour par la methode ancetre
 	kmEvaluationClustering->UpdateConfusionMatrix(sPredictedTargetValue, sActualTargetValue);
 
-	// Mise a jour de la matrice de confusion (directement dans la matrice du maitre, puisqu'on n'utilise pas d'esclaves)
-	masterConfMatrixEvaluation->AddInstanceEvaluation(sPredictedTargetValue, sActualTargetValue);
-
-	// Recherche de l'index en apprentissage de la modalite effective
-	// Par defaut: le nombre de modalites cible en apprentissage
-	// (signifie valeur cible inconnue en apprentissage)
-	nActualValueIndex = shared_nTargetValueNumber;
-	if (shared_livProbAttributes.GetSize() > 0)
-	{
-		for (i = 0; i < shared_nTargetValueNumber; i++)
-		{
-			if (shared_svPredictedModalities.GetAt(i) == sActualTargetValue)
-			{
-				nActualValueIndex = i;
-				break;
-			}
-		}
-	}
-
-	// Mise a jour du taux de compression si pertinente
-	if (shared_livProbAttributes.GetSize() > 0)
-	{
-		// Recherche de la probabilite predite pour la valeur cible reelle
-		cActualTargetValueProb = 0;
-		if (nActualValueIndex < shared_livProbAttributes.GetSize())
-		{
-			assert(kwoObject->GetSymbolValueAt(shared_liTargetAttribute.GetValue()) ==
-				shared_svPredictedModalities.GetAt(nActualValueIndex));
-			cActualTargetValueProb =
-				kwoObject->GetContinuousValueAt(shared_livProbAttributes.GetAt(nActualValueIndex));
-
-			// On projete sur [0, 1] pour avoir une probabilite quoi qu'il arrive
-			if (cActualTargetValueProb < cEpsilon)
-				cActualTargetValueProb = cEpsilon;
-			if (cActualTargetValueProb > 1)
-				cActualTargetValueProb = 1;
-		}
-		// Si la valeur etait inconnue en apprentissage, on lui associe une probabilite minimale
-		else
-			cActualTargetValueProb = cEpsilon;
-
-		// Ajout du log negatif de cette probabilite a l'evaluation des scores
-		kmClassifierEvaluation->dCompressionRate -= log(cActualTargetValueProb);
-	}
-
-	// Collecte des informations necessaires a l'estimation de l'AUC et aux courbes de lift
-	if (bIsAucEvaluated)
-	{
-		instanceEvaluation = new KWClassifierInstanceEvaluation;
-		instanceEvaluation->SetTargetValueNumber(shared_nTargetValueNumber);
-		instanceEvaluation->SetActualTargetIndex(nActualValueIndex);
-		for (i = 0; i < shared_nTargetValueNumber; i++)
-		{
-			instanceEvaluation->SetTargetProbAt(i,
-				kwoObject->GetContinuousValueAt(shared_livProbAttributes.GetAt(i)));
-		}
-		evaluationInstances->Add(instanceEvaluation);
-	}
+	// en evaluation en une seule lecture, la compacite ne peut attendre les centroides d'evaluation : elle est calculee par rapport au modele
+	if (kmEvaluationClustering->GetParameters()->GetSinglePassEvaluation() and cluster->GetMajorityTargetIndex() != -1)
+		cluster->UpdateCompactness(kwoObject, kmEvaluationClustering->GetTargetAttributeValues(), targetAttribute, cluster->GetModelingCentroidValues());
 
 	if (updateModalitiesProbs)
 		UpdateModalitiesProbs(kwoObject, idCluster);
@@ -609,7 +577,7 @@ KMCluster* KMClassifierEvaluationTask::UpdateEvaluationFirstDatabaseRead(KWPredi
 }
 
 
-KMCluster* KMClassifierEvaluationTask::UpdateEvaluationSecondDatabaseRead(KWObject* kwoObject)
+KMCluster* KMClassifierEvaluationTask::UpdateEvaluationSecondDatabaseRead(const KWObject* kwoObject)
 {
 	require(kwoObject != NULL);
 	assert(kmEvaluationClustering != NULL);
@@ -620,7 +588,7 @@ KMCluster* KMClassifierEvaluationTask::UpdateEvaluationSecondDatabaseRead(KWObje
 
 	const int idCluster = (int)kwoObject->GetContinuousValueAt(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute()->GetLoadIndex()) - 1;
 
-	if (idCluster > kmEvaluationClustering->GetClusters()->GetSize()) {
+	if (idCluster < 0 or idCluster >= kmEvaluationClustering->GetClusters()->GetSize()) {
 		AddError("UpdateEvaluation : Cluster number " + ALString(IntToString(idCluster + 1)) + " does not exist.");
 		// ne doit pas arriver, sauf si on a utilis� par erreur un dico de modelisation en mode benchmark, a la place d'un dico natif
 		return NULL;
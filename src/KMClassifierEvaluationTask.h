@@ -12,6 +12,8 @@ class KMClassifierEvaluation;
 
 ////////////////////////////////////////////////////////////////////////////////
 /// Tache d'evaluation d'un classifieur KMean sur une base de donnees
+/// Comme pour KMPredictorEvaluationTask, l'evaluation se fait en deux passes paralleles sur la base. Les esclaves
+/// renvoient egalement au maitre leurs valeurs cibles et leur matrice de confusion "classes majoritaires / classes reelles"
 class KMClassifierEvaluationTask : public KWClassifierEvaluationTask
 {
 public:
@@ -42,17 +44,22 @@ public:
 	////  Implementation
 protected:
 
-	// Reimplementation des methodes virtuelles. NB. pour le moment, on ne traite pas en parallele
+	// Reimplementation des methodes virtuelles
 	const ALString GetTaskName() const override;
 	PLParallelTask* Create() const override;
 	boolean MasterInitialize() override;
+	boolean MasterAggregateResults() override;
 	boolean MasterFinalize(boolean bProcessEndedCorrectly) override;
+	boolean SlaveInitialize() override;
+	boolean SlaveProcessExploitDatabase() override;
+	boolean SlaveProcessExploitDatabaseObject(const KWObject* kwoObject) override;
+	boolean SlaveFinalize(boolean bProcessEndedCorrectly) override;
 
 	/** evaluation lors de la premiere passe de lecture */
-	KMCluster* UpdateEvaluationFirstDatabaseRead(KWPredictor* predictor, KWObject* kwoObject, const bool updateModalitiesProbs);
+	KMCluster* UpdateEvaluationFirstDatabaseRead(const KWObject* kwoObject, const bool updateModalitiesProbs);
 
 	/** evaluation lors de la seconde passe de lecture */
-	KMCluster* UpdateEvaluationSecondDatabaseRead(KWObject* kwoObject);
+	KMCluster* UpdateEvaluationSecondDatabaseRead(const KWObject* kwoObject);
 
 	void InitializeModalitiesProbs();
 
@@ -60,8 +67,6 @@ protected:
 
 	////////////////////////////////////  variables membres ///////////////////////////////
 
-	KMClassifierEvaluation* kmClassifierEvaluation;
-
 	longint lInstancesWithMissingValues;
 
 	longint lInstanceEvaluationNumber;
@@ -86,9 +91,43 @@ protected:
 	/** cle = nom d'attribut. Valeur = objet KWFrequencyTable, contenant le comptage des modalits non groupes pour un attribut donn */
 	ObjectDictionary odAtomicModalitiesFrequencyTables;
 
-	longint lReadInstancesForMedianComputation;;
+	longint lReadInstancesForMedianComputation;
+
+	// variables membres du maitre
+
+	/** passe de lecture de la base en cours (1 ou 2) */
+	int master_nDatabasePass;
+
+	/** resumes de quantiles renvoyes par les esclaves pour le calcul des medianes (cf. KMPredictorEvaluationTask::UpdateMedianSketches) */
+	ObjectArray master_oaMedianSketches;
+
+	// variables membres des esclaves
+
+	/** classifieur servant a reconstituer le modele a partir du dictionnaire */
+	KMTrainedClassifier* slave_trainedClassifier;
+
+	/** indique si les frequences de modalites sont a mettre a jour */
+	boolean slave_bUpdateModalitiesProbs;
+
+	/** resumes de quantiles de la portion de base pour le calcul des medianes */
+	ObjectArray slave_oaMedianSketches;
 
-	ObjectArray* evaluationInstances;
+	// variables partagees
+	PLShared_String shared_sEvaluationClassName;
+	PLShared_Int shared_nDatabasePass;
+	PLShared_Boolean shared_bMedianComputation;
+	PLShared_ObjectArray* shared_oaEvaluationCentroids;
+	PLShared_StringVector shared_svMajorityTargetValues;
+	PLShared_IntVector shared_ivMajorityTargetIndexes;
+	PLShared_Longint output_lInstanceEvaluationNumber;
+	PLShared_Longint output_lInstancesWithMissingValues;
+	PLShared_Longint output_lReadInstancesForMedianComputation;
+	PLShared_ObjectArray* output_oaClusters;
+	PLShared_ObjectArray* output_oaGroupedModalitiesFrequencies;
+	PLShared_ObjectArray* output_oaAtomicModalitiesFrequencies;
+	PLShared_ObjectArray* output_oaMedianSketches;
+	PLShared_StringVector output_svTargetValues;
+	PLShared_IntVector output_ivConfusionMatrix;
 };
 
 inline 	longint KMClassifierEvaluationTask::GetReadInstancesForMedianComputation() const {
@@ -5,10 +5,16 @@
 
 #include "KMCluster.h"
 #include "KMClustering.h"
+#include "KMDistanceKernel.h"
+#include "KMQuantileSketch.h"
+
 
 KMCluster::KMCluster(const KMParameters *params) : parameters(params) {
   InitializeStatistics();
   iIndex = -1;
+  bRunningSumsUpToDate = false;
+  lRunningSumsUpdates = 0;
+  lRunningSumsCount = 0;
 }
 KMCluster::~KMCluster(void) {
   if (instanceNearestToCentroid != NULL)
@@ -33,6 +39,8 @@ void KMCluster::InitializeStatistics() {
   dMinDistanceFromCentroid = 0;
   instanceNearestToCentroid = NULL;
   instanceFurthestToCentroid = NULL;
+  kwoFinalNearestInstance = NULL;
+  kwoFinalFurthestInstance = NULL;
   nearestCluster = NULL;
   iMajorityTargetIndex = -1;
 }
@@ -195,7 +203,7 @@ void KMCluster::ComputeInstanceFurthestToCentroid(
       new KMClusterInstance(furthestInstance, parameters);
 }
 
-void KMCluster::ComputeIterationStatistics() {
+void KMCluster::ComputeIterationStatistics(const bool bComputeDistanceSum) {
   // NB. un cluster clone est considere comme etant a jour, du point de vue de
   // ses stats internes. Il ne faut pas recalculer ses stats, sinon elles seront
   // faussees, puisqu'il ne contient plus d'instances.
@@ -216,8 +224,10 @@ void KMCluster::ComputeIterationStatistics() {
     // mise a jour des centroides
     ComputeMeanModelingCentroidValues();
 
-    // mise a jour de la somme des distances
-    ComputeDistanceSum(parameters->GetDistanceType());
+    // mise a jour de la somme des distances (sauf si elle est calculee par
+    // ailleurs, cf. ComputeFinalStatistics)
+    if (bComputeDistanceSum)
+      ComputeDistanceSum(parameters->GetDistanceType());
   }
 
   bStatisticsUpToDate = true;
@@ -245,14 +255,23 @@ void KMCluster::ComputeMeanModelingCentroidValues() {
     cvModelingCentroidValues.Initialize();
   }
 
+  const int size = parameters->GetKMeanAttributesLoadIndexes().GetSize();
+
+  // cas ou les sommes courantes sont a jour : calcul en O(nombre d'attributs),
+  // sans rebalayer les instances
+  if (bRunningSumsUpToDate and lRunningSumsCount == GetCount() and
+      lRunningSumsUpdates <= GetCount()) {
+    for (int i = 0; i < size; i++)
+      cvModelingCentroidValues.SetAt(i, (cvRunningSums.GetAt(i) / GetCount()));
+    return;
+  }
+
   ContinuousVector sums;
 
   sums.SetSize(nbAttr);
 
   sums.Initialize();
 
-  const int size = parameters->GetKMeanAttributesLoadIndexes().GetSize();
-
   // balayer toutes les instances pour mettre a jour les valeurs de centroides
   position = GetStartPosition();
 
@@ -273,144 +292,51 @@ void KMCluster::ComputeMeanModelingCentroidValues() {
   for (int i = 0; i < size; i++) {
     cvModelingCentroidValues.SetAt(i, (sums.GetAt(i) / GetCount()));
   }
-}
-
-void KMCluster::ComputeMedianModelingCentroidValues() {
-
-  if (GetCount() == 0) {
-    AddWarning("Can't compute median centroid values, on cluster " + sLabel +
-               ", because it does not contain any element.");
-    return;
-  }
-
-  POSITION position = GetStartPosition();
-  NUMERIC key;
-  Object *oCurrent;
-  GetNextAssoc(position, key, oCurrent);
-  KWObject *currentInstance = static_cast<KWObject *>(oCurrent);
 
-  const int nbAttr = currentInstance->GetClass()->GetLoadedAttributeNumber();
-  require(nbAttr != 0);
-
-  if (cvModelingCentroidValues.GetSize() == 0) { // premiere maj
-    cvModelingCentroidValues.SetSize(nbAttr);
-    cvModelingCentroidValues.Initialize();
-  }
-
-  assert(nbAttr == parameters->GetKMeanAttributesLoadIndexes().GetSize());
-
-  for (int i = 0; i < nbAttr; i++) {
-
-    const KWLoadIndex loadIndex =
-        parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-
-    if (not loadIndex.IsValid())
-      // il ne s'agit pas d'un attribut KMeans
-      continue;
-
-    ContinuousVector cvValues;
+  // les sommes calculees servent desormais de base aux mises a jour
+  // incrementales, lors des ajouts et suppressions d'instances
+  cvRunningSums.CopyFrom(&sums);
+  bRunningSumsUpToDate = true;
+  lRunningSumsUpdates = 0;
+  lRunningSumsCount = GetCount();
+}
 
-    // balayer toutes les instances pour mettre a jour les valeurs de centroides
-    position = GetStartPosition();
+void KMCluster::InitializeRunningSums(const ContinuousVector &cvSums) {
 
-    while (position != NULL) {
+  require(cvSums.GetSize() ==
+          parameters->GetKMeanAttributesLoadIndexes().GetSize());
 
-      GetNextAssoc(position, key, oCurrent);
-      currentInstance = static_cast<KWObject *>(oCurrent);
-      cvValues.Add(currentInstance->GetContinuousValueAt(loadIndex));
-    }
+  cvRunningSums.CopyFrom(&cvSums);
+  bRunningSumsUpToDate = true;
+  lRunningSumsUpdates = 0;
+  lRunningSumsCount = GetCount();
+}
 
-    // Calcul de la valeur mediane
-    assert(cvValues.GetSize() > 0);
+void KMCluster::UpdateRunningSums(const KWObject *instance, const int sign) {
 
-    if (cvValues.GetSize() == 1)
-      cvModelingCentroidValues.SetAt(i, cvValues.GetAt(0));
-    // Cas ou il y a au moins deux valeurs
-    else {
-      // Tri des valeurs
-      cvValues.Sort();
-
-      // Calcul de la valeur mediane, selon la parite de la taille du tableau de
-      // valeurs
-      if (cvValues.GetSize() % 2 == 0)
-        cvModelingCentroidValues.SetAt(
-            i, (cvValues.GetAt(cvValues.GetSize() / 2 - 1) +
-                cvValues.GetAt(cvValues.GetSize() / 2)) /
-                   2);
-      else
-        cvModelingCentroidValues.SetAt(i,
-                                       cvValues.GetAt(cvValues.GetSize() / 2));
-    }
-  }
-}
+  assert(bRunningSumsUpToDate);
+  assert(sign == 1 or sign == -1);
 
-void KMCluster::ComputeMedianEvaluationCentroidValues() {
+  lRunningSumsCount = GetCount();
 
   if (GetCount() == 0) {
-    AddWarning("Can't compute median evaluation centroid values, on cluster " +
-               sLabel + ", because it does not contain any element.");
+    // cluster devenu vide : repartir de sommes exactement nulles
+    cvRunningSums.Initialize();
+    lRunningSumsUpdates = 0;
     return;
   }
 
-  POSITION position = GetStartPosition();
-  NUMERIC key;
-  Object *oCurrent;
-  GetNextAssoc(position, key, oCurrent);
-  KWObject *currentInstance = static_cast<KWObject *>(oCurrent);
-
-  const int nbAttr = currentInstance->GetClass()->GetLoadedAttributeNumber();
-  require(nbAttr != 0);
-
-  if (cvEvaluationCentroidValues.GetSize() == 0) { // premiere maj
-    cvEvaluationCentroidValues.SetSize(nbAttr);
-    cvEvaluationCentroidValues.Initialize();
-  }
-
-  assert(nbAttr == parameters->GetKMeanAttributesLoadIndexes().GetSize());
-
-  for (int i = 0; i < nbAttr; i++) {
+  const int size = parameters->GetKMeanAttributesLoadIndexes().GetSize();
 
+  for (int i = 0; i < size; i++) {
     const KWLoadIndex loadIndex =
         parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-
-    if (not loadIndex.IsValid())
-      // il ne s'agit pas d'un attribut KMeans
-      continue;
-
-    ContinuousVector cvValues;
-
-    // balayer toutes les instances pour mettre a jour les valeurs de centroides
-    position = GetStartPosition();
-
-    while (position != NULL) {
-
-      GetNextAssoc(position, key, oCurrent);
-      currentInstance = static_cast<KWObject *>(oCurrent);
-      cvValues.Add(currentInstance->GetContinuousValueAt(loadIndex));
-    }
-
-    // Calcul de la valeur mediane
-    assert(cvValues.GetSize() > 0);
-
-    if (cvValues.GetSize() == 1)
-      cvEvaluationCentroidValues.SetAt(i, cvValues.GetAt(0));
-    // Cas ou il y a au moins deux valeurs
-    else {
-      // Tri des valeurs
-      cvValues.Sort();
-
-      // Calcul de la valeur mediane, selon la parite de la taille du tableau de
-      // valeurs
-      if (cvValues.GetSize() % 2 == 0)
-        cvEvaluationCentroidValues.SetAt(
-            i, (cvValues.GetAt(cvValues.GetSize() / 2 - 1) +
-                cvValues.GetAt(cvValues.GetSize() / 2)) /
-                   2);
-      else
-        cvEvaluationCentroidValues.SetAt(
-            i, cvValues.GetAt(cvValues.GetSize() / 2));
-    }
+    if (loadIndex.IsValid())
+      cvRunningSums.SetAt(i, cvRunningSums.GetAt(i) +
+                                 sign * instance->GetContinuousValueAt(loadIndex));
   }
+
+  lRunningSumsUpdates++;
 }
 
 void KMCluster::ComputeDistanceSum(KMParameters::DistanceType distanceType) {
@@ -441,6 +367,7 @@ void KMCluster::ComputeDistanceSum(KMParameters::DistanceType distanceType) {
 void KMCluster::CopyInstancesFrom(const KMCluster *source) {
 
   RemoveAll();
+  bRunningSumsUpToDate = false;
 
   NUMERIC key;
   Object *oCurrent;
@@ -489,6 +416,177 @@ KMCluster::ComputeInertyIntra(KMParameters::DistanceType distanceType) {
   return sum;
 }
 
+void KMCluster::ReserveFinalStatistics() {
+
+  assert(cvModelingCentroidValues.GetSize() > 0);
+
+  if (cvInertyIntraL1ByAttributes.GetSize() == 0) {
+    cvInertyIntraL1ByAttributes.SetSize(cvModelingCentroidValues.GetSize());
+    cvInertyIntraL1ByAttributes.Initialize();
+  }
+  if (cvInertyIntraL2ByAttributes.GetSize() == 0) {
+    cvInertyIntraL2ByAttributes.SetSize(cvModelingCentroidValues.GetSize());
+    cvInertyIntraL2ByAttributes.Initialize();
+  }
+  if (cvInertyIntraCosineByAttributes.GetSize() == 0) {
+    cvInertyIntraCosineByAttributes.SetSize(cvModelingCentroidValues.GetSize());
+    cvInertyIntraCosineByAttributes.Initialize();
+  }
+}
+
+void KMCluster::ComputeFinalStatistics(
+    KMParameters::DistanceType distanceType) {
+
+  // meme resultat que ComputeDistanceSum pour chaque norme,
+  // ComputeInertyIntra, ComputeInertyIntraForAttribute pour chaque attribut
+  // et ComputeInstanceNearestToCentroid / ComputeInstanceFurthestToCentroid,
+  // mais en une seule passe sur les instances et sans allocation memoire
+
+  require(GetCount() > 0);
+  require(cvInertyIntraL1ByAttributes.GetSize() ==
+          cvModelingCentroidValues.GetSize());
+
+  const KWLoadIndexVector &loadIndexes =
+      parameters->GetKMeanAttributesLoadIndexes();
+  const int size = loadIndexes.GetSize();
+
+  ContinuousVector &cvInertyIntraByAttributes =
+      (distanceType == KMParameters::L1Norm
+           ? cvInertyIntraL1ByAttributes
+           : (distanceType == KMParameters::L2Norm
+                  ? cvInertyIntraL2ByAttributes
+                  : cvInertyIntraCosineByAttributes));
+
+  // la norme du centroide ne depend pas de l'instance
+  Continuous denominatorCentroid = 0.0;
+  for (int i = 0; i < size; i++) {
+    if (not loadIndexes.GetAt(i).IsValid())
+      continue;
+    denominatorCentroid += pow(cvModelingCentroidValues.GetAt(i), 2);
+    cvInertyIntraByAttributes.SetAt(i, 0);
+  }
+
+  Continuous sumL1 = 0.0;
+  Continuous sumL2 = 0.0;
+  Continuous sumCosine = 0.0;
+  Continuous minimumDistance = 0.0;
+  Continuous maximumDistance = 0.0;
+
+  kwoFinalNearestInstance = NULL;
+  kwoFinalFurthestInstance = NULL;
+
+  NUMERIC key;
+  Object *oCurrent;
+  POSITION position = GetStartPosition();
+
+  while (position != NULL) {
+
+    GetNextAssoc(position, key, oCurrent);
+    KWObject *currentInstance = static_cast<KWObject *>(oCurrent);
+
+    Continuous distanceL1 = 0.0;
+    Continuous distanceL2 = 0.0;
+    Continuous numerator = 0.0;
+    Continuous denominatorInstance = 0.0;
+
+    for (int i = 0; i < size; i++) {
+      const KWLoadIndex loadIndex = loadIndexes.GetAt(i);
+      if (not loadIndex.IsValid())
+        continue;
+
+      const Continuous centroidValue = cvModelingCentroidValues.GetAt(i);
+      const Continuous value = currentInstance->GetContinuousValueAt(loadIndex);
+      const Continuous d = centroidValue - value;
+
+      distanceL2 += (d * d);
+      distanceL1 += fabs(d);
+      numerator += centroidValue * value;
+      denominatorInstance += pow(value, 2);
+
+      // contribution de l'attribut a l'inertie intra par attribut
+      Continuous attributeDistance;
+      if (distanceType == KMParameters::L2Norm)
+        attributeDistance = (d * d);
+      else if (distanceType == KMParameters::L1Norm)
+        attributeDistance = fabs(d);
+      else {
+        const Continuous attributeDenominator =
+            sqrt(pow(value, 2)) * sqrt(pow(centroidValue, 2));
+        attributeDistance =
+            1 - (attributeDenominator == 0
+                     ? 0
+                     : centroidValue * value / attributeDenominator);
+      }
+      cvInertyIntraByAttributes.UpgradeAt(i, attributeDistance);
+    }
+
+    const Continuous denominator =
+        sqrt(denominatorInstance) * sqrt(denominatorCentroid);
+    const Continuous distanceCosine =
+        1 - (denominator == 0 ? 0 : numerator / denominator);
+
+    sumL1 += distanceL1;
+    sumL2 += distanceL2;
+    sumCosine += distanceCosine;
+
+    const Continuous distance =
+        (distanceType == KMParameters::L1Norm
+             ? distanceL1
+             : (distanceType == KMParameters::L2Norm ? distanceL2
+                                                     : distanceCosine));
+
+    if (kwoFinalNearestInstance == NULL) {
+      minimumDistance = distance;
+      maximumDistance = distance;
+      kwoFinalNearestInstance = currentInstance;
+      kwoFinalFurthestInstance = currentInstance;
+    } else {
+      if (minimumDistance > distance) {
+        minimumDistance = distance;
+        kwoFinalNearestInstance = currentInstance;
+      }
+      if (distance > maximumDistance) {
+        maximumDistance = distance;
+        kwoFinalFurthestInstance = currentInstance;
+      }
+    }
+  }
+
+  cvDistancesSum.SetAt(KMParameters::L1Norm, sumL1);
+  cvDistancesSum.SetAt(KMParameters::L2Norm, sumL2);
+  cvDistancesSum.SetAt(KMParameters::CosineNorm, sumCosine);
+
+  cvInertyIntra.SetAt(distanceType,
+                      cvDistancesSum.GetAt(distanceType) / GetCount());
+
+  for (int i = 0; i < size; i++) {
+    if (loadIndexes.GetAt(i).IsValid())
+      cvInertyIntraByAttributes.SetAt(
+          i, cvInertyIntraByAttributes.GetAt(i) / GetCount());
+  }
+}
+
+void KMCluster::ComputeFinalStatisticsInstances() {
+
+  require(kwoFinalNearestInstance != NULL);
+  require(kwoFinalFurthestInstance != NULL);
+
+  if (instanceNearestToCentroid != NULL)
+    delete instanceNearestToCentroid;
+  if (instanceFurthestToCentroid != NULL)
+    delete instanceFurthestToCentroid;
+
+  instanceNearestToCentroid =
+      new KMClusterInstance(kwoFinalNearestInstance, parameters);
+  instanceFurthestToCentroid =
+      new KMClusterInstance(kwoFinalFurthestInstance, parameters);
+
+  // les instances reperees ne sont valides que jusqu'a la prochaine
+  // modification du cluster
+  kwoFinalNearestInstance = NULL;
+  kwoFinalFurthestInstance = NULL;
+}
+
 const Continuous KMCluster::ComputeInertyIntraForAttribute(
     const int attributeRank, KMParameters::DistanceType distanceType) {
 
@@ -1030,53 +1128,8 @@ KMCluster::FindDistanceFromCentroid(const KWObject *o1,
   assert(centroids.GetSize() > 0);
   assert(o1 != NULL);
 
-  Continuous result = 0.0;
-  const int size = parameters->GetKMeanAttributesLoadIndexes().GetSize();
-
-  if (distanceType == KMParameters::L2Norm) {
-
-    for (int i = 0; i < size; i++) {
-      const KWLoadIndex loadIndex =
-          parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-      if (not loadIndex.IsValid())
-        continue;
-      const Continuous d =
-          centroids.GetAt(i) - o1->GetContinuousValueAt(loadIndex);
-      result += (d * d);
-    }
-  } else {
-    if (distanceType == KMParameters::L1Norm) {
-      for (int i = 0; i < size; i++) {
-        const KWLoadIndex loadIndex =
-            parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-        if (not loadIndex.IsValid())
-          continue;
-        result +=
-            fabs(centroids.GetAt(i) - o1->GetContinuousValueAt(loadIndex));
-      }
-    } else {
-      if (distanceType == KMParameters::CosineNorm) {
-        Continuous numerator = 0.0;
-        Continuous denominatorInstance = 0.0;
-        Continuous denominatorCentroid = 0.0;
-
-        for (int i = 0; i < size; i++) {
-          const KWLoadIndex loadIndex =
-              parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-          if (not loadIndex.IsValid())
-            continue;
-          numerator += centroids.GetAt(i) * o1->GetContinuousValueAt(loadIndex);
-          denominatorInstance += pow(o1->GetContinuousValueAt(loadIndex), 2);
-          denominatorCentroid += pow(centroids.GetAt(i), 2);
-        }
-        Continuous denominator =
-            sqrt(denominatorInstance) * sqrt(denominatorCentroid);
-        result = 1 - (denominator == 0 ? 0 : numerator / denominator);
-      }
-    }
-  }
-
-  return result;
+  return KMDistanceKernel::ComputeDistance(
+      o1, centroids, parameters->GetKMeanAttributesLoadIndexes(), distanceType);
 }
 
 Continuous KMCluster::FindDistanceFromCentroid(
@@ -1128,55 +1181,158 @@ KMCluster::FindDistanceFromCentroid(const KMClusterInstance *clusterInstance,
   assert(centroids.GetSize() > 0);
   assert(clusterInstance != NULL);
 
-  Continuous result = 0.0;
-  const int size = parameters->GetKMeanAttributesLoadIndexes().GetSize();
+  return KMDistanceKernel::ComputeDistance(
+      clusterInstance, centroids, parameters->GetKMeanAttributesLoadIndexes(),
+      distanceType);
+}
 
-  if (distanceType == KMParameters::L2Norm) {
+void KMCluster::UpdateEvaluationSufficientStatistics(
+    const KWObject *instance) {
 
-    for (int i = 0; i < size; i++) {
-      KWLoadIndex loadIndex =
-          parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-      if (not loadIndex.IsValid())
-        continue;
-      const Continuous d =
-          centroids.GetAt(i) - clusterInstance->GetContinuousValueAt(loadIndex);
-      result += (d * d);
-    }
-  } else {
-    if (distanceType == KMParameters::L1Norm) {
-      for (int i = 0; i < size; i++) {
-        KWLoadIndex loadIndex =
-            parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-        if (not loadIndex.IsValid())
-          continue;
-        result += fabs(centroids.GetAt(i) -
-                       clusterInstance->GetContinuousValueAt(loadIndex));
-      }
-    } else {
-      if (distanceType == KMParameters::CosineNorm) {
-        Continuous numerator = 0.0;
-        Continuous denominatorInstance = 0.0;
-        Continuous denominatorCentroid = 0.0;
-
-        for (int i = 0; i < size; i++) {
-          KWLoadIndex loadIndex =
-              parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-          if (not loadIndex.IsValid())
-            continue;
-          numerator += centroids.GetAt(i) *
-                       clusterInstance->GetContinuousValueAt(loadIndex);
-          denominatorInstance +=
-              pow(clusterInstance->GetContinuousValueAt(loadIndex), 2);
-          denominatorCentroid += pow(centroids.GetAt(i), 2);
-        }
-        Continuous denominator =
-            sqrt(denominatorInstance) * sqrt(denominatorCentroid);
-        result = 1 - (denominator == 0 ? 0 : numerator / denominator);
-      }
-    }
+  require(instance != NULL);
+  require(lFrequency > 0);
+
+  const KWLoadIndexVector &kmeanAttributesLoadIndexes =
+      parameters->GetKMeanAttributesLoadIndexes();
+  const int nbAttr = kmeanAttributesLoadIndexes.GetSize();
+
+  assert(cvModelingCentroidValues.GetSize() == nbAttr);
+
+  if (cvEvaluationSquaredDeviationsSums.GetSize() == 0) // premiere maj
+    InitializeEvaluationSufficientStatistics(nbAttr);
+
+  // norme de l'instance, pour la norme cosinus
+  Continuous norm = 0;
+  for (int i = 0; i < nbAttr; i++) {
+    const KWLoadIndex loadIndex = kmeanAttributesLoadIndexes.GetAt(i);
+    if (not loadIndex.IsValid())
+      continue;
+    const Continuous value = instance->GetContinuousValueAt(loadIndex);
+    norm += value * value;
   }
+  norm = sqrt(norm);
 
-  return result;
+  for (int i = 0; i < nbAttr; i++) {
+
+    const KWLoadIndex loadIndex = kmeanAttributesLoadIndexes.GetAt(i);
+    if (not loadIndex.IsValid())
+      // pas un attribut KMean
+      continue;
+
+    const Continuous value = instance->GetContinuousValueAt(loadIndex);
+
+    // algorithme de Welford : l'ecart au centroide d'evaluation avant sa maj,
+    // pondere par (n-1)/n, donne l'accroissement exact de la somme des carres
+    // des ecarts a la moyenne
+    const Continuous delta =
+        value - (cvEvaluationCentroidValues.GetSize() == 0
+                     ? 0
+                     : cvEvaluationCentroidValues.GetAt(i));
+    cvEvaluationSquaredDeviationsSums.SetAt(
+        i, cvEvaluationSquaredDeviationsSums.GetAt(i) +
+               delta * delta * (lFrequency - 1) / lFrequency);
+
+    // une instance nulle est a distance cosinus 1 de tout centroide, et ne
+    // contribue pas a la somme des instances normees
+    if (norm > 0)
+      cvEvaluationUnitInstancesSums.SetAt(
+          i, cvEvaluationUnitInstancesSums.GetAt(i) + value / norm);
+
+    // ecarts au centroide du modele, connu des la lecture de l'instance
+    const Continuous reference = cvModelingCentroidValues.GetAt(i);
+    cvEvaluationAbsoluteDeviationsSums.SetAt(
+        i, cvEvaluationAbsoluteDeviationsSums.GetAt(i) +
+               fabs(value - reference));
+    if (value < reference)
+      cvEvaluationBelowModelingCentroidCounts.SetAt(
+          i, cvEvaluationBelowModelingCentroidCounts.GetAt(i) + 1);
+    else if (value > reference)
+      cvEvaluationAboveModelingCentroidCounts.SetAt(
+          i, cvEvaluationAboveModelingCentroidCounts.GetAt(i) + 1);
+  }
+}
+
+void KMCluster::ComputeDistancesFromSufficientStatistics(
+    const boolean bInertyIntra) {
+
+  if (lFrequency == 0 or cvEvaluationCentroidValues.GetSize() == 0 or
+      cvEvaluationSquaredDeviationsSums.GetSize() == 0)
+    // cluster vide en evaluation
+    return;
+
+  const KWLoadIndexVector &kmeanAttributesLoadIndexes =
+      parameters->GetKMeanAttributesLoadIndexes();
+
+  assert(cvEvaluationSquaredDeviationsSums.GetSize() ==
+         cvEvaluationCentroidValues.GetSize());
+
+  Continuous distanceL1 = 0;
+  Continuous distanceL2 = 0;
+  Continuous numerator = 0;
+  Continuous centroidNorm = 0;
+
+  for (int i = 0; i < kmeanAttributesLoadIndexes.GetSize(); i++) {
+
+    if (not kmeanAttributesLoadIndexes.GetAt(i).IsValid())
+      continue;
+
+    const Continuous centroid = cvEvaluationCentroidValues.GetAt(i);
+
+    // L2 (distance au carre) : le centroide d'evaluation etant la moyenne des
+    // instances, la somme des distances est la somme des carres des ecarts
+    distanceL2 += cvEvaluationSquaredDeviationsSums.GetAt(i);
+
+    // cosinus : somme des (1 - <x, c> / (||x|| ||c||)) = n - <somme des x /
+    // ||x||, c> / ||c||
+    numerator += cvEvaluationUnitInstancesSums.GetAt(i) * centroid;
+    centroidNorm += centroid * centroid;
+
+    // L1 : f(t) = somme des |x - t| est convexe et lineaire par morceaux. Elle
+    // est connue au centroide du modele r, et on la prolonge jusqu'au centroide
+    // d'evaluation c avec sa pente en r, du cote de c. L'estimation est exacte
+    // si aucune instance n'a de valeur strictement comprise entre r et c, et
+    // minore la somme exacte sinon
+    const Continuous reference = cvModelingCentroidValues.GetAt(i);
+    const Continuous slope =
+        (centroid >= reference
+             ? lFrequency -
+                   2 * cvEvaluationAboveModelingCentroidCounts.GetAt(i)
+             : 2 * cvEvaluationBelowModelingCentroidCounts.GetAt(i) -
+                   lFrequency);
+    const Continuous estimate = cvEvaluationAbsoluteDeviationsSums.GetAt(i) +
+                                slope * (centroid - reference);
+    distanceL1 += (estimate > 0 ? estimate : 0);
+  }
+
+  const Continuous distanceCosine =
+      lFrequency -
+      (centroidNorm > 0 ? numerator / sqrt(centroidNorm) : 0);
+
+  cvDistancesSum.SetAt(KMParameters::L1Norm, distanceL1);
+  cvDistancesSum.SetAt(KMParameters::L2Norm, distanceL2);
+  cvDistancesSum.SetAt(KMParameters::CosineNorm, distanceCosine);
+
+  // les inerties intra seront divisees par la frequence lors de la
+  // finalisation
+  if (bInertyIntra) {
+    cvInertyIntra.SetAt(KMParameters::L1Norm, distanceL1);
+    cvInertyIntra.SetAt(KMParameters::L2Norm, distanceL2);
+    cvInertyIntra.SetAt(KMParameters::CosineNorm, distanceCosine);
+  }
+}
+
+void KMCluster::InitializeEvaluationSufficientStatistics(const int nSize) {
+
+  cvEvaluationSquaredDeviationsSums.SetSize(nSize);
+  cvEvaluationSquaredDeviationsSums.Initialize();
+  cvEvaluationUnitInstancesSums.SetSize(nSize);
+  cvEvaluationUnitInstancesSums.Initialize();
+  cvEvaluationAbsoluteDeviationsSums.SetSize(nSize);
+  cvEvaluationAbsoluteDeviationsSums.Initialize();
+  cvEvaluationBelowModelingCentroidCounts.SetSize(nSize);
+  cvEvaluationBelowModelingCentroidCounts.Initialize();
+  cvEvaluationAboveModelingCentroidCounts.SetSize(nSize);
+  cvEvaluationAboveModelingCentroidCounts.Initialize();
 }
 
 void KMCluster::FinalizeStatisticsUpdateFromInstances() {
@@ -1234,6 +1390,126 @@ void KMCluster::FinalizeStatisticsUpdateFromInstances() {
     dCompactness = 0;
 }
 
+void KMCluster::AggregateEvaluationStatistics(
+    const KMCluster *source, const IntVector &ivTargetValueIndexes) {
+
+  require(source != NULL);
+  require(source->cvTargetProbs.GetSize() == 0 or
+          source->lFrequency == 0 or
+          ivTargetValueIndexes.GetSize() == source->cvTargetProbs.GetSize());
+
+  // stats de premiere lecture : le cluster source n'en porte que s'il a recu
+  // des instances (sinon, ses probas cibles sont celles du modele)
+  if (source->lFrequency > 0) {
+
+    // comme pour la mise a jour instance par instance, les probas cibles
+    // issues du modele sont remplacees par des comptages
+    if (lFrequency == 0)
+      cvTargetProbs.Initialize();
+
+    for (int i = 0; i < source->cvTargetProbs.GetSize(); i++) {
+      const int nTarget = ivTargetValueIndexes.GetAt(i);
+      if (nTarget >= cvTargetProbs.GetSize())
+        cvTargetProbs.SetSize(nTarget + 1);
+      cvTargetProbs.SetAt(nTarget, cvTargetProbs.GetAt(nTarget) +
+                                       source->cvTargetProbs.GetAt(i));
+    }
+
+    // statistiques suffisantes d'une evaluation en une seule lecture. La somme
+    // des carres des ecarts a la moyenne est corrigee de l'ecart entre les deux
+    // moyennes (formule de Chan et al.) : elle doit donc etre agregee avant le
+    // centroide d'evaluation
+    if (source->cvEvaluationSquaredDeviationsSums.GetSize() > 0) {
+
+      if (cvEvaluationSquaredDeviationsSums.GetSize() == 0)
+        InitializeEvaluationSufficientStatistics(
+            source->cvEvaluationSquaredDeviationsSums.GetSize());
+
+      assert(cvEvaluationSquaredDeviationsSums.GetSize() ==
+             source->cvEvaluationSquaredDeviationsSums.GetSize());
+
+      for (int i = 0; i < cvEvaluationSquaredDeviationsSums.GetSize(); i++) {
+
+        Continuous correction = 0;
+        if (lFrequency > 0) {
+          const Continuous delta = source->cvEvaluationCentroidValues.GetAt(i) -
+                                   cvEvaluationCentroidValues.GetAt(i);
+          correction = delta * delta *
+                       ((Continuous)lFrequency * source->lFrequency) /
+                       (lFrequency + source->lFrequency);
+        }
+
+        cvEvaluationSquaredDeviationsSums.SetAt(
+            i, cvEvaluationSquaredDeviationsSums.GetAt(i) +
+                   source->cvEvaluationSquaredDeviationsSums.GetAt(i) +
+                   correction);
+        cvEvaluationUnitInstancesSums.SetAt(
+            i, cvEvaluationUnitInstancesSums.GetAt(i) +
+                   source->cvEvaluationUnitInstancesSums.GetAt(i));
+        cvEvaluationAbsoluteDeviationsSums.SetAt(
+            i, cvEvaluationAbsoluteDeviationsSums.GetAt(i) +
+                   source->cvEvaluationAbsoluteDeviationsSums.GetAt(i));
+        cvEvaluationBelowModelingCentroidCounts.SetAt(
+            i, cvEvaluationBelowModelingCentroidCounts.GetAt(i) +
+                   source->cvEvaluationBelowModelingCentroidCounts.GetAt(i));
+        cvEvaluationAboveModelingCentroidCounts.SetAt(
+            i, cvEvaluationAboveModelingCentroidCounts.GetAt(i) +
+                   source->cvEvaluationAboveModelingCentroidCounts.GetAt(i));
+      }
+    }
+
+    // centroide d'evaluation : moyenne ponderee par les frequences
+    if (lFrequency == 0)
+      cvEvaluationCentroidValues.CopyFrom(&source->cvEvaluationCentroidValues);
+    else {
+      assert(cvEvaluationCentroidValues.GetSize() ==
+             source->cvEvaluationCentroidValues.GetSize());
+      const longint lTotalFrequency = lFrequency + source->lFrequency;
+      for (int i = 0; i < cvEvaluationCentroidValues.GetSize(); i++)
+        cvEvaluationCentroidValues.SetAt(
+            i, (cvEvaluationCentroidValues.GetAt(i) * lFrequency +
+                source->cvEvaluationCentroidValues.GetAt(i) *
+                    source->lFrequency) /
+                   lTotalFrequency);
+    }
+
+    // sommes des attributs natifs continus (divisees lors de la finalisation)
+    if (cvNativeAttributesContinuousMeanValues.GetSize() == 0) {
+      cvNativeAttributesContinuousMeanValues.SetSize(
+          source->cvNativeAttributesContinuousMeanValues.GetSize());
+      cvNativeAttributesContinuousMeanValues.Initialize();
+    }
+    for (int i = 0; i < source->cvNativeAttributesContinuousMeanValues.GetSize();
+         i++)
+      cvNativeAttributesContinuousMeanValues.SetAt(
+          i, cvNativeAttributesContinuousMeanValues.GetAt(i) +
+                 source->cvNativeAttributesContinuousMeanValues.GetAt(i));
+
+    // valeurs manquantes des attributs natifs
+    if (ivMissingNativeValues.GetSize() == 0 and
+        source->ivMissingNativeValues.GetSize() > 0) {
+      ivMissingNativeValues.SetSize(source->ivMissingNativeValues.GetSize());
+      ivMissingNativeValues.Initialize();
+    }
+    for (int i = 0; i < source->ivMissingNativeValues.GetSize(); i++)
+      ivMissingNativeValues.SetAt(i, ivMissingNativeValues.GetAt(i) +
+                                         source->ivMissingNativeValues.GetAt(i));
+
+    lFrequency += source->lFrequency;
+  }
+
+  // stats de seconde lecture, qui dependent des centroides d'evaluation
+  for (int i = 0; i < cvDistancesSum.GetSize(); i++)
+    cvDistancesSum.SetAt(i, cvDistancesSum.GetAt(i) +
+                                source->cvDistancesSum.GetAt(i));
+
+  for (int i = 0; i < cvInertyIntra.GetSize(); i++)
+    cvInertyIntra.SetAt(i, cvInertyIntra.GetAt(i) +
+                               source->cvInertyIntra.GetAt(i));
+
+  dCompactness += source->dCompactness;
+}
+
 KMCluster *KMCluster::Clone() {
   require(bStatisticsUpToDate); // ne pas creer un clone dont les stats n'ont
                                 // pas été calculées ou "rafraichies"
@@ -1259,6 +1535,16 @@ void KMCluster::CopyFrom(const KMCluster *aSource) {
   cvNativeAttributesContinuousMedianValues.CopyFrom(
       &aSource->cvNativeAttributesContinuousMedianValues);
   cvDistancesSum.CopyFrom(&aSource->cvDistancesSum);
+  cvEvaluationSquaredDeviationsSums.CopyFrom(
+      &aSource->cvEvaluationSquaredDeviationsSums);
+  cvEvaluationUnitInstancesSums.CopyFrom(
+      &aSource->cvEvaluationUnitInstancesSums);
+  cvEvaluationAbsoluteDeviationsSums.CopyFrom(
+      &aSource->cvEvaluationAbsoluteDeviationsSums);
+  cvEvaluationBelowModelingCentroidCounts.CopyFrom(
+      &aSource->cvEvaluationBelowModelingCentroidCounts);
+  cvEvaluationAboveModelingCentroidCounts.CopyFrom(
+      &aSource->cvEvaluationAboveModelingCentroidCounts);
   cvInertyIntra.CopyFrom(&aSource->cvInertyIntra);
   cvInertyIntraL1ByAttributes.CopyFrom(&aSource->cvInertyIntraL1ByAttributes);
   cvInertyIntraL2ByAttributes.CopyFrom(&aSource->cvInertyIntraL2ByAttributes);
@@ -1266,6 +1552,7 @@ void KMCluster::CopyFrom(const KMCluster *aSource) {
       &aSource->cvInertyIntraCosineByAttributes);
   cvInertyInter.CopyFrom(&aSource->cvInertyInter);
   cvTargetProbs.CopyFrom(&aSource->cvTargetProbs);
+  ivMissingNativeValues.CopyFrom(&aSource->ivMissingNativeValues);
   lFrequency = aSource->lFrequency;
   dCoverage = aSource->dCoverage;
   dMinDistanceFromCentroid = aSource->dMinDistanceFromCentroid;
@@ -1291,6 +1578,7 @@ void KMCluster::CopyFrom(const KMCluster *aSource) {
   nearestCluster = aSource->nearestCluster;
 
   RemoveAll(); // enleve les instances eventuellement existantes
+  bRunningSumsUpToDate = false;
 }
 
 void KMCluster::SetTargetProbs(const ContinuousVector &source) {
@@ -1373,120 +1661,24 @@ void KMCluster::ComputeNativeAttributesContinuousMeanValues() {
   }
 }
 
-void KMCluster::ComputeNativeAttributesContinuousMedianValues() {
-
-  if (GetCount() == 0) {
-    AddWarning("Can't compute native attributes continuous median values, on "
-               "cluster " +
-               sLabel + ", because it does not contain any element.");
-    return;
-  }
-
-  const KWClass *kwc = NULL;
-  ObjectArray *continuousValues = NULL;
-  int idxInstance = 0;
-
-  const KWLoadIndexVector &nativeAttributesLoadIndexes =
-      parameters->GetNativeAttributesLoadIndexes();
-  const int nbNativeAttributes = nativeAttributesLoadIndexes.GetSize();
-
-  // parcourir toutes les instances du cluster
+void KMCluster::ComputeNativeAttributesContinuousMedianValues(
+    const ObjectArray &oaSketches) {
 
-  NUMERIC key;
-  Object *oCurrent;
-  POSITION position = GetStartPosition();
+  cvNativeAttributesContinuousMedianValues.SetSize(
+      parameters->GetNativeAttributesLoadIndexes().GetSize());
+  cvNativeAttributesContinuousMedianValues.Initialize();
 
-  while (position != NULL) {
-
-    GetNextAssoc(position, key, oCurrent);
-    KWObject *instance = static_cast<KWObject *>(oCurrent);
-
-    if (instance != NULL) {
-
-      if (kwc == NULL) {
-        kwc = instance->GetClass();
-        cvNativeAttributesContinuousMedianValues.SetSize(
-            kwc->GetLoadedAttributeNumber()); // vecteur des valeurs finales de
-                                              // medianes
-        cvNativeAttributesContinuousMedianValues.Initialize();
-
-        // initialisation du vecteur de vecteurs qui contiendra les valeurs
-        // continues des attributs natifs
-        continuousValues = new ObjectArray;
-        continuousValues->SetSize(kwc->GetLoadedAttributeNumber());
-        for (int i = 0; i < continuousValues->GetSize(); i++) {
-          ContinuousVector *continuousValuesByAttribute = new ContinuousVector;
-          continuousValuesByAttribute->SetSize(GetCount());
-          continuousValuesByAttribute->Initialize();
-          continuousValues->SetAt(i, continuousValuesByAttribute);
-        }
-      }
-
-      // parcourir tous les attributs natifs de cette instance de cluster, et
-      // stocker les valeurs continues dans les vecteurs correspondants
-
-      for (int i = 0; i < nbNativeAttributes; i++) {
-
-        const KWLoadIndex loadIndex = nativeAttributesLoadIndexes.GetAt(i);
-        if (not(loadIndex.IsValid()))
-          continue;
-
-        KWAttribute *native =
-            instance->GetClass()->GetAttributeAtLoadIndex(loadIndex);
-        assert(native != NULL);
-
-        if (native->GetType() == KWType::Continuous and
-            instance->GetContinuousValueAt(native->GetLoadIndex()) !=
-                KWContinuous::GetMissingValue()) {
-          ContinuousVector *continuousValuesByAttribute =
-              cast(ContinuousVector *, continuousValues->GetAt(i));
-          assert(continuousValuesByAttribute != NULL);
-          continuousValuesByAttribute->SetAt(
-              idxInstance, instance->GetContinuousValueAt(loadIndex));
-          cvNativeAttributesContinuousMedianValues.SetAt(
-              i, cvNativeAttributesContinuousMedianValues.GetAt(i) +
-                     instance->GetContinuousValueAt(loadIndex));
-        }
-      }
-    }
-    idxInstance++;
-  }
-
-  assert(kwc != NULL);
-
-  // trier tous les vecteurs obtenus (un par attribut), par ordre croissant, et
-  // en deduire la mediane
-  for (int idxAttribute = 0; idxAttribute < continuousValues->GetSize();
+  for (int idxAttribute = 0; idxAttribute < oaSketches.GetSize();
        idxAttribute++) {
 
-    ContinuousVector *continuousValuesByAttribute =
-        cast(ContinuousVector *, continuousValues->GetAt(idxAttribute));
+    const KMQuantileSketch *sketch =
+        cast(KMQuantileSketch *, oaSketches.GetAt(idxAttribute));
 
-    if (continuousValuesByAttribute->GetSize() == 1) {
-      // cas particulier : une seule instance dans la base
-      cvNativeAttributesContinuousMedianValues.SetAt(
-          idxAttribute, continuousValuesByAttribute->GetAt(0));
-    } else {
-      // si au moins 2 valeurs : calcul de la valeur mediane, selon la parite de
-      // la taille du tableau de valeurs
-      continuousValuesByAttribute->Sort();
-      if (continuousValuesByAttribute->GetSize() % 2 == 0)
-        cvNativeAttributesContinuousMedianValues.SetAt(
-            idxAttribute, (continuousValuesByAttribute->GetAt(
-                               continuousValuesByAttribute->GetSize() / 2 - 1) +
-                           continuousValuesByAttribute->GetAt(
-                               continuousValuesByAttribute->GetSize() / 2)) /
-                              2);
-      else
-        cvNativeAttributesContinuousMedianValues.SetAt(
-            idxAttribute, continuousValuesByAttribute->GetAt(
-                              continuousValuesByAttribute->GetSize() / 2));
-    }
-  }
+    if (sketch == NULL or sketch->GetCount() == 0)
+      continue;
 
-  if (continuousValues != NULL) {
-    continuousValues->DeleteAll();
-    delete continuousValues;
+    cvNativeAttributesContinuousMedianValues.SetAt(idxAttribute,
+                                                   sketch->ComputeMedian());
   }
 }
 
@@ -1674,6 +1866,7 @@ void PLShared_Cluster::SerializeObject(PLSerializer *serializer,
                                        const Object *object) const {
   KMCluster *cluster;
   PLShared_ContinuousVector sharedContinuousVector;
+  PLShared_IntVector sharedIntVector;
 
   require(serializer != NULL);
   require(serializer->IsOpenForWrite());
@@ -1682,12 +1875,35 @@ void PLShared_Cluster::SerializeObject(PLSerializer *serializer,
   cluster = cast(KMCluster *, object);
   sharedContinuousVector.SerializeObject(serializer, &(cluster->cvTargetProbs));
   serializer->PutLongint(cluster->lFrequency);
+
+  // stats incrementales d'evaluation, non finalisees
+  sharedContinuousVector.SerializeObject(
+      serializer, &(cluster->cvEvaluationCentroidValues));
+  sharedContinuousVector.SerializeObject(
+      serializer, &(cluster->cvNativeAttributesContinuousMeanValues));
+  sharedIntVector.SerializeObject(serializer, &(cluster->ivMissingNativeValues));
+  sharedContinuousVector.SerializeObject(serializer, &(cluster->cvDistancesSum));
+  sharedContinuousVector.SerializeObject(serializer, &(cluster->cvInertyIntra));
+  serializer->PutDouble(cluster->dCompactness);
+
+  // statistiques suffisantes d'une evaluation en une seule lecture
+  sharedContinuousVector.SerializeObject(
+      serializer, &(cluster->cvEvaluationSquaredDeviationsSums));
+  sharedContinuousVector.SerializeObject(
+      serializer, &(cluster->cvEvaluationUnitInstancesSums));
+  sharedContinuousVector.SerializeObject(
+      serializer, &(cluster->cvEvaluationAbsoluteDeviationsSums));
+  sharedContinuousVector.SerializeObject(
+      serializer, &(cluster->cvEvaluationBelowModelingCentroidCounts));
+  sharedContinuousVector.SerializeObject(
+      serializer, &(cluster->cvEvaluationAboveModelingCentroidCounts));
 }
 
 void PLShared_Cluster::DeserializeObject(PLSerializer *serializer,
                                          Object *object) const {
   KMCluster *cluster;
   PLShared_ContinuousVector sharedContinuousVector;
+  PLShared_IntVector sharedIntVector;
 
   require(serializer->IsOpenForRead());
 
@@ -1697,6 +1913,29 @@ void PLShared_Cluster::DeserializeObject(PLSerializer *serializer,
   sharedContinuousVector.DeserializeObject(serializer,
                                            &(cluster->cvTargetProbs));
   cluster->lFrequency = serializer->GetLongint();
+
+  sharedContinuousVector.DeserializeObject(
+      serializer, &(cluster->cvEvaluationCentroidValues));
+  sharedContinuousVector.DeserializeObject(
+      serializer, &(cluster->cvNativeAttributesContinuousMeanValues));
+  sharedIntVector.DeserializeObject(serializer,
+                                    &(cluster->ivMissingNativeValues));
+  sharedContinuousVector.DeserializeObject(serializer,
+                                           &(cluster->cvDistancesSum));
+  sharedContinuousVector.DeserializeObject(serializer,
+                                           &(cluster->cvInertyIntra));
+  cluster->dCompactness = serializer->GetDouble();
+
+  sharedContinuousVector.DeserializeObject(
+      serializer, &(cluster->cvEvaluationSquaredDeviationsSums));
+  sharedContinuousVector.DeserializeObject(
+      serializer, &(cluster->cvEvaluationUnitInstancesSums));
+  sharedContinuousVector.DeserializeObject(
+      serializer, &(cluster->cvEvaluationAbsoluteDeviationsSums));
+  sharedContinuousVector.DeserializeObject(
+      serializer, &(cluster->cvEvaluationBelowModelingCentroidCounts));
+  sharedContinuousVector.DeserializeObject(
+      serializer, &(cluster->cvEvaluationAboveModelingCentroidCounts));
 }
 
 Object *PLShared_Cluster::Create() const { return new KMCluster(NULL); }
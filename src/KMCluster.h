@@ -75,6 +75,10 @@ public:
   /** obtenir la distance totale des instances vis a vis du centre du cluster */
   const Continuous GetDistanceSum(KMParameters::DistanceType) const;
 
+  /** modifier la distance totale des instances vis a vis du centre du cluster
+   * (restitution d'un etat memorise) */
+  void SetDistanceSum(KMParameters::DistanceType, const Continuous);
+
   /** initialiser les valeurs du centroide a partir d'une instance de BDD */
   void InitializeModelingCentroidValues(const KWObject *);
 
@@ -195,7 +199,7 @@ public:
 
   /** calculer les statistiques de fin d'iteration, sur l'ensemble des instances
    * du cluster, pendant un clustering */
-  void ComputeIterationStatistics();
+  void ComputeIterationStatistics(const bool bComputeDistanceSum = true);
 
   /** mettre a jour la somme des distances des instances par rapport au centre
    * du cluster, sur l'ensemble des instances du cluster */
@@ -205,13 +209,11 @@ public:
    * l'ensemble des instances du cluster */
   void ComputeMeanModelingCentroidValues();
 
-  /** mettre a jour les valeurs du centroide de modeling, en mode de calcul
-   * "mediane", sur l'ensemble des instances du cluster */
-  void ComputeMedianModelingCentroidValues();
-
-  /** mettre a jour les valeurs du centroide d'evaluation, en mode de calcul
-   * "mediane", sur l'ensemble des instances du cluster */
-  void ComputeMedianEvaluationCentroidValues();
+  /** initialisation des sommes courantes a partir de sommes calculees par
+   * ailleurs (postes = index des attributs K-Means), pour les instances
+   * actuellement presentes dans le cluster : les calculs de centroides
+   * ulterieurs se font alors en O(nombre d'attributs) */
+  void InitializeRunningSums(const ContinuousVector &cvSums);
 
   /** determiner quelle est l'instance la plus proche du centre virtuel, sur
    * l'ensemble des instances du cluster */
@@ -225,6 +227,21 @@ public:
    * l'ensemble des instances du cluster */
   const Continuous ComputeInertyIntra(KMParameters::DistanceType);
 
+  /** dimensionnement des inerties intra par attribut : ComputeFinalStatistics
+   * ne fait alors plus d'allocation memoire, et peut etre appele dans un
+   * thread */
+  void ReserveFinalStatistics();
+
+  /** statistiques de fin d'apprentissage, en une seule passe sur les instances
+   * du cluster (non vide) : sommes des distances au centroide pour toutes les
+   * normes, inertie intra globale et par attribut pour la norme choisie, et
+   * reperage des instances la plus proche et la plus eloignee du centroide */
+  void ComputeFinalStatistics(KMParameters::DistanceType);
+
+  /** creation des instances la plus proche et la plus eloignee du centroide,
+   * reperees par ComputeFinalStatistics (allocation memoire : hors threads) */
+  void ComputeFinalStatisticsInstances();
+
   /** calcul de l'inertie intra du cluster, pour un attribut particulier, sur
    * l'ensemble des instances du cluster */
   const Continuous ComputeInertyIntraForAttribute(const int attributeRank,
@@ -247,10 +264,6 @@ public:
    * des instances du cluster */
   void ComputeNativeAttributesContinuousMeanValues();
 
-  /** calcul des medianes, pour les attributs de type Continuous, sur l'ensemble
-   * des instances du cluster */
-  void ComputeNativeAttributesContinuousMedianValues();
-
   /** calcul de la repartition des valeurs reelles de l'attribut cible (mode
    * supervisé), sur l'ensemble des instances du cluster */
   void ComputeTrainingTargetProbs(const ObjectArray &targetAttributeValues,
@@ -316,11 +329,55 @@ public:
                                      const int attributeLoadIndex,
                                      KMParameters::DistanceType);
 
+  /** mise a jour incrementale des statistiques suffisantes d'evaluation en une
+   * seule lecture de base (cf. ComputeDistancesFromSufficientStatistics). A
+   * appeler apres la maj de la frequence, et avant celle du centroide
+   * d'evaluation */
+  void UpdateEvaluationSufficientStatistics(const KWObject *newInstance);
+
+  /** calcul des sommes de distances (et si demande, des inerties intra) au
+   * centroide d'evaluation, a partir des statistiques suffisantes, en lieu et
+   * place d'une seconde lecture de base. Exact en normes L2 et cosinus, estime
+   * en norme L1 */
+  void ComputeDistancesFromSufficientStatistics(const boolean bInertyIntra);
+
   /** finalisation du calcul des stats incerementales (c'est a dire, calculees
    * instance par instance) */
   void FinalizeStatisticsUpdateFromInstances();
 
+  // agregation des stats incrementales calculees sur des parties distinctes de
+  // la base (taches d'evaluation paralleles)
+
+  /** ajout des stats incrementales non finalisees d'un cluster source
+   * (frequence, centroide d'evaluation, sommes des attributs natifs, valeurs
+   * manquantes, occurences cibles, statistiques suffisantes, sommes des
+   * distances, inerties intra et compacite). ivTargetValueIndexes donne, pour chaque poste des probas
+   * cibles du cluster source, le poste correspondant dans le cluster courant */
+  void AggregateEvaluationStatistics(const KMCluster *source,
+                                     const IntVector &ivTargetValueIndexes);
+
+  /** initialiser les valeurs du centroide d'evaluation (calculees par ailleurs,
+   * par exemple par le maitre d'une tache parallele) */
+  void SetEvaluationCentroidValues(const ContinuousVector &);
+
+  /** initialiser la valeur majoritaire de la cible, et son index */
+  void SetMajorityTargetValue(const ALString &sValue, const int nIndex);
+
+  /** calcul des medianes des attributs natifs continus, a partir de resumes
+   * de quantiles deja alimentes (un KMQuantileSketch des valeurs non
+   * manquantes par rang d'attribut natif), et non des instances du cluster */
+  void
+  ComputeNativeAttributesContinuousMedianValues(const ObjectArray &oaSketches);
+
 protected:
+  /** mise a jour des sommes courantes, lors de l'ajout (sign = 1) ou de la
+   * suppression (sign = -1) d'une instance */
+  void UpdateRunningSums(const KWObject *instance, const int sign);
+
+  /** dimensionnement et mise a zero des statistiques suffisantes d'une
+   * evaluation en une seule lecture de base */
+  void InitializeEvaluationSufficientStatistics(const int nSize);
+
   // attributs
 
   /** parametrage du clustering */
@@ -333,6 +390,31 @@ protected:
   /** valeurs du centroide (centre virtuel) */
   ContinuousVector cvModelingCentroidValues;
 
+  /** sommes courantes des valeurs K-Means des instances du cluster (postes =
+   * index des attributs K-Means), mises a jour a chaque ajout ou suppression
+   * d'instance : le centroide moyen est alors obtenu sans rebalayer les
+   * instances */
+  ContinuousVector cvRunningSums;
+
+  /** indique si les sommes courantes ont ete initialisees, par un calcul
+   * complet ou par InitializeRunningSums. NB. sur le chemin de la matrice
+   * dense des instances, les sommes sont tenues par cluster dans KMClustering
+   * pendant les iterations, puis reportees ici en fin de replicate, lors du
+   * remplissage des instances des clusters */
+  bool bRunningSumsUpToDate;
+
+  /** nombre d'instances prises en compte par les sommes courantes. Les
+   * instances peuvent etre modifiees sans passer par AddInstance et
+   * RemoveInstance (methodes RemoveAll, DeleteAll, SetAt de
+   * NumericKeyDictionary) : un nombre different de GetCount() lors d'un ajout,
+   * d'une suppression ou d'un calcul de centroide invalide les sommes */
+  longint lRunningSumsCount;
+
+  /** nombre de mises a jour incrementales des sommes courantes depuis leur
+   * dernier calcul complet (au dela du nombre d'instances, on refait un calcul
+   * complet, afin de borner l'accumulation des erreurs d'arrondi) */
+  longint lRunningSumsUpdates;
+
   /** valeurs initiales du centroide, avant convergence (centre virtuel) */
   ContinuousVector cvInitialCentroidValues;
 
@@ -343,6 +425,27 @@ protected:
   /** somme des distances des instances par rapport au centre */
   ContinuousVector cvDistancesSum;
 
+  // statistiques suffisantes d'une evaluation en une seule lecture de base
+  // (postes = rangs des attributs K-Means)
+
+  /** sommes des carres des ecarts au centroide d'evaluation courant
+   * (algorithme de Welford) */
+  ContinuousVector cvEvaluationSquaredDeviationsSums;
+
+  /** sommes des instances normees (x / ||x||), pour la norme cosinus */
+  ContinuousVector cvEvaluationUnitInstancesSums;
+
+  /** sommes des ecarts absolus au centroide du modele, pour la norme L1 */
+  ContinuousVector cvEvaluationAbsoluteDeviationsSums;
+
+  /** nombres d'instances dont la valeur est inferieure a celle du centroide du
+   * modele */
+  ContinuousVector cvEvaluationBelowModelingCentroidCounts;
+
+  /** nombres d'instances dont la valeur est superieure a celle du centroide du
+   * modele */
+  ContinuousVector cvEvaluationAboveModelingCentroidCounts;
+
   /** inertie intra du cluster, tous attributs confondus (une valeur par type de
    * distance) */
   ContinuousVector cvInertyIntra;
@@ -396,6 +499,11 @@ protected:
   /** instance reelle la plus eloignee du centroide du cluster */
   KMClusterInstance *instanceFurthestToCentroid;
 
+  /** instances la plus proche et la plus eloignee du centroide, reperees par
+   * ComputeFinalStatistics (NULL si aucune) */
+  KWObject *kwoFinalNearestInstance;
+  KWObject *kwoFinalFurthestInstance;
+
   /** cluster le plus proche de ce cluster */
   KMCluster *nearestCluster;
 
@@ -452,14 +560,24 @@ inline const double KMCluster::GetCompactness() const { return dCompactness; }
 
 inline void KMCluster::AddInstance(KWObject *o) {
   require(o != NULL);
+  const int nCount = GetCount();
   this->SetAt(o, o); // La valeur n'est nécessaire qu'afin de pouvoir faire un
                      // DeleteAll(), à la fin de l'évaluation (cf. methode
                      // KMClassifierEvaluation::Evaluate() )
+  if (bRunningSumsUpToDate and lRunningSumsCount != nCount)
+    bRunningSumsUpToDate = false;
+  if (bRunningSumsUpToDate and GetCount() > nCount)
+    UpdateRunningSums(o, 1);
   bStatisticsUpToDate = false;
 }
 
 inline KWObject *KMCluster::RemoveInstance(KWObject *o) {
+  const int nCount = GetCount();
+  if (bRunningSumsUpToDate and lRunningSumsCount != nCount)
+    bRunningSumsUpToDate = false;
   this->RemoveKey(o);
+  if (bRunningSumsUpToDate and GetCount() < nCount)
+    UpdateRunningSums(o, -1);
   bStatisticsUpToDate = false;
   return (o);
 }
@@ -507,6 +625,10 @@ inline const Continuous
 KMCluster::GetDistanceSum(KMParameters::DistanceType d) const {
   return cvDistancesSum.GetAt(d);
 }
+inline void KMCluster::SetDistanceSum(KMParameters::DistanceType d,
+                                      const Continuous cValue) {
+  cvDistancesSum.SetAt(d, cValue);
+}
 inline const Continuous
 KMCluster::GetInertyIntra(KMParameters::DistanceType d) const {
   return cvInertyIntra.GetAt(d);
@@ -551,6 +673,17 @@ inline KMCluster *KMCluster::GetNearestCluster() const {
   return nearestCluster;
 }
 
+inline void
+KMCluster::SetEvaluationCentroidValues(const ContinuousVector &cvValues) {
+  cvEvaluationCentroidValues.CopyFrom(&cvValues);
+}
+
+inline void KMCluster::SetMajorityTargetValue(const ALString &sValue,
+                                              const int nIndex) {
+  sMajorityTargetValue = sValue;
+  iMajorityTargetIndex = nIndex;
+}
+
 inline const ALString &KMCluster::GetMajorityTargetValue() const {
   return sMajorityTargetValue;
 }
@@ -0,0 +1,93 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMClusterMembership.h"
+
+KMClusterMembership::KMClusterMembership()
+{
+	bClustersListsUpToDate = false;
+}
+
+KMClusterMembership::~KMClusterMembership()
+{
+}
+
+void KMClusterMembership::Initialize(const int nPositionNumber)
+{
+	require(nPositionNumber >= 0);
+
+	ivClustersIndexes.SetSize(nPositionNumber);
+	for (int i = 0; i < nPositionNumber; i++)
+		ivClustersIndexes.SetAt(i, -1);
+
+	ivClustersStarts.SetSize(0);
+	ivClustersPositions.SetSize(0);
+	bClustersListsUpToDate = false;
+}
+
+void KMClusterMembership::RemoveClusterIndex(const int nClusterIndex)
+{
+	require(nClusterIndex >= 0);
+
+	for (int i = 0; i < ivClustersIndexes.GetSize(); i++) {
+		const int idCluster = ivClustersIndexes.GetAt(i);
+		if (idCluster == nClusterIndex)
+			ivClustersIndexes.SetAt(i, -1);
+		else
+			if (idCluster > nClusterIndex)
+				ivClustersIndexes.SetAt(i, idCluster - 1);
+	}
+	bClustersListsUpToDate = false;
+}
+
+void KMClusterMembership::BuildClustersLists(const int nClusterNumber)
+{
+	require(nClusterNumber >= 0);
+
+	// denombrement des positions de chaque cluster (decale d'un rang, pour obtenir directement les debuts de listes par cumul)
+	ivClustersStarts.SetSize(nClusterNumber + 1);
+	ivClustersStarts.Initialize();
+
+	int nAssignedNumber = 0;
+	for (int i = 0; i < ivClustersIndexes.GetSize(); i++) {
+		const int idCluster = ivClustersIndexes.GetAt(i);
+		if (idCluster != -1) {
+			assert(idCluster < nClusterNumber);
+			ivClustersStarts.UpgradeAt(idCluster + 1, 1);
+			nAssignedNumber++;
+		}
+	}
+
+	for (int k = 0; k < nClusterNumber; k++)
+		ivClustersStarts.UpgradeAt(k + 1, ivClustersStarts.GetAt(k));
+
+	// rangement des positions, par positions croissantes au sein de chaque cluster
+	ivClustersPositions.SetSize(nAssignedNumber);
+
+	for (int i = 0; i < ivClustersIndexes.GetSize(); i++) {
+		const int idCluster = ivClustersIndexes.GetAt(i);
+		if (idCluster != -1) {
+			ivClustersPositions.SetAt(ivClustersStarts.GetAt(idCluster), i);
+			ivClustersStarts.UpgradeAt(idCluster, 1);
+		}
+	}
+
+	// chaque debut de liste a ete avance jusqu'a la fin de sa liste, c'est a dire jusqu'au debut de la liste suivante : on les retablit
+	for (int k = nClusterNumber; k > 0; k--)
+		ivClustersStarts.SetAt(k, ivClustersStarts.GetAt(k - 1));
+	ivClustersStarts.SetAt(0, 0);
+
+	bClustersListsUpToDate = true;
+}
+
+longint KMClusterMembership::GetUsedMemory() const
+{
+	return sizeof(KMClusterMembership) + ivClustersIndexes.GetUsedMemory() - sizeof(IntVector) + ivClustersStarts.GetUsedMemory() - sizeof(IntVector) +
+	       ivClustersPositions.GetUsedMemory() - sizeof(IntVector);
+}
+
+const ALString KMClusterMembership::GetClassLabel() const
+{
+	return "Cluster membership";
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "Vector.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Appartenance des instances d'une liste aux clusters, reperees par leur position dans la liste : un tableau plat donne l'index du cluster de chaque position
+/// (-1 si l'instance n'est affectee a aucun cluster). Un changement de cluster se fait en temps constant, sans insertion ni suppression dans une table de hachage.
+/// Les listes de positions de chaque cluster sont reconstruites a la demande par tri par denombrement : elles sont rangees de facon contigue dans un unique
+/// tableau, chaque liste etant ordonnee par positions croissantes.
+
+class KMClusterMembership : public Object
+{
+public:
+
+	KMClusterMembership();
+	~KMClusterMembership();
+
+	/** dimensionnement pour un nombre de positions, aucune position n'etant affectee */
+	void Initialize(const int nPositionNumber);
+
+	/** nombre de positions */
+	int GetPositionNumber() const;
+
+	/** index du cluster d'une position (-1 si non affectee) */
+	int GetClusterIndexAt(const int nPosition) const;
+
+	/** affectation d'une position a un cluster (-1 : aucun cluster). Invalide les listes de positions des clusters */
+	void SetClusterIndexAt(const int nPosition, const int nClusterIndex);
+
+	/** suppression d'un index de cluster : les positions du cluster ne sont plus affectees, et les index de clusters superieurs sont decrementes */
+	void RemoveClusterIndex(const int nClusterIndex);
+
+	/** reconstruction des listes de positions de chaque cluster, par tri par denombrement (temps lineaire en nombre de positions et de clusters) */
+	void BuildClustersLists(const int nClusterNumber);
+
+	/** indique si les listes de positions sont a jour vis a vis des affectations */
+	boolean AreClustersListsUpToDate() const;
+
+	/** nombre de clusters des listes de positions */
+	int GetClusterNumber() const;
+
+	/** nombre de positions d'un cluster, d'apres les listes */
+	int GetClusterFrequencyAt(const int nClusterIndex) const;
+
+	/** i-eme position d'un cluster, d'apres les listes */
+	int GetClusterPositionAt(const int nClusterIndex, const int i) const;
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	/** pour chaque position, index du cluster (-1 si aucun) */
+	IntVector ivClustersIndexes;
+
+	/** debut de la liste de chaque cluster dans ivClustersPositions (nombre de clusters + 1 valeurs) */
+	IntVector ivClustersStarts;
+
+	/** listes de positions des clusters, contigues */
+	IntVector ivClustersPositions;
+
+	boolean bClustersListsUpToDate;
+};
+
+inline int KMClusterMembership::GetPositionNumber() const {
+	return ivClustersIndexes.GetSize();
+}
+
+inline int KMClusterMembership::GetClusterIndexAt(const int nPosition) const {
+	return ivClustersIndexes.GetAt(nPosition);
+}
+
+inline void KMClusterMembership::SetClusterIndexAt(const int nPosition, const int nClusterIndex) {
+	assert(nClusterIndex >= -1);
+	ivClustersIndexes.SetAt(nPosition, nClusterIndex);
+	bClustersListsUpToDate = false;
+}
+
+inline boolean KMClusterMembership::AreClustersListsUpToDate() const {
+	return bClustersListsUpToDate;
+}
+
+inline int KMClusterMembership::GetClusterNumber() const {
+	return ivClustersStarts.GetSize() == 0 ? 0 : ivClustersStarts.GetSize() - 1;
+}
+
+inline int KMClusterMembership::GetClusterFrequencyAt(const int nClusterIndex) const {
+	assert(bClustersListsUpToDate);
+	return ivClustersStarts.GetAt(nClusterIndex + 1) - ivClustersStarts.GetAt(nClusterIndex);
+}
+
+inline int KMClusterMembership::GetClusterPositionAt(const int nClusterIndex, const int i) const {
+	assert(bClustersListsUpToDate);
+	assert(i >= 0 and i < GetClusterFrequencyAt(nClusterIndex));
+	return ivClustersPositions.GetAt(ivClustersStarts.GetAt(nClusterIndex) + i);
+}
@@ -5,7 +5,10 @@
 #include "KMClustering.h"
 #include "KMClusteringQuality.h"
 #include "KMClusteringInitializer.h"
+#include "KMDistanceKernel.h"
+#include "KMGlobalStatistics.h"
 #include <cmath>
+#include <thread>
 
 KMClustering::KMClustering(KMParameters* p)
 {
@@ -13,17 +16,26 @@ KMClustering::KMClustering(KMParameters* p)
 
 	parameters = p;
 	kmClusters = new ObjectArray();
-	kmBestClusters = new ObjectArray();
 	iIterationsDone = 0;
 	iDroppedClustersNumber = 0;
 	dUsedSampleNumberPercentage = 100.0;
 	cvClustersDistancesSum.SetSize(3); // 3 normes : L1, L2 et Cosinus
 	cvClustersDistancesSum.Initialize();
 	kmGlobalCluster = NULL;
-	clustersCentersDistances = new Continuous * [KMParameters::K_MAX_VALUE];
-	for (int i = 0; i < KMParameters::K_MAX_VALUE; i++)
-		clustersCentersDistances[i] = NULL;
+	bCentersDistancesEvaluationCentroids = false;
+	bCentersDistancesDenseCentroids = false;
 	instancesToClusters = new NumericKeyDictionary;
+	instancesMatrix = NULL;
+	instancesSparseMatrix = NULL;
+	oaMatrixInstances = NULL;
+	bInstancesBoundsUpToDate = false;
+	bMembershipSumsUpToDate = false;
+	lMembershipSumsUpdates = 0;
+	iMaxDriftClusterIndex = -1;
+	cMaxDrift = 0;
+	cSecondMaxDrift = 0;
+	lComputedDistancesNumber = 0;
+	lPrunedDistancesNumber = 0;
 	clusteringQuality = new KMClusteringQuality(kmClusters, parameters);
 	clusteringInitializer = new KMClusteringInitializer(this);
 	attributesPartitioningManager = new KMAttributesPartitioningManager;
@@ -36,18 +48,12 @@ KMClustering::~KMClustering(void)
 	kmClusters->DeleteAll();
 	delete kmClusters;
 
-	kmBestClusters->DeleteAll();
-	delete kmBestClusters;
-
 	if (kmGlobalCluster != NULL)
 		delete kmGlobalCluster;
 
 	oaTargetAttributeValues.DeleteAll();
 
-	for (int i = 0; i < KMParameters::K_MAX_VALUE; i++)
-		if (clustersCentersDistances[i] != NULL)
-			delete[] clustersCentersDistances[i];
-	delete[] clustersCentersDistances;
+	oaCentersDistancesCentroids.DeleteAll();
 
 	if (instancesToClusters != NULL) {
 		instancesToClusters->RemoveAll();
@@ -85,7 +91,10 @@ bool KMClustering::ComputeReplicate(ObjectArray* instances, const KWAttribute* t
 		return false;
 	}
 
-	instances->Shuffle();
+	if (instancesMatrix != NULL and instancesMatrix->GetRowNumber() == instances->GetSize())
+		ShuffleInstancesMatrixRows(instances);
+	else
+		instances->Shuffle();
 
 	// affecter les instances a un cluster 'fictif' unique, et calculer les statistiques correspondantes
 	// (uniquement dans le cas ou ces stats n'auraient pas deja �t� recuperees a partir d'un autre resultat)
@@ -156,18 +165,7 @@ bool KMClustering::ComputeReplicate(ObjectArray* instances, const KWAttribute* t
 	clusteringQuality->ComputeDaviesBouldin(); // calcul de l'indice DB, tous attributs confondus
 	//cout << endl << "DB : " << clusteringQuality->GetDaviesBouldin() << endl;
 
-	// calcul de l'indice DB pour chaque attribut separement (auparavant, il est necessaire de calculer les inerties intra par attribut et par cluster) :
-	for (int i = 0; i < GetClusters()->GetSize(); i++) {
-
-		KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
-
-		for (int iLoadIndex = 0; iLoadIndex < parameters->GetKMeanAttributesLoadIndexes().GetSize(); iLoadIndex++) {
-			const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(iLoadIndex);
-			if (loadIndex.IsValid()) {
-				c->ComputeInertyIntraForAttribute(iLoadIndex, parameters->GetDistanceType());
-			}
-		}
-	}
+	// calcul de l'indice DB pour chaque attribut separement (les inerties intra par attribut et par cluster ont ete calculees par FinalizeReplicateComputing) :
 	for (int iLoadIndex = 0; iLoadIndex < parameters->GetKMeanAttributesLoadIndexes().GetSize(); iLoadIndex++) {
 		const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(iLoadIndex);
 		if (loadIndex.IsValid()) {
@@ -221,9 +219,12 @@ boolean KMClustering::DoClusteringIterations(const ObjectArray* instances, const
 	double minDistanceSum = 0.0;
 	double newDistancesSum = 0.0;
 	boolean interruptRequest = false;
+	boolean bSnapshotRestored = false;
 
 	iIterationsDone = 0;
 	iDroppedClustersNumber = 0;
+	lComputedDistancesNumber = 0;
+	lPrunedDistancesNumber = 0;
 
 	// calcul de la distance initiale, tous clusters confondus
 	for (int i = 0; i < kmClusters->GetSize(); i++) {
@@ -269,23 +270,46 @@ boolean KMClustering::DoClusteringIterations(const ObjectArray* instances, const
 			}
 
 			// effectuer les mouvements d'instances entre clusters
-			for (int i = 0; i < maxInstances; i++) {
+			if (IsInstancesMatrixUsable(instances)) {
 
-				KWObject* instance = cast(KWObject*, instances->GetAt(i));
+				// version optimisee : les distances sont calculees a partir des lignes contigues de la matrice dense,
+				// et l'appartenance des instances aux clusters est lue dans un tableau indexe par position.
+				// Les centroides etant figes pendant la phase d'affectation, le nouveau cluster de chaque instance est d'abord calcule
+				// independamment (eventuellement en parallele), puis les mouvements sont appliques dans l'ordre des positions.
+				// Les dictionnaires d'instances des clusters ne sont pas mis a jour lors des iterations (cf. UpdateClustersInstancesFromMembership)
+				movements = ComputeNewInstancesClusters(maxInstances);
 
-				KMCluster* currentCluster = cast(KMCluster*, instancesToClusters->Lookup(instance));
+				// au dela d'un nombre de positions de mises a jour incrementales, les sommes par cluster seront entierement recalculees
+				if (lMembershipSumsUpdates + movements > instancesMembership.GetPositionNumber())
+					bMembershipSumsUpToDate = false;
 
-				if (currentCluster == NULL)
-					continue; // cas d'une instance ayant des valeurs K-Means manquantes, et qui n'a donc jamais ete affectee precedemment a un cluster
+				for (int i = 0; movements > 0 and i < maxInstances; i++) {
 
-				KMCluster* newCluster = FindNearestCluster(instance);
+					if (ivNewInstancesClusters.GetAt(i) != instancesMembership.GetClusterIndexAt(i)) {
+						// l'instance change de cluster
+						MoveInstanceInMembership(i, ivNewInstancesClusters.GetAt(i));
+					}
+				}
+			}
+			else {
+				for (int i = 0; i < maxInstances; i++) {
+
+					KWObject* instance = cast(KWObject*, instances->GetAt(i));
+
+					KMCluster* currentCluster = cast(KMCluster*, instancesToClusters->Lookup(instance));
+
+					if (currentCluster == NULL)
+						continue; // cas d'une instance ayant des valeurs K-Means manquantes, et qui n'a donc jamais ete affectee precedemment a un cluster
 
-				if (newCluster != NULL and newCluster != currentCluster) {
-					// l'instance change de cluster
-					currentCluster->RemoveInstance(instance);
-					newCluster->AddInstance(instance);
-					instancesToClusters->SetAt(instance, newCluster);
-					movements += 1;
+					KMCluster* newCluster = FindNearestCluster(instance);
+
+					if (newCluster != NULL and newCluster != currentCluster) {
+						// l'instance change de cluster
+						currentCluster->RemoveInstance(instance);
+						newCluster->AddInstance(instance);
+						instancesToClusters->SetAt(instance, newCluster);
+						movements += 1;
+					}
 				}
 			}
 
@@ -297,6 +321,9 @@ boolean KMClustering::DoClusteringIterations(const ObjectArray* instances, const
 		if ((iIterationsDone <= parameters->GetMaxIterations() or parameters->GetMaxIterations() == 0) and parameters->GetMaxIterations() != -1) {
 
 			// mise a jour des stats de chaque cluster (seulement les stats necessaires a la poursuite des iterations)
+			if (IsInstancesMatrixUsable(instances))
+				ComputeIterationStatisticsFromMembership();
+
 			for (int i = 0; i < kmClusters->GetSize(); i++) {
 				KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
 				c->ComputeIterationStatistics();
@@ -317,15 +344,13 @@ boolean KMClustering::DoClusteringIterations(const ObjectArray* instances, const
 		// en fin de clustering, on garde la meilleure iteration effectuee (qui n'est pas forcement la derniere)
 		// NB. la meilleure iteration retenue peut contenir des clusters vides
 
-		if (not continueClustering and kmBestClusters->GetSize() > 0) {
+		if (not continueClustering and not kmBestClustersSnapshot.IsEmpty()) {
 
-			for (int i = 0; i < kmBestClusters->GetSize(); i++)
-			{
-				KMCluster* source = cast(KMCluster*, kmBestClusters->GetAt(i));
-				KMCluster* target = cast(KMCluster*, kmClusters->GetAt(i));
-				target->CopyFrom(source);
-			}
-			kmBestClusters->DeleteAll();
+			kmBestClustersSnapshot.Restore(kmClusters);
+			kmBestClustersSnapshot.Reset();
+			bInstancesBoundsUpToDate = false;
+			bMembershipSumsUpToDate = false;
+			bSnapshotRestored = true;
 		}
 
 		// gestion des clusters devenus vides apres une iteration
@@ -346,6 +371,16 @@ boolean KMClustering::DoClusteringIterations(const ObjectArray* instances, const
 
 	} // fin de la boucle d'affectation des instances aux clusters
 
+	// les instances des clusters sont restituees a partir du tableau d'appartenance, sauf si la meilleure iteration a ete restauree
+	// (les clusters ne contiennent alors plus d'instances, celles-ci ne correspondant plus aux centroides restitues)
+	if (IsInstancesMatrixUsable(instances) and not bSnapshotRestored)
+		UpdateClustersInstancesFromMembership();
+
+	if (parameters->GetVerboseMode() and lComputedDistancesNumber + lPrunedDistancesNumber > 0)
+		AddSimpleMessage("Distance bounds pruning : " + ALString(LongintToString(lComputedDistancesNumber)) + " distances computed, " +
+			ALString(LongintToString(lPrunedDistancesNumber)) + " distances pruned (" +
+			ALString(DoubleToString((100.0 * lPrunedDistancesNumber) / (lComputedDistancesNumber + lPrunedDistancesNumber))) + "%)");
+
 	TaskProgression::EndTask();
 
 	return (interruptRequest == true ? false : true);
@@ -376,7 +411,7 @@ bool KMClustering::ManageConvergence(const int movements, const int iterationsDo
 			minDistanceSum = newDistancesSum; // Memorisation de la distance mini observ�e, toutes iterations confondues
 
 			// Memorisation du mod�le courant, car il est le meilleur
-			CloneBestClusters();
+			SaveBestClusters();
 		}
 		else {
 
@@ -401,7 +436,6 @@ KMCluster* KMClustering::FindNearestCluster(KWObject* instance)
 	assert(parameters->GetDistanceType() == KMParameters::L1Norm or
 		parameters->GetDistanceType() == KMParameters::L2Norm or
 		parameters->GetDistanceType() == KMParameters::CosineNorm);
-	assert(clustersCentersDistances != NULL);
 
 	if (kmClusters == NULL or kmClusters->GetSize() == 0) {
 		return NULL;
@@ -426,12 +460,11 @@ KMCluster* KMClustering::FindNearestClusterL1(KWObject* instance) {
 		return NULL;
 
 	const int nbClusters = kmClusters->GetSize();
-
-	const int size = parameters->GetKMeanAttributesLoadIndexes().GetSize();
+	const KWLoadIndexVector& kmeanAttributesLoadIndexes = parameters->GetKMeanAttributesLoadIndexes();
 	int	nearestClusterIndex = 0;
 	Continuous minimumDistance = 0.0;
 
-	// recuperer le cluster auquel appartient actuellement cette instance (NB. : en cours  de premi�re initialisation des clusters, il n'y en a pas encore)
+	// recuperer le cluster auquel appartient actuellement cette instance (NB. : en cours  de premiere initialisation des clusters, il n'y en a pas encore)
 	KMCluster* firstClusterToCheck = cast(KMCluster*, instancesToClusters->Lookup(instance));
 
 	if (firstClusterToCheck == NULL) {
@@ -440,38 +473,18 @@ KMCluster* KMClustering::FindNearestClusterL1(KWObject* instance) {
 		// minimiser les tests a effectuer par la suite, et optimiser ainsi la vitesse d'execution
 
 		firstClusterToCheck = cast(KMCluster*, kmClusters->GetAt(0));
-
-		for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
-
-			const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-			if (not loadIndex.IsValid())
-				continue;
-			assert(firstClusterToCheck->GetModelingCentroidValues().GetSize() > idxAttribut);
-			const Continuous d = firstClusterToCheck->GetModelingCentroidValues().GetAt(idxAttribut) - instance->GetContinuousValueAt(loadIndex);
-			minimumDistance += fabs(d); // premiere initialisation de la distance minimale de reference
-		}
-
-
+		minimumDistance = KMDistanceKernel::ComputeDistance(instance, firstClusterToCheck->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::L1Norm);
 	}
 	else {
 
 		// pour optimiser la vitesse d'execution : comparer la distance entre l'instance et son cluster, avec la distance entre
-		// le cluster de l'instance et son cluster le plus proche. En fonction du r�sultat, on pourra se passer de calculer la distance pour
+		// le cluster de l'instance et son cluster le plus proche. En fonction du resultat, on pourra se passer de calculer la distance pour
 		// les autres clusters
 
 		nearestClusterIndex = firstClusterToCheck->GetIndex();
 
 		// calcul de distance entre l'instance et le centroide de son cluster courant
-
-		for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
-
-			const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-			if (not loadIndex.IsValid())
-				continue;
-			assert(firstClusterToCheck->GetModelingCentroidValues().GetSize() > idxAttribut);
-			const Continuous d = firstClusterToCheck->GetModelingCentroidValues().GetAt(idxAttribut) - instance->GetContinuousValueAt(loadIndex);
-			minimumDistance += fabs(d); // premiere initialisation de la distance minimale de reference
-		}
+		minimumDistance = KMDistanceKernel::ComputeDistance(instance, firstClusterToCheck->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::L1Norm);
 
 		KMCluster* nearestToCurrentCluster = firstClusterToCheck->GetNearestCluster();
 
@@ -480,7 +493,7 @@ KMCluster* KMClustering::FindNearestClusterL1(KWObject* instance) {
 		assert(firstClusterToCheck->GetIndex() >= 0);
 
 		// distance entre le cluster de l'instance, et le cluster le plus proche de ce cluster
-		Continuous distanceBetweenClusters = clustersCentersDistances[nearestToCurrentCluster->GetIndex()][firstClusterToCheck->GetIndex()];
+		Continuous distanceBetweenClusters = clustersCentersDistances.GetAt(nearestToCurrentCluster->GetIndex(), firstClusterToCheck->GetIndex());
 
 		if (distanceBetweenClusters * 0.5 > minimumDistance) {
 			return firstClusterToCheck; // l'instance ne changera pas de cluster, inutile de verifier pour les autres clusters
@@ -494,33 +507,17 @@ KMCluster* KMClustering::FindNearestClusterL1(KWObject* instance) {
 		KMCluster* cluster = cast(KMCluster*, kmClusters->GetAt(idxCluster));
 
 		if (cluster == firstClusterToCheck)
-			continue; // cluster deja trait�
-
-		Continuous distance = 0.0;
-		bool distanceComputed = false;
+			continue; // cluster deja traite
 
-		if (0.5 * clustersCentersDistances[nearestClusterIndex][idxCluster] < minimumDistance) {
+		if (0.5 * clustersCentersDistances.GetAt(nearestClusterIndex, idxCluster) < minimumDistance) {
 
-			distanceComputed = true;
+			const Continuous distance = KMDistanceKernel::ComputeDistance(instance, cluster->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::L1Norm);
 
-			for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
-				const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-				if (not loadIndex.IsValid())
-					continue;
-				assert(cluster->GetModelingCentroidValues().GetSize() > idxAttribut);
-				const Continuous d = cluster->GetModelingCentroidValues().GetAt(idxAttribut) - instance->GetContinuousValueAt(loadIndex);
-
-				distance += fabs(d);
-
-				if (distance > minimumDistance)
-					break; // pas la peine de continuer a calculer, la distance entre l'instance et ce cluster sera superieure a la distance minimale deja trouvee
+			if (minimumDistance > distance) {
+				minimumDistance = distance;
+				nearestClusterIndex = idxCluster;
 			}
 		}
-
-		if (distanceComputed and minimumDistance > distance) {
-			minimumDistance = distance;
-			nearestClusterIndex = idxCluster;
-		}
 	}
 
 	return cast(KMCluster*, kmClusters->GetAt(nearestClusterIndex));
@@ -533,12 +530,11 @@ KMCluster* KMClustering::FindNearestClusterL2(KWObject* instance) {
 		return NULL;
 
 	const int nbClusters = kmClusters->GetSize();
-
-	const int size = parameters->GetKMeanAttributesLoadIndexes().GetSize();
+	const KWLoadIndexVector& kmeanAttributesLoadIndexes = parameters->GetKMeanAttributesLoadIndexes();
 	int	nearestClusterIndex = 0;
 	Continuous minimumDistance = 0.0;
 
-	// recuperer le cluster auquel appartient actuellement cette instance (NB. : en cours  de premi�re initialisation des clusters, il n'y en a pas encore)
+	// recuperer le cluster auquel appartient actuellement cette instance (NB. : en cours  de premiere initialisation des clusters, il n'y en a pas encore)
 	KMCluster* firstClusterToCheck = cast(KMCluster*, instancesToClusters->Lookup(instance));
 
 	if (firstClusterToCheck == NULL) {
@@ -547,37 +543,18 @@ KMCluster* KMClustering::FindNearestClusterL2(KWObject* instance) {
 		// minimiser les tests a effectuer par la suite, et optimiser ainsi la vitesse d'execution
 
 		firstClusterToCheck = cast(KMCluster*, kmClusters->GetAt(0));
-
-		for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
-
-			const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-			if (not loadIndex.IsValid())
-				continue;
-			assert(firstClusterToCheck->GetModelingCentroidValues().GetSize() > idxAttribut);
-			const Continuous d = firstClusterToCheck->GetModelingCentroidValues().GetAt(idxAttribut) - instance->GetContinuousValueAt(loadIndex);
-			minimumDistance += (d * d); // premiere initialisation de la distance minimale de reference
-		}
-
+		minimumDistance = KMDistanceKernel::ComputeDistance(instance, firstClusterToCheck->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::L2Norm);
 	}
 	else {
 
 		// pour optimiser la vitesse d'execution : comparer la distance entre l'instance et son cluster, avec la distance entre
-		// l'instance et le cluster le plus proche de son cluster. En fonction du r�sultat, on pourra se passer de calculer la distance pour
+		// l'instance et le cluster le plus proche de son cluster. En fonction du resultat, on pourra se passer de calculer la distance pour
 		// les autres clusters
 
 		nearestClusterIndex = firstClusterToCheck->GetIndex();
 
-		// calcul de distance entre l'instance et le centroide de son cluster courant
-
-		for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
-
-			const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-			if (not loadIndex.IsValid())
-				continue;
-			assert(firstClusterToCheck->GetModelingCentroidValues().GetSize() > idxAttribut);
-			const Continuous d = firstClusterToCheck->GetModelingCentroidValues().GetAt(idxAttribut) - instance->GetContinuousValueAt(loadIndex);
-			minimumDistance += (d * d); // premiere initialisation de la distance minimale de reference
-		}
+		// calcul de distance entre l'instance et le centroide de son cluster courant (distance au carre)
+		minimumDistance = KMDistanceKernel::ComputeDistance(instance, firstClusterToCheck->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::L2Norm);
 
 		KMCluster* nearestToCurrentCluster = firstClusterToCheck->GetNearestCluster();
 
@@ -586,7 +563,7 @@ KMCluster* KMClustering::FindNearestClusterL2(KWObject* instance) {
 		assert(firstClusterToCheck->GetIndex() >= 0);
 
 		// distance entre le cluster de l'instance, et le cluster le plus proche de ce cluster
-		Continuous distanceBetweenClusters = clustersCentersDistances[nearestToCurrentCluster->GetIndex()][firstClusterToCheck->GetIndex()];
+		Continuous distanceBetweenClusters = clustersCentersDistances.GetAt(nearestToCurrentCluster->GetIndex(), firstClusterToCheck->GetIndex());
 
 		if (sqrt(distanceBetweenClusters) * 0.5 > sqrt(minimumDistance))
 			return firstClusterToCheck; // l'instance ne changera pas de cluster, inutile de verifier pour les autres clusters
@@ -599,34 +576,17 @@ KMCluster* KMClustering::FindNearestClusterL2(KWObject* instance) {
 		KMCluster* cluster = cast(KMCluster*, kmClusters->GetAt(idxCluster));
 
 		if (cluster == firstClusterToCheck)
-			continue; // cluster deja trait�
-
-		Continuous distance = 0.0;
-		bool distanceComputed = false;
+			continue; // cluster deja traite
 
-		if (0.5 * sqrt(clustersCentersDistances[nearestClusterIndex][idxCluster]) < sqrt(minimumDistance)) {
-
-			distanceComputed = true;
-
-			for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
-
-				const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-				if (not loadIndex.IsValid())
-					continue;
-				assert(cluster->GetModelingCentroidValues().GetSize() > idxAttribut);
-				const Continuous d = cluster->GetModelingCentroidValues().GetAt(idxAttribut) - instance->GetContinuousValueAt(loadIndex);
+		if (0.5 * sqrt(clustersCentersDistances.GetAt(nearestClusterIndex, idxCluster)) < sqrt(minimumDistance)) {
 
-				distance += (d * d);
+			const Continuous distance = KMDistanceKernel::ComputeDistance(instance, cluster->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::L2Norm);
 
-				if (distance > minimumDistance)
-					break; // pas la peine de continuer a calculer, la distance entre l'instance et ce cluster sera superieure a la distance minimale deja trouvee
+			if (minimumDistance > distance) {
+				minimumDistance = distance;
+				nearestClusterIndex = idxCluster;
 			}
 		}
-
-		if (distanceComputed and minimumDistance > distance) {
-			minimumDistance = distance; // todo distance2
-			nearestClusterIndex = idxCluster;
-		}
 	}
 
 	return cast(KMCluster*, kmClusters->GetAt(nearestClusterIndex));
@@ -639,16 +599,11 @@ KMCluster* KMClustering::FindNearestClusterCosinus(KWObject* instance) {
 		return NULL;
 
 	const int nbClusters = kmClusters->GetSize();
-
-	const int size = parameters->GetKMeanAttributesLoadIndexes().GetSize();
+	const KWLoadIndexVector& kmeanAttributesLoadIndexes = parameters->GetKMeanAttributesLoadIndexes();
 	int	nearestClusterIndex = 0;
 	Continuous minimumDistance = 0.0;
-	Continuous numeratorCosinus = 0.0;
-	Continuous denominatorInstanceCosinus = 0.0;
-	Continuous denominatorCentroidCosinus = 0.0;
-	Continuous denominator = 0.0;
 
-	// recuperer le cluster auquel appartient actuellement cette instance (NB. : en cours  de premi�re initialisation des clusters, il n'y en a pas encore)
+	// recuperer le cluster auquel appartient actuellement cette instance (NB. : en cours  de premiere initialisation des clusters, il n'y en a pas encore)
 	KMCluster* firstClusterToCheck = cast(KMCluster*, instancesToClusters->Lookup(instance));
 
 	if (firstClusterToCheck == NULL) {
@@ -657,43 +612,18 @@ KMCluster* KMClustering::FindNearestClusterCosinus(KWObject* instance) {
 		// minimiser les tests a effectuer par la suite, et optimiser ainsi la vitesse d'execution
 
 		firstClusterToCheck = cast(KMCluster*, kmClusters->GetAt(0));
-
-		for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
-
-			const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-			if (not loadIndex.IsValid())
-				continue;
-
-			numeratorCosinus += firstClusterToCheck->GetModelingCentroidValues().GetAt(idxAttribut) * instance->GetContinuousValueAt(loadIndex);
-			denominatorInstanceCosinus += pow(instance->GetContinuousValueAt(loadIndex), 2);
-			denominatorCentroidCosinus += pow(firstClusterToCheck->GetModelingCentroidValues().GetAt(idxAttribut), 2);
-		}
-		denominator = sqrt(denominatorInstanceCosinus) * sqrt(denominatorCentroidCosinus);
-		minimumDistance = 1 - (denominator == 0 ? 0 : numeratorCosinus / denominator);;
-
+		minimumDistance = KMDistanceKernel::ComputeDistance(instance, firstClusterToCheck->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::CosineNorm);
 	}
 	else {
 
 		// pour optimiser la vitesse d'execution : comparer la distance entre l'instance et son cluster, avec la distance entre
-		// l'instance et le cluster le plus proche de son cluster. En fonction du r�sultat, on pourra se passer de calculer la distance pour
+		// l'instance et le cluster le plus proche de son cluster. En fonction du resultat, on pourra se passer de calculer la distance pour
 		// les autres clusters
 
 		nearestClusterIndex = firstClusterToCheck->GetIndex();
 
 		// calcul de distance entre l'instance et le centroide de son cluster courant
-
-		for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
-
-			const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-			if (not loadIndex.IsValid())
-				continue;
-			assert(firstClusterToCheck->GetModelingCentroidValues().GetSize() > idxAttribut);
-			numeratorCosinus += firstClusterToCheck->GetModelingCentroidValues().GetAt(idxAttribut) * instance->GetContinuousValueAt(loadIndex);
-			denominatorInstanceCosinus += pow(instance->GetContinuousValueAt(loadIndex), 2);
-			denominatorCentroidCosinus += pow(firstClusterToCheck->GetModelingCentroidValues().GetAt(idxAttribut), 2);
-		}
-		denominator = sqrt(denominatorInstanceCosinus) * sqrt(denominatorCentroidCosinus);
-		minimumDistance = 1 - (denominator == 0 ? 0 : numeratorCosinus / denominator);;
+		minimumDistance = KMDistanceKernel::ComputeDistance(instance, firstClusterToCheck->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::CosineNorm);
 
 		KMCluster* nearestToCurrentCluster = firstClusterToCheck->GetNearestCluster();
 
@@ -702,7 +632,7 @@ KMCluster* KMClustering::FindNearestClusterCosinus(KWObject* instance) {
 		assert(firstClusterToCheck->GetIndex() >= 0);
 
 		// distance entre le cluster de l'instance, et le cluster le plus proche de ce cluster
-		Continuous distanceBetweenClusters = clustersCentersDistances[nearestToCurrentCluster->GetIndex()][firstClusterToCheck->GetIndex()];
+		Continuous distanceBetweenClusters = clustersCentersDistances.GetAt(nearestToCurrentCluster->GetIndex(), firstClusterToCheck->GetIndex());
 
 		if (distanceBetweenClusters * 0.5 > minimumDistance)
 			return firstClusterToCheck; // l'instance ne changera pas de cluster, inutile de verifier pour les autres clusters
@@ -716,126 +646,691 @@ KMCluster* KMClustering::FindNearestClusterCosinus(KWObject* instance) {
 		KMCluster* cluster = cast(KMCluster*, kmClusters->GetAt(idxCluster));
 
 		if (cluster == firstClusterToCheck)
-			continue; // cluster deja trait�
+			continue; // cluster deja traite
 
-		Continuous distance = 0.0;
-		bool distanceComputed = false;
+		if (0.5 * clustersCentersDistances.GetAt(nearestClusterIndex, idxCluster) < minimumDistance) {
 
-		if (0.5 * clustersCentersDistances[nearestClusterIndex][idxCluster] < minimumDistance) {
+			const Continuous distance = KMDistanceKernel::ComputeDistance(instance, cluster->GetModelingCentroidValues(), kmeanAttributesLoadIndexes, KMParameters::CosineNorm);
 
-			distanceComputed = true;
+			if (minimumDistance > distance) {
+				minimumDistance = distance;
+				nearestClusterIndex = idxCluster;
+			}
+		}
+	}
 
-			numeratorCosinus = 0.0;
-			denominatorInstanceCosinus = 0.0;
-			denominatorCentroidCosinus = 0.0;
+	return cast(KMCluster*, kmClusters->GetAt(nearestClusterIndex));
 
-			for (int idxAttribut = 0; idxAttribut < size; idxAttribut++) {
+}
 
-				const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(idxAttribut);
-				if (not loadIndex.IsValid())
-					continue;
+boolean KMClustering::IsInstancesMatrixUsable(const ObjectArray* instances) const {
+
+	return instancesMatrix != NULL and instances != NULL and instances == oaMatrixInstances and instancesMembership.GetPositionNumber() == instances->GetSize();
+}
+
+void KMClustering::DetachInstancesMatrices() {
+
+	if (IsInstancesMatrixUsable(oaMatrixInstances))
+		UpdateClustersInstancesFromMembership();
+
+	instancesMatrix = NULL;
+	instancesSparseMatrix = NULL;
+	oaMatrixInstances = NULL;
+	bInstancesBoundsUpToDate = false;
+	bMembershipSumsUpToDate = false;
+}
+
+void KMClustering::ShuffleInstancesMatrixRows(ObjectArray* instances) {
+
+	assert(instancesMatrix != NULL);
+	assert(instancesMatrix->GetRowNumber() == instances->GetSize());
+
+	const int nbInstances = instancesMatrix->GetRowNumber();
+
+	ivInstancesRows.SetSize(nbInstances);
+	for (int i = 0; i < nbInstances; i++)
+		ivInstancesRows.SetAt(i, i);
+
+	// melange aleatoire des lignes, avec le meme algorithme que ObjectArray::Shuffle()
+	for (int i = 1; i < nbInstances; i++) {
+		const int iSwap = RandomInt(i);
+		const int nRow = ivInstancesRows.GetAt(iSwap);
+		ivInstancesRows.SetAt(iSwap, ivInstancesRows.GetAt(i));
+		ivInstancesRows.SetAt(i, nRow);
+	}
+
+	// les instances sont rangees dans l'ordre des lignes melangees
+	for (int i = 0; i < nbInstances; i++)
+		instances->SetAt(i, instancesMatrix->GetInstanceAt(ivInstancesRows.GetAt(i)));
+
+	oaMatrixInstances = instances;
+	bInstancesBoundsUpToDate = false;
+	bMembershipSumsUpToDate = false;
+	instancesMembership.Initialize(nbInstances);
+}
+
+int KMClustering::ComputeNewInstancesClusters(const int maxInstances) {
+
+	assert(IsInstancesMatrixUsable(oaMatrixInstances));
+	assert(maxInstances <= instancesMembership.GetPositionNumber());
 
-				numeratorCosinus += cluster->GetModelingCentroidValues().GetAt(idxAttribut) * instance->GetContinuousValueAt(loadIndex);
-				denominatorInstanceCosinus += pow(instance->GetContinuousValueAt(loadIndex), 2);
-				denominatorCentroidCosinus += pow(cluster->GetModelingCentroidValues().GetAt(idxAttribut), 2);
+	int nThreads = parameters->GetEffectiveThreadsNumber();
+
+	// ne pas lancer de threads pour des volumes trop faibles
+	if (nThreads > maxInstances / MIN_INSTANCES_BY_THREAD)
+		nThreads = maxInstances / MIN_INSTANCES_BY_THREAD;
+
+	ivNewInstancesClusters.SetSize(maxInstances);
+
+	// elagage par bornes : mise a jour prealable des bornes, en fonction des deplacements des centroides
+	boolean bKeepBounds = false;
+	if (IsBoundsPruningUsable())
+		bKeepBounds = PrepareInstancesBounds();
+
+	int movements = 0;
+
+	if (nThreads <= 1)
+		movements = ComputeNewInstancesClustersRange(0, maxInstances, lComputedDistancesNumber, lPrunedDistancesNumber);
+	else {
+
+		// chaque thread traite une tranche contigue de positions, et ecrit dans une zone disjointe de ivNewInstancesClusters (et des bornes).
+		// NB. aucune allocation memoire n'est faite dans les threads (l'allocateur n'est pas thread-safe)
+		IntVector ivThreadsMovements;
+		LongintVector lvThreadsComputedDistances;
+		LongintVector lvThreadsPrunedDistances;
+		ivThreadsMovements.SetSize(nThreads);
+		lvThreadsComputedDistances.SetSize(nThreads);
+		lvThreadsPrunedDistances.SetSize(nThreads);
+
+		std::thread* threads = new std::thread[nThreads];
+
+		for (int t = 0; t < nThreads; t++) {
+
+			const int nFirstPosition = (int)(((longint)maxInstances * t) / nThreads);
+			const int nLastPosition = (int)(((longint)maxInstances * (t + 1)) / nThreads);
+
+			threads[t] = std::thread([this, t, nFirstPosition, nLastPosition, &ivThreadsMovements, &lvThreadsComputedDistances, &lvThreadsPrunedDistances]() {
+				longint lComputedDistances = 0;
+				longint lPrunedDistances = 0;
+				ivThreadsMovements.SetAt(t, ComputeNewInstancesClustersRange(nFirstPosition, nLastPosition, lComputedDistances, lPrunedDistances));
+				lvThreadsComputedDistances.SetAt(t, lComputedDistances);
+				lvThreadsPrunedDistances.SetAt(t, lPrunedDistances);
+				});
+		}
+
+		// fusion des comptages, dans l'ordre des threads
+		for (int t = 0; t < nThreads; t++) {
+			threads[t].join();
+			movements += ivThreadsMovements.GetAt(t);
+			lComputedDistancesNumber += lvThreadsComputedDistances.GetAt(t);
+			lPrunedDistancesNumber += lvThreadsPrunedDistances.GetAt(t);
+		}
+		delete[] threads;
+	}
+
+	// les bornes calculees lors de cette phase sont valides pour la phase suivante, sauf modification des clusters d'ici la
+	bInstancesBoundsUpToDate = bKeepBounds;
+
+	return movements;
+}
+
+int KMClustering::ComputeNewInstancesClustersRange(const int nFirstPosition, const int nLastPosition, longint& lComputedDistances, longint& lPrunedDistances) {
+
+	const boolean bUseBounds = IsBoundsPruningUsable();
+	const boolean bUseSparseMatrix = IsInstancesSparseMatrixUsable();
+	int movements = 0;
+
+	// la matrice dense n'a pas de valeurs lorsque celles-ci sont stockees dans la matrice creuse
+	assert(bUseSparseMatrix or instancesMatrix->HasValues());
+
+	for (int i = nFirstPosition; i < nLastPosition; i++) {
+
+		const int currentClusterIndex = instancesMembership.GetClusterIndexAt(i);
+		int newClusterIndex = currentClusterIndex;
+
+		// NB. les instances ayant des valeurs K-Means manquantes n'ont jamais ete affectees a un cluster, et restent non affectees
+		if (currentClusterIndex != -1) {
+			if (bUseBounds)
+				newClusterIndex = FindNearestClusterIndexWithBounds(i, currentClusterIndex, lComputedDistances, lPrunedDistances);
+			else
+				if (bUseSparseMatrix)
+					newClusterIndex = FindNearestClusterIndexSparse(ivInstancesRows.GetAt(i), currentClusterIndex);
+				else
+					newClusterIndex = FindNearestClusterIndex(instancesMatrix->GetRowAt(ivInstancesRows.GetAt(i)), currentClusterIndex);
+		}
+
+		ivNewInstancesClusters.SetAt(i, newClusterIndex);
+
+		if (newClusterIndex != currentClusterIndex)
+			movements++;
+	}
+
+	return movements;
+}
+
+boolean KMClustering::IsBoundsPruningUsable() const {
+
+	// les bornes reposent sur l'inegalite triangulaire, qui n'est pas verifiee par la distance cosinus
+	return parameters->GetBoundsPruning() and
+		(parameters->GetDistanceType() == KMParameters::L1Norm or parameters->GetDistanceType() == KMParameters::L2Norm) and
+		IsInstancesMatrixUsable(oaMatrixInstances);
+}
+
+boolean KMClustering::PrepareInstancesBounds() {
+
+	const int nbClusters = kmClusters->GetSize();
+	const int nbColumns = dmClustersCentroids.GetColumnNumber();
+
+	// demi-distance de chaque centroide a son plus proche centroide : une instance plus proche de son centroide que cette valeur ne peut pas changer de cluster
+	cvClustersHalfMinDistances.SetSize(nbClusters);
+	for (int j = 0; j < nbClusters; j++) {
+
+		Continuous distance = 0;
+
+		if (nbClusters > 1) {
+			const int nearestClusterIndex = cast(KMCluster*, kmClusters->GetAt(j))->GetNearestCluster()->GetIndex();
+			distance = clustersCentersDistances.GetAt(j, nearestClusterIndex);
+			if (parameters->GetDistanceType() == KMParameters::L2Norm)
+				distance = sqrt(distance); // les distances inter-clusters L2 sont au carre
+		}
+		cvClustersHalfMinDistances.SetAt(j, 0.5 * distance);
+	}
+
+	// deplacements des centroides depuis la precedente phase d'affectation
+	cvClustersDrifts.SetSize(nbClusters);
+	cvClustersDrifts.Initialize();
+	iMaxDriftClusterIndex = -1;
+	cMaxDrift = 0;
+	cSecondMaxDrift = 0;
+
+	if (bInstancesBoundsUpToDate and
+		dmPreviousClustersCentroids.GetRowNumber() == nbClusters and
+		dmPreviousClustersCentroids.GetColumnNumber() == nbColumns) {
+
+		for (int j = 0; j < nbClusters; j++) {
+
+			const Continuous* previousValues = dmPreviousClustersCentroids.GetRowAt(j);
+			const Continuous drift = ComputeMetricDistanceToCentroid(previousValues, j);
+			cvClustersDrifts.SetAt(j, drift);
+
+			if (drift > cMaxDrift) {
+				cSecondMaxDrift = cMaxDrift;
+				cMaxDrift = drift;
+				iMaxDriftClusterIndex = j;
 			}
-			denominator = sqrt(denominatorInstanceCosinus) * sqrt(denominatorCentroidCosinus);
-			distance = 1 - (denominator == 0 ? 0 : numeratorCosinus / denominator);
+			else
+				if (drift > cSecondMaxDrift)
+					cSecondMaxDrift = drift;
+		}
+	}
+	else {
+		// bornes inexistantes ou invalidees : elles seront entierement recalculees lors de cette phase d'affectation
+		bInstancesBoundsUpToDate = false;
+		cvInstancesUpperBounds.SetSize(instancesMembership.GetPositionNumber());
+		cvInstancesLowerBounds.SetSize(instancesMembership.GetPositionNumber());
+	}
+
+	// memoriser les centroides courants, pour mesurer leurs deplacements lors de la prochaine phase d'affectation
+	return dmPreviousClustersCentroids.CopyFrom(&dmClustersCentroids);
+}
+
+int KMClustering::FindNearestClusterIndexWithBounds(const int nPosition, const int currentClusterIndex, longint& lComputedDistances, longint& lPrunedDistances) {
+
+	const int nbClusters = kmClusters->GetSize();
+	const int nRow = ivInstancesRows.GetAt(nPosition);
+	const boolean bUseSparseMatrix = IsInstancesSparseMatrixUsable();
+	const boolean bL2Norm = (parameters->GetDistanceType() == KMParameters::L2Norm);
+
+	if (bInstancesBoundsUpToDate) {
+
+		// mise a jour des bornes, en fonction des deplacements des centroides (inegalite triangulaire)
+		Continuous upperBound = cvInstancesUpperBounds.GetAt(nPosition) + cvClustersDrifts.GetAt(currentClusterIndex);
+		Continuous lowerBound = cvInstancesLowerBounds.GetAt(nPosition) - (currentClusterIndex == iMaxDriftClusterIndex ? cSecondMaxDrift : cMaxDrift);
+		cvInstancesLowerBounds.SetAt(nPosition, lowerBound);
+
+		const Continuous threshold = (lowerBound > cvClustersHalfMinDistances.GetAt(currentClusterIndex) ? lowerBound : cvClustersHalfMinDistances.GetAt(currentClusterIndex));
+
+		if (upperBound <= threshold) {
+			// aucun autre centroide ne peut etre plus proche
+			cvInstancesUpperBounds.SetAt(nPosition, upperBound);
+			lPrunedDistances += nbClusters;
+			return currentClusterIndex;
 		}
 
-		if (distanceComputed and minimumDistance > distance) {
+		// resserrer la borne superieure, par un calcul exact de la distance au centroide courant
+		upperBound = ComputeRowDistanceToCentroid(nRow, currentClusterIndex, bUseSparseMatrix);
+		if (bL2Norm)
+			upperBound = sqrt(upperBound);
+		cvInstancesUpperBounds.SetAt(nPosition, upperBound);
+
+		if (upperBound <= threshold) {
+			lComputedDistances++;
+			lPrunedDistances += nbClusters - 1;
+			return currentClusterIndex;
+		}
+	}
+
+	// calcul des distances a tous les centroides, en memorisant la plus petite et la seconde plus petite.
+	// Comme pour les autres methodes de recherche, le cluster courant est prioritaire en cas d'egalite, puis les clusters par index croissant
+	int nearestClusterIndex = currentClusterIndex;
+	Continuous minimumDistance; // distances au carre en norme L2
+	Continuous secondMinimumDistance = KWContinuous::GetMaxValue();
+
+	minimumDistance = ComputeRowDistanceToCentroid(nRow, currentClusterIndex, bUseSparseMatrix);
+
+	for (int idxCluster = 0; idxCluster < nbClusters; idxCluster++) {
+
+		if (idxCluster == currentClusterIndex)
+			continue;
+
+		const Continuous distance = ComputeRowDistanceToCentroid(nRow, idxCluster, bUseSparseMatrix);
+
+		if (distance < minimumDistance) {
+			secondMinimumDistance = minimumDistance;
 			minimumDistance = distance;
 			nearestClusterIndex = idxCluster;
 		}
+		else
+			if (distance < secondMinimumDistance)
+				secondMinimumDistance = distance;
 	}
 
-	return cast(KMCluster*, kmClusters->GetAt(nearestClusterIndex));
+	lComputedDistances += nbClusters;
+
+	if (nbClusters == 1)
+		secondMinimumDistance = 0;
+
+	cvInstancesUpperBounds.SetAt(nPosition, bL2Norm ? sqrt(minimumDistance) : minimumDistance);
+	cvInstancesLowerBounds.SetAt(nPosition, bL2Norm ? sqrt(secondMinimumDistance) : secondMinimumDistance);
+
+	return nearestClusterIndex;
+}
+
+Continuous KMClustering::ComputeMetricDistanceToCentroid(const Continuous* instanceValues, const int clusterIndex) const {
+
+	const int nbValues = dmClustersCentroids.GetRowStride();
+	const Continuous* centroidValues = dmClustersCentroids.GetRowAt(clusterIndex);
+
+	if (parameters->GetDistanceType() == KMParameters::L2Norm)
+		return sqrt(KMDistanceKernel::ComputeSquaredL2(instanceValues, centroidValues, nbValues));
+	else
+		return KMDistanceKernel::ComputeL1(instanceValues, centroidValues, nbValues);
+}
+
+int KMClustering::FindNearestClusterIndex(const Continuous* instanceValues, const int currentClusterIndex) const
+{
+	assert(instanceValues != NULL);
+	assert(dmClustersCentroids.GetRowNumber() == kmClusters->GetSize());
+
+	if (parameters->GetDistanceType() == KMParameters::L1Norm)
+		return FindNearestClusterIndexL1(instanceValues, currentClusterIndex);
+	else
+		if (parameters->GetDistanceType() == KMParameters::L2Norm)
+			return FindNearestClusterIndexL2(instanceValues, currentClusterIndex);
+		else
+			return FindNearestClusterIndexCosinus(instanceValues, currentClusterIndex);
+}
 
+boolean KMClustering::IsInstancesSparseMatrixUsable() const {
+
+	return instancesSparseMatrix != NULL and instancesMatrix != NULL and instancesSparseMatrix->GetRowNumber() == instancesMatrix->GetRowNumber() and
+		cvClustersCentroidsSquaredNorms.GetSize() == dmClustersCentroids.GetRowNumber();
+}
+
+Continuous KMClustering::ComputeSparseDistanceToCentroid(const int nRow, const int clusterIndex) const {
+
+	const Continuous distance = KMDistanceKernel::ComputeSparseDistance(instancesSparseMatrix->GetRowColumnsAt(nRow), instancesSparseMatrix->GetRowValuesAt(nRow),
+		instancesSparseMatrix->GetRowNonZeroNumberAt(nRow), instancesSparseMatrix->GetRowSquaredNormAt(nRow), dmClustersCentroids.GetRowAt(clusterIndex),
+		cvClustersCentroidsL1Norms.GetAt(clusterIndex), cvClustersCentroidsSquaredNorms.GetAt(clusterIndex), parameters->GetDistanceType());
+
+	// la distance creuse complete les termes des colonnes non nulles de l'instance par le reste des normes du centroide, obtenu par difference :
+	// en mode debug, on verifie l'ecart avec la distance calculee a partir des valeurs K-Means de l'instance, relativement aux normes
+	assert(cast(KMCluster*, kmClusters->GetAt(clusterIndex))->GetModelingCentroidValues().GetSize() == 0 or
+		fabs(distance - KMDistanceKernel::ComputeDistance(instancesMatrix->GetInstanceAt(nRow), cast(KMCluster*, kmClusters->GetAt(clusterIndex))->GetModelingCentroidValues(),
+			parameters->GetKMeanAttributesLoadIndexes(), parameters->GetDistanceType())) <=
+		SPARSE_DISTANCE_TOLERANCE * (1 + instancesSparseMatrix->GetRowSquaredNormAt(nRow) + cvClustersCentroidsSquaredNorms.GetAt(clusterIndex) +
+			cvClustersCentroidsL1Norms.GetAt(clusterIndex)));
+
+	return distance;
+}
+
+Continuous KMClustering::ComputeRowDistanceToCentroid(const int nRow, const int clusterIndex, const boolean bUseSparseMatrix) const {
+
+	if (bUseSparseMatrix)
+		return ComputeSparseDistanceToCentroid(nRow, clusterIndex);
+	else
+		return KMDistanceKernel::ComputeDistance(instancesMatrix->GetRowAt(nRow), dmClustersCentroids.GetRowAt(clusterIndex),
+			dmClustersCentroids.GetRowStride(), parameters->GetDistanceType());
 }
 
-/** calculer les distances entre les diff�rents centres des clusters, afin de produire une matrice des distances,
-dont l'utilisation permettra une optimisation des performances */
+int KMClustering::FindNearestClusterIndexSparse(const int nRow, const int currentClusterIndex) const {
+
+	assert(IsInstancesSparseMatrixUsable());
+	assert(dmClustersCentroids.GetRowNumber() == kmClusters->GetSize());
+
+	// meme elagage par les distances inter-clusters que les methodes FindNearestClusterIndexXX (en L2, sur les racines des distances au carre)
+	const boolean bL2Norm = (parameters->GetDistanceType() == KMParameters::L2Norm);
+	const int nbClusters = kmClusters->GetSize();
+	const int firstClusterToCheck = (currentClusterIndex == -1 ? 0 : currentClusterIndex);
+	int nearestClusterIndex = firstClusterToCheck;
+	Continuous minimumDistance = ComputeSparseDistanceToCentroid(nRow, firstClusterToCheck);
+
+	if (currentClusterIndex != -1) {
+		// distance entre le cluster de l'instance, et le cluster le plus proche de ce cluster
+		const int nearestToCurrentClusterIndex = cast(KMCluster*, kmClusters->GetAt(currentClusterIndex))->GetNearestCluster()->GetIndex();
+		const Continuous centersDistance = clustersCentersDistances.GetAt(nearestToCurrentClusterIndex, currentClusterIndex);
+
+		if ((bL2Norm ? sqrt(centersDistance) * 0.5 > sqrt(minimumDistance) : centersDistance * 0.5 > minimumDistance))
+			return currentClusterIndex; // l'instance ne changera pas de cluster, inutile de verifier pour les autres clusters
+	}
+
+	for (int idxCluster = 0; idxCluster < nbClusters; idxCluster++) {
+
+		if (idxCluster == firstClusterToCheck)
+			continue; // cluster deja traite
+
+		const Continuous centersDistance = clustersCentersDistances.GetAt(nearestClusterIndex, idxCluster);
+
+		if ((bL2Norm ? 0.5 * sqrt(centersDistance) < sqrt(minimumDistance) : 0.5 * centersDistance < minimumDistance)) {
+
+			const Continuous distance = ComputeSparseDistanceToCentroid(nRow, idxCluster);
+
+			if (minimumDistance > distance) {
+				minimumDistance = distance;
+				nearestClusterIndex = idxCluster;
+			}
+		}
+	}
+
+	return nearestClusterIndex;
+}
+
+// NB. les methodes FindNearestClusterIndexXX reproduisent l'elagage par les distances inter-clusters des methodes FindNearestClusterXX,
+// mais les distances sont calculees en entier par les noyaux vectorises de KMDistanceKernel (sur toute la largeur des lignes, completees par des 0) :
+// l'ordre des sommations differe, et les affectations peuvent donc differer de celles des methodes FindNearestClusterXX en cas de quasi egalite
+
+int KMClustering::FindNearestClusterIndexL1(const Continuous* instanceValues, const int currentClusterIndex) const {
+
+	const int nbClusters = kmClusters->GetSize();
+	const int nbValues = dmClustersCentroids.GetRowStride();
+	const int firstClusterToCheck = (currentClusterIndex == -1 ? 0 : currentClusterIndex);
+	int nearestClusterIndex = firstClusterToCheck;
+	Continuous minimumDistance = KMDistanceKernel::ComputeL1(instanceValues, dmClustersCentroids.GetRowAt(firstClusterToCheck), nbValues);
+
+	if (currentClusterIndex != -1) {
+		// distance entre le cluster de l'instance, et le cluster le plus proche de ce cluster
+		const int nearestToCurrentClusterIndex = cast(KMCluster*, kmClusters->GetAt(currentClusterIndex))->GetNearestCluster()->GetIndex();
+
+		if (clustersCentersDistances.GetAt(nearestToCurrentClusterIndex, currentClusterIndex) * 0.5 > minimumDistance)
+			return currentClusterIndex; // l'instance ne changera pas de cluster, inutile de verifier pour les autres clusters
+	}
+
+	for (int idxCluster = 0; idxCluster < nbClusters; idxCluster++) {
+
+		if (idxCluster == firstClusterToCheck)
+			continue; // cluster deja traite
+
+		if (0.5 * clustersCentersDistances.GetAt(nearestClusterIndex, idxCluster) < minimumDistance) {
+
+			const Continuous distance = KMDistanceKernel::ComputeL1(instanceValues, dmClustersCentroids.GetRowAt(idxCluster), nbValues);
+
+			if (minimumDistance > distance) {
+				minimumDistance = distance;
+				nearestClusterIndex = idxCluster;
+			}
+		}
+	}
+
+	return nearestClusterIndex;
+}
+
+int KMClustering::FindNearestClusterIndexL2(const Continuous* instanceValues, const int currentClusterIndex) const {
+
+	const int nbClusters = kmClusters->GetSize();
+	const int nbValues = dmClustersCentroids.GetRowStride();
+	const int firstClusterToCheck = (currentClusterIndex == -1 ? 0 : currentClusterIndex);
+	int nearestClusterIndex = firstClusterToCheck;
+	Continuous minimumDistance = KMDistanceKernel::ComputeSquaredL2(instanceValues, dmClustersCentroids.GetRowAt(firstClusterToCheck), nbValues);
+
+	if (currentClusterIndex != -1) {
+		// distance entre le cluster de l'instance, et le cluster le plus proche de ce cluster
+		const int nearestToCurrentClusterIndex = cast(KMCluster*, kmClusters->GetAt(currentClusterIndex))->GetNearestCluster()->GetIndex();
+
+		if (sqrt(clustersCentersDistances.GetAt(nearestToCurrentClusterIndex, currentClusterIndex)) * 0.5 > sqrt(minimumDistance))
+			return currentClusterIndex; // l'instance ne changera pas de cluster, inutile de verifier pour les autres clusters
+	}
+
+	for (int idxCluster = 0; idxCluster < nbClusters; idxCluster++) {
+
+		if (idxCluster == firstClusterToCheck)
+			continue; // cluster deja traite
+
+		if (0.5 * sqrt(clustersCentersDistances.GetAt(nearestClusterIndex, idxCluster)) < sqrt(minimumDistance)) {
+
+			const Continuous distance = KMDistanceKernel::ComputeSquaredL2(instanceValues, dmClustersCentroids.GetRowAt(idxCluster), nbValues);
+
+			if (minimumDistance > distance) {
+				minimumDistance = distance;
+				nearestClusterIndex = idxCluster;
+			}
+		}
+	}
+
+	return nearestClusterIndex;
+}
+
+int KMClustering::FindNearestClusterIndexCosinus(const Continuous* instanceValues, const int currentClusterIndex) const {
+
+	const int nbClusters = kmClusters->GetSize();
+	const int nbValues = dmClustersCentroids.GetRowStride();
+	const int firstClusterToCheck = (currentClusterIndex == -1 ? 0 : currentClusterIndex);
+	int nearestClusterIndex = firstClusterToCheck;
+	Continuous minimumDistance = KMDistanceKernel::ComputeCosine(instanceValues, dmClustersCentroids.GetRowAt(firstClusterToCheck), nbValues);
+
+	if (currentClusterIndex != -1) {
+		// distance entre le cluster de l'instance, et le cluster le plus proche de ce cluster
+		const int nearestToCurrentClusterIndex = cast(KMCluster*, kmClusters->GetAt(currentClusterIndex))->GetNearestCluster()->GetIndex();
+
+		if (clustersCentersDistances.GetAt(nearestToCurrentClusterIndex, currentClusterIndex) * 0.5 > minimumDistance)
+			return currentClusterIndex; // l'instance ne changera pas de cluster, inutile de verifier pour les autres clusters
+	}
+
+	for (int idxCluster = 0; idxCluster < nbClusters; idxCluster++) {
+
+		if (idxCluster == firstClusterToCheck)
+			continue; // cluster deja traite
+
+		if (0.5 * clustersCentersDistances.GetAt(nearestClusterIndex, idxCluster) < minimumDistance) {
+
+			const Continuous distance = KMDistanceKernel::ComputeCosine(instanceValues, dmClustersCentroids.GetRowAt(idxCluster), nbValues);
+
+			if (minimumDistance > distance) {
+				minimumDistance = distance;
+				nearestClusterIndex = idxCluster;
+			}
+		}
+	}
+
+	return nearestClusterIndex;
+}
+
+/** calculer les distances entre les differents centres des clusters, afin de produire une matrice des distances,
+dont l'utilisation permettra une optimisation des performances. Seules les distances impliquant un cluster dont le centroide a change
+depuis le precedent calcul (cluster ajoute, deplace, supprime ou reordonne) sont recalculees */
 void KMClustering::ComputeClustersCentersDistances(const boolean bUseEvaluationCentroids) {
 
 	const int nbClusters = GetClusters()->GetSize();
-	assert(clustersCentersDistances != NULL);
+	IntVector ivChangedClusters;
+	IntVector ivChangedClustersIndexes;
+	int i;
+	int j;
+
+	// la matrice est allouee une seule fois par clustering, pour le nombre de clusters demande (elle n'est agrandie qu'en cas de depassement)
+	clustersCentersDistances.Reserve(parameters->GetKValue() > nbClusters ? parameters->GetKValue() : nbClusters);
+
+	// mise a jour de la version dense des centroides, utilisee pour les affectations a partir de la matrice dense des instances,
+	// ainsi que pour le calcul vectorise des distances inter-clusters
+	boolean bUseDenseCentroids = (instancesMatrix != NULL and not bUseEvaluationCentroids);
+
+	// memoire insuffisante pour les centroides denses : on poursuit a partir des instances de la base, sans les matrices d'instances
+	if (bUseDenseCentroids and not dmClustersCentroids.InitializeFromCentroids(kmClusters, instancesMatrix)) {
+		AddWarning("Not enough memory for the dense matrix of the clusters centroids: the K-Means instances matrix is no longer used");
+		DetachInstancesMatrices();
+		bUseDenseCentroids = false;
+	}
+
+	if (bUseDenseCentroids) {
+
+		// normes des centroides, pour les distances calculees a partir des seules valeurs non nulles des instances
+		cvClustersCentroidsL1Norms.SetSize(0);
+		cvClustersCentroidsSquaredNorms.SetSize(0);
+
+		if (instancesSparseMatrix != NULL) {
+
+			cvClustersCentroidsL1Norms.SetSize(nbClusters);
+			cvClustersCentroidsSquaredNorms.SetSize(nbClusters);
+
+			for (i = 0; i < nbClusters; i++) {
+
+				const Continuous* centroidValues = dmClustersCentroids.GetRowAt(i);
+				Continuous cL1Norm = 0;
+				Continuous cSquaredNorm = 0;
 
-	// suppression des anciennes distances
-	for (int i = 0; i < KMParameters::K_MAX_VALUE; i++) {
-		if (clustersCentersDistances[i] != NULL) {
-			delete[] clustersCentersDistances[i];
-			clustersCentersDistances[i] = NULL;
+				for (j = 0; j < dmClustersCentroids.GetColumnNumber(); j++) {
+					cL1Norm += fabs(centroidValues[j]);
+					cSquaredNorm += centroidValues[j] * centroidValues[j];
+				}
+				cvClustersCentroidsL1Norms.SetAt(i, cL1Norm);
+				cvClustersCentroidsSquaredNorms.SetAt(i, cSquaredNorm);
+			}
 		}
 	}
 
-	for (int i = 0; i < nbClusters; i++) {
+	// en cas de changement de type de centroides, toutes les distances sont a recalculer
+	if (bUseEvaluationCentroids != bCentersDistancesEvaluationCentroids or bUseDenseCentroids != bCentersDistancesDenseCentroids) {
+		oaCentersDistancesCentroids.DeleteAll();
+		bCentersDistancesEvaluationCentroids = bUseEvaluationCentroids;
+		bCentersDistancesDenseCentroids = bUseDenseCentroids;
+	}
 
-		KMCluster* cluster1 = cast(KMCluster*, kmClusters->GetAt(i));
+	// reperer les clusters dont le centroide a change depuis le precedent calcul
+	ivChangedClusters.SetSize(nbClusters);
 
-		clustersCentersDistances[i] = new Continuous[nbClusters];
+	for (i = 0; i < nbClusters; i++) {
 
-		cluster1->SetIndex(i); // pour acceder a cette distance ulterieurement, garder la memoire de l'index de chaque cluster
+		KMCluster* cluster = cast(KMCluster*, kmClusters->GetAt(i));
 
-		for (int j = 0; j < nbClusters; j++) {
+		cluster->SetIndex(i); // pour acceder a cette distance ulterieurement, garder la memoire de l'index de chaque cluster
+
+		const ContinuousVector& cvCentroid = (bUseEvaluationCentroids ? cluster->GetEvaluationCentroidValues() : cluster->GetModelingCentroidValues());
+		boolean bChanged = true;
+
+		if (i == oaCentersDistancesCentroids.GetSize())
+			oaCentersDistancesCentroids.Add(new ContinuousVector);
+		else {
+			const ContinuousVector* cvPreviousCentroid = cast(ContinuousVector*, oaCentersDistancesCentroids.GetAt(i));
+
+			if (cvPreviousCentroid->GetSize() == cvCentroid.GetSize()) {
+				bChanged = false;
+				for (j = 0; j < cvCentroid.GetSize(); j++) {
+					if (cvPreviousCentroid->GetAt(j) != cvCentroid.GetAt(j)) {
+						bChanged = true;
+						break;
+					}
+				}
+			}
+		}
+
+		if (bChanged) {
+			cast(ContinuousVector*, oaCentersDistancesCentroids.GetAt(i))->CopyFrom(&cvCentroid);
+			ivChangedClusters.SetAt(i, 1);
+			ivChangedClustersIndexes.Add(i);
+		}
+	}
+
+	// clusters supprimes depuis le precedent calcul
+	while (oaCentersDistancesCentroids.GetSize() > nbClusters) {
+		delete oaCentersDistancesCentroids.GetAt(oaCentersDistancesCentroids.GetSize() - 1);
+		oaCentersDistancesCentroids.SetSize(oaCentersDistancesCentroids.GetSize() - 1);
+	}
+
+	// recalcul des seules distances impliquant au moins un cluster modifie (chaque distance entre 2 clusters modifies n'est calculee qu'une fois)
+	clustersCentersDistances.SetSize(nbClusters);
+
+	for (int n = 0; n < ivChangedClustersIndexes.GetSize(); n++) {
 
-			if (i == j) {
-				clustersCentersDistances[i][j] = 0.0;
-				continue;
-			}
-			else {
-				if (i > j) {
-					// la distance entre les 2 centres de clusters a deja ete calcul�e, la reporter
-					clustersCentersDistances[i][j] = clustersCentersDistances[j][i];
-					continue;
-				}
-			}
+		i = ivChangedClustersIndexes.GetAt(n);
 
-			KMCluster* cluster2 = cast(KMCluster*, kmClusters->GetAt(j));
+		for (j = 0; j < nbClusters; j++) {
 
-			const ContinuousVector& cluster1Centroids = (bUseEvaluationCentroids ? cluster1->GetEvaluationCentroidValues() : cluster1->GetModelingCentroidValues());
-			const ContinuousVector& cluster2Centroids = (bUseEvaluationCentroids ? cluster2->GetEvaluationCentroidValues() : cluster2->GetModelingCentroidValues());
+			if (i == j or (j > i and ivChangedClusters.GetAt(j) == 1))
+				continue;
 
-			if (cluster1Centroids.GetSize() == 0 or cluster2Centroids.GetSize() == 0)
-				clustersCentersDistances[i][j] = 0; // cas de clusters devenus vides lors de l'evaluation de test
-			else
-				clustersCentersDistances[i][j] = GetDistanceBetween(cluster1Centroids, cluster2Centroids, parameters->GetDistanceType(), parameters->GetKMeanAttributesLoadIndexes());
+			clustersCentersDistances.SetAt(i, j, ComputeClustersCentersDistance(i, j, bUseEvaluationCentroids, bUseDenseCentroids));
 		}
 	}
 
-
 	// pour chaque cluster, repertorier quel est le cluster qui en est le plus proche
-	// (aux fins d'optimisation de la vitesse d'execution, lors des affectations aux clusters)
+	// (aux fins d'optimisation de la vitesse d'execution, lors des affectations aux clusters).
+	// En cas d'egalite, le cluster de plus petit index est retenu
+	ivCentersDistancesNearestClusters.SetSize(nbClusters);
 
-	for (int i = 0; i < nbClusters; i++) {
+	for (i = 0; i < nbClusters; i++) {
 
-		double minimumDistance = -1;
+		int nearestClusterIndex = ivCentersDistancesNearestClusters.GetAt(i);
 
-		KMCluster* cluster = cast(KMCluster*, kmClusters->GetAt(i));
-		assert(cluster != NULL);
+		if (nbClusters == 1)
+			nearestClusterIndex = 0;
+		else
+			if (ivChangedClusters.GetAt(i) == 1 or nearestClusterIndex < 0 or nearestClusterIndex >= nbClusters or
+				nearestClusterIndex == i or ivChangedClusters.GetAt(nearestClusterIndex) == 1) {
 
-		// pour chaque cluster, m�moriser le pointeur du cluster qui lui est le plus proche
-		for (int j = 0; j < nbClusters; j++) {
+				// recherche sur toute la ligne
+				nearestClusterIndex = -1;
+				for (j = 0; j < nbClusters; j++) {
 
-			if (i == j and nbClusters > 1)
-				continue;
+					if (i == j)
+						continue;
+
+					if (nearestClusterIndex == -1 or clustersCentersDistances.GetAt(i, nearestClusterIndex) > clustersCentersDistances.GetAt(i, j))
+						nearestClusterIndex = j;
+				}
+			}
+			else {
+				// le cluster et son plus proche voisin sont inchanges : seuls les clusters modifies peuvent etre devenus plus proches
+				for (int n = 0; n < ivChangedClustersIndexes.GetSize(); n++) {
 
-			if (minimumDistance == -1 or minimumDistance > clustersCentersDistances[i][j]) {
+					j = ivChangedClustersIndexes.GetAt(n);
 
-				minimumDistance = clustersCentersDistances[i][j];
-				cluster->SetNearestCluster(cast(KMCluster*, kmClusters->GetAt(j)));
+					const Continuous distance = clustersCentersDistances.GetAt(i, j);
+					const Continuous minimumDistance = clustersCentersDistances.GetAt(i, nearestClusterIndex);
+
+					if (distance < minimumDistance or (distance == minimumDistance and j < nearestClusterIndex))
+						nearestClusterIndex = j;
+				}
 			}
-		}
+
+		ivCentersDistancesNearestClusters.SetAt(i, nearestClusterIndex);
+		cast(KMCluster*, kmClusters->GetAt(i))->SetNearestCluster(cast(KMCluster*, kmClusters->GetAt(nearestClusterIndex)));
 	}
+}
+
+Continuous KMClustering::ComputeClustersCentersDistance(const int i, const int j, const boolean bUseEvaluationCentroids, const boolean bUseDenseCentroids) const {
 
-	//for (int i = 0; i < nbClusters; i++){
-	//	if (clustersCentersDistances[i] != NULL){
-	//		cout << "cluster " << i << " : " << endl;
-	//		for (int j = 0; j < nbClusters; j++){
-	//			cout << "\tcluster " << j << " : distance = " << clustersCentersDistances[i][j] << endl;
-	//		}
-	//	}
-	//}
+	const KMCluster* cluster1 = cast(KMCluster*, kmClusters->GetAt(i));
+	const KMCluster* cluster2 = cast(KMCluster*, kmClusters->GetAt(j));
 
+	const ContinuousVector& cluster1Centroids = (bUseEvaluationCentroids ? cluster1->GetEvaluationCentroidValues() : cluster1->GetModelingCentroidValues());
+	const ContinuousVector& cluster2Centroids = (bUseEvaluationCentroids ? cluster2->GetEvaluationCentroidValues() : cluster2->GetModelingCentroidValues());
+
+	if (cluster1Centroids.GetSize() == 0 or cluster2Centroids.GetSize() == 0)
+		return 0; // cas de clusters devenus vides lors de l'evaluation de test
+	else
+		if (bUseDenseCentroids)
+			return KMDistanceKernel::ComputeDistance(dmClustersCentroids.GetRowAt(i), dmClustersCentroids.GetRowAt(j),
+				dmClustersCentroids.GetRowStride(), parameters->GetDistanceType());
+		else
+			return GetDistanceBetween(cluster1Centroids, cluster2Centroids, parameters->GetDistanceType(), parameters->GetKMeanAttributesLoadIndexes());
 }
 
 Continuous KMClustering::GetSimilarityBetween(const ContinuousVector& v1, const ContinuousVector& v2,
@@ -865,58 +1360,10 @@ Continuous KMClustering::GetDistanceBetween(const ContinuousVector& v1, const Co
 		// comparaison avec un cluster devenu vide ?
 		return KWContinuous::GetMaxValue();
 
-	Continuous result = 0.0;
-	const int size = kmeanAttributesLoadIndexes.GetSize();
-
-	// calcul de distance norme L2
-	if (distanceType == KMParameters::L2Norm) {
-
-		for (int i = 0; i < size; i++) {
-			const KWLoadIndex loadIndex = kmeanAttributesLoadIndexes.GetAt(i);
-			if (not loadIndex.IsValid())
-				continue;
-			const Continuous d = v1.GetAt(i) - v2.GetAt(i);
-			result += (d * d);
-		}
-	}
-	// norme L1
-	else {
-		if (distanceType == KMParameters::L1Norm) {
-			for (int i = 0; i < size; i++) {
-				const KWLoadIndex loadIndex = kmeanAttributesLoadIndexes.GetAt(i);
-				if (not loadIndex.IsValid())
-					continue;
-				result += fabs(v1.GetAt(i) - v2.GetAt(i));
-			}
-		}
-		else {
-
-			if (distanceType == KMParameters::CosineNorm) {
-				// norme cosinus
-
-				Continuous numeratorCosinus = 0.0;
-				Continuous denominatorInstanceCosinus = 0.0;
-				Continuous denominatorCentroidCosinus = 0.0;
-
-				for (int i = 0; i < size; i++) {
-					const KWLoadIndex loadIndex = kmeanAttributesLoadIndexes.GetAt(i);
-					if (not loadIndex.IsValid())
-						continue;
-					numeratorCosinus += v1.GetAt(i) * v2.GetAt(i);
-					denominatorInstanceCosinus += pow(v1.GetAt(i), 2);
-					denominatorCentroidCosinus += pow(v2.GetAt(i), 2);
-				}
-
-				Continuous denominator = sqrt(denominatorInstanceCosinus) * sqrt(denominatorCentroidCosinus);
-				result = 1 - (denominator == 0 ? 0 : numeratorCosinus / denominator);
-			}
-			else
-				assert(false);
-		}
-	}
-
-	return result;
+	assert(distanceType == KMParameters::L1Norm or distanceType == KMParameters::L2Norm or distanceType == KMParameters::CosineNorm);
 
+	// calcul par les noyaux de KMDistanceKernel, apres rassemblement des valeurs des attributs K-Means valides
+	return KMDistanceKernel::ComputeDistance(v1, v2, kmeanAttributesLoadIndexes, distanceType);
 }
 
 Continuous KMClustering::GetDistanceBetweenForAttribute(const int attributeLoadIndex, const ContinuousVector& v1, const ContinuousVector& v2,
@@ -1014,22 +1461,38 @@ int KMClustering::ManageEmptyClusters(const boolean continueClustering) {
 		ObjectArray oaInstances;
 
 		// etablir la liste compl�te des instances et de leurs distances
-		for (int i = 0; i < kmClusters->GetSize(); i++)
-		{
-			KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
-
-			POSITION position = c->GetStartPosition();
-			NUMERIC key;
-			Object* oCurrent;
+		if (IsInstancesMatrixUsable(oaMatrixInstances)) {
 
-			while (position != NULL) {
+			for (int i = 0; i < oaMatrixInstances->GetSize(); i++) {
 
-				c->GetNextAssoc(position, key, oCurrent);
-				KWObject* object = static_cast<KWObject *>(oCurrent);
+				const int idCluster = instancesMembership.GetClusterIndexAt(i);
 
-				if (object != NULL) {
+				if (idCluster != -1) {
+					KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(idCluster));
+					KWObject* object = cast(KWObject*, oaMatrixInstances->GetAt(i));
 					double d = c->FindDistanceFromCentroid(object, c->GetModelingCentroidValues(), parameters->GetDistanceType());
-					oaInstances.Add(new KMInstance(object, i, d));
+					oaInstances.Add(new KMInstance(object, idCluster, d, i));
+				}
+			}
+		}
+		else {
+			for (int i = 0; i < kmClusters->GetSize(); i++)
+			{
+				KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
+
+				POSITION position = c->GetStartPosition();
+				NUMERIC key;
+				Object* oCurrent;
+
+				while (position != NULL) {
+
+					c->GetNextAssoc(position, key, oCurrent);
+					KWObject* object = static_cast<KWObject *>(oCurrent);
+
+					if (object != NULL) {
+						double d = c->FindDistanceFromCentroid(object, c->GetModelingCentroidValues(), parameters->GetDistanceType());
+						oaInstances.Add(new KMInstance(object, i, d));
+					}
 				}
 			}
 		}
@@ -1046,20 +1509,30 @@ int KMClustering::ManageEmptyClusters(const boolean continueClustering) {
 			if (c->GetFrequency() == 0) {
 
 				KMInstance* inst = cast(KMInstance*, oaInstances.GetAt(instanceIdx++));
-				c->AddInstance(cast(KWObject*, inst->instance));
 
-				// enlever l'instance de l'ancien cluster :
-				KMCluster* oldCluster = cast(KMCluster*, GetClusters()->GetAt(inst->idCluster));
-				oldCluster->RemoveInstance((KWObject*)inst->instance);
+				// maj de la correspondance entre instances et clusters (en cours d'iterations, les dictionnaires d'instances des clusters
+				// ne sont pas utilises avec la matrice dense)
+				if (inst->position != -1)
+					MoveInstanceInMembership(inst->position, i);
+				else {
+					c->AddInstance(cast(KWObject*, inst->instance));
+
+					// enlever l'instance de l'ancien cluster :
+					KMCluster* oldCluster = cast(KMCluster*, GetClusters()->GetAt(inst->idCluster));
+					oldCluster->RemoveInstance((KWObject*)inst->instance);
 
-				// maj de la correspondance entre instances et clusters
-				instancesToClusters->SetAt((KWObject*)inst->instance, c);
+					instancesToClusters->SetAt((KWObject*)inst->instance, c);
+				}
 			}
 		}
+		bInstancesBoundsUpToDate = false;
 
 		oaInstances.DeleteAll();
 
 		// remettre a jour les stats, pour les clusters qui ont �t� modifi�s
+		if (IsInstancesMatrixUsable(oaMatrixInstances))
+			ComputeIterationStatisticsFromMembership();
+
 		for (int i = 0; i < kmClusters->GetSize(); i++)
 		{
 			KMCluster* c = cast(KMCluster*, kmClusters->GetAt(i));
@@ -1434,7 +1907,7 @@ void KMClustering::ComputeTrainingConfusionMatrix(const KWAttribute* targetAttri
 }
 
 
-void KMClustering::UpdateConfusionMatrix(const Symbol& sPredictedTarget, const Symbol& sActualTarget) {
+void KMClustering::UpdateConfusionMatrix(const Symbol& sPredictedTarget, const Symbol& sActualTarget, const int nFrequency) {
 
 	assert(oaTargetAttributeValues.GetSize() > 0);
 	assert(kwftConfusionMatrix != NULL);
@@ -1499,7 +1972,7 @@ void KMClustering::UpdateConfusionMatrix(const Symbol& sPredictedTarget, const S
 
 	KWDenseFrequencyVector* fv = cast(KWDenseFrequencyVector*, kwftConfusionMatrix->GetFrequencyVectorAt(idxPredictedTarget));
 	fv->GetFrequencyVector()->SetAt(idxActualTarget,
-		fv->GetFrequencyVector()->GetAt(idxActualTarget) + 1);
+		fv->GetFrequencyVector()->GetAt(idxActualTarget) + nFrequency);
 
 }
 
@@ -1585,17 +2058,40 @@ void KMClustering::AddInstancesToClusters(const ObjectArray* instances) {
 	instancesToClusters->RemoveAll();
 
 	// reaffecter les instances aux clusters, en fonction de leurs centroides precedemment calcul�s
-	for (int i = 0; i < instances->GetSize(); i++) {
-		KWObject* instance = cast(KWObject*, instances->GetAt(i));
-		if (parameters->HasMissingKMeanValue(instance)) {
-			clusteringInitializer->IncrementInstancesWithMissingValuesNumber();
-			continue;
+	if (instancesMatrix != NULL and instances == oaMatrixInstances and GetClusters()->GetSize() > 0) {
+
+		// version optimisee, a partir de la matrice dense des instances
+		const boolean bUseSparseMatrix = IsInstancesSparseMatrixUsable();
+		bInstancesBoundsUpToDate = false;
+		bMembershipSumsUpToDate = false;
+		for (int i = 0; i < instances->GetSize(); i++) {
+
+			instancesMembership.SetClusterIndexAt(i, -1);
+
+			const int nRow = ivInstancesRows.GetAt(i);
+			if (instancesMatrix->IsMissingValueRow(nRow)) {
+				clusteringInitializer->IncrementInstancesWithMissingValuesNumber();
+				continue;
+			}
+			instancesMembership.SetClusterIndexAt(i, bUseSparseMatrix ? FindNearestClusterIndexSparse(nRow, -1) : FindNearestClusterIndex(instancesMatrix->GetRowAt(nRow), -1));
 		}
-		KMCluster* c = FindNearestCluster(instance);
 
-		if (c != NULL) {
-			c->AddInstance(instance);
-			instancesToClusters->SetAt(instance, c);
+		// les dictionnaires restent utilises en dehors des iterations (initialisations, matrice de confusion, etc)
+		UpdateClustersInstancesFromMembership();
+	}
+	else {
+		for (int i = 0; i < instances->GetSize(); i++) {
+			KWObject* instance = cast(KWObject*, instances->GetAt(i));
+			if (parameters->HasMissingKMeanValue(instance)) {
+				clusteringInitializer->IncrementInstancesWithMissingValuesNumber();
+				continue;
+			}
+			KMCluster* c = FindNearestCluster(instance);
+
+			if (c != NULL) {
+				c->AddInstance(instance);
+				instancesToClusters->SetAt(instance, c);
+			}
 		}
 	}
 
@@ -1607,8 +2103,366 @@ void KMClustering::AddInstancesToClusters(const ObjectArray* instances) {
 
 }
 
+void KMClustering::UpdateClustersInstancesFromMembership() {
+
+	assert(IsInstancesMatrixUsable(oaMatrixInstances));
+
+	const int nbClusters = kmClusters->GetSize();
+	const int nbColumns = instancesMatrix->GetColumnNumber();
+	const boolean bUseMembershipSums = (bMembershipSumsUpToDate and dmMembershipSums.GetRowNumber() == nbClusters);
+	const boolean bUseSparseMatrix = (instancesSparseMatrix != NULL and instancesSparseMatrix->GetRowNumber() == instancesMatrix->GetRowNumber());
+	ContinuousVector cvSums;
+	int nColumn;
+
+	instancesMembership.BuildClustersLists(nbClusters);
+	instancesToClusters->RemoveAll();
+	cvSums.SetSize(parameters->GetKMeanAttributesLoadIndexes().GetSize());
+
+	// les instances sont ajoutees cluster par cluster, dans l'ordre des positions, sans modifier les statistiques deja calculees
+	for (int k = 0; k < nbClusters; k++) {
+
+		KMCluster* c = cast(KMCluster*, kmClusters->GetAt(k));
+		const bool bStatisticsUpToDate = c->IsStatisticsUpToDate();
+
+		c->RemoveAll();
+		cvSums.Initialize();
+
+		for (int i = 0; i < instancesMembership.GetClusterFrequencyAt(k); i++) {
+			const int nPosition = instancesMembership.GetClusterPositionAt(k, i);
+			KWObject* instance = cast(KWObject*, oaMatrixInstances->GetAt(nPosition));
+			c->AddInstance(instance);
+			instancesToClusters->SetAt(instance, c);
+
+			// a defaut de sommes par cluster a jour, cumul des lignes des instances
+			if (not bUseMembershipSums) {
+				const int nRow = ivInstancesRows.GetAt(nPosition);
+
+				if (bUseSparseMatrix) {
+					const int* nColumns = instancesSparseMatrix->GetRowColumnsAt(nRow);
+					const Continuous* cValues = instancesSparseMatrix->GetRowValuesAt(nRow);
+					for (int j = 0; j < instancesSparseMatrix->GetRowNonZeroNumberAt(nRow); j++)
+						cvSums.UpgradeAt(instancesMatrix->GetAttributeRankAt(nColumns[j]), cValues[j]);
+				}
+				else {
+					const Continuous* instanceValues = instancesMatrix->GetRowAt(nRow);
+					for (nColumn = 0; nColumn < nbColumns; nColumn++)
+						cvSums.UpgradeAt(instancesMatrix->GetAttributeRankAt(nColumn), instanceValues[nColumn]);
+				}
+			}
+		}
+
+		if (bUseMembershipSums) {
+			const Continuous* sumValues = dmMembershipSums.GetRowAt(k);
+			for (nColumn = 0; nColumn < nbColumns; nColumn++)
+				cvSums.SetAt(instancesMatrix->GetAttributeRankAt(nColumn), sumValues[nColumn]);
+		}
+
+		// sommes courantes du cluster, pour les calculs de centroides ulterieurs a partir des KWObject (post-optimisation, finalisation du replicate)
+		c->InitializeRunningSums(cvSums);
+		c->SetStatisticsUpToDate(bStatisticsUpToDate);
+	}
+}
+
+void KMClustering::ComputeIterationStatisticsFromMembership() {
+
+	assert(IsInstancesMatrixUsable(oaMatrixInstances));
+
+	const int nbClusters = kmClusters->GetSize();
+	const int nbColumns = instancesMatrix->GetColumnNumber();
+	const int nbPositions = instancesMembership.GetPositionNumber();
+	const boolean bUseSparseMatrix = (instancesSparseMatrix != NULL and instancesSparseMatrix->GetRowNumber() == instancesMatrix->GetRowNumber());
+	int nThreads = parameters->GetEffectiveThreadsNumber();
+	int t;
+	int k;
+
+	// effectifs des clusters
+	instancesMembership.BuildClustersLists(nbClusters);
+
+	// calcul complet des sommes si elles ne sont pas (ou plus) synchronisees avec le tableau d'appartenance : tous les clusters sont alors a recalculer
+	const boolean bFullComputation = (not bMembershipSumsUpToDate or dmMembershipSums.GetRowNumber() != nbClusters or
+		dmIterationCentroids.GetRowNumber() != nbClusters or ivMembershipChangedClusters.GetSize() != nbClusters);
+
+	// ne pas lancer de threads pour des volumes trop faibles
+	if (nThreads > nbPositions / MIN_INSTANCES_BY_THREAD)
+		nThreads = nbPositions / MIN_INSTANCES_BY_THREAD;
+	if (nThreads < 1)
+		nThreads = 1;
+
+	// chaque thread supplementaire cumule ses propres sommes partielles des centroides : leur nombre est limite par la memoire disponible
+	const longint lThreadMemory = KMDenseMatrix::ComputeRequiredMemory(nbClusters, nbColumns);
+	if (nThreads > 1 and bFullComputation and lThreadMemory * (nThreads - 1) > RMResourceManager::GetRemainingAvailableMemory() / 2)
+		nThreads = 1 + (int)(RMResourceManager::GetRemainingAvailableMemory() / 2 / lThreadMemory);
+
+	// tampons dimensionnes avant le lancement des threads (l'allocateur n'est pas thread-safe) : le premier thread cumule directement dans dmMembershipSums,
+	// les suivants dans leurs lignes de dmThreadsCentroidsSums (une ligne par couple thread, cluster)
+	if (bFullComputation) {
+
+		// memoire insuffisante : on poursuit a partir des instances de la base, les statistiques des clusters etant recalculees a partir de leurs dictionnaires
+		if (not dmMembershipSums.SetDimensions(nbClusters, nbColumns) or not dmIterationCentroids.SetDimensions(nbClusters, nbColumns)) {
+			AddWarning("Not enough memory for the sums of the clusters instances: the K-Means instances matrix is no longer used");
+			DetachInstancesMatrices();
+			for (k = 0; k < nbClusters; k++)
+				cast(KMCluster*, kmClusters->GetAt(k))->SetStatisticsUpToDate(false);
+			return;
+		}
+		if (nThreads > 1 and not dmThreadsCentroidsSums.SetDimensions((nThreads - 1) * nbClusters, nbColumns))
+			nThreads = 1;
+		cvIterationCentroidsL1Norms.SetSize(nbClusters);
+		cvIterationCentroidsSquaredNorms.SetSize(nbClusters);
+		cvIterationDistancesSums.SetSize(nbClusters);
+		ivMembershipChangedClusters.SetSize(nbClusters);
+		for (k = 0; k < nbClusters; k++)
+			ivMembershipChangedClusters.SetAt(k, 1);
+
+		// cumul des instances de chaque cluster, chaque thread traitant une tranche contigue de positions
+		if (nThreads == 1)
+			ComputeIterationCentroidsSumsRange(0, nbPositions, bUseSparseMatrix, &dmMembershipSums, 0);
+		else {
+			std::thread* threads = new std::thread[nThreads];
+
+			for (t = 0; t < nThreads; t++) {
+
+				const int nFirstPosition = (int)(((longint)nbPositions * t) / nThreads);
+				const int nLastPosition = (int)(((longint)nbPositions * (t + 1)) / nThreads);
+				KMDenseMatrix* sums = (t == 0 ? &dmMembershipSums : &dmThreadsCentroidsSums);
+				const int nFirstRow = (t == 0 ? 0 : (t - 1) * nbClusters);
+
+				threads[t] = std::thread([this, nFirstPosition, nLastPosition, bUseSparseMatrix, sums, nFirstRow]() {
+					ComputeIterationCentroidsSumsRange(nFirstPosition, nLastPosition, bUseSparseMatrix, sums, nFirstRow);
+					});
+			}
+
+			for (t = 0; t < nThreads; t++)
+				threads[t].join();
+
+			delete[] threads;
+		}
+
+		// fusion des sommes partielles dans l'ordre des threads (resultat identique d'une execution a l'autre, pour un nombre de threads donne)
+		for (k = 0; k < nbClusters; k++) {
+
+			Continuous* sumValues = dmMembershipSums.GetRowAt(k);
+
+			for (t = 1; t < nThreads; t++) {
+				const Continuous* threadSumValues = dmThreadsCentroidsSums.GetRowAt((t - 1) * nbClusters + k);
+				for (int nColumn = 0; nColumn < nbColumns; nColumn++)
+					sumValues[nColumn] += threadSumValues[nColumn];
+			}
+		}
+
+		bMembershipSumsUpToDate = true;
+		lMembershipSumsUpdates = 0;
+	}
+
+	// centroides moyens des clusters modifies, et positions de leurs instances
+	ivChangedClustersPositions.SetSize(0);
+
+	for (k = 0; k < nbClusters; k++) {
+
+		if (ivMembershipChangedClusters.GetAt(k) == 0)
+			continue;
+
+		const Continuous* sumValues = dmMembershipSums.GetRowAt(k);
+		Continuous* centroidValues = dmIterationCentroids.GetRowAt(k);
+		const int nFrequency = instancesMembership.GetClusterFrequencyAt(k);
+		Continuous cL1Norm = 0;
+		Continuous cSquaredNorm = 0;
+
+		for (int nColumn = 0; nColumn < nbColumns; nColumn++) {
+			centroidValues[nColumn] = (nFrequency > 0 ? sumValues[nColumn] / nFrequency : 0);
+			cL1Norm += fabs(centroidValues[nColumn]);
+			cSquaredNorm += centroidValues[nColumn] * centroidValues[nColumn];
+		}
+		cvIterationCentroidsL1Norms.SetAt(k, cL1Norm);
+		cvIterationCentroidsSquaredNorms.SetAt(k, cSquaredNorm);
+		cvIterationDistancesSums.SetAt(k, 0);
+
+		for (int i = 0; i < nFrequency; i++)
+			ivChangedClustersPositions.Add(instancesMembership.GetClusterPositionAt(k, i));
+	}
+
+	// sommes des distances aux nouveaux centroides, pour les seules instances des clusters modifies
+	const int nbChangedPositions = ivChangedClustersPositions.GetSize();
+
+	if (nThreads > nbChangedPositions / MIN_INSTANCES_BY_THREAD)
+		nThreads = nbChangedPositions / MIN_INSTANCES_BY_THREAD;
+	if (nThreads < 1)
+		nThreads = 1;
+
+	dmThreadsDistancesSums.SetDimensions(nThreads, nbClusters);
+
+	if (nThreads == 1)
+		ComputeIterationDistancesSumsRange(0, nbChangedPositions, bUseSparseMatrix, dmThreadsDistancesSums.GetRowAt(0));
+	else {
+		std::thread* threads = new std::thread[nThreads];
+
+		for (t = 0; t < nThreads; t++) {
+
+			const int nFirst = (int)(((longint)nbChangedPositions * t) / nThreads);
+			const int nLast = (int)(((longint)nbChangedPositions * (t + 1)) / nThreads);
+			Continuous* cDistancesSums = dmThreadsDistancesSums.GetRowAt(t);
+
+			threads[t] = std::thread([this, nFirst, nLast, bUseSparseMatrix, cDistancesSums]() {
+				ComputeIterationDistancesSumsRange(nFirst, nLast, bUseSparseMatrix, cDistancesSums);
+				});
+		}
+
+		for (t = 0; t < nThreads; t++)
+			threads[t].join();
+
+		delete[] threads;
+	}
+
+	for (t = 0; t < nThreads; t++) {
+		const Continuous* cDistancesSums = dmThreadsDistancesSums.GetRowAt(t);
+		for (k = 0; k < nbClusters; k++) {
+			if (ivMembershipChangedClusters.GetAt(k) == 1)
+				cvIterationDistancesSums.UpgradeAt(k, cDistancesSums[k]);
+		}
+	}
+
+	// report des resultats dans les clusters modifies (les attributs K-Means non valides ont un centroide nul)
+	ContinuousVector cvCentroid;
+	cvCentroid.SetSize(parameters->GetKMeanAttributesLoadIndexes().GetSize());
+
+	for (k = 0; k < nbClusters; k++) {
+
+		KMCluster* c = cast(KMCluster*, kmClusters->GetAt(k));
+		const int nFrequency = instancesMembership.GetClusterFrequencyAt(k);
+
+		if (ivMembershipChangedClusters.GetAt(k) == 0) {
+			assert(c->GetFrequency() == nFrequency);
+			c->SetStatisticsUpToDate(true);
+			continue;
+		}
+
+		ivMembershipChangedClusters.SetAt(k, 0);
+		cvCentroid.Initialize();
+		c->SetFrequency(nFrequency);
+
+		if (nFrequency == 0) {
+			// le cluster a ete vide suite a une iteration
+			c->SetDistanceSum(KMParameters::L1Norm, 0);
+			c->SetDistanceSum(KMParameters::L2Norm, 0);
+			c->SetDistanceSum(KMParameters::CosineNorm, 0);
+		}
+		else {
+			const Continuous* centroidValues = dmIterationCentroids.GetRowAt(k);
+			for (int nColumn = 0; nColumn < nbColumns; nColumn++)
+				cvCentroid.SetAt(instancesMatrix->GetAttributeRankAt(nColumn), centroidValues[nColumn]);
+
+			c->SetDistanceSum(parameters->GetDistanceType(), cvIterationDistancesSums.GetAt(k));
+		}
+		c->SetModelingCentroidValues(cvCentroid);
+		c->SetStatisticsUpToDate(true);
+	}
+}
+
+void KMClustering::MoveInstanceInMembership(const int nPosition, const int nNewClusterIndex) {
+
+	const int nOldClusterIndex = instancesMembership.GetClusterIndexAt(nPosition);
+
+	assert(nNewClusterIndex != nOldClusterIndex);
+
+	instancesMembership.SetClusterIndexAt(nPosition, nNewClusterIndex);
+
+	if (not bMembershipSumsUpToDate)
+		return;
+
+	const int nRow = ivInstancesRows.GetAt(nPosition);
+
+	if (nOldClusterIndex != -1) {
+		UpdateMembershipSums(nRow, nOldClusterIndex, -1);
+		ivMembershipChangedClusters.SetAt(nOldClusterIndex, 1);
+	}
+	if (nNewClusterIndex != -1) {
+		UpdateMembershipSums(nRow, nNewClusterIndex, 1);
+		ivMembershipChangedClusters.SetAt(nNewClusterIndex, 1);
+	}
+	lMembershipSumsUpdates++;
+}
+
+void KMClustering::UpdateMembershipSums(const int nRow, const int nClusterIndex, const int sign) {
+
+	assert(sign == 1 or sign == -1);
+
+	Continuous* sumValues = dmMembershipSums.GetRowAt(nClusterIndex);
+
+	if (instancesSparseMatrix != NULL and instancesSparseMatrix->GetRowNumber() == instancesMatrix->GetRowNumber()) {
+		// seules les valeurs non nulles de l'instance modifient les sommes
+		const int* nColumns = instancesSparseMatrix->GetRowColumnsAt(nRow);
+		const Continuous* cValues = instancesSparseMatrix->GetRowValuesAt(nRow);
+
+		for (int j = 0; j < instancesSparseMatrix->GetRowNonZeroNumberAt(nRow); j++)
+			sumValues[nColumns[j]] += sign * cValues[j];
+	}
+	else {
+		const Continuous* instanceValues = instancesMatrix->GetRowAt(nRow);
+
+		for (int nColumn = 0; nColumn < instancesMatrix->GetColumnNumber(); nColumn++)
+			sumValues[nColumn] += sign * instanceValues[nColumn];
+	}
+}
+
+void KMClustering::ComputeIterationCentroidsSumsRange(const int nFirstPosition, const int nLastPosition, const boolean bUseSparseMatrix,
+	KMDenseMatrix* sums, const int nFirstRow) {
+
+	const int nbColumns = instancesMatrix->GetColumnNumber();
+
+	for (int i = nFirstPosition; i < nLastPosition; i++) {
+
+		const int idCluster = instancesMembership.GetClusterIndexAt(i);
+		if (idCluster == -1)
+			continue;
+
+		const int nRow = ivInstancesRows.GetAt(i);
+		Continuous* sumValues = sums->GetRowAt(nFirstRow + idCluster);
+
+		if (bUseSparseMatrix) {
+			// on ne cumule que les valeurs non nulles de l'instance
+			const int* nColumns = instancesSparseMatrix->GetRowColumnsAt(nRow);
+			const Continuous* cValues = instancesSparseMatrix->GetRowValuesAt(nRow);
+
+			for (int j = 0; j < instancesSparseMatrix->GetRowNonZeroNumberAt(nRow); j++)
+				sumValues[nColumns[j]] += cValues[j];
+		}
+		else {
+			const Continuous* instanceValues = instancesMatrix->GetRowAt(nRow);
+
+			for (int nColumn = 0; nColumn < nbColumns; nColumn++)
+				sumValues[nColumn] += instanceValues[nColumn];
+		}
+	}
+}
+
+void KMClustering::ComputeIterationDistancesSumsRange(const int nFirst, const int nLast, const boolean bUseSparseMatrix, Continuous* cDistancesSums) {
+
+	const int nbColumns = instancesMatrix->GetColumnNumber();
+	const KMParameters::DistanceType distanceType = parameters->GetDistanceType();
+
+	for (int n = nFirst; n < nLast; n++) {
+
+		const int i = ivChangedClustersPositions.GetAt(n);
+		const int idCluster = instancesMembership.GetClusterIndexAt(i);
+		assert(idCluster != -1);
+
+		const int nRow = ivInstancesRows.GetAt(i);
+		const Continuous* centroidValues = dmIterationCentroids.GetRowAt(idCluster);
+
+		if (bUseSparseMatrix)
+			cDistancesSums[idCluster] += KMDistanceKernel::ComputeSparseDistance(instancesSparseMatrix->GetRowColumnsAt(nRow),
+				instancesSparseMatrix->GetRowValuesAt(nRow), instancesSparseMatrix->GetRowNonZeroNumberAt(nRow), instancesSparseMatrix->GetRowSquaredNormAt(nRow),
+				centroidValues, cvIterationCentroidsL1Norms.GetAt(idCluster), cvIterationCentroidsSquaredNorms.GetAt(idCluster), distanceType);
+		else
+			cDistancesSums[idCluster] += KMDistanceKernel::ComputeDistance(instancesMatrix->GetRowAt(nRow), centroidValues, nbColumns, distanceType);
+	}
+}
+
 void KMClustering::FinalizeReplicateComputing(bool recomputeCentroids) {
 
+	ObjectArray oaNonEmptyClusters;
+	longint lInstancesNumber = 0;
+
 	// recalculer les stats et centroides, au cas ou quelques instances n'ont pas �t� reaffect�es � leur cluster d'origine
 
 	for (int i = 0; i < GetClusters()->GetSize(); i++) {
@@ -1616,10 +2470,9 @@ void KMClustering::FinalizeReplicateComputing(bool recomputeCentroids) {
 		KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
 
 		if (recomputeCentroids)
-			c->ComputeIterationStatistics(); // maj des centroides et de la somme des distances, pour la norme choisie. Cette methode doit etre ex�cut�e y compris si un cluster est devenu vide
+			c->ComputeIterationStatistics(false); // maj des centroides (les sommes des distances sont calculees ci-dessous). Cette methode doit etre ex�cut�e y compris si un cluster est devenu vide
 		else {
 			// conserver les centroides existants
-			c->ComputeDistanceSum(GetParameters()->GetDistanceType());
 			c->SetFrequency(c->GetCount());
 			c->SetStatisticsUpToDate(true);
 		}
@@ -1627,26 +2480,49 @@ void KMClustering::FinalizeReplicateComputing(bool recomputeCentroids) {
 		if (c->GetFrequency() == 0) // teste si le cluster est devenu vide
 			continue;
 
-		c->ComputeInstanceNearestToCentroid(parameters->GetDistanceType());
+		// les tampons sont alloues avant le lancement des threads (l'allocateur n'est pas thread-safe)
+		c->ReserveFinalStatistics();
+		oaNonEmptyClusters.Add(c);
+		lInstancesNumber += c->GetCount();
+	}
 
-		// calculer les sommes des distances au centre du cluster (uniquement pour les normes pas encore calcul�es)
-		if (GetParameters()->GetDistanceType() == KMParameters::L1Norm) {
-			c->ComputeDistanceSum(KMParameters::L2Norm);
-			c->ComputeDistanceSum(KMParameters::CosineNorm);
-		}
-		else {
-			if (GetParameters()->GetDistanceType() == KMParameters::L2Norm) {
-				c->ComputeDistanceSum(KMParameters::L1Norm);
-				c->ComputeDistanceSum(KMParameters::CosineNorm);
-			}
-			else {
-				c->ComputeDistanceSum(KMParameters::L1Norm);
-				c->ComputeDistanceSum(KMParameters::L2Norm);
-			}
+	// sommes des distances pour toutes les normes, inerties intra (globale et par attribut, cf. indices Davies Bouldin)
+	// et instances la plus proche et la plus eloignee du centroide : une seule passe sur les instances de chaque cluster
+	int nThreads = parameters->GetEffectiveThreadsNumber();
+
+	// ne pas lancer de threads pour des volumes trop faibles
+	if (nThreads > lInstancesNumber / MIN_INSTANCES_BY_THREAD)
+		nThreads = (int)(lInstancesNumber / MIN_INSTANCES_BY_THREAD);
+	if (nThreads > oaNonEmptyClusters.GetSize())
+		nThreads = oaNonEmptyClusters.GetSize();
+
+	const KMParameters::DistanceType distanceType = parameters->GetDistanceType();
+
+	if (nThreads <= 1) {
+		for (int i = 0; i < oaNonEmptyClusters.GetSize(); i++)
+			cast(KMCluster*, oaNonEmptyClusters.GetAt(i))->ComputeFinalStatistics(distanceType);
+	}
+	else {
+		// chaque thread traite un cluster sur nThreads : chaque cluster n'ecrit que dans ses propres statistiques
+		std::thread* threads = new std::thread[nThreads];
+
+		for (int t = 0; t < nThreads; t++) {
+
+			threads[t] = std::thread([t, nThreads, distanceType, &oaNonEmptyClusters]() {
+				for (int i = t; i < oaNonEmptyClusters.GetSize(); i += nThreads)
+					cast(KMCluster*, oaNonEmptyClusters.GetAt(i))->ComputeFinalStatistics(distanceType);
+				});
 		}
-		c->ComputeInertyIntra(parameters->GetDistanceType()); // necessaire pour calculer l'indice Davies Bouldin
+
+		for (int t = 0; t < nThreads; t++)
+			threads[t].join();
+
+		delete[] threads;
 	}
 
+	for (int i = 0; i < oaNonEmptyClusters.GetSize(); i++)
+		cast(KMCluster*, oaNonEmptyClusters.GetAt(i))->ComputeFinalStatisticsInstances();
+
 	UpdateGlobalDistancesSum();
 
 }
@@ -1683,42 +2559,103 @@ void KMClustering::ComputeGlobalClusterStatistics(ObjectArray* instances) {
 
 	kmGlobalCluster = CreateGlobalCluster();
 
-	// construire le cluster global
-	for (int i = 0; i < instances->GetSize(); i++) {
-		KWObject* instance = cast(KWObject*, instances->GetAt(i));
-		if (parameters->HasMissingKMeanValue(instance))
-			continue;
-		kmGlobalCluster->AddInstance(instance);
+	// instances du cluster global : seules les instances completes, si elles ont ete reperees apres la lecture de la base
+	const KMMissingValuesIndex* missingValuesIndex = parameters->GetMissingValuesIndex();
+	const boolean bCompleteInstances = (missingValuesIndex != NULL and missingValuesIndex->IsIndexing(instances));
+	const ObjectArray* globalInstances = (bCompleteInstances ? missingValuesIndex->GetCompleteInstances() : instances);
+	const int nInstancesNumber = globalInstances->GetSize();
+
+	// les statistiques sont calculees en flux, sans inserer les instances dans le cluster global
+	int nThreads = parameters->GetEffectiveThreadsNumber();
+
+	// ne pas lancer de threads pour des volumes trop faibles
+	if (nThreads > nInstancesNumber / MIN_INSTANCES_BY_THREAD)
+		nThreads = nInstancesNumber / MIN_INSTANCES_BY_THREAD;
+	if (nThreads < 1)
+		nThreads = 1;
+
+	// un accumulateur par thread, dimensionne avant le lancement des threads. Chaque thread traite une tranche contigue de la base
+	ObjectArray oaStatistics;
+	for (int t = 0; t < nThreads; t++) {
+		KMGlobalStatistics* statistics = new KMGlobalStatistics;
+		statistics->Initialize(parameters);
+		oaStatistics.Add(statistics);
 	}
 
-	if (kmGlobalCluster->GetCount() == 0)
-		return;
+	// premiere passe : effectif, centroide, et sommes des distances en normes L2 et cosinus
+	std::thread* threads = new std::thread[nThreads];
+
+	for (int t = 0; t < nThreads; t++) {
+
+		threads[t] = std::thread([t, nThreads, nInstancesNumber, bCompleteInstances, globalInstances, &oaStatistics, this]() {
+			KMGlobalStatistics* statistics = cast(KMGlobalStatistics*, oaStatistics.GetAt(t));
+			const int nLast = (int)((longint)nInstancesNumber * (t + 1) / nThreads);
+			for (int i = (int)((longint)nInstancesNumber * t / nThreads); i < nLast; i++) {
+				KWObject* instance = cast(KWObject*, globalInstances->GetAt(i));
+				if (not bCompleteInstances and parameters->HasMissingKMeanValue(instance))
+					continue;
+				statistics->AddInstance(instance);
+			}
+			});
+	}
+
+	for (int t = 0; t < nThreads; t++)
+		threads[t].join();
+
+	KMGlobalStatistics* globalStatistics = cast(KMGlobalStatistics*, oaStatistics.GetAt(0));
+	for (int t = 1; t < nThreads; t++)
+		globalStatistics->Merge(cast(KMGlobalStatistics*, oaStatistics.GetAt(t)));
+
+	if (globalStatistics->GetFrequency() > 0) {
+
+		ContinuousVector cvCentroid;
+		globalStatistics->ComputeCentroid(cvCentroid);
+
+		// seconde passe, le centroide etant connu : somme des distances en norme L1, et instance la plus proche du centroide
+		for (int t = 0; t < nThreads; t++)
+			cast(KMGlobalStatistics*, oaStatistics.GetAt(t))->SetCentroid(cvCentroid);
 
-	kmGlobalCluster->ComputeIterationStatistics();
-	kmGlobalCluster->ComputeInstanceNearestToCentroid(parameters->GetDistanceType());
+		for (int t = 0; t < nThreads; t++) {
 
-	// calculer la distance dans les normes pas encore trait�es
-	if (GetParameters()->GetDistanceType() == KMParameters::L1Norm) {
-		kmGlobalCluster->ComputeDistanceSum(KMParameters::L2Norm);
-		kmGlobalCluster->ComputeDistanceSum(KMParameters::CosineNorm);
-	}
-	else {
-		if (GetParameters()->GetDistanceType() == KMParameters::L2Norm) {
-			kmGlobalCluster->ComputeDistanceSum(KMParameters::L1Norm);
-			kmGlobalCluster->ComputeDistanceSum(KMParameters::CosineNorm);
-		}
-		else {
-			kmGlobalCluster->ComputeDistanceSum(KMParameters::L1Norm);
-			kmGlobalCluster->ComputeDistanceSum(KMParameters::L2Norm);
+			threads[t] = std::thread([t, nThreads, nInstancesNumber, bCompleteInstances, globalInstances, &oaStatistics, this]() {
+				KMGlobalStatistics* statistics = cast(KMGlobalStatistics*, oaStatistics.GetAt(t));
+				const int nLast = (int)((longint)nInstancesNumber * (t + 1) / nThreads);
+				for (int i = (int)((longint)nInstancesNumber * t / nThreads); i < nLast; i++) {
+					KWObject* instance = cast(KWObject*, globalInstances->GetAt(i));
+					if (not bCompleteInstances and parameters->HasMissingKMeanValue(instance))
+						continue;
+					statistics->AddInstanceDistances(instance, i);
+				}
+				});
 		}
+
+		for (int t = 0; t < nThreads; t++)
+			threads[t].join();
+
+		for (int t = 1; t < nThreads; t++)
+			globalStatistics->MergeDistances(cast(KMGlobalStatistics*, oaStatistics.GetAt(t)));
+
+		kmGlobalCluster->SetFrequency(globalStatistics->GetFrequency());
+		kmGlobalCluster->SetModelingCentroidValues(cvCentroid);
+		kmGlobalCluster->SetDistanceSum(KMParameters::L1Norm, globalStatistics->GetL1DistanceSum());
+		kmGlobalCluster->SetDistanceSum(KMParameters::L2Norm, globalStatistics->GetL2DistanceSum());
+		kmGlobalCluster->SetDistanceSum(KMParameters::CosineNorm, globalStatistics->ComputeCosineDistanceSum());
+		kmGlobalCluster->UpdateInstanceNearestToCentroid(parameters->GetDistanceType(), globalStatistics->GetInstanceNearestToCentroid(), cvCentroid);
+		kmGlobalCluster->SetStatisticsUpToDate(true);
 	}
+
+	delete[] threads;
+	oaStatistics.DeleteAll();
 }
 
 void KMClustering::AddTargetAttributeValueIfNotExists(const KWAttribute* targetAttribute, const KWObject* instance) {
 
-	assert(kmGlobalCluster != NULL);
+	AddTargetAttributeValueIfNotExists(instance->GetSymbolValueAt(targetAttribute->GetLoadIndex()).GetValue());
+}
 
-	ALString value = instance->GetSymbolValueAt(targetAttribute->GetLoadIndex()).GetValue();
+int KMClustering::AddTargetAttributeValueIfNotExists(const ALString& value) {
+
+	assert(kmGlobalCluster != NULL);
 
 	// rechercher l'index correspondant a la valeur de la modalite, pour renseigner notre tableau d'occurences
 	int idx = 0;
@@ -1751,6 +2688,7 @@ void KMClustering::AddTargetAttributeValueIfNotExists(const KWAttribute* targetA
 	cv.SetSize(oaTargetAttributeValues.GetSize());
 	kmGlobalCluster->SetTargetProbs(cv);
 
+	return idx;
 }
 
 KMCluster* KMClustering::CreateGlobalCluster()
@@ -1799,12 +2737,7 @@ void KMClustering::CopyFrom(const KMClustering* aSource)
 	}
 
 	// copie des meilleurs clusters observ�s :
-	kmBestClusters->DeleteAll();
-	for (int i = 0; i < aSource->kmBestClusters->GetSize(); i++)
-	{
-		KMCluster* c = cast(KMCluster*, aSource->kmBestClusters->GetAt(i));
-		kmBestClusters->Add(c->Clone());
-	}
+	kmBestClustersSnapshot.CopyFrom(&aSource->kmBestClustersSnapshot);
 
 	// copie du cluster global (contenant toutes les instances)
 	if (kmGlobalCluster != NULL) {
@@ -1850,15 +2783,11 @@ void KMClustering::CopyFrom(const KMClustering* aSource)
 	attributesPartitioningManager->CopyFrom(aSource->attributesPartitioningManager);
 }
 
-void KMClustering::CloneBestClusters() {
+void KMClustering::SaveBestClusters() {
 
-	kmBestClusters->DeleteAll();
-
-	for (int i = 0; i < GetClusters()->GetSize(); i++)
-	{
-		KMCluster* c = cast(KMCluster*, kmClusters->GetAt(i));
-		kmBestClusters->Add(c->Clone());	// NB. on ne clone pas les instances elles-m�mes, mais uniquement les centroides et les stats
-	}
+	// NB. on ne memorise pas les instances elles-m�mes, mais uniquement les centroides et les stats modifies par les iterations.
+	// Les tampons du snapshot sont reutilises d'une iteration a l'autre
+	kmBestClustersSnapshot.Save(kmClusters);
 }
 
 
@@ -1900,11 +2829,36 @@ boolean KMClustering::PostOptimize(const ObjectArray* instances, const KWAttribu
 	double overAllBestEVA = GetClusteringQuality()->GetEVA();
 	int iBestK = kmClusters->GetSize();
 
-	NumericKeyDictionary* instancesToClustersByAscDistance = ComputeInstancesToClustersByAscDistance();// pour chaque instance, creer une liste des clusters tries par ordre de distance croissante
+	// pour chaque instance, liste des clusters les plus proches, tries par ordre de distance croissante
+	if (parameters->GetVerboseMode())
+		AddSimpleMessage("Computing nearest clusters lists, for each database instance...");
+
+	KMSortedNeighbors sortedNeighbors;
+	sortedNeighbors.SetNeighborNumber(parameters->GetPostOptimizationNeighborsNumber());
+	sortedNeighbors.Initialize(instances, kmClusters, parameters);
+
+	IntVector ivInstancesTargetIndexes;
+	ComputeInstancesTargetIndexes(&sortedNeighbors, targetAttribute, ivInstancesTargetIndexes);
+	IntVector ivAvailableClusters;
+
+	if (parameters->GetVerboseMode())
+		AddSimpleMessage("Done.");
+
 	KWFrequencyTable* currentClusteringModalitiesFrequenciesByClusters = CreateModalitiesFrequenciesByClusters(kmClusters);
 	KWFrequencyTable overallBestModalitiesFrequenciesByClusters;
 	NumericKeyDictionary* removedInstancesNewClusters = new NumericKeyDictionary;
 
+	// evaluation incrementale de l'EVA, et tampons de deplacements d'instances, un par thread d'evaluation des candidats a la suppression
+	// (leurs dimensions ne changent pas d'une valeur de K a l'autre)
+	KMIncrementalEVA incrementalEVA;
+	ObjectArray oaThreadsMoves;
+	for (int t = 0; t < parameters->GetEffectiveThreadsNumber() or t == 0; t++) {
+		KMEVAMoves* threadMoves = new KMEVAMoves;
+		threadMoves->Initialize(currentClusteringModalitiesFrequenciesByClusters->GetFrequencyVectorNumber(),
+			currentClusteringModalitiesFrequenciesByClusters->GetFrequencyVectorSize());
+		oaThreadsMoves.Add(threadMoves);
+	}
+
 	const double evaOneCluster =
 		GetClusteringQuality()->ComputeEVAFirstTerm(1, currentClusteringModalitiesFrequenciesByClusters) +
 		GetClusteringQuality()->ComputeEVASecondTerm(1, currentClusteringModalitiesFrequenciesByClusters) +
@@ -1947,17 +2901,27 @@ boolean KMClustering::PostOptimize(const ObjectArray* instances, const KWAttribu
 
 		KWFrequencyTable currentClusteringBestLocalFrequencies;
 
+		// les listes de clusters les plus proches doivent garder au moins deux clusters disponibles, pour que la suppression d'un candidat
+		// laisse toujours un cluster disponible a ses instances : les listes epuisees par les suppressions precedentes sont recalculees
+		ComputeAvailableClusters(currentClusteringModalitiesFrequenciesByClusters, ivAvailableClusters);
+		sortedNeighbors.Refill(&ivAvailableClusters, 2);
+
+		// contributions des lignes de la table courante a l'EVA, que chaque candidat ne fera que corriger
+		incrementalEVA.Initialize(currentClusteringModalitiesFrequenciesByClusters);
+
 		TaskProgression::DisplayLabel("Looking for best EVA when K = " + ALString(IntToString(currentClustering->GetClusters()->GetSize() - 1)) +
 			" (so far, best EVA is " + ALString(DoubleToString(overAllBestEVA)) + ", optimal K value is " + ALString(IntToString(iBestK)) + ")");
 
 		// rechercher le cluster dont la suppression produit la meilleure valeur d'EVA, pour la valeur de K en cours de test
 		KMCluster* clusterToRemove = PostOptimizationSearchClusterToRemove(currentClustering,
 			currentClusteringModalitiesFrequenciesByClusters,
-			instancesToClustersByAscDistance,
-			targetAttribute,
-			K,
+			&incrementalEVA,
+			&sortedNeighbors,
+			&ivAvailableClusters,
 			eVAallClustersFirstTerm,
 			evaOneCluster,
+			&ivInstancesTargetIndexes,
+			&oaThreadsMoves,
 			currentClusteringBestLocalFrequencies,
 			removedInstancesNewClusters,
 			nbClusteringsDone,
@@ -2086,24 +3050,24 @@ boolean KMClustering::PostOptimize(const ObjectArray* instances, const KWAttribu
 
 	delete currentClusteringModalitiesFrequenciesByClusters;
 	delete removedInstancesNewClusters;
+	oaThreadsMoves.DeleteAll();
 
 	if (parameters->GetPostOptimizationVnsLevel() > 0)
 		bOk = PostOptimizeVns(instances, targetAttribute);
 
-	instancesToClustersByAscDistance->DeleteAll();
-	delete instancesToClustersByAscDistance;
-
 	return bOk;
 
 }
 
 KMCluster* KMClustering::PostOptimizationSearchClusterToRemove(const KMClustering* currentClustering,
 	const KWFrequencyTable* currentClusteringModalitiesFrequenciesByClusters,
-	const NumericKeyDictionary* instancesToClustersByAscDistance,
-	const KWAttribute* targetAttribute,
-	const int K,
+	const KMIncrementalEVA* incrementalEVA,
+	const KMSortedNeighbors* sortedNeighbors,
+	const IntVector* ivAvailableClusters,
 	const double eVAallClustersFirstTerm,
 	const double evaOneCluster,
+	const IntVector* ivInstancesTargetIndexes,
+	ObjectArray* oaThreadsMoves,
 	KWFrequencyTable& currentClusteringBestLocalFrequencies,
 	NumericKeyDictionary* removedInstancesNewClusters,
 	int& nbClusteringsDone,
@@ -2113,74 +3077,213 @@ KMCluster* KMClustering::PostOptimizationSearchClusterToRemove(const KMClusterin
 #endif
 ) {
 
+	assert(incrementalEVA != NULL);
+	assert(oaThreadsMoves != NULL);
+	assert(oaThreadsMoves->GetSize() > 0);
+
 	KMCluster* result = NULL;
 
-	// pour chacun des centres de clusters toujours en cours de selection, calculer l'EVA du clustering, dans l'hypothese ou ce centre serait supprime
+	if (TaskProgression::IsInterruptionRequested())
+		return NULL;
+
+	// candidats : chacun des centres de clusters toujours en cours de selection. Les clusters de kmClusters contiennent reellement des instances,
+	// contrairement aux clusters clones contenus dans currentClustering
+	ObjectArray oaRemovedClusters;
 	for (int idxCluster = 0; idxCluster < currentClustering->GetClusters()->GetSize(); idxCluster++) {
 
 		KMCluster* c = cast(KMCluster*, currentClustering->GetClusters()->GetAt(idxCluster));
-		KMCluster* removedCluster = cast(KMCluster*, kmClusters->GetAt(c->GetIndex())); // ce cluster contient reellement des instances, contrairement au cluster clone contenu dans currentClustering
+		KMCluster* removedCluster = cast(KMCluster*, kmClusters->GetAt(c->GetIndex()));
 		assert(removedCluster != NULL);
 		assert(removedCluster->GetFrequency() > 0);
+		oaRemovedClusters.Add(removedCluster);
+	}
 
-		if (TaskProgression::IsInterruptionRequested())
-			break;
-
-		NumericKeyDictionary* removedInstancesNewClustersAfterClusterRemoval = new NumericKeyDictionary;// memoriser les nouveaux clusters qui seraient affectes aux instances du cluster dont on teste la suppression
+	const int nCandidates = oaRemovedClusters.GetSize();
+	ContinuousVector cvCandidatesEVA;
+	IntVector ivCandidatesOk;
+	cvCandidatesEVA.SetSize(nCandidates);
+	ivCandidatesOk.SetSize(nCandidates);
+
+	int nThreads = oaThreadsMoves->GetSize();
+	if (nThreads > nCandidates)
+		nThreads = nCandidates;
+
+	// calcul de l'EVA de chaque candidat, dans l'hypothese ou il serait supprime. Les candidats ne font que lire l'etat partage, et chaque thread
+	// memorise les deplacements d'instances dans ses propres tampons (un candidat sur nThreads par thread)
+	if (nThreads <= 1) {
+		for (int idxCandidate = 0; idxCandidate < nCandidates; idxCandidate++) {
+			double dEVA = 0;
+			ivCandidatesOk.SetAt(idxCandidate, PostOptimizationEvaluateClusterRemoval(cast(KMCluster*, oaRemovedClusters.GetAt(idxCandidate)),
+				incrementalEVA, sortedNeighbors, ivAvailableClusters, ivInstancesTargetIndexes,
+				eVAallClustersFirstTerm, evaOneCluster, cast(KMEVAMoves*, oaThreadsMoves->GetAt(0)), dEVA));
+			cvCandidatesEVA.SetAt(idxCandidate, dEVA);
+		}
+	}
+	else {
+		std::thread* threads = new std::thread[nThreads];
+
+		for (int t = 0; t < nThreads; t++) {
+
+			threads[t] = std::thread([this, t, nThreads, nCandidates, eVAallClustersFirstTerm, evaOneCluster, &oaRemovedClusters, &cvCandidatesEVA, &ivCandidatesOk,
+				incrementalEVA, sortedNeighbors, ivAvailableClusters, ivInstancesTargetIndexes, oaThreadsMoves]() {
+				for (int idxCandidate = t; idxCandidate < nCandidates; idxCandidate += nThreads) {
+					double dEVA = 0;
+					ivCandidatesOk.SetAt(idxCandidate, PostOptimizationEvaluateClusterRemoval(cast(KMCluster*, oaRemovedClusters.GetAt(idxCandidate)),
+						incrementalEVA, sortedNeighbors, ivAvailableClusters, ivInstancesTargetIndexes,
+						eVAallClustersFirstTerm, evaOneCluster, cast(KMEVAMoves*, oaThreadsMoves->GetAt(t)), dEVA));
+					cvCandidatesEVA.SetAt(idxCandidate, dEVA);
+				}
+				});
+		}
 
-		// parcourir les instances du cluster dont on teste la suppression, et pour chaque instance, mettre a jour l' effectif du cluster le plus proche de cette instance
-		KWFrequencyTable frequenciesAfterClusterRemoval;
-		frequenciesAfterClusterRemoval.CopyFrom(currentClusteringModalitiesFrequenciesByClusters);
-		boolean bOk = PostOptimizationUpdateFrequencies(removedCluster, instancesToClustersByAscDistance, targetAttribute, oaTargetAttributeValues, frequenciesAfterClusterRemoval, removedInstancesNewClustersAfterClusterRemoval);
+		for (int t = 0; t < nThreads; t++)
+			threads[t].join();
 
-		if (not bOk)
-			return NULL;
+		delete[] threads;
+	}
 
-		// en utilisant la table des frequences par modalites resultant de l'hypothese de la suppression du cluster, calculer l'EVA
-		const double eVAallClusters =
-			eVAallClustersFirstTerm +
-			GetClusteringQuality()->ComputeEVASecondTerm(K, &frequenciesAfterClusterRemoval) +
-			GetClusteringQuality()->ComputeEVAThirdTerm(K, &frequenciesAfterClusterRemoval);
+	// choix du meilleur candidat, dans l'ordre des clusters : en cas d'egalite, le premier rencontre est garde, comme en sequentiel
+	int idxBestCandidate = -1;
+	for (int idxCandidate = 0; idxCandidate < nCandidates; idxCandidate++) {
 
-		const double currentEVA = 1 - (eVAallClusters / evaOneCluster);
+		if (not ivCandidatesOk.GetAt(idxCandidate)) {
+			AddError("Nearest available cluster not found for a database instance. Aborting post-optimization....");
+			return NULL;
+		}
 
 		nbClusteringsDone++;
 
 #ifdef DEBUG_POST_OPTIMIZATION
+		const KMCluster* removedCluster = cast(KMCluster*, oaRemovedClusters.GetAt(idxCandidate));
 		for (int i = 0; i < currentClustering->GetClusters()->GetSize(); i++) {
 			KMCluster* c = cast(KMCluster*, currentClustering->GetClusters()->GetAt(i));
 			if (c->GetIndex() != removedCluster->GetIndex())
 				fsPostOptimizationFile << c->GetLabel() << " ";
 		}
-		fsPostOptimizationFile << "\t" << currentEVA << endl;
+		fsPostOptimizationFile << "\t" << cvCandidatesEVA.GetAt(idxCandidate) << endl;
 #endif
 
-		// si, pour la valeur de K en cours de test, le critere EVA a ete ameliore "localement" en supprimant ce cluster, alors garder la memoire de l'index de ce cluster, ainsi que des frequences
-		if (currentEVA > currentClusteringBestEVA) {
-			currentClusteringBestEVA = currentEVA;
-			result = removedCluster;
-			currentClusteringBestLocalFrequencies.CopyFrom(&frequenciesAfterClusterRemoval);
-			removedInstancesNewClusters->CopyFrom(removedInstancesNewClustersAfterClusterRemoval);
+		// si, pour la valeur de K en cours de test, le critere EVA a ete ameliore "localement" en supprimant ce cluster, alors garder la memoire de ce cluster
+		if (cvCandidatesEVA.GetAt(idxCandidate) > currentClusteringBestEVA) {
+			currentClusteringBestEVA = cvCandidatesEVA.GetAt(idxCandidate);
+			idxBestCandidate = idxCandidate;
 		}
-
-		delete removedInstancesNewClustersAfterClusterRemoval;
 	}
 
-	assert(result != NULL);
+	assert(idxBestCandidate != -1);
+	result = cast(KMCluster*, oaRemovedClusters.GetAt(idxBestCandidate));
+
+	// seul le meilleur candidat est rejoue, afin de memoriser ses frequences et les nouveaux clusters des instances du cluster supprime
+	currentClusteringBestLocalFrequencies.CopyFrom(currentClusteringModalitiesFrequenciesByClusters);
+	removedInstancesNewClusters->RemoveAll();
+
+	if (not PostOptimizationUpdateFrequencies(result, sortedNeighbors, ivAvailableClusters, ivInstancesTargetIndexes,
+		currentClusteringBestLocalFrequencies, removedInstancesNewClusters))
+		return NULL;
+
+	// l'EVA du meilleur candidat, evaluee de facon incrementale (eventuellement dans un thread), doit correspondre au calcul direct sur ses frequences
+	assert(KMIncrementalEVA::CheckTerms((1 - currentClusteringBestEVA) * evaOneCluster - eVAallClustersFirstTerm, &currentClusteringBestLocalFrequencies));
 
 	return result;
 }
 
+boolean KMClustering::PostOptimizationEvaluateClusterRemoval(const KMCluster* removedCluster, const KMIncrementalEVA* incrementalEVA,
+	const KMSortedNeighbors* sortedNeighbors, const IntVector* ivAvailableClusters, const IntVector* ivInstancesTargetIndexes,
+	const double eVAallClustersFirstTerm, const double evaOneCluster,
+	KMEVAMoves* moves, double& dEVA) {
+
+	assert(removedCluster != NULL);
+	assert(removedCluster->GetFrequency() == removedCluster->GetCount());
+	assert(incrementalEVA != NULL);
+	assert(moves != NULL);
+	assert(moves->GetTouchedRowNumber() == 0);
+
+	// affecter les instances du cluster supprime a leurs clusters suivants les plus proches, encore disponibles (cf. PostOptimizationUpdateFrequencies)
+	POSITION position = removedCluster->GetStartPosition();
+	NUMERIC key;
+	Object* oCurrent;
+
+	while (position != NULL) {
+
+		removedCluster->GetNextAssoc(position, key, oCurrent);
+		const int idxInstance = sortedNeighbors->GetInstanceIndex(static_cast<KWObject *>(oCurrent));
+		assert(idxInstance != -1);
+
+		const int idxNextCluster = sortedNeighbors->GetNearestAvailableCluster(idxInstance, ivAvailableClusters, removedCluster->GetIndex());
+		if (idxNextCluster == -1) {
+			moves->Reset();
+			return false;
+		}
+
+		const int idxTarget = ivInstancesTargetIndexes->GetAt(idxInstance);
+		assert(idxTarget != -1);
+		moves->AddMove(idxNextCluster, idxTarget);
+	}
+
+	// seules la ligne du cluster supprime et celles des clusters qui recoivent ses instances sont reevaluees
+	const double eVAallClusters =
+		eVAallClustersFirstTerm +
+		incrementalEVA->ComputeTermsAfterMoves(removedCluster->GetIndex(), moves);
+
+	dEVA = 1 - (eVAallClusters / evaOneCluster);
+
+	moves->Reset();
+
+	return true;
+}
+
+void KMClustering::ComputeInstancesTargetIndexes(const KMSortedNeighbors* sortedNeighbors, const KWAttribute* targetAttribute, IntVector& ivInstancesTargetIndexes) const {
+
+	assert(sortedNeighbors != NULL);
+	assert(targetAttribute != NULL);
+
+	ivInstancesTargetIndexes.SetSize(sortedNeighbors->GetInstanceNumber());
+
+	for (int i = 0; i < sortedNeighbors->GetInstanceNumber(); i++) {
+
+		const ALString value = sortedNeighbors->GetInstanceAt(i)->GetSymbolValueAt(targetAttribute->GetLoadIndex()).GetValue();
+
+		int idxTarget = 0;
+		for (; idxTarget < oaTargetAttributeValues.GetSize(); idxTarget++) {
+			if (value == cast(StringObject*, oaTargetAttributeValues.GetAt(idxTarget))->GetString())
+				break;
+		}
+
+		// les instances dont la modalite cible est inconnue n'appartiennent a aucun cluster (valeurs manquantes)
+		ivInstancesTargetIndexes.SetAt(i, idxTarget < oaTargetAttributeValues.GetSize() ? idxTarget : -1);
+	}
+}
+
+void KMClustering::ComputeAvailableClusters(const KWFrequencyTable* modalitiesFrequenciesByClusters, IntVector& ivAvailableClusters) const {
+
+	assert(modalitiesFrequenciesByClusters != NULL);
+	assert(modalitiesFrequenciesByClusters->GetFrequencyVectorNumber() == kmClusters->GetSize());
+
+	ivAvailableClusters.SetSize(modalitiesFrequenciesByClusters->GetFrequencyVectorNumber());
+
+	for (int idxCluster = 0; idxCluster < ivAvailableClusters.GetSize(); idxCluster++) {
+
+		assert(cast(KMCluster*, kmClusters->GetAt(idxCluster))->GetIndex() == idxCluster);
 
-boolean KMClustering::PostOptimizationUpdateFrequencies(const KMCluster* removedCluster, const NumericKeyDictionary* instancesToClustersByAscDistance,
-	const KWAttribute* targetAttribute, const ObjectArray& targetAttributeValues, KWFrequencyTable& frequenciesAfterClusterRemoval, NumericKeyDictionary* removedInstancesNewClusters) {
+		const IntVector* ivFrequencies = cast(KWDenseFrequencyVector*, modalitiesFrequenciesByClusters->GetFrequencyVectorAt(idxCluster))->GetFrequencyVector();
+		longint sourceFrequency = 0;
+		for (int iTarget = 0; iTarget < ivFrequencies->GetSize(); iTarget++)
+			sourceFrequency += ivFrequencies->GetAt(iTarget);
+
+		// si la frequence est a 0, le cluster a deja ete ecarte de la solution optimisee
+		ivAvailableClusters.SetAt(idxCluster, sourceFrequency > 0 ? 1 : 0);
+	}
+}
+
+boolean KMClustering::PostOptimizationUpdateFrequencies(const KMCluster* removedCluster, const KMSortedNeighbors* sortedNeighbors, const IntVector* ivAvailableClusters,
+	const IntVector* ivInstancesTargetIndexes, KWFrequencyTable& frequenciesAfterClusterRemoval, NumericKeyDictionary* removedInstancesNewClusters) {
 
 	assert(removedCluster != NULL);
 	assert(removedCluster->GetFrequency() > 0);
 	assert(removedCluster->GetFrequency() == removedCluster->GetCount());
-	assert(instancesToClustersByAscDistance != NULL);
-	assert(targetAttribute != NULL);
-	assert(targetAttributeValues.GetSize() > 0);
+	assert(sortedNeighbors != NULL);
+	assert(ivAvailableClusters != NULL);
+	assert(ivInstancesTargetIndexes != NULL);
 	assert(frequenciesAfterClusterRemoval.GetTotalFrequency() == kmGlobalCluster->GetFrequency());
 
 	KWDenseFrequencyVector* fvRemovedCluster = cast(KWDenseFrequencyVector*, frequenciesAfterClusterRemoval.GetFrequencyVectorAt(removedCluster->GetIndex()));
@@ -2200,59 +3303,29 @@ boolean KMClustering::PostOptimizationUpdateFrequencies(const KMCluster* removed
 
 		removedCluster->GetNextAssoc(position, key, oCurrent);
 		KWObject* currentInstance = static_cast<KWObject *>(oCurrent);
-		Object* o = instancesToClustersByAscDistance->Lookup(currentInstance);
-		assert(o != NULL);
-
-		// acces a la liste des clusters tries par distances croissantes, pour cette instance, afin de trouver le cluster suivant, par ordre de distance croissante a l'instance
-		// NB. ce cluster ne doit pas avoir ete ecarte auparavant de la liste des clusters faisant partie de la solution optimisee
-		ObjectArray* oaClustersList = cast(ObjectArray*, o);
-		assert(oaClustersList->GetSize() == kmClusters->GetSize());
-
-		// chercher le cluster le plus proche dans la liste, qui soit encore disponible :
-
-		KMCluster* nextCluster = NULL;
+		const int idxInstance = sortedNeighbors->GetInstanceIndex(currentInstance);
+		assert(idxInstance != -1);
 
-		for (int idxCluster = 0; idxCluster < oaClustersList->GetSize(); idxCluster++) {
-
-			KMCluster* c = cast(KMCluster*, oaClustersList->GetAt(idxCluster));
-
-			if (c->GetIndex() == removedCluster->GetIndex())
-				continue;
-			KWDenseFrequencyVector* fv = cast(KWDenseFrequencyVector*, frequenciesAfterClusterRemoval.GetFrequencyVectorAt(c->GetIndex()));
-			longint sourceFrequency = 0;
-			for (int iTarget = 0; iTarget < fv->GetSize(); iTarget++) {
-				sourceFrequency += fv->GetFrequencyVector()->GetAt(iTarget);
-			}
-
-			if (sourceFrequency == 0)
-				continue; // car si la frequence est a 0, cela veut dire qu'il a deja ete ecarte de la solution optimisee
-
-			nextCluster = c;
-			break;
-		}
+		// chercher le cluster le plus proche dans la liste de l'instance, qui soit encore disponible
+		// NB. ce cluster ne doit pas avoir ete ecarte auparavant de la solution optimisee
+		const int idxNextCluster = sortedNeighbors->GetNearestAvailableCluster(idxInstance, ivAvailableClusters, removedCluster->GetIndex());
 
-		if (nextCluster == NULL) {
+		if (idxNextCluster == -1) {
 			// ne devrait en principe jamais arriver, mais....
 			AddError("Nearest available cluster not found for a database instance. Aborting post-optimization....");
 			return false;
 		}
 
+		KMCluster* nextCluster = cast(KMCluster*, kmClusters->GetAt(idxNextCluster));
 		assert(nextCluster->GetFrequency() > 0);
 		removedInstancesNewClusters->SetAt(currentInstance, nextCluster);
 
-		// recuperer l'index de la modalite cible pour cette instance
-		ALString value = currentInstance->GetSymbolValueAt(targetAttribute->GetLoadIndex()).GetValue();
-		int idxTarget = 0;
-		for (; idxTarget < targetAttributeValues.GetSize(); idxTarget++) {
-			StringObject* s = cast(StringObject*, targetAttributeValues.GetAt(idxTarget));
-			if (value == s->GetString())
-				break;
-		}
-
-		assert(idxTarget < targetAttributeValues.GetSize());
+		// index de la modalite cible pour cette instance
+		const int idxTarget = ivInstancesTargetIndexes->GetAt(idxInstance);
+		assert(idxTarget != -1);
 
 		// Mettre a jour la frequence du cluster qui recupere cette instance, pour la modalite concernee
-		KWDenseFrequencyVector* fvNextCluster = cast(KWDenseFrequencyVector*, frequenciesAfterClusterRemoval.GetFrequencyVectorAt(nextCluster->GetIndex()));
+		KWDenseFrequencyVector* fvNextCluster = cast(KWDenseFrequencyVector*, frequenciesAfterClusterRemoval.GetFrequencyVectorAt(idxNextCluster));
 		fvNextCluster->GetFrequencyVector()->SetAt(idxTarget, fvNextCluster->GetFrequencyVector()->GetAt(idxTarget) + 1);
 	}
 
@@ -2334,59 +3407,6 @@ KWFrequencyTable* KMClustering::CreateModalitiesFrequenciesByClusters(const Obje
 }
 
 
-NumericKeyDictionary* KMClustering::ComputeInstancesToClustersByAscDistance() const {
-
-	NumericKeyDictionary* instancesToClustersByAscDistance = new NumericKeyDictionary; // cle = instance KWObject *, valeur = ObjectArray * contenant la liste de KMCluster *, tries par distance croissante � cette instance
-
-	if (parameters->GetVerboseMode())
-		AddSimpleMessage("Computing clusters sorted list, for each database instance...");
-
-
-	// par commodite, on part de la liste existante associant chaque instance a son cluster
-	assert(instancesToClusters != NULL);
-	assert(instancesToClusters->GetCount() > 0);
-
-	POSITION position = instancesToClusters->GetStartPosition();
-	NUMERIC key;
-	Object* oCurrent;
-
-	while (position != NULL) {
-
-		instancesToClusters->GetNextAssoc(position, key, oCurrent);
-		KWObject* currentInstance = static_cast<KWObject *>(oCurrent);
-
-		// recenser toutes les distances entre cette instance et les clusters
-		ObjectArray* oaDistances = new ObjectArray;
-
-		for (int i = 0; i < kmClusters->GetSize(); i++)
-		{
-			KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
-			double d = c->FindDistanceFromCentroid(currentInstance, c->GetModelingCentroidValues(), parameters->GetDistanceType());
-			oaDistances->Add(new KMInstance(currentInstance, i, d));
-		}
-		oaDistances->SetCompareFunction(KMClusteringDistanceCompareAsc);
-		oaDistances->Sort(); // tri par distances croissantes
-
-		ObjectArray* oaClustersList = new ObjectArray;
-
-		for (int i = 0; i < oaDistances->GetSize(); i++) {
-
-			KMInstance* instance = cast(KMInstance*, oaDistances->GetAt(i));
-			oaClustersList->Add(kmClusters->GetAt(instance->idCluster));
-		}
-		oaDistances->DeleteAll();
-		delete oaDistances;
-
-		instancesToClustersByAscDistance->SetAt(currentInstance, oaClustersList);
-	}
-
-	if (parameters->GetVerboseMode())
-		AddSimpleMessage("Done.");
-
-	return instancesToClustersByAscDistance;
-
-}
-
 boolean KMClustering::PostOptimizeVns(const ObjectArray* instances, const KWAttribute* targetAttribute) {
 
 	assert(kmGlobalCluster != NULL);
@@ -2419,6 +3439,7 @@ boolean KMClustering::PostOptimizeVns(const ObjectArray* instances, const KWAttr
 
 	const longint maxDegree = pow(2, parameters->GetPostOptimizationVnsLevel());
 	int currentDegree = 1;
+	const int nTimeLimit = parameters->GetPostOptimizationVnsTimeLimit();
 
 	if (parameters->GetVerboseMode()) {
 		AddSimpleMessage("VNS post-optimization (KMax = " + ALString(IntToString(KMax)) + ", max degree = " + ALString(IntToString(maxDegree)));
@@ -2434,112 +3455,29 @@ boolean KMClustering::PostOptimizeVns(const ObjectArray* instances, const KWAttr
 	boolean verboseModeOldValue = parameters->GetVerboseMode();
 	parameters->SetVerboseMode(false);
 
-	while (currentDegree < maxDegree) {
-
-		double challengedPercentage = (double)currentDegree / (double)maxDegree; // donne le % qui sera remis en question pour le clustering en cours de test
-
-		const int nbChallengedClusters = round(challengedPercentage * (double)kmClusters->GetSize() + 0.5);
-
-		// on tire au hasard le nombre de clusters remis en cause (challenged)
-		IntVector idxChallengedClusters;
-
-		while (idxChallengedClusters.GetSize() < nbChallengedClusters) {
-			int idxCluster = RandomInt(kmClusters->GetSize() - 1);
-			// verifier que ce cluster n'a pas deja ete tire au sort, et dans le cas contraire, le referencer
-			boolean found = false;
-			for (int i = 0; i < idxChallengedClusters.GetSize(); i++) {
-				if (idxChallengedClusters.GetAt(i) == idxCluster) {
-					// deja tire au sort, recommencer
-					found = true;
-					break;
-				}
-			}
-			if (not found)
-				idxChallengedClusters.Add(idxCluster);
-		}
-
-#ifdef DEBUG_POST_OPTIMIZATION_VNS
-		cout << endl << endl << "currentDegree = " << currentDegree << endl;
-		cout << "challengedPercentage = " << challengedPercentage << endl;
-		cout << "nbChallengedClusters = " << nbChallengedClusters << endl;
-		cout << "Randomly chosen clusters : " << endl;
-		for (int i = 0; i < idxChallengedClusters.GetSize(); i++) {
-			KMCluster* c = cast(KMCluster*, clusters->GetAt(i));
-			cout << c->GetIndex() << " ";
-		}
-		cout << endl;
-#endif
-
-		// copier les instances des clusters concernes dans un tableau de travail
-		ObjectArray* oaChallengedClustersInstances = new ObjectArray;
-		for (int i = 0; i < idxChallengedClusters.GetSize(); i++) {
-			const int idxChallenged = idxChallengedClusters.GetAt(i);
-			KMCluster* removedCluster = cast(KMCluster*, kmClusters->GetAt(idxChallenged));
-			NUMERIC key;
-			Object* oCurrent;
-			POSITION position = removedCluster->GetStartPosition();
-			while (position != NULL) {
-				removedCluster->GetNextAssoc(position, key, oCurrent);
-				KWObject* currentInstance = static_cast<KWObject *>(oCurrent);
-				oaChallengedClustersInstances->Add(currentInstance);
-			}
-		}
-
-		oaChallengedClustersInstances->Shuffle(); // melanger aleatoirement
-		int newClustersNumber = round((challengedPercentage * (double)oaChallengedClustersInstances->GetSize()) + 0.5);
-		if (newClustersNumber >= KMax)
-			newClustersNumber = KMax;
-
-		// supprimer les clusters destines a etre remplaces par les nouveaux
-		for (int i = 0; i < idxChallengedClusters.GetSize(); i++) {
-			for (int j = 0; j < kmClusters->GetSize(); j++) {
-				KMCluster* c = cast(KMCluster*, kmClusters->GetAt(j));
-				if (c->GetIndex() == idxChallengedClusters.GetAt(i)) {
-					DeleteClusterAt(j);
-					break;
-				}
-			}
-		}
-
-		// creer les nouveaux clusters, a partir des premieres instances du tableau de travail
-		for (int i = 0; i < newClustersNumber; i++) {
-			KWObject* currentInstance = cast(KWObject*, oaChallengedClustersInstances->GetAt(i));
-			KMCluster* newCluster = new KMCluster(parameters);
-			newCluster->InitializeModelingCentroidValues(currentInstance);
-			newCluster->SetInitialCentroidValues(newCluster->GetModelingCentroidValues());
-			newCluster->SetLabel("VNS_degree_" + ALString(IntToString(currentDegree)) + "_number_" + ALString(IntToString(i)));
-			kmClusters->Add(newCluster);
-		}
-
-		AddInstancesToClusters(instances); // reaffecter toutes les instances
-
-		int emptyClusters = ManageEmptyClusters(false);// car il est possible qu'il y ait des clusters vides, dans le cas ou on a utilise des instances qui ont des valeurs identiques, comme nouveaux centres de clusters
+	Timer timer;
+	timer.Start();
 
-		if (emptyClusters > 0)
-			AddInstancesToClusters(instances); // reaffecter toutes les instances, uniquement sur les clusters qui n'etaient pas vides
+	while (currentDegree < maxDegree) {
 
-		for (int i = 0; i < kmClusters->GetSize(); i++) {
-			KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
-			assert(c->GetCount() > 0);
-			c->ComputeDistanceSum(KMParameters::L2Norm);
-			c->ComputeDistanceSum(KMParameters::CosineNorm);
-			c->ComputeDistanceSum(KMParameters::L1Norm);
-			c->SetFrequency(c->GetCount());
-			c->ComputeInstanceNearestToCentroid(parameters->GetDistanceType());
-			c->ComputeInertyIntra(parameters->GetDistanceType());
-			c->SetStatisticsUpToDate(true);
+		if (nTimeLimit > 0 and timer.GetElapsedTime() >= nTimeLimit) {
+			AddSimpleMessage("VNS post-optimization: time limit of " + ALString(IntToString(nTimeLimit)) + " seconds is reached.");
+			break;
 		}
 
-		const int initialKValue = kmClusters->GetSize();
+		// perturbation et reoptimisation de la solution courante, au degre courant
+		int nbChallengedClusters = 0;
+		int nbChallengedInstances = 0;
+		int initialKValue = 0;
 
-		bOk = PostOptimize(instances, targetAttribute); // reffectuer une post-optimisation complete a partir des nouveaux clusters
+		bOk = PostOptimizeVnsStep(instances, targetAttribute, currentDegree, maxDegree, KMax, nbChallengedClusters, nbChallengedInstances, initialKValue);
 
 		AddSimpleMessage(
 			KMGetDisplayString(currentDegree) +
 			KMGetDisplayString(initialKValue) +
 			KMGetDisplayString(kmClusters->GetSize()) +
 			KMGetDisplayString(nbChallengedClusters) +
-			KMGetDisplayString(oaChallengedClustersInstances->GetSize()) +
+			KMGetDisplayString(nbChallengedInstances) +
 			KMGetDisplayString(bestClustering->GetClusters()->GetSize()) +
 			KMGetDisplayString(GetClusteringQuality()->GetEVA()) +
 			KMGetDisplayString(overAllBestEVA)
@@ -2553,8 +3491,6 @@ boolean KMClustering::PostOptimizeVns(const ObjectArray* instances, const KWAttr
 		else
 			currentDegree++;
 
-		delete oaChallengedClustersInstances;
-
 		if (not bOk)
 			break;
 	}
@@ -2564,17 +3500,7 @@ boolean KMClustering::PostOptimizeVns(const ObjectArray* instances, const KWAttr
 	AddInstancesToClusters(instances);
 
 	// mise a jour des stats, necessaire apres reaffectation des instances
-
-	for (int i = 0; i < kmClusters->GetSize(); i++) {
-		KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
-		c->ComputeDistanceSum(KMParameters::L2Norm);
-		c->ComputeDistanceSum(KMParameters::CosineNorm);
-		c->ComputeDistanceSum(KMParameters::L1Norm);
-		c->SetFrequency(c->GetCount());
-		c->ComputeInstanceNearestToCentroid(parameters->GetDistanceType());
-		c->ComputeInertyIntra(parameters->GetDistanceType());
-		c->SetStatisticsUpToDate(true);
-	}
+	UpdateVnsClustersStatistics();
 
 	ComputeTrainingTargetProbs(targetAttribute);
 	GetClusteringQuality()->ComputeEVA(kmGlobalCluster, oaTargetAttributeValues.GetSize());
@@ -2590,6 +3516,113 @@ boolean KMClustering::PostOptimizeVns(const ObjectArray* instances, const KWAttr
 
 }
 
+boolean KMClustering::PostOptimizeVnsStep(const ObjectArray* instances, const KWAttribute* targetAttribute, const int currentDegree, const longint maxDegree,
+	const longint KMax, int& nbChallengedClusters, int& nbChallengedInstances, int& initialKValue)
+{
+	double challengedPercentage = (double)currentDegree / (double)maxDegree; // donne le % qui sera remis en question pour le clustering en cours de test
+
+	nbChallengedClusters = round(challengedPercentage * (double)kmClusters->GetSize() + 0.5);
+
+	// on tire au hasard le nombre de clusters remis en cause (challenged)
+	IntVector idxChallengedClusters;
+
+	while (idxChallengedClusters.GetSize() < nbChallengedClusters) {
+		int idxCluster = RandomInt(kmClusters->GetSize() - 1);
+		// verifier que ce cluster n'a pas deja ete tire au sort, et dans le cas contraire, le referencer
+		boolean found = false;
+		for (int i = 0; i < idxChallengedClusters.GetSize(); i++) {
+			if (idxChallengedClusters.GetAt(i) == idxCluster) {
+				// deja tire au sort, recommencer
+				found = true;
+				break;
+			}
+		}
+		if (not found)
+			idxChallengedClusters.Add(idxCluster);
+	}
+
+#ifdef DEBUG_POST_OPTIMIZATION_VNS
+	cout << endl << endl << "currentDegree = " << currentDegree << endl;
+	cout << "challengedPercentage = " << challengedPercentage << endl;
+	cout << "nbChallengedClusters = " << nbChallengedClusters << endl;
+	cout << "Randomly chosen clusters : " << endl;
+	for (int i = 0; i < idxChallengedClusters.GetSize(); i++) {
+		KMCluster* c = cast(KMCluster*, clusters->GetAt(i));
+		cout << c->GetIndex() << " ";
+	}
+	cout << endl;
+#endif
+
+	// copier les instances des clusters concernes dans un tableau de travail
+	ObjectArray oaChallengedClustersInstances;
+	for (int i = 0; i < idxChallengedClusters.GetSize(); i++) {
+		const int idxChallenged = idxChallengedClusters.GetAt(i);
+		KMCluster* removedCluster = cast(KMCluster*, kmClusters->GetAt(idxChallenged));
+		NUMERIC key;
+		Object* oCurrent;
+		POSITION position = removedCluster->GetStartPosition();
+		while (position != NULL) {
+			removedCluster->GetNextAssoc(position, key, oCurrent);
+			KWObject* currentInstance = static_cast<KWObject *>(oCurrent);
+			oaChallengedClustersInstances.Add(currentInstance);
+		}
+	}
+
+	oaChallengedClustersInstances.Shuffle(); // melanger aleatoirement
+	int newClustersNumber = round((challengedPercentage * (double)oaChallengedClustersInstances.GetSize()) + 0.5);
+	if (newClustersNumber >= KMax)
+		newClustersNumber = KMax;
+
+	// supprimer les clusters destines a etre remplaces par les nouveaux
+	for (int i = 0; i < idxChallengedClusters.GetSize(); i++) {
+		for (int j = 0; j < kmClusters->GetSize(); j++) {
+			KMCluster* c = cast(KMCluster*, kmClusters->GetAt(j));
+			if (c->GetIndex() == idxChallengedClusters.GetAt(i)) {
+				DeleteClusterAt(j);
+				break;
+			}
+		}
+	}
+
+	// creer les nouveaux clusters, a partir des premieres instances du tableau de travail
+	for (int i = 0; i < newClustersNumber; i++) {
+		KWObject* currentInstance = cast(KWObject*, oaChallengedClustersInstances.GetAt(i));
+		KMCluster* newCluster = new KMCluster(parameters);
+		newCluster->InitializeModelingCentroidValues(currentInstance);
+		newCluster->SetInitialCentroidValues(newCluster->GetModelingCentroidValues());
+		newCluster->SetLabel("VNS_degree_" + ALString(IntToString(currentDegree)) + "_number_" + ALString(IntToString(i)));
+		kmClusters->Add(newCluster);
+	}
+
+	AddInstancesToClusters(instances); // reaffecter toutes les instances
+
+	int emptyClusters = ManageEmptyClusters(false);// car il est possible qu'il y ait des clusters vides, dans le cas ou on a utilise des instances qui ont des valeurs identiques, comme nouveaux centres de clusters
+
+	if (emptyClusters > 0)
+		AddInstancesToClusters(instances); // reaffecter toutes les instances, uniquement sur les clusters qui n'etaient pas vides
+
+	UpdateVnsClustersStatistics();
+
+	initialKValue = kmClusters->GetSize();
+	nbChallengedInstances = oaChallengedClustersInstances.GetSize();
+
+	return PostOptimize(instances, targetAttribute); // reffectuer une post-optimisation complete a partir des nouveaux clusters
+}
+
+void KMClustering::UpdateVnsClustersStatistics()
+{
+	for (int i = 0; i < kmClusters->GetSize(); i++) {
+		KMCluster* c = cast(KMCluster*, GetClusters()->GetAt(i));
+		c->ComputeDistanceSum(KMParameters::L2Norm);
+		c->ComputeDistanceSum(KMParameters::CosineNorm);
+		c->ComputeDistanceSum(KMParameters::L1Norm);
+		c->SetFrequency(c->GetCount());
+		c->ComputeInstanceNearestToCentroid(parameters->GetDistanceType());
+		c->ComputeInertyIntra(parameters->GetDistanceType());
+		c->SetStatisticsUpToDate(true);
+	}
+}
+
 void KMClustering::ComputeClusteringLevels(KWClass* kwcModeling, ObjectArray* attributesStats, ObjectArray* clusters) {
 
 	assert(clusters != NULL);
@@ -2922,6 +3955,11 @@ void KMClustering::DeleteClusterAt(int idx) {
 	KMCluster* c = cast(KMCluster*, kmClusters->GetAt(idx));
 	kmClusters->RemoveAt(idx);
 	delete c;
+
+	// maj des index de clusters des instances, en cas d'utilisation de la matrice dense des instances (les bornes de distances ne sont plus valides)
+	bInstancesBoundsUpToDate = false;
+	bMembershipSumsUpToDate = false;
+	instancesMembership.RemoveClusterIndex(idx);
 }
 
 const double KMClustering::GetClustersDistanceSum(KMParameters::DistanceType d) const
@@ -3010,6 +4048,9 @@ Object* PLShared_Clustering::Create() const
 	return new KMClustering(NULL);
 }
 
+const int KMClustering::MIN_INSTANCES_BY_THREAD = 10000;
+const double KMClustering::SPARSE_DISTANCE_TOLERANCE = 1e-9;
+
 ////////////////////////////////////////////////////////////////
 
 // fonction de comparaison pour tri de tableau, tri par distances decroissantes
@@ -9,6 +9,13 @@
 #include "KMCluster.h"
 #include "KMParameters.h"
 #include "KMAttributesPartitioningManager.h"
+#include "KMDenseMatrix.h"
+#include "KMSparseMatrix.h"
+#include "KMTriangularMatrix.h"
+#include "KMClustersSnapshot.h"
+#include "KMSortedNeighbors.h"
+#include "KMIncrementalEVA.h"
+#include "KMClusterMembership.h"
 
 // #define DEBUG_POST_OPTIMIZATION
 // #define DEBUG_POST_OPTIMIZATION_VNS
@@ -100,8 +107,9 @@ public:
 	// mise a jour de la somme des distances des clusters, pour toutes les normes
 	void UpdateGlobalDistancesSum();
 
-	/** maj, lors de l'evaluation, de la matrice de confusion "classes majoritaires / classes reelles" */
-	void UpdateConfusionMatrix(const Symbol& sPredictedTarget, const Symbol& sActualTarget);
+	/** maj, lors de l'evaluation, de la matrice de confusion "classes majoritaires / classes reelles" (nFrequency permet d'ajouter
+	en une fois les effectifs comptes ailleurs, par exemple par les esclaves d'une tache d'evaluation parallele) */
+	void UpdateConfusionMatrix(const Symbol& sPredictedTarget, const Symbol& sActualTarget, const int nFrequency = 1);
 
 	/** acces a la classe gerant les indicateurs de la qualite d'un clustering */
 	KMClusteringQuality* GetClusteringQuality() const;
@@ -110,11 +118,22 @@ public:
 	KMAttributesPartitioningManager* GetAttributesPartitioningManager() const;
 
 	/** matrice des distances entre clusters */
-	Continuous** GetClustersCentersDistances() const;
+	const KMTriangularMatrix& GetClustersCentersDistances() const;
 
 	/** dictionnaire des instances et de leurs clusters associes */
 	NumericKeyDictionary* GetInstancesToClusters() const;
 
+	/** matrice dense des valeurs K-Means des instances de la base (non possedee). Si elle est renseignee, les affectations des instances aux clusters
+	lors des iterations d'un replicate sont calculees a partir de cette matrice, plutot qu'a partir des KWObject */
+	void SetInstancesMatrix(const KMDenseMatrix*);
+	const KMDenseMatrix* GetInstancesMatrix() const;
+
+	/** version creuse de la matrice dense des instances (non possedee, memes lignes et colonnes). Si elle est renseignee, en plus de la matrice dense,
+	les distances des instances aux centroides et les centroides lors des iterations sont calcules a partir des seules valeurs non nulles des instances.
+	La matrice dense peut alors ne porter que les lignes et les colonnes, sans valeurs (cf. KMDenseMatrix::HasValues) */
+	void SetInstancesSparseMatrix(const KMSparseMatrix*);
+	const KMSparseMatrix* GetInstancesSparseMatrix() const;
+
 	/** retourne le nombre d'instances qui ont au moins une valeur manquante dans leurs attributs */
 	const longint GetInstancesWithMissingValues() const;
 
@@ -129,17 +148,22 @@ public:
 
 	void AddTargetAttributeValueIfNotExists(const KWAttribute* targetAttribute, const KWObject* kwoObject);
 
+	/** idem, a partir d'une valeur cible. Retourne l'index de la valeur dans la liste des valeurs cibles */
+	int AddTargetAttributeValueIfNotExists(const ALString& sValue);
+
 	/** supprimer certains centres de clusters, si cela a pour effet d'ameliorer l'EVA du clustering */
 	boolean PostOptimize(const ObjectArray* instances, const KWAttribute* targetAttribute);
 
 	/** rechercher le cluster dont la suppression produirait le meilleur EVA, pour un clustering donne */
 	KMCluster* PostOptimizationSearchClusterToRemove(const KMClustering* currentClustering,
 		const KWFrequencyTable* currentClusteringModalitiesFrequenciesByClusters,
-		const NumericKeyDictionary* instancesToClustersByAscDistance,
-		const KWAttribute* targetAttribute,
-		const int K,
+		const KMIncrementalEVA* incrementalEVA,
+		const KMSortedNeighbors* sortedNeighbors,
+		const IntVector* ivAvailableClusters,
 		const double eVAallClustersFirstTerm,
 		const double evaOneCluster,
+		const IntVector* ivInstancesTargetIndexes,
+		ObjectArray* oaThreadsMoves,
 		KWFrequencyTable& currentClusteringBestLocalFrequencies,
 		NumericKeyDictionary* removedInstancesNewClusters,
 		int& nbClusteringsDone,
@@ -150,9 +174,19 @@ public:
 	);
 
 
-	/** post-optimisation a base de recherche a voisinage variable (Variable Neighborhood Search) */
+	/** post-optimisation a base de recherche a voisinage variable (Variable Neighborhood Search). Une seule chaine de recherche,
+	executee sequentiellement (seule l'evaluation des suppressions de clusters de la post-optimisation est multi-threadee) ; la recherche
+	s'arrete au plus tard a l'issue de la duree maximale eventuelle (cf. KMParameters::GetPostOptimizationVnsTimeLimit) */
 	boolean PostOptimizeVns(const ObjectArray* instances, const KWAttribute* targetAttribute);
 
+	/** une etape de VNS sur le clustering courant : remise en cause aleatoire d'une partie des clusters (selon le degre courant), puis post-optimisation.
+	Renvoie le nombre de clusters et d'instances remis en cause, ainsi que le nombre de clusters avant post-optimisation */
+	boolean PostOptimizeVnsStep(const ObjectArray* instances, const KWAttribute* targetAttribute, const int currentDegree, const longint maxDegree,
+		const longint KMax, int& nbChallengedClusters, int& nbChallengedInstances, int& initialKValue);
+
+	/** mise a jour des stats des clusters, necessaire apres reaffectation des instances */
+	void UpdateVnsClustersStatistics();
+
 	/** construction des tables de contingence servant au calcul des levels de clustering, a l'issue de l'apprentissage, et a partir des instances contenues dans les clusters */
 	void ComputeClusteringLevels(KWClass* modelingClass, ObjectArray* attributesStats, ObjectArray* clusters);
 
@@ -179,6 +213,87 @@ protected:
 	/** retourne le cluster dont le centre est le plus proche de l'objet pass en parametre (norme Cosinus) */
 	KMCluster* FindNearestClusterCosinus(KWObject*);
 
+	/** distance entre les centres de deux clusters, pour le calcul de la matrice des distances entre centres de clusters */
+	Continuous ComputeClustersCentersDistance(const int i, const int j, const boolean bUseEvaluationCentroids, const boolean bUseDenseCentroids) const;
+
+	/** indique si la matrice dense des instances peut etre utilisee pour une liste d'instances (i.e, liste obtenue par melange des lignes de la matrice) */
+	boolean IsInstancesMatrixUsable(const ObjectArray* instances) const;
+
+	/** melange aleatoire des instances a partir des lignes de la matrice dense, en memorisant la ligne de matrice correspondant a chaque position */
+	void ShuffleInstancesMatrixRows(ObjectArray* instances);
+
+	/** abandon des matrices d'instances (dense et creuse) : les dictionnaires d'instances des clusters sont au prealable
+	mis a jour a partir du tableau d'appartenance, afin de pouvoir poursuivre a partir des instances de la base */
+	void DetachInstancesMatrices();
+
+	/** retourne l'index du cluster dont le centre est le plus proche d'une ligne de la matrice dense des instances
+	(index du cluster courant de l'instance = -1, si celle-ci n'est pas encore affectee) */
+	int FindNearestClusterIndex(const Continuous* instanceValues, const int currentClusterIndex) const;
+
+	/** idem, pour chacune des normes */
+	int FindNearestClusterIndexL1(const Continuous* instanceValues, const int currentClusterIndex) const;
+	int FindNearestClusterIndexL2(const Continuous* instanceValues, const int currentClusterIndex) const;
+	int FindNearestClusterIndexCosinus(const Continuous* instanceValues, const int currentClusterIndex) const;
+
+	/** indique si la matrice creuse des instances peut etre utilisee a la place de la matrice dense, pour les calculs de distances */
+	boolean IsInstancesSparseMatrixUsable() const;
+
+	/** idem FindNearestClusterIndex, a partir d'une ligne de la matrice creuse des instances */
+	int FindNearestClusterIndexSparse(const int nRow, const int currentClusterIndex) const;
+
+	/** distance (au sens du parametrage) entre une ligne de la matrice creuse des instances et le centroide dense d'un cluster */
+	Continuous ComputeSparseDistanceToCentroid(const int nRow, const int clusterIndex) const;
+
+	/** distance (au sens du parametrage) entre une ligne des matrices d'instances et le centroide dense d'un cluster, a partir de la matrice creuse
+	si bUseSparseMatrix (cf. IsInstancesSparseMatrixUsable), de la matrice dense sinon */
+	Continuous ComputeRowDistanceToCentroid(const int nRow, const int clusterIndex, const boolean bUseSparseMatrix) const;
+
+	/** a partir de la matrice dense des instances, calcul du nouveau cluster de chacune des maxInstances premieres instances (resultats ranges dans ivNewInstancesClusters).
+	En mode parallele, les instances sont reparties par tranches contigues entre plusieurs threads. Retourne le nombre d'instances qui changent de cluster */
+	int ComputeNewInstancesClusters(const int maxInstances);
+
+	/** idem, pour une tranche de positions [nFirstPosition, nLastPosition[ (traitement d'un thread).
+	En cas d'utilisation des bornes de distances, les nombres de distances instance-centroide calculees et evitees sont ajoutes aux compteurs passes en parametres */
+	int ComputeNewInstancesClustersRange(const int nFirstPosition, const int nLastPosition, longint& lComputedDistances, longint& lPrunedDistances);
+
+	/** indique si l'elagage par bornes de distances (algorithme de Hamerly) peut etre utilise pour la phase d'affectation */
+	boolean IsBoundsPruningUsable() const;
+
+	/** elagage par bornes : mise a jour des bornes des instances en fonction du deplacement des centroides depuis l'iteration precedente,
+	et calcul de la demi-distance de chaque centroide a son plus proche voisin. Retourne false si les bornes ne pourront pas etre conservees pour la phase suivante (memoire insuffisante) */
+	boolean PrepareInstancesBounds();
+
+	/** elagage par bornes : affectation d'une instance (position dans oaMatrixInstances) a son plus proche cluster, en mettant a jour ses bornes */
+	int FindNearestClusterIndexWithBounds(const int nPosition, const int currentClusterIndex, longint& lComputedDistances, longint& lPrunedDistances);
+
+	/** a partir de la matrice dense (ou creuse) des instances : mise a jour des statistiques d'iteration des clusters (effectif, centroide moyen, somme des distances),
+	d'apres le tableau d'appartenance. Si les sommes par cluster sont a jour (cf. MoveInstanceInMembership), seuls les clusters dont l'appartenance a change
+	recalculent leur centroide (en O(nombre de colonnes)) et leur somme des distances (a partir de leurs seules instances). Sinon, les sommes sont entierement
+	recalculees : en mode parallele, les positions sont reparties par tranches contigues entre les threads, chacun cumulant ses propres sommes partielles
+	par cluster, fusionnees ensuite dans l'ordre des threads */
+	void ComputeIterationStatisticsFromMembership();
+
+	/** calcul complet, pour une tranche de positions [nFirstPosition, nLastPosition[ (traitement d'un thread) : cumul des instances de chaque cluster k
+	dans la ligne nFirstRow + k d'une matrice de sommes */
+	void ComputeIterationCentroidsSumsRange(const int nFirstPosition, const int nLastPosition, const boolean bUseSparseMatrix, KMDenseMatrix* sums, const int nFirstRow);
+
+	/** pour une tranche [nFirst, nLast[ de ivChangedClustersPositions (traitement d'un thread) : cumul des distances aux centroides de dmIterationCentroids, par cluster */
+	void ComputeIterationDistancesSumsRange(const int nFirst, const int nLast, const boolean bUseSparseMatrix, Continuous* cDistancesSums);
+
+	/** changement de cluster d'une position du tableau d'appartenance (nouvel index de cluster different de l'actuel). Si les sommes par cluster sont a jour,
+	les valeurs de l'instance sont retirees de la ligne de son ancien cluster et ajoutees a celle du nouveau, et les deux clusters sont marques comme modifies */
+	void MoveInstanceInMembership(const int nPosition, const int nNewClusterIndex);
+
+	/** ajout (sign = 1) ou retrait (sign = -1) des valeurs d'une ligne de la matrice des instances, a la ligne d'un cluster de dmMembershipSums */
+	void UpdateMembershipSums(const int nRow, const int nClusterIndex, const int sign);
+
+	/** a partir de la matrice dense des instances : remplissage des dictionnaires d'instances des clusters, et du dictionnaire instancesToClusters,
+	d'apres le tableau d'appartenance (les statistiques des clusters ne sont pas modifiees) */
+	void UpdateClustersInstancesFromMembership();
+
+	/** distance (au sens metrique : L1, ou racine de la distance L2 au carre) entre un vecteur (selon les colonnes de dmClustersCentroids) et le centroide d'un cluster */
+	Continuous ComputeMetricDistanceToCentroid(const Continuous* instanceValues, const int clusterIndex) const;
+
 	/** construire un cluster 'fictif' contenant toutes les instances, et calculer les statistiques correspondantes */
 	void ComputeGlobalClusterStatistics(ObjectArray* instances);
 
@@ -205,8 +320,8 @@ protected:
 	/** determiner quelles sont les modalites de la variable cible (mode supervis) */
 	void ReadTargetAttributeValues(const ObjectArray* instances, const KWAttribute* targetAttribute);
 
-	/** sauvegarder les meilleurs clusters observs */
-	void CloneBestClusters();
+	/** sauvegarder l'etat des meilleurs clusters observs */
+	void SaveBestClusters();
 
 	/** initialiser les tables de contingence permettant de caculer un level de clustering */
 	void InitializeClusteringLevelFrequencyTables(const int nbClusters);
@@ -214,18 +329,28 @@ protected:
 	/** mettre a jour les tables de contingence permettant de caculer un level de clustering */
 	void UpdateClusteringLevelFrequencyTables(const KWObject* kwoObject, const int idCluster);
 
-	/** post optimisation d'un clustering : creation d'une structure faisant correspondre, pour chaque instance de la base, la liste des clusters tries par ordre de distance croissante
-	(cle = KWObject *, valeur =  ObjectArray contenant des KMClusters *)   */
-	NumericKeyDictionary* ComputeInstancesToClustersByAscDistance() const;
-
 	/** post optimisation d'un clustering : lignes = clusters, colonnes = modalites cibles, valeurs = frequences pour 1 cluster et 1 modalite cible donnes  */
 	KWFrequencyTable* CreateModalitiesFrequenciesByClusters(const ObjectArray* clusters);
 
 	/** post optimisation d'un clustering : dans le cas ou on supprimerait un cluster, calculer les frequences qui seraient produites si on
 	affectait les instances du cluster supprime, a leurs plus proches clusters suivants */
-	boolean PostOptimizationUpdateFrequencies(const KMCluster* removedCluster, const NumericKeyDictionary* instancesToClustersByAscDistance,
-		const KWAttribute* targetAttribute, const ObjectArray& oaTargetAttributeValues,
-		KWFrequencyTable& frequenciesAfterClusterRemoval, NumericKeyDictionary* removedInstancesNewClusters);
+	boolean PostOptimizationUpdateFrequencies(const KMCluster* removedCluster, const KMSortedNeighbors* sortedNeighbors, const IntVector* ivAvailableClusters,
+		const IntVector* ivInstancesTargetIndexes, KWFrequencyTable& frequenciesAfterClusterRemoval, NumericKeyDictionary* removedInstancesNewClusters);
+
+	/** post optimisation d'un clustering : calcul de l'EVA qui serait obtenu en supprimant un cluster, par correction incrementale de l'EVA
+	de la table courante (seules les lignes touchees sont reevaluees). Ni allocation memoire ni message utilisateur : la methode peut etre
+	appelee dans un thread, avec ses propres tampons de deplacements. Renvoie false si une instance n'a pas de cluster disponible */
+	boolean PostOptimizationEvaluateClusterRemoval(const KMCluster* removedCluster, const KMIncrementalEVA* incrementalEVA,
+		const KMSortedNeighbors* sortedNeighbors, const IntVector* ivAvailableClusters, const IntVector* ivInstancesTargetIndexes,
+		const double eVAallClustersFirstTerm, const double evaOneCluster,
+		KMEVAMoves* moves, double& dEVA);
+
+	/** post optimisation d'un clustering : index de la modalite cible de chaque instance, dans l'ordre des instances des listes de clusters les plus proches
+	(-1 si la modalite cible est inconnue) */
+	void ComputeInstancesTargetIndexes(const KMSortedNeighbors* sortedNeighbors, const KWAttribute* targetAttribute, IntVector& ivInstancesTargetIndexes) const;
+
+	/** post optimisation d'un clustering : clusters encore disponibles (valeur 1) ou ecartes de la solution (valeur 0), d'apres leurs frequences */
+	void ComputeAvailableClusters(const KWFrequencyTable* modalitiesFrequenciesByClusters, IntVector& ivAvailableClusters) const;
 
 	/** post optimisation d'un clustering : deplacer les instances d'un cluster supprime, a leurs clusters les plus proches */
 	void PostOptimizationMoveInstancesToNextClusters(const NumericKeyDictionary* removedInstancesNewClusters);
@@ -235,8 +360,8 @@ protected:
 	/** contient des objets KMCluster * , et reprsente l'etat courant des clusters, au fil des iterations */
 	ObjectArray* kmClusters;
 
-	/** contient des objets KMCluster * , et sauvegarde le meilleur tat observ au cours des iterations */
-	ObjectArray* kmBestClusters;
+	/** sauvegarde compacte du meilleur tat observ au cours des iterations (centroides, frequences et sommes des distances) */
+	KMClustersSnapshot kmBestClustersSnapshot;
 
 	/** cluster global : permet la construction des statistiques globales, calcules  partir de toutes les instances */
 	KMCluster* kmGlobalCluster;
@@ -268,12 +393,107 @@ protected:
 	/** pourcentage de la base qui a ete lue (utile en cas de memoire insuffisante) */
 	double dUsedSampleNumberPercentage;
 
-	/** matrice 2 dimensions (ligne = n de cluster, colonne = n de cluster) qui contient les distances entre chaque centre de cluster */
-	Continuous** clustersCentersDistances;
+	/** matrice (ligne = n de cluster, colonne = n de cluster) qui contient les distances entre chaque centre de cluster. Symetrique, elle est stockee
+	sous forme triangulaire dans un bloc contigu, alloue une seule fois par clustering, et seules les lignes des clusters modifies sont recalculees */
+	KMTriangularMatrix clustersCentersDistances;
+
+	/** pour chaque ligne de la matrice des distances entre centres de clusters, centroide ayant servi a son dernier calcul (ContinuousVector *, possedes) */
+	ObjectArray oaCentersDistancesCentroids;
+
+	/** pour chaque ligne de la matrice des distances entre centres de clusters, index du cluster le plus proche lors du dernier calcul */
+	IntVector ivCentersDistancesNearestClusters;
+
+	/** type des centroides (evaluation ou modelisation, denses ou non) ayant servi au dernier calcul de la matrice des distances entre centres de clusters */
+	boolean bCentersDistancesEvaluationCentroids;
+	boolean bCentersDistancesDenseCentroids;
 
 	/** correspondance,  un instant T, entre une instance et son cluster d'appartenance. Cl = pointeur sur KWObject. Valeur = pointeur sur KMCluster */
 	NumericKeyDictionary* instancesToClusters;
 
+	/** matrice dense des valeurs K-Means des instances (non possedee, NULL si non utilisee) */
+	const KMDenseMatrix* instancesMatrix;
+
+	/** liste d'instances melangee a partir des lignes de la matrice dense des instances (non possedee) */
+	const ObjectArray* oaMatrixInstances;
+
+	/** pour chaque position dans oaMatrixInstances, ligne correspondante de la matrice dense des instances */
+	IntVector ivInstancesRows;
+
+	/** pour chaque position dans oaMatrixInstances, index du cluster d'appartenance (-1 si l'instance n'est affectee a aucun cluster), et listes de positions
+	de chaque cluster. Remplace le dictionnaire instancesToClusters et les dictionnaires d'instances des clusters, lors des iterations d'un replicate */
+	KMClusterMembership instancesMembership;
+
+	/** centroides (une ligne par cluster, colonnes de la matrice dense des instances), leurs normes, et sommes des distances, calcules a partir du tableau d'appartenance */
+	KMDenseMatrix dmIterationCentroids;
+	ContinuousVector cvIterationCentroidsL1Norms;
+	ContinuousVector cvIterationCentroidsSquaredNorms;
+	ContinuousVector cvIterationDistancesSums;
+
+	/** sommes des valeurs des instances de chaque cluster (une ligne par cluster, colonnes de la matrice dense des instances), mises a jour a chaque changement
+	de cluster d'une instance pendant les iterations : le centroide d'un cluster est alors obtenu sans rebalayer ses instances */
+	KMDenseMatrix dmMembershipSums;
+
+	/** indique si dmMembershipSums est synchronisee avec le tableau d'appartenance (invalidee par toute modification de l'appartenance ou des clusters
+	ne passant pas par MoveInstanceInMembership) */
+	boolean bMembershipSumsUpToDate;
+
+	/** nombre de mises a jour incrementales de dmMembershipSums depuis son dernier calcul complet (au dela du nombre de positions, on refait un calcul complet,
+	afin de borner l'accumulation des erreurs d'arrondi) */
+	longint lMembershipSumsUpdates;
+
+	/** pour chaque cluster, 1 si son appartenance a change depuis le dernier calcul des statistiques d'iteration, 0 sinon */
+	IntVector ivMembershipChangedClusters;
+
+	/** positions des instances des clusters modifies, dont les distances a leur centroide sont a recalculer */
+	IntVector ivChangedClustersPositions;
+
+	/** sommes partielles des centroides des threads autres que le premier (une ligne par couple thread, cluster), et sommes partielles des distances (une ligne par thread) */
+	KMDenseMatrix dmThreadsCentroidsSums;
+	KMDenseMatrix dmThreadsDistancesSums;
+
+	/** pour chaque position dans oaMatrixInstances, index du nouveau cluster d'appartenance calcule lors de la phase d'affectation d'une iteration */
+	IntVector ivNewInstancesClusters;
+
+	/** nombre minimal d'instances traitees par thread, lors de la phase d'affectation en parallele */
+	static const int MIN_INSTANCES_BY_THREAD;
+
+	/** ecart relatif tolere (en mode debug) entre les distances calculees sur la matrice creuse et a partir des valeurs K-Means des instances */
+	static const double SPARSE_DISTANCE_TOLERANCE;
+
+	/** elagage par bornes : pour chaque position dans oaMatrixInstances, borne superieure de la distance de l'instance a son centroide,
+	et borne inferieure de sa distance a tous les autres centroides */
+	ContinuousVector cvInstancesUpperBounds;
+	ContinuousVector cvInstancesLowerBounds;
+
+	/** elagage par bornes : indique si les bornes des instances sont valides (elles sont invalidees par toute modification des clusters hors phase d'affectation) */
+	boolean bInstancesBoundsUpToDate;
+
+	/** elagage par bornes : centroides lors du dernier calcul des bornes, servant a mesurer le deplacement des centroides */
+	KMDenseMatrix dmPreviousClustersCentroids;
+
+	/** elagage par bornes : pour chaque cluster, deplacement du centroide depuis l'iteration precedente, et demi-distance a son plus proche centroide */
+	ContinuousVector cvClustersDrifts;
+	ContinuousVector cvClustersHalfMinDistances;
+
+	/** elagage par bornes : plus grand deplacement de centroide (et index du cluster correspondant), puis second plus grand deplacement */
+	int iMaxDriftClusterIndex;
+	Continuous cMaxDrift;
+	Continuous cSecondMaxDrift;
+
+	/** nombres de distances instance-centroide calculees et evitees lors des phases d'affectation d'un replicate (elagage par bornes) */
+	longint lComputedDistancesNumber;
+	longint lPrunedDistancesNumber;
+
+	/** matrice dense des centroides de modelisation des clusters, mise a jour en meme temps que la matrice des distances inter-clusters */
+	KMDenseMatrix dmClustersCentroids;
+
+	/** matrice creuse des valeurs K-Means des instances (non possedee, NULL si non utilisee) */
+	const KMSparseMatrix* instancesSparseMatrix;
+
+	/** normes L1, et carres des normes L2, des lignes de dmClustersCentroids (calculs de distances a partir de la matrice creuse des instances) */
+	ContinuousVector cvClustersCentroidsL1Norms;
+	ContinuousVector cvClustersCentroidsSquaredNorms;
+
 	/** matrice de confusion "classes predites (ou majoritaires) versus classes reelles", mode supervise et phase de train
 	colonne = classe reelle, ligne = classe predite */
 	KWFrequencyTable* kwftConfusionMatrix;
@@ -346,9 +566,8 @@ inline KMCluster* KMClustering::GetCluster(const int idx) const
 	return cast(KMCluster*, GetClusters()->GetAt(idx));
 }
 
-inline Continuous** KMClustering::GetClustersCentersDistances() const {
+inline const KMTriangularMatrix& KMClustering::GetClustersCentersDistances() const {
 
-	assert(clustersCentersDistances != NULL);
 	return clustersCentersDistances;
 }
 
@@ -357,6 +576,22 @@ inline NumericKeyDictionary* KMClustering::GetInstancesToClusters() const {
 	return instancesToClusters;
 }
 
+inline void KMClustering::SetInstancesMatrix(const KMDenseMatrix* matrix) {
+	instancesMatrix = matrix;
+}
+
+inline const KMDenseMatrix* KMClustering::GetInstancesMatrix() const {
+	return instancesMatrix;
+}
+
+inline void KMClustering::SetInstancesSparseMatrix(const KMSparseMatrix* matrix) {
+	instancesSparseMatrix = matrix;
+}
+
+inline const KMSparseMatrix* KMClustering::GetInstancesSparseMatrix() const {
+	return instancesSparseMatrix;
+}
+
 
 inline const int  KMClustering::GetIterationsDone() const {
 	return iIterationsDone;
@@ -379,11 +614,12 @@ class KMInstance : public Object
 {
 public:
 
-	KMInstance(KWObject* inst, int idClus, double dist) : idCluster(idClus), distance(dist), instance(inst) {}
+	KMInstance(KWObject* inst, int idClus, double dist, int pos = -1) : idCluster(idClus), distance(dist), instance(inst), position(pos) {}
 
 	const int idCluster;
 	const double distance;
 	const KWObject* instance;
+	const int position; // position de l'instance dans la liste d'instances melangee a partir de la matrice dense (-1 si non utilisee)
 };
 
 int KMClusteringDistanceCompareDesc(const void* elem1, const void* elem2);
@@ -1417,23 +1417,33 @@ void KMClusteringInitializer::InitializeKMeanPlusPlusNextCenters(const ObjectArr
 
 	ObjectArray* clusters = clustering->GetClusters();
 	const KMParameters* parameters = clustering->GetParameters();
-	KWLoadIndex loadIndex;
-	boolean bIsDuplicate;
 	assert(clusters->GetSize() > 0); // a ce stade, on a : soit des clusters correspondant a tout ou partie des modalites cibles (KMean++R), soit 1 seul cluster dont le centre a ete tire au hasard
 	const int initiallyCreatedClusters = clusters->GetSize();
 
-	ContinuousVector distances; // contient les plus petites distances, pour chaque instance
-	distances.SetSize(instances->GetSize());
-	distances.Initialize();
+	ContinuousVector cvMinDistances; // contient les plus petites distances aux centres deja choisis, pour chaque instance (0 si valeurs manquantes)
+	ContinuousVector cvCumulatedDistances; // sommes cumulees des plus petites distances, pour le tirage du centre suivant
+	IntVector ivMissingValues; // 1 si l'instance a des valeurs K-Means manquantes
 
-	ContinuousVector normalizedDistances; // contient les plus petites distances normalisees, pour chaque instance
-	normalizedDistances.SetSize(instances->GetSize());
-	normalizedDistances.Initialize();
+	ivMissingValues.SetSize(instances->GetSize());
+	for (int idxInstance = 0; idxInstance < instances->GetSize(); idxInstance++) {
+		if (parameters->HasMissingKMeanValue(cast(KWObject*, instances->GetAt(idxInstance))))
+			ivMissingValues.SetAt(idxInstance, 1);
+	}
 
-	clustering->ComputeClustersCentersDistances(); // calculer la matrice des distances entre centres de clusters
+	// distances aux centres initiaux : par la suite, les plus petites distances ne sont mises a jour que par rapport a chaque nouveau centre
+	InitializeKMeanPlusPlusMinDistances(instances, ivMissingValues, cvMinDistances);
 
 	int nbCreatedCenters = 0;
 
+	// tirage d'une partie des centres selon l'algorithme KMean|| (les centres restants eventuels sont tires de maniere sequentielle)
+	if (parameters->GetKMeanParallelSeeding() and nbCentersToCreate > 1) {
+
+		nbCreatedCenters = InitializeKMeanParallelNextCenters(instances, ivMissingValues, nbCentersToCreate);
+
+		if (nbCreatedCenters < nbCentersToCreate)
+			InitializeKMeanPlusPlusMinDistances(instances, ivMissingValues, cvMinDistances);
+	}
+
 	// calcul des centres suivants, a partir de centres KMean++ ou KMean++R deja calcules
 
 	boolean bContinue = nbCreatedCenters < nbCentersToCreate ? true : false;
@@ -1446,88 +1456,309 @@ void KMClusteringInitializer::InitializeKMeanPlusPlusNextCenters(const ObjectArr
 		TaskProgression::DisplayProgression((double)nbCreatedCenters / (double)nbCentersToCreate * 100);
 		TaskProgression::DisplayLabel("Clusters initialized : " + ALString(IntToString(nbCreatedCenters)) + " on " + ALString(IntToString(nbCentersToCreate + initiallyCreatedClusters)));
 
-		for (int idxInstance = 0; idxInstance < instances->GetSize(); idxInstance++) {
+		const double distancesSum = ComputeCumulatedDistances(cvMinDistances, NULL, cvCumulatedDistances);
 
-			KWObject* instance = cast(KWObject*, instances->GetAt(idxInstance));
+		if (distancesSum <= 0.0)
+			break;
 
-			if (parameters->HasMissingKMeanValue(instance))
-				continue;
+		// tirage d'une instance avec une probabilite proportionnelle a sa plus petite distance aux centres deja choisis
+		const double rand = (double)RandomInt(instances->GetSize()) / (double)instances->GetSize();
 
-			double dDistanceMin = -1;
+		int idxInstance = SearchCumulatedDistance(cvCumulatedDistances, rand * distancesSum);
 
-			// trouver la plus petite distance entre cette instance et les centres deja connus
-			KMCluster* nearestCluster = clustering->FindNearestCluster(instance);
+		KMCluster* newCluster = NULL;
 
-			double d = nearestCluster->FindDistanceFromCentroid(instance, nearestCluster->GetModelingCentroidValues(), parameters->GetDistanceType());
+		// si l'instance tiree correspond a un centre deja utilise, on retient la suivante (comme lors d'un parcours lineaire des sommes cumulees)
+		while (idxInstance < instances->GetSize()) {
 
-			if (d != KWContinuous::GetMaxValue()) { // tenir compte du probleme des eventuelles valeurs manquantes
+			if (ivMissingValues.GetAt(idxInstance) == 0) {
 
-				if (dDistanceMin == -1 or d < dDistanceMin) {
-					distances.SetAt(idxInstance, d);
-					dDistanceMin = d;
-				}
+				KWObject* center = cast(KWObject*, instances->GetAt(idxInstance));
+				newCluster = new KMCluster(parameters);
+				newCluster->InitializeModelingCentroidValues(center); // initialiser le centroide de cluster a partir de l'instance trouvee
+
+				if (not IsDuplicateCenter(newCluster, cvMinDistances.GetAt(idxInstance)))
+					break;
+
+				delete newCluster;
+				newCluster = NULL;
 			}
+			idxInstance++;
+		}
+
+		if (newCluster != NULL) {
+			clusters->Add(newCluster);
+			nbCreatedCenters++;
+			UpdateKMeanPlusPlusMinDistances(instances, ivMissingValues, newCluster, cvMinDistances, NULL, -1);
 		}
 
-		// normalisation du vecteur des distances
+		bContinue = nbCreatedCenters < nbCentersToCreate ? true : false;
+	}
+
+	clustering->ComputeClustersCentersDistances(); // calculer la matrice des distances entre centres de clusters
+}
+
+int KMClusteringInitializer::InitializeKMeanParallelNextCenters(const ObjectArray* instances, const IntVector& ivMissingValues, const int nbCentersToCreate)
+{
+	assert(instances != NULL);
+	assert(clustering != NULL);
+	assert(nbCentersToCreate > 0);
+
+	ObjectArray* clusters = clustering->GetClusters();
+	const KMParameters* parameters = clustering->GetParameters();
+	const int initiallyCreatedClusters = clusters->GetSize();
+
+	ObjectArray oaCandidates; // centres candidats (KMCluster *, possedes tant qu'ils ne sont pas retenus)
+	ObjectArray oaCandidatesInstances; // instance de BDD a l'origine de chaque centre candidat
+	ContinuousVector cvMinDistances; // pour chaque instance, plus petite distance aux centres initiaux et aux centres candidats
+	IntVector ivNearestCandidates; // pour chaque instance, index du centre candidat le plus proche (-1 si c'est un centre initial)
+	ContinuousVector cvCumulatedDistances;
+	int idxInstance;
+	int idxCandidate;
+
+	// facteur de sur-echantillonnage : nombre moyen de candidats tires a chaque passe
+	const double oversamplingFactor = 2.0 * nbCentersToCreate;
+
+	InitializeKMeanPlusPlusMinDistances(instances, ivMissingValues, cvMinDistances);
+
+	ivNearestCandidates.SetSize(instances->GetSize());
+	for (idxInstance = 0; idxInstance < instances->GetSize(); idxInstance++)
+		ivNearestCandidates.SetAt(idxInstance, -1);
+
+	// passes de sur-echantillonnage : chaque instance est retenue comme candidat avec une probabilite proportionnelle a sa plus petite distance aux centres
+	for (int nRound = 0; nRound < KMParameters::KMEAN_PARALLEL_ROUNDS; nRound++) {
+
+		if (TaskProgression::IsInterruptionRequested())
+			break;
+
+		TaskProgression::DisplayProgression((double)nRound / (double)KMParameters::KMEAN_PARALLEL_ROUNDS * 100);
+		TaskProgression::DisplayLabel("KMean|| seeding : round " + ALString(IntToString(nRound + 1)) + " on " + ALString(IntToString(KMParameters::KMEAN_PARALLEL_ROUNDS)));
+
 		double distancesSum = 0.0;
-		for (int i = 0; i < instances->GetSize(); i++) {
-			distancesSum += distances.GetAt(i);
+		for (idxInstance = 0; idxInstance < instances->GetSize(); idxInstance++)
+			distancesSum += cvMinDistances.GetAt(idxInstance);
+
+		if (distancesSum <= 0.0)
+			break;
+
+		const int firstNewCandidate = oaCandidates.GetSize();
+
+		for (idxInstance = 0; idxInstance < instances->GetSize(); idxInstance++) {
+
+			// une instance a distance nulle des centres existants ne peut pas produire de nouveau centre
+			if (ivMissingValues.GetAt(idxInstance) == 1 or cvMinDistances.GetAt(idxInstance) <= 0.0)
+				continue;
+
+			if (RandomDouble() < oversamplingFactor * cvMinDistances.GetAt(idxInstance) / distancesSum) {
+
+				KWObject* instance = cast(KWObject*, instances->GetAt(idxInstance));
+				KMCluster* candidate = new KMCluster(parameters);
+				candidate->InitializeModelingCentroidValues(instance);
+				oaCandidates.Add(candidate);
+				oaCandidatesInstances.Add(instance);
+			}
 		}
 
-		if (distancesSum > 0.0) {
-			for (int i = 0; i < distances.GetSize(); i++) {
-				normalizedDistances.SetAt(i, distances.GetAt(i) / distancesSum);
+		// mise a jour des plus petites distances, par rapport aux seuls nouveaux candidats
+		for (idxCandidate = firstNewCandidate; idxCandidate < oaCandidates.GetSize(); idxCandidate++)
+			UpdateKMeanPlusPlusMinDistances(instances, ivMissingValues, cast(KMCluster*, oaCandidates.GetAt(idxCandidate)), cvMinDistances, &ivNearestCandidates, idxCandidate);
+	}
+
+	// poids de chaque candidat : nombre d'instances dont il est le centre le plus proche
+	ContinuousVector cvCandidatesWeights;
+	cvCandidatesWeights.SetSize(oaCandidates.GetSize());
+	cvCandidatesWeights.Initialize();
+
+	for (idxInstance = 0; idxInstance < instances->GetSize(); idxInstance++) {
+		idxCandidate = ivNearestCandidates.GetAt(idxInstance);
+		if (idxCandidate != -1)
+			cvCandidatesWeights.SetAt(idxCandidate, cvCandidatesWeights.GetAt(idxCandidate) + 1);
+	}
+
+	// KMean++ pondere sur les candidats : plus petites distances des candidats aux centres initiaux, puis mises a jour par rapport a chaque centre retenu
+	ContinuousVector cvCandidatesMinDistances;
+	cvCandidatesMinDistances.SetSize(oaCandidates.GetSize());
+
+	for (idxCandidate = 0; idxCandidate < oaCandidates.GetSize(); idxCandidate++) {
+
+		const KWObject* instance = cast(KWObject*, oaCandidatesInstances.GetAt(idxCandidate));
+		double dDistanceMin = KWContinuous::GetMaxValue();
+
+		for (int idxCluster = 0; idxCluster < initiallyCreatedClusters; idxCluster++) {
+
+			KMCluster* cluster = cast(KMCluster*, clusters->GetAt(idxCluster));
+			const double d = cluster->FindDistanceFromCentroid(instance, cluster->GetModelingCentroidValues(), parameters->GetDistanceType());
+
+			if (d < dDistanceMin)
+				dDistanceMin = d;
+		}
+		cvCandidatesMinDistances.SetAt(idxCandidate, dDistanceMin == KWContinuous::GetMaxValue() ? 0.0 : dDistanceMin);
+	}
+
+	int nbCreatedCenters = 0;
+
+	while (nbCreatedCenters < nbCentersToCreate) {
+
+		if (TaskProgression::IsInterruptionRequested())
+			break;
+
+		const double distancesSum = ComputeCumulatedDistances(cvCandidatesMinDistances, &cvCandidatesWeights, cvCumulatedDistances);
+
+		// plus de candidat distinct des centres deja retenus
+		if (distancesSum <= 0.0)
+			break;
+
+		idxCandidate = SearchCumulatedDistance(cvCumulatedDistances, RandomDouble() * distancesSum);
+
+		if (idxCandidate == oaCandidates.GetSize())
+			continue;
+
+		KMCluster* newCluster = cast(KMCluster*, oaCandidates.GetAt(idxCandidate));
+
+		oaCandidates.SetAt(idxCandidate, NULL);
+		clusters->Add(newCluster);
+		nbCreatedCenters++;
+
+		for (int i = 0; i < oaCandidates.GetSize(); i++) {
+
+			if (oaCandidates.GetAt(i) == NULL) {
+				cvCandidatesMinDistances.SetAt(i, 0.0);
+				continue;
 			}
+
+			const double d = newCluster->FindDistanceFromCentroid(cast(KWObject*, oaCandidatesInstances.GetAt(i)),
+				newCluster->GetModelingCentroidValues(), parameters->GetDistanceType());
+
+			if (d < cvCandidatesMinDistances.GetAt(i))
+				cvCandidatesMinDistances.SetAt(i, d);
 		}
-		else
-			bContinue = false;
+	}
 
-		// tirage nombre aleatoire entre 0 et 1
-		double rand = (double)RandomInt(instances->GetSize()) / (double)instances->GetSize();
+	// destruction des candidats non retenus
+	oaCandidates.DeleteAll();
 
-		// choix du centre suivant
-		double sum = 0.0;
+	if (parameters->GetVerboseMode())
+		AddSimpleMessage("KMean|| seeding : " + ALString(IntToString(nbCreatedCenters)) + " centers chosen among " +
+			ALString(IntToString(oaCandidatesInstances.GetSize())) + " candidates");
 
-		for (int idxInstance = 0; idxInstance < normalizedDistances.GetSize(); idxInstance++) {
+	return nbCreatedCenters;
+}
 
-			sum += normalizedDistances.GetAt(idxInstance);
+void KMClusteringInitializer::InitializeKMeanPlusPlusMinDistances(const ObjectArray* instances, const IntVector& ivMissingValues, ContinuousVector& cvMinDistances)
+{
+	assert(instances != NULL);
+	assert(clustering != NULL);
 
-			if (sum > rand) {
+	const ObjectArray* clusters = clustering->GetClusters();
+	const KMParameters* parameters = clustering->GetParameters();
 
-				KWObject* center = cast(KWObject*, instances->GetAt(idxInstance));
-				assert(center != NULL);
-				KMCluster* newCluster = new KMCluster(parameters);
-				newCluster->InitializeModelingCentroidValues(center); // initialiser le centroide de cluster a partir de l'instance trouv�e
-
-				// detecter si ce nouveau centre potentiel n'a pas deja ete utilise
-				bIsDuplicate = false;
-				for (int i = 0; i < clusters->GetSize(); i++)
-				{
-					KMCluster* existingCenter = cast(KMCluster*, clusters->GetAt(i));
-					const Continuous distance = KMClustering::GetDistanceBetween(existingCenter->GetModelingCentroidValues(),
-						newCluster->GetModelingCentroidValues(), parameters->GetDistanceType(), parameters->GetKMeanAttributesLoadIndexes());
-					if (distance == 0) {
-						bIsDuplicate = true;
-						break;
-					}
-				}
+	cvMinDistances.SetSize(instances->GetSize());
 
-				if (bIsDuplicate) {
-					delete newCluster;
-				}
-				else {
-					clusters->Add(newCluster);
-					nbCreatedCenters++;
-					clustering->ComputeClustersCentersDistances();// on a ajoute un cluster : recalculer la matrice des distances entre centres de clusters
-					break;
-				}
+	for (int idxInstance = 0; idxInstance < instances->GetSize(); idxInstance++) {
+
+		double dDistanceMin = KWContinuous::GetMaxValue();
+
+		if (ivMissingValues.GetAt(idxInstance) == 0) {
+
+			const KWObject* instance = cast(KWObject*, instances->GetAt(idxInstance));
+
+			for (int idxCluster = 0; idxCluster < clusters->GetSize(); idxCluster++) {
+
+				KMCluster* cluster = cast(KMCluster*, clusters->GetAt(idxCluster));
+				const double d = cluster->FindDistanceFromCentroid(instance, cluster->GetModelingCentroidValues(), parameters->GetDistanceType());
+
+				if (d < dDistanceMin)
+					dDistanceMin = d;
 			}
 		}
 
-		if (bContinue)
-			bContinue = nbCreatedCenters < nbCentersToCreate ? true : false;
+		// tenir compte du probleme des eventuelles valeurs manquantes
+		cvMinDistances.SetAt(idxInstance, dDistanceMin == KWContinuous::GetMaxValue() ? 0.0 : dDistanceMin);
+	}
+}
+
+void KMClusteringInitializer::UpdateKMeanPlusPlusMinDistances(const ObjectArray* instances, const IntVector& ivMissingValues, KMCluster* newCenter,
+	ContinuousVector& cvMinDistances, IntVector* ivNearestCenters, const int newCenterIndex)
+{
+	assert(instances != NULL);
+	assert(newCenter != NULL);
+	assert(clustering != NULL);
+
+	const KMParameters* parameters = clustering->GetParameters();
+	const ContinuousVector& cvCentroid = newCenter->GetModelingCentroidValues();
+
+	for (int idxInstance = 0; idxInstance < instances->GetSize(); idxInstance++) {
+
+		// instances avec valeurs manquantes, ou confondues avec un centre existant : plus petite distance nulle, qui ne peut plus diminuer
+		if (ivMissingValues.GetAt(idxInstance) == 1 or cvMinDistances.GetAt(idxInstance) <= 0.0)
+			continue;
+
+		const double d = newCenter->FindDistanceFromCentroid(cast(KWObject*, instances->GetAt(idxInstance)), cvCentroid, parameters->GetDistanceType());
+
+		if (d < cvMinDistances.GetAt(idxInstance)) {
+			cvMinDistances.SetAt(idxInstance, d);
+			if (ivNearestCenters != NULL)
+				ivNearestCenters->SetAt(idxInstance, newCenterIndex);
+		}
+	}
+}
+
+double KMClusteringInitializer::ComputeCumulatedDistances(const ContinuousVector& cvDistances, const ContinuousVector* cvWeights, ContinuousVector& cvCumulatedDistances)
+{
+	double distancesSum = 0.0;
+
+	cvCumulatedDistances.SetSize(cvDistances.GetSize());
+
+	for (int i = 0; i < cvDistances.GetSize(); i++) {
+		distancesSum += (cvWeights == NULL ? cvDistances.GetAt(i) : cvWeights->GetAt(i) * cvDistances.GetAt(i));
+		cvCumulatedDistances.SetAt(i, distancesSum);
 	}
+
+	return distancesSum;
+}
+
+int KMClusteringInitializer::SearchCumulatedDistance(const ContinuousVector& cvCumulatedDistances, const double dValue)
+{
+	int nLower = 0;
+	int nUpper = cvCumulatedDistances.GetSize();
+
+	// recherche dichotomique du premier index dont la somme cumulee est strictement superieure a la valeur (taille du vecteur si aucun)
+	while (nLower < nUpper) {
+
+		const int nMiddle = nLower + (nUpper - nLower) / 2;
+
+		if (cvCumulatedDistances.GetAt(nMiddle) > dValue)
+			nUpper = nMiddle;
+		else
+			nLower = nMiddle + 1;
+	}
+
+	return nLower;
+}
+
+boolean KMClusteringInitializer::IsDuplicateCenter(const KMCluster* newCluster, const double dMinDistance) const
+{
+	assert(newCluster != NULL);
+	assert(clustering != NULL);
+
+	const ObjectArray* clusters = clustering->GetClusters();
+	const KMParameters* parameters = clustering->GetParameters();
+
+	// en normes L1 et L2, une instance a distance non nulle de tous les centres ne peut pas etre confondue avec l'un d'eux
+	if (parameters->GetDistanceType() != KMParameters::CosineNorm and dMinDistance > 0.0)
+		return false;
+
+	// detecter si ce nouveau centre potentiel n'a pas deja ete utilise
+	for (int i = 0; i < clusters->GetSize(); i++)
+	{
+		KMCluster* existingCenter = cast(KMCluster*, clusters->GetAt(i));
+		const Continuous distance = KMClustering::GetDistanceBetween(existingCenter->GetModelingCentroidValues(),
+			newCluster->GetModelingCentroidValues(), parameters->GetDistanceType(), parameters->GetKMeanAttributesLoadIndexes());
+		if (distance == 0)
+			return true;
+	}
+
+	return false;
 }
 
 // creer les clusters correspondant aux modalites cibles
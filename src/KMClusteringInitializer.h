@@ -79,9 +79,31 @@ protected:
 	/** creer les "C" clusters initiaux (correspondant aux modalites cibles) */
 	void CreateTargetModalitiesClusters(const ObjectArray* instances, const KWAttribute* targetAttribute);
 
-	/** initialiser les centres suivants, en KMean++ ou KMean++R */
+	/** initialiser les centres suivants, en KMean++ ou KMean++R. Les plus petites distances des instances aux centres deja choisis sont memorisees,
+	et mises a jour uniquement par rapport a chaque nouveau centre */
 	void InitializeKMeanPlusPlusNextCenters(const ObjectArray* instances, const int nbCenters);
 
+	/** initialiser tout ou partie des centres suivants selon l'algorithme KMean|| : quelques passes de sur-echantillonnage de centres candidats,
+	puis KMean++ pondere sur les candidats. Retourne le nombre de centres crees */
+	int InitializeKMeanParallelNextCenters(const ObjectArray* instances, const IntVector& ivMissingValues, const int nbCenters);
+
+	/** calcul, pour chaque instance, de la plus petite distance aux centres des clusters existants (0 si l'instance a des valeurs manquantes) */
+	void InitializeKMeanPlusPlusMinDistances(const ObjectArray* instances, const IntVector& ivMissingValues, ContinuousVector& cvMinDistances);
+
+	/** mise a jour des plus petites distances des instances aux centres, par rapport a un nouveau centre.
+	Si un vecteur d'index est passe en parametre, l'index du nouveau centre y est memorise pour les instances dont il devient le centre le plus proche */
+	void UpdateKMeanPlusPlusMinDistances(const ObjectArray* instances, const IntVector& ivMissingValues, KMCluster* newCenter,
+		ContinuousVector& cvMinDistances, IntVector* ivNearestCenters, const int newCenterIndex);
+
+	/** calcul des sommes cumulees de distances (eventuellement ponderees), et retour de la somme totale */
+	static double ComputeCumulatedDistances(const ContinuousVector& cvDistances, const ContinuousVector* cvWeights, ContinuousVector& cvCumulatedDistances);
+
+	/** recherche dichotomique du premier index dont la somme cumulee est strictement superieure a une valeur (taille du vecteur si aucun) */
+	static int SearchCumulatedDistance(const ContinuousVector& cvCumulatedDistances, const double dValue);
+
+	/** indique si un centre potentiel est confondu avec le centre d'un cluster existant (plus petite distance de l'instance correspondante aux centres fournie) */
+	boolean IsDuplicateCenter(const KMCluster* newCluster, const double dMinDistance) const;
+
 	/** initialiser les centres suivants, en MinMax */
 	void InitializeMinMaxNextCenters(const ObjectArray* instances);
 
@@ -4,6 +4,10 @@
 
 #include "KMClusteringMiniBatch.h"
 #include "KMClusteringQuality.h"
+#include "KMMiniBatchReader.h"
+#include "KMMiniBatchTask.h"
+#include "KMDistanceKernel.h"
+#include "KMGlobalStatistics.h"
 
 KMClusteringMiniBatch::KMClusteringMiniBatch(KMParameters* p) : KMClustering(p)
 {
@@ -13,9 +17,10 @@ KMClusteringMiniBatch::~KMClusteringMiniBatch(void)
 {
 }
 
-bool KMClusteringMiniBatch::ComputeReplicate(KWDatabase* database, const KWAttribute* targetAttribute, const int iMiniBatchesNumber,
-	const int originDatabaseSamplePercentage, const int miniBatchDatabaseSamplePercentage)
+bool KMClusteringMiniBatch::ComputeReplicate(KWDatabase* database, const KWAttribute* targetAttribute, const int iMiniBatchesNumber, const ObjectArray* oaInitializationSample)
 {
+	require(oaInitializationSample != NULL);
+
 	Timer timer;
 	timer.Start();
 
@@ -29,76 +34,89 @@ bool KMClusteringMiniBatch::ComputeReplicate(KWDatabase* database, const KWAttri
 		AddSimpleMessage(ALString("Instances with missing values, detected during clusters initialization : ") + LongintToString(GetInstancesWithMissingValues()));
 
 	ContinuousVector cvClustersTotalCount;
+	ContinuousVector cvClustersSums;
+	IntVector ivClustersFrequencies;
+	ObjectArray oaMiniBatchInstances;
+	boolean bOk;
 
-	// modifier le sample en fonction du nombre d'instances de chaque mini batch (calcule precedemment)
-	database->SetSampleNumberPercentage(miniBatchDatabaseSamplePercentage);
 	database->SetSilentMode(true);
 
-	for (int iIteration = 0; iIteration < iMiniBatchesNumber; iIteration++) {
+	// les mini-batches sont lus en flux : chaque passe sur la base fournit l'ensemble des mini-batches, en une seule lecture
+	KMMiniBatchReader miniBatchReader;
+	miniBatchReader.SetDatabase(database);
+	miniBatchReader.SetMiniBatchSize(parameters->GetMiniBatchSize());
+	miniBatchReader.SetBlockMiniBatchesNumber(KMParameters::MINI_BATCHES_BY_SHUFFLED_BLOCK);
 
-		database->DeleteAll();
-		database->ReadAll();// lecture partielle de la base
-		ObjectArray* miniBatchInstances = database->GetObjects();
-		miniBatchInstances->Shuffle();
-		const int nbInstances = miniBatchInstances->GetSize();
+	bOk = miniBatchReader.Open();
 
-		if (parameters->GetKValue() > nbInstances) {
-			AddWarning("K parameter (" + ALString(IntToString(parameters->GetKValue())) +
-				") is greater than the number of instances in mini-batch (" + ALString(IntToString(nbInstances)) +
-				"), setting K value to " + ALString(IntToString(nbInstances)));
-			parameters->SetKValue(nbInstances);
-		}
+	for (int iIteration = 0; bOk and iIteration < iMiniBatchesNumber; iIteration++) {
+
+		bOk = miniBatchReader.ReadNextMiniBatch(&oaMiniBatchInstances);
+		if (not bOk)
+			break;
 
 		if (iIteration == 0) {
-			// a la premiere iteration : repartition initiale des instances du mini-batch entre les clusters, selon la methode parametree par l'utilisateur, et
-			// calcul des centroides initiaux
-			if (not InitializeClusters(parameters->GetClustersCentersInitializationMethod(), miniBatchInstances, targetAttribute)) {
+
+			// les blocs lus ne couvrent que le debut de la base : le mini-batch d'initialisation est tire au hasard dans l'echantillon uniforme
+			// constitue lors du calcul des statistiques globales (propre a chaque replicate, via la graine aleatoire)
+			ObjectArray oaInitializationInstances;
+			oaInitializationInstances.CopyFrom(oaInitializationSample);
+			oaInitializationInstances.Shuffle();
+			if (oaInitializationInstances.GetSize() > parameters->GetMiniBatchSize())
+				oaInitializationInstances.SetSize(parameters->GetMiniBatchSize());
+
+			const int nbInstances = oaInitializationInstances.GetSize();
+
+			if (parameters->GetKValue() > nbInstances) {
+				AddWarning("K parameter (" + ALString(IntToString(parameters->GetKValue())) +
+					") is greater than the number of instances in mini-batch (" + ALString(IntToString(nbInstances)) +
+					"), setting K value to " + ALString(IntToString(nbInstances)));
+				parameters->SetKValue(nbInstances);
+			}
+
+			// a la premiere iteration : repartition initiale des instances du mini-batch d'initialisation entre les clusters, selon la methode parametree
+			// par l'utilisateur, et calcul des centroides initiaux
+			if (not InitializeClusters(parameters->GetClustersCentersInitializationMethod(), &oaInitializationInstances, targetAttribute)) {
 				AddMessage("Failed to initialize clusters");
-				return false;
+				bOk = false;
+				break;
 			}
+
+			// les clusters ne doivent plus referencer les instances d'initialisation, les mini-batches etant ensuite traites en flux
+			for (int idxCluster = 0; idxCluster < kmClusters->GetSize(); idxCluster++)
+				cast(KMCluster*, kmClusters->GetAt(idxCluster))->RemoveAll();
+			instancesToClusters->RemoveAll();
+
 			cvClustersTotalCount.SetSize(kmClusters->GetSize());
 			cvClustersTotalCount.Initialize();
 		}
-		else
-			// vider les clusters de leurs anciennes instances, et affecter les instances du minibatch aux centroides ayant ete modifies a l'iteration precedente
-			AddInstancesToClusters(miniBatchInstances);
-
-		// parcourir les instances de chaque cluster et faire evoluer la valeur des centroides
-		for (int idxCluster = 0; idxCluster < kmClusters->GetSize(); idxCluster++) {
 
-			KMCluster* cluster = cast(KMCluster*, kmClusters->GetAt(idxCluster));
-
-			NUMERIC key;
-			Object* oCurrent;
-			POSITION position = cluster->GetStartPosition();
-
-			// parcours des instances du cluster
-			while (position != NULL) {
+		// affectation des instances du mini-batch aux centroides courants, puis mise a jour des centroides
+		bOk = ComputeMiniBatchClustersSums(&oaMiniBatchInstances, cvClustersSums, ivClustersFrequencies);
+		if (not bOk)
+			break;
 
-				cluster->GetNextAssoc(position, key, oCurrent);
-				KWObject* currentInstance = static_cast<KWObject *>(oCurrent);
+		UpdateMiniBatchCentroids(cvClustersSums, ivClustersFrequencies, cvClustersTotalCount);
 
-				cvClustersTotalCount.SetAt(idxCluster, cvClustersTotalCount.GetAt(idxCluster) + 1);
+		if (TaskProgression::IsInterruptionRequested())
+			bOk = false;
+	}
 
-				const Continuous cLearningRate = 1.0 / (double)cvClustersTotalCount.GetAt(idxCluster);
+	if (parameters->GetVerboseMode() and bOk)
+		AddSimpleMessage("Mini-batches read in " + ALString(IntToString(miniBatchReader.GetEpochNumber())) + " database pass(es)");
 
-				ContinuousVector cvUpdatedCentroidValues;
-				cvUpdatedCentroidValues.CopyFrom(&cluster->GetInitialCentroidValues());
+	oaMiniBatchInstances.SetSize(0);
+	miniBatchReader.Close();
 
-				for (int i = 0; i < parameters->GetKMeanAttributesLoadIndexes().GetSize(); i++) {
-					const KWLoadIndex loadIndex = parameters->GetKMeanAttributesLoadIndexes().GetAt(i);
-					if (loadIndex.IsValid()) {
-						cvUpdatedCentroidValues.SetAt(i, ((1 - cLearningRate) * cvUpdatedCentroidValues.GetAt(i)) + (cLearningRate * currentInstance->GetContinuousValueAt(loadIndex)));
-					}
-				}
-				cluster->SetModelingCentroidValues(cvUpdatedCentroidValues);
-			}
-			cluster->SetStatisticsUpToDate(true);// on n'a pas besoin de rafraichir les autres stats
-		}
+	if (not bOk) {
+		database->SetSilentMode(false);
+		return false;
 	}
 
+	// mise a jour des distances inter-clusters, a partir des centroides finaux
+	ComputeClustersCentersDistances();
+
 	// a partir des instances de l'ensemble de la base, mise a jour finale des stats des clusters (sans toucher aux centroides) :
-	database->SetSampleNumberPercentage(originDatabaseSamplePercentage);
 	FinalizeReplicateComputing(database, targetAttribute);
 
 	int iDroppedClusters = ManageEmptyClusters(false);// supprimer les clusters qui seraient devenus vides
@@ -186,6 +204,102 @@ bool KMClusteringMiniBatch::ComputeReplicate(KWDatabase* database, const KWAttri
 	return true;
 }
 
+boolean KMClusteringMiniBatch::ComputeMiniBatchClustersSums(const ObjectArray* miniBatchInstances, ContinuousVector& cvClustersSums, IntVector& ivClustersFrequencies) {
+
+	require(miniBatchInstances != NULL);
+	require(kmClusters->GetSize() > 0);
+
+	const int nbClusters = kmClusters->GetSize();
+	const KMParameters::DistanceType distanceType = parameters->GetDistanceType();
+
+	// copie des valeurs K-Means du mini-batch et des centroides dans des matrices denses, pour le calcul vectorise des distances
+	if (not dmMiniBatchInstances.InitializeFromInstances(miniBatchInstances, parameters->GetKMeanAttributesLoadIndexes()))
+		return false;
+	if (not dmMiniBatchCentroids.InitializeFromCentroids(kmClusters, &dmMiniBatchInstances))
+		return false;
+
+	const int nbColumns = dmMiniBatchInstances.GetColumnNumber();
+	const int nStride = dmMiniBatchInstances.GetRowStride();
+
+	// en mode parallele, les lignes du mini-batch sont reparties entre les esclaves, des qu'il y a au moins deux tranches a traiter
+	if (parameters->GetParallelMode() and dmMiniBatchInstances.GetRowNumber() >= 2 * KMMiniBatchTask::MIN_ROWS_BY_TASK) {
+
+		KMMiniBatchTask miniBatchTask;
+
+		if (not miniBatchTask.ComputeClustersSums(&dmMiniBatchInstances, &dmMiniBatchCentroids, nbClusters, distanceType))
+			return false;
+
+		cvClustersSums.CopyFrom(&miniBatchTask.GetClustersSums());
+		ivClustersFrequencies.CopyFrom(&miniBatchTask.GetClustersFrequencies());
+
+		return true;
+	}
+
+	cvClustersSums.SetSize(nbClusters * nbColumns);
+	cvClustersSums.Initialize();
+	ivClustersFrequencies.SetSize(nbClusters);
+	ivClustersFrequencies.Initialize();
+
+	for (int nRow = 0; nRow < dmMiniBatchInstances.GetRowNumber(); nRow++) {
+
+		if (dmMiniBatchInstances.IsMissingValueRow(nRow))
+			continue;
+
+		const Continuous* cValues = dmMiniBatchInstances.GetRowAt(nRow);
+
+		int nearestClusterIndex = 0;
+		Continuous minimumDistance = KWContinuous::GetMaxValue();
+
+		for (int idxCluster = 0; idxCluster < nbClusters; idxCluster++) {
+
+			const Continuous distance = KMDistanceKernel::ComputeDistance(cValues, dmMiniBatchCentroids.GetRowAt(idxCluster), nStride, distanceType);
+			if (distance < minimumDistance) {
+				minimumDistance = distance;
+				nearestClusterIndex = idxCluster;
+			}
+		}
+
+		for (int nColumn = 0; nColumn < nbColumns; nColumn++)
+			cvClustersSums.SetAt(nearestClusterIndex * nbColumns + nColumn, cvClustersSums.GetAt(nearestClusterIndex * nbColumns + nColumn) + cValues[nColumn]);
+
+		ivClustersFrequencies.SetAt(nearestClusterIndex, ivClustersFrequencies.GetAt(nearestClusterIndex) + 1);
+	}
+
+	return true;
+}
+
+void KMClusteringMiniBatch::UpdateMiniBatchCentroids(const ContinuousVector& cvClustersSums, const IntVector& ivClustersFrequencies, ContinuousVector& cvClustersTotalCount) {
+
+	const int nbColumns = dmMiniBatchInstances.GetColumnNumber();
+	ContinuousVector cvUpdatedCentroidValues;
+
+	assert(cvClustersSums.GetSize() == kmClusters->GetSize() * nbColumns);
+
+	// l'effet cumule des mises a jour instance par instance (taux d'apprentissage 1 / effectif total du cluster) revient a deplacer
+	// le centroide vers la moyenne des instances du mini-batch, avec un taux egal a (effectif du mini-batch / effectif total)
+	for (int idxCluster = 0; idxCluster < kmClusters->GetSize(); idxCluster++) {
+
+		const int nMiniBatchFrequency = ivClustersFrequencies.GetAt(idxCluster);
+		if (nMiniBatchFrequency == 0)
+			continue;
+
+		KMCluster* cluster = cast(KMCluster*, kmClusters->GetAt(idxCluster));
+
+		cvClustersTotalCount.SetAt(idxCluster, cvClustersTotalCount.GetAt(idxCluster) + nMiniBatchFrequency);
+
+		const Continuous cLearningRate = nMiniBatchFrequency / (double)cvClustersTotalCount.GetAt(idxCluster);
+
+		cvUpdatedCentroidValues.CopyFrom(&cluster->GetModelingCentroidValues());
+
+		for (int nColumn = 0; nColumn < nbColumns; nColumn++) {
+			const int i = dmMiniBatchInstances.GetAttributeRankAt(nColumn);
+			const Continuous cMiniBatchMean = cvClustersSums.GetAt(idxCluster * nbColumns + nColumn) / nMiniBatchFrequency;
+			cvUpdatedCentroidValues.SetAt(i, ((1 - cLearningRate) * cvUpdatedCentroidValues.GetAt(i)) + (cLearningRate * cMiniBatchMean));
+		}
+		cluster->SetModelingCentroidValues(cvUpdatedCentroidValues);
+	}
+}
+
 void KMClusteringMiniBatch::UpdateTrainingConfusionMatrix(const KWObject* instance, const KMCluster* cluster, const KWAttribute* targetAttribute) {
 
 	assert(oaTargetAttributeValues.GetSize() > 0);
@@ -210,28 +324,37 @@ void KMClusteringMiniBatch::UpdateTrainingConfusionMatrix(const KWObject* instan
 }
 
 // calculer les statistiques globales
-void KMClusteringMiniBatch::ComputeGlobalClusterStatistics(KWDatabase* allInstances, const KWAttribute* targetAttribute) {
+void KMClusteringMiniBatch::ComputeGlobalClusterStatistics(KWDatabase* allInstances, const KWAttribute* targetAttribute, ObjectArray* oaInitializationSample) {
 
 	assert(allInstances != NULL);
+	assert(oaInitializationSample != NULL);
+	assert(oaInitializationSample->GetSize() == 0);
 	assert(allInstances->GetSampleEstimatedObjectNumber() > 0);
 
 	kmGlobalCluster = CreateGlobalCluster();
 
 	ResetInstancesWithMissingValuesNumber();
 
+	// statistiques K-Means calculees en flux (effectif, centroide, sommes des distances)
+	KMGlobalStatistics globalStatistics;
+	globalStatistics.Initialize(parameters);
+
 	// calcul des centroides et (si supervise) des stats sur la modalite cible
-	ComputeGlobalClusterStatisticsFirstDatabaseRead(allInstances, targetAttribute);
+	ComputeGlobalClusterStatisticsFirstDatabaseRead(allInstances, targetAttribute, &globalStatistics, oaInitializationSample);
 
 	// calcul des stats dependant de la valeur finale du centroide (distances, ...)
-	ComputeGlobalClusterStatisticsSecondDatabaseRead(allInstances, targetAttribute);
+	ComputeGlobalClusterStatisticsSecondDatabaseRead(allInstances, targetAttribute, &globalStatistics);
 
 	kmGlobalCluster->FinalizeStatisticsUpdateFromInstances();
 }
 
 // calculer les statistiques globales, premiere passe
-void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsFirstDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute) {
+void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsFirstDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute, KMGlobalStatistics* globalStatistics,
+	ObjectArray* oaInitializationSample) {
 
 	assert(allInstances != NULL);
+	assert(globalStatistics != NULL);
+	assert(oaInitializationSample != NULL);
 	assert(allInstances->GetSampleEstimatedObjectNumber() > 0);
 	const double dMinNecessaryMemory = 16 * 1024 * 1024;
 	ALString sTmp;
@@ -249,6 +372,8 @@ void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsFirstDatabaseRead(KWDa
 	boolean bHasMainTargetModality = parameters->GetMainTargetModality() != "" ? true : false;
 	int iMainTargetModalityIndex = -1;
 
+	const int nInitializationSampleSize = parameters->GetMiniBatchSize() * KMParameters::MINI_BATCHES_BY_SHUFFLED_BLOCK;
+
 	// Ouverture de la base en lecture
 	boolean bOk = allInstances->OpenForRead();
 
@@ -315,10 +440,22 @@ void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsFirstDatabaseRead(KWDa
 				}
 
 				kmGlobalCluster->SetFrequency(kmGlobalCluster->GetFrequency() + 1);
-				kmGlobalCluster->UpdateMeanCentroidValues(kwoObject, (ContinuousVector&)kmGlobalCluster->GetModelingCentroidValues());
+				globalStatistics->AddInstance(kwoObject);
 				kmGlobalCluster->UpdateNativeAttributesContinuousMeanValues(kwoObject);
 
-				delete kwoObject;
+				// echantillon d'initialisation (algorithme du reservoir) : la n-ieme instance complete remplace une instance tiree au hasard
+				// avec une probabilite (taille de l'echantillon / n), de sorte que toutes les instances de la base ont la meme probabilite d'y figurer
+				if (oaInitializationSample->GetSize() < nInitializationSampleSize)
+					oaInitializationSample->Add(kwoObject);
+				else {
+					const longint lReplacedIndex = (longint)(RandomDouble() * kmGlobalCluster->GetFrequency());
+					if (lReplacedIndex < nInitializationSampleSize) {
+						delete oaInitializationSample->GetAt((int)lReplacedIndex);
+						oaInitializationSample->SetAt((int)lReplacedIndex, kwoObject);
+					}
+					else
+						delete kwoObject;
+				}
 			}
 		}
 
@@ -340,12 +477,25 @@ void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsFirstDatabaseRead(KWDa
 		oaTargetAttributeValues.CopyFrom(&oaNewTargetAttributeValues);
 	}
 	allInstances->Close();
+
+	if (globalStatistics->GetFrequency() > 0) {
+
+		// centroide definitif, et sommes des distances deja connues (normes L2 et cosinus)
+		ContinuousVector cvCentroid;
+		globalStatistics->ComputeCentroid(cvCentroid);
+		globalStatistics->SetCentroid(cvCentroid);
+
+		kmGlobalCluster->SetModelingCentroidValues(cvCentroid);
+		kmGlobalCluster->SetDistanceSum(KMParameters::L2Norm, globalStatistics->GetL2DistanceSum());
+		kmGlobalCluster->SetDistanceSum(KMParameters::CosineNorm, globalStatistics->ComputeCosineDistanceSum());
+	}
 }
 
 // calculer les statistiques globales, seconde passe
-void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsSecondDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute) {
+void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsSecondDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute, KMGlobalStatistics* globalStatistics) {
 
 	assert(allInstances != NULL);
+	assert(globalStatistics != NULL);
 	assert(allInstances->GetSampleEstimatedObjectNumber() > 0);
 	const double dMinNecessaryMemory = 16 * 1024 * 1024;
 	ALString sTmp;
@@ -383,10 +533,15 @@ void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsSecondDatabaseRead(KWD
 
 			if (kwoObject != NULL)
 			{
-				kmGlobalCluster->UpdateDistanceSum(KMParameters::L1Norm, kwoObject, kmGlobalCluster->GetModelingCentroidValues());
-				kmGlobalCluster->UpdateDistanceSum(KMParameters::L2Norm, kwoObject, kmGlobalCluster->GetModelingCentroidValues());
-				kmGlobalCluster->UpdateDistanceSum(KMParameters::CosineNorm, kwoObject, kmGlobalCluster->GetModelingCentroidValues());
-				kmGlobalCluster->UpdateInstanceNearestToCentroid(parameters->GetDistanceType(), kwoObject, kmGlobalCluster->GetModelingCentroidValues());
+				nObject++;
+
+				// comme en premiere passe, les instances ayant une valeur K-Means manquante ne font pas partie du cluster global
+				if (not parameters->HasMissingKMeanValue(kwoObject)) {
+
+					// l'instance la plus proche du centroide est copiee des qu'elle est trouvee, l'objet lu etant detruit apres traitement
+					if (globalStatistics->AddInstanceDistances(kwoObject, nObject))
+						kmGlobalCluster->UpdateInstanceNearestToCentroid(parameters->GetDistanceType(), kwoObject, kmGlobalCluster->GetModelingCentroidValues());
+				}
 
 				delete kwoObject;
 			}
@@ -395,6 +550,8 @@ void KMClusteringMiniBatch::ComputeGlobalClusterStatisticsSecondDatabaseRead(KWD
 		Global::DesactivateErrorFlowControl();
 	}
 	allInstances->Close();
+
+	kmGlobalCluster->SetDistanceSum(KMParameters::L1Norm, globalStatistics->GetL1DistanceSum());
 }
 
 void KMClusteringMiniBatch::FinalizeReplicateComputing(KWDatabase* allInstances, const KWAttribute* targetAttribute) {
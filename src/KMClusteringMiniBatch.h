@@ -6,6 +6,8 @@
 
 #include "KMClustering.h"
 
+class KMGlobalStatistics;
+
 ////////////////////////
 /// clustering K-Means selon l'algo des mini-batches
 //
@@ -17,20 +19,30 @@ public:
 	KMClusteringMiniBatch(KMParameters*);
 	~KMClusteringMiniBatch(void);
 
-	/** calcul K-Means mini-batch : boucle principale d'un traitement de clustering */
-	bool ComputeReplicate(KWDatabase* allInstances, const KWAttribute* targetAttribute, const int iMiniBatchesNumber,
-		const int originalDatabaseSamplePercentage, const int miniBatchDatabaseSamplePercentage);
+	/** calcul K-Means mini-batch : boucle principale d'un traitement de clustering (les mini-batches sont lus en flux, sur l'echantillon courant de la base).
+	Les clusters sont initialises a partir d'un mini-batch tire au hasard dans l'echantillon d'initialisation (cf. ComputeGlobalClusterStatistics) */
+	bool ComputeReplicate(KWDatabase* allInstances, const KWAttribute* targetAttribute, const int iMiniBatchesNumber, const ObjectArray* oaInitializationSample);
 
-	/** calculer les statistiques globales 'a la volee', sur toutes les instances de la base */
-	void ComputeGlobalClusterStatistics(KWDatabase* allInstances, const KWAttribute* targetAttribute);
+	/** calculer les statistiques globales 'a la volee', sur toutes les instances de la base. Lors de la premiere lecture, un echantillon uniforme
+	(reservoir) des instances sans valeur K-Means manquante est constitue dans oaInitializationSample, qui doit etre vide et dont l'appelant
+	detruit le contenu. Sa taille est celle d'un bloc de lecture (cf. KMParameters::MINI_BATCHES_BY_SHUFFLED_BLOCK) */
+	void ComputeGlobalClusterStatistics(KWDatabase* allInstances, const KWAttribute* targetAttribute, ObjectArray* oaInitializationSample);
 
 protected:
 
 	/** calcul des stats du cluster global, premiere passe de lecteure de la database */
-	void ComputeGlobalClusterStatisticsFirstDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute);
+	void ComputeGlobalClusterStatisticsFirstDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute, KMGlobalStatistics* globalStatistics,
+		ObjectArray* oaInitializationSample);
 
 	/** calcul des stats du cluster global, premiere passe de lecteure de la database */
-	void ComputeGlobalClusterStatisticsSecondDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute);
+	void ComputeGlobalClusterStatisticsSecondDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute, KMGlobalStatistics* globalStatistics);
+
+	/** affectation des instances d'un mini-batch aux centroides courants : sommes des valeurs K-Means (une ligne de colonnes de matrice dense par cluster)
+	et effectifs des instances affectees a chaque cluster. En mode parallele, le calcul est reparti entre les esclaves (cf. KMMiniBatchTask) */
+	boolean ComputeMiniBatchClustersSums(const ObjectArray* miniBatchInstances, ContinuousVector& cvClustersSums, IntVector& ivClustersFrequencies);
+
+	/** mise a jour des centroides a partir des sommes et effectifs d'un mini-batch, et mise a jour des effectifs totaux des clusters */
+	void UpdateMiniBatchCentroids(const ContinuousVector& cvClustersSums, const IntVector& ivClustersFrequencies, ContinuousVector& cvClustersTotalCount);
 
 	/** en apprentissage, mise a jour de la matrice de confusion "classes majoritaires / classes reelles" */
 	void UpdateTrainingConfusionMatrix(const KWObject* kwoObject, const KMCluster* cluster, const KWAttribute* targetAttribute);
@@ -43,6 +55,10 @@ protected:
 
 	/** finalisation du calcul d'un replicate, 2eme passe de lecture de la database */
 	void FinalizeReplicateComputingSecondDatabaseRead(KWDatabase* allInstances, const KWAttribute* targetAttribute);
+
+	/** valeurs K-Means du mini-batch courant et des centroides, sous forme de matrices denses (reutilisees d'un mini-batch a l'autre) */
+	KMDenseMatrix dmMiniBatchInstances;
+	KMDenseMatrix dmMiniBatchCentroids;
 };
 
 
@@ -0,0 +1,105 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMClustersSnapshot.h"
+#include "KMCluster.h"
+
+const int KMClustersSnapshot::DISTANCE_TYPE_NUMBER = 3; // L1, L2 et cosinus
+
+KMClustersSnapshot::KMClustersSnapshot()
+{
+	nClusterNumber = 0;
+}
+
+KMClustersSnapshot::~KMClustersSnapshot()
+{
+	oaCentroids.DeleteAll();
+}
+
+void KMClustersSnapshot::Save(const ObjectArray* oaClusters)
+{
+	require(oaClusters != NULL);
+
+	nClusterNumber = oaClusters->GetSize();
+
+	// les tampons ne sont agrandis que si le nombre de clusters augmente
+	while (oaCentroids.GetSize() < nClusterNumber)
+		oaCentroids.Add(new ContinuousVector);
+	if (lvFrequencies.GetSize() < nClusterNumber)
+		lvFrequencies.SetSize(nClusterNumber);
+	if (cvDistancesSums.GetSize() < nClusterNumber * DISTANCE_TYPE_NUMBER)
+		cvDistancesSums.SetSize(nClusterNumber * DISTANCE_TYPE_NUMBER);
+
+	for (int i = 0; i < nClusterNumber; i++) {
+
+		const KMCluster* c = cast(KMCluster*, oaClusters->GetAt(i));
+		ContinuousVector* cvCentroid = cast(ContinuousVector*, oaCentroids.GetAt(i));
+		const ContinuousVector& cvSource = c->GetModelingCentroidValues();
+
+		if (cvCentroid->GetSize() != cvSource.GetSize())
+			cvCentroid->SetSize(cvSource.GetSize());
+		for (int j = 0; j < cvSource.GetSize(); j++)
+			cvCentroid->SetAt(j, cvSource.GetAt(j));
+
+		lvFrequencies.SetAt(i, c->GetFrequency());
+
+		for (int d = 0; d < DISTANCE_TYPE_NUMBER; d++)
+			cvDistancesSums.SetAt(i * DISTANCE_TYPE_NUMBER + d, c->GetDistanceSum((KMParameters::DistanceType)d));
+	}
+}
+
+void KMClustersSnapshot::Restore(ObjectArray* oaClusters) const
+{
+	require(oaClusters != NULL);
+	require(not IsEmpty());
+	require(oaClusters->GetSize() == nClusterNumber);
+
+	for (int i = 0; i < nClusterNumber; i++) {
+
+		KMCluster* c = cast(KMCluster*, oaClusters->GetAt(i));
+
+		c->SetModelingCentroidValues(*cast(ContinuousVector*, oaCentroids.GetAt(i)));
+		c->SetFrequency(lvFrequencies.GetAt(i));
+
+		for (int d = 0; d < DISTANCE_TYPE_NUMBER; d++)
+			c->SetDistanceSum((KMParameters::DistanceType)d, cvDistancesSums.GetAt(i * DISTANCE_TYPE_NUMBER + d));
+
+		c->RemoveAll(); // enleve les instances, qui ne correspondent plus aux centroides restitues
+		c->SetStatisticsUpToDate(true);
+	}
+}
+
+void KMClustersSnapshot::Reset()
+{
+	nClusterNumber = 0;
+}
+
+void KMClustersSnapshot::CopyFrom(const KMClustersSnapshot* source)
+{
+	require(source != NULL);
+
+	oaCentroids.DeleteAll();
+	for (int i = 0; i < source->oaCentroids.GetSize(); i++)
+		oaCentroids.Add(cast(ContinuousVector*, source->oaCentroids.GetAt(i))->Clone());
+
+	lvFrequencies.CopyFrom(&source->lvFrequencies);
+	cvDistancesSums.CopyFrom(&source->cvDistancesSums);
+	nClusterNumber = source->nClusterNumber;
+}
+
+longint KMClustersSnapshot::GetUsedMemory() const
+{
+	longint lUsedMemory = sizeof(KMClustersSnapshot) + oaCentroids.GetUsedMemory() - sizeof(ObjectArray) +
+		lvFrequencies.GetUsedMemory() - sizeof(LongintVector) + cvDistancesSums.GetUsedMemory() - sizeof(ContinuousVector);
+
+	for (int i = 0; i < oaCentroids.GetSize(); i++)
+		lUsedMemory += cast(ContinuousVector*, oaCentroids.GetAt(i))->GetUsedMemory();
+
+	return lUsedMemory;
+}
+
+const ALString KMClustersSnapshot::GetClassLabel() const
+{
+	return "Clusters snapshot";
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "Vector.h"
+
+class KMCluster;
+
+////////////////////////////////////////////////////////////////////////////////
+/// Memorisation compacte de l'etat des clusters au cours des iterations (meilleure iteration observee) : centroides de modeling,
+/// frequences et sommes des distances. La memorisation coute O(K.d), et ne fait pas d'allocation memoire une fois les
+/// tampons dimensionnes lors de la premiere memorisation : ceux-ci sont conserves d'une memorisation a l'autre.
+
+class KMClustersSnapshot : public Object
+{
+public:
+
+	KMClustersSnapshot();
+	~KMClustersSnapshot();
+
+	/** memorisation de l'etat d'un tableau de KMCluster */
+	void Save(const ObjectArray* oaClusters);
+
+	/** restitution de l'etat memorise, dans des clusters en meme nombre. Comme lors d'une copie de cluster, les clusters
+	ne contiennent plus d'instances a l'issue de la restitution : seuls les centroides et les stats sont restitues */
+	void Restore(ObjectArray* oaClusters) const;
+
+	/** indique si un etat a ete memorise */
+	boolean IsEmpty() const;
+
+	/** oubli de l'etat memorise (les tampons sont conserves) */
+	void Reset();
+
+	void CopyFrom(const KMClustersSnapshot* source);
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	/** nombre de clusters memorises (0 si aucun etat memorise) */
+	int nClusterNumber;
+
+	/** un ContinuousVector par cluster : valeurs du centroide de modeling */
+	ObjectArray oaCentroids;
+
+	/** frequences des clusters */
+	LongintVector lvFrequencies;
+
+	/** sommes des distances des clusters, pour chaque norme (index = cluster * nombre de normes + norme) */
+	ContinuousVector cvDistancesSums;
+
+	/** nombre de normes pour lesquelles les sommes des distances sont memorisees */
+	static const int DISTANCE_TYPE_NUMBER;
+};
+
+inline boolean KMClustersSnapshot::IsEmpty() const {
+	return nClusterNumber == 0;
+}
@@ -0,0 +1,276 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMDRNearestCentroid.h"
+#include "KMDistanceKernel.h"
+
+KMDRNearestCentroid::KMDRNearestCentroid()
+{
+	SetName("NearestCentroid");
+	SetLabel("Index of the nearest centroid");
+	SetType(KWType::Continuous);
+	SetOperandNumber(3);
+	SetVariableOperandNumber(true);
+	GetOperandAt(0)->SetType(KWType::Symbol);
+	GetOperandAt(0)->SetOrigin(KWDerivationRuleOperand::OriginConstant);
+	GetOperandAt(1)->SetType(KWType::Continuous);
+	GetOperandAt(1)->SetOrigin(KWDerivationRuleOperand::OriginConstant);
+	GetOperandAt(2)->SetType(KWType::Continuous);
+
+	compiledDistanceType = KMParameters::L2Norm;
+	nCompiledAttributeNumber = 0;
+	nCompiledCentroidNumber = 0;
+	cCompiledCentroids = NULL;
+	cInstanceValues = NULL;
+	bPruning = false;
+}
+
+KMDRNearestCentroid::~KMDRNearestCentroid()
+{
+	CleanCompiledValues();
+}
+
+KWDerivationRule* KMDRNearestCentroid::Create() const
+{
+	return new KMDRNearestCentroid;
+}
+
+void KMDRNearestCentroid::Initialize(const KMParameters::DistanceType distanceType, const StringVector& svAttributeNames, const ObjectArray& oaCentroids)
+{
+	require(svAttributeNames.GetSize() > 0);
+	require(oaCentroids.GetSize() > 0);
+
+	KWDerivationRuleOperand* operand;
+
+	DeleteAllOperands();
+
+	operand = new KWDerivationRuleOperand;
+	operand->SetType(KWType::Symbol);
+	operand->SetOrigin(KWDerivationRuleOperand::OriginConstant);
+	operand->SetSymbolConstant(Symbol(GetDistanceLabel(distanceType)));
+	AddOperand(operand);
+
+	operand = new KWDerivationRuleOperand;
+	operand->SetType(KWType::Continuous);
+	operand->SetOrigin(KWDerivationRuleOperand::OriginConstant);
+	operand->SetContinuousConstant(svAttributeNames.GetSize());
+	AddOperand(operand);
+
+	for (int i = 0; i < svAttributeNames.GetSize(); i++) {
+		operand = new KWDerivationRuleOperand;
+		operand->SetType(KWType::Continuous);
+		operand->SetOrigin(KWDerivationRuleOperand::OriginAttribute);
+		operand->SetAttributeName(svAttributeNames.GetAt(i));
+		AddOperand(operand);
+	}
+
+	for (int k = 0; k < oaCentroids.GetSize(); k++) {
+
+		const ContinuousVector* cvCentroid = cast(ContinuousVector*, oaCentroids.GetAt(k));
+		assert(cvCentroid->GetSize() == svAttributeNames.GetSize());
+
+		for (int i = 0; i < cvCentroid->GetSize(); i++) {
+			operand = new KWDerivationRuleOperand;
+			operand->SetType(KWType::Continuous);
+			operand->SetOrigin(KWDerivationRuleOperand::OriginConstant);
+			operand->SetContinuousConstant(cvCentroid->GetAt(i));
+			AddOperand(operand);
+		}
+	}
+}
+
+const ALString KMDRNearestCentroid::GetDistanceLabel() const
+{
+	return GetOperandAt(0)->GetSymbolConstant().GetValue();
+}
+
+const ALString KMDRNearestCentroid::GetAttributeNameAt(const int nAttribute) const
+{
+	require(nAttribute >= 0 and nAttribute < GetAttributeNumber());
+	return GetOperandAt(2 + nAttribute)->GetAttributeName();
+}
+
+Continuous KMDRNearestCentroid::GetCentroidValueAt(const int nCentroid, const int nAttribute) const
+{
+	require(nCentroid >= 0 and nCentroid < GetCentroidNumber());
+	require(nAttribute >= 0 and nAttribute < GetAttributeNumber());
+	return GetOperandAt(GetCentroidFirstOperandIndex(nCentroid) + nAttribute)->GetContinuousConstant();
+}
+
+Continuous KMDRNearestCentroid::ComputeContinuousResult(const KWObject* kwoObject) const
+{
+	require(IsCompiled());
+	require(nCompiledCentroidNumber > 0);
+
+	int nearestCentroidIndex;
+	Continuous minimumDistance;
+	Continuous minimumMetricDistance;
+	Continuous distance;
+
+	// recopie des valeurs K-Means de l'instance
+	for (int i = 0; i < nCompiledAttributeNumber; i++) {
+		cInstanceValues[i] = GetOperandAt(2 + i)->GetContinuousValue(kwoObject);
+		if (cInstanceValues[i] == KWContinuous::GetMissingValue())
+			return KWContinuous::GetMissingValue();
+	}
+
+	nearestCentroidIndex = 0;
+	minimumDistance = KMDistanceKernel::ComputeDistance(cInstanceValues, cCompiledCentroids, nCompiledAttributeNumber, compiledDistanceType);
+	minimumMetricDistance = (compiledDistanceType == KMParameters::L2Norm ? sqrt(minimumDistance) : minimumDistance);
+
+	for (int k = 1; k < nCompiledCentroidNumber; k++) {
+
+		// inegalite triangulaire : si d(c, c') >= 2 d(x, c), alors d(x, c') >= d(x, c), et le centroide c' ne peut pas etre plus proche
+		if (bPruning and tmCentroidsDistances.GetAt(nearestCentroidIndex, k) >= 2 * minimumMetricDistance)
+			continue;
+
+		distance = KMDistanceKernel::ComputeDistance(cInstanceValues, cCompiledCentroids + (longint)k * nCompiledAttributeNumber, nCompiledAttributeNumber, compiledDistanceType);
+
+		if (distance < minimumDistance) {
+			minimumDistance = distance;
+			minimumMetricDistance = (compiledDistanceType == KMParameters::L2Norm ? sqrt(minimumDistance) : minimumDistance);
+			nearestCentroidIndex = k;
+		}
+	}
+
+	// comme pour la regle ArgMin, les index commencent a 1
+	return (Continuous)(nearestCentroidIndex + 1);
+}
+
+boolean KMDRNearestCentroid::CheckOperandsCompleteness(const KWClass* kwcOwnerClass) const
+{
+	boolean bOk;
+	ALString sTmp;
+
+	bOk = KWDerivationRule::CheckOperandsCompleteness(kwcOwnerClass);
+
+	if (bOk) {
+
+		const ALString sDistanceLabel = GetOperandAt(0)->GetSymbolConstant().GetValue();
+		const Continuous cAttributeNumber = GetOperandAt(1)->GetContinuousConstant();
+
+		if (sDistanceLabel != "L1" and sDistanceLabel != "L2" and sDistanceLabel != "CO") {
+			AddError(sTmp + "Invalid distance label (" + sDistanceLabel + "), should be L1, L2 or CO");
+			bOk = false;
+		}
+		else
+			if (cAttributeNumber < 1 or cAttributeNumber != (int)cAttributeNumber) {
+				AddError(sTmp + "Invalid number of attributes in second operand (" + KWContinuous::ContinuousToString(cAttributeNumber) + ")");
+				bOk = false;
+			}
+			else {
+				const int nAttributeNumber = (int)cAttributeNumber;
+				const int nValueNumber = GetOperandNumber() - 2 - nAttributeNumber;
+
+				if (nValueNumber < nAttributeNumber or nValueNumber % nAttributeNumber != 0) {
+					AddError(sTmp + "Number of centroid values (" + IntToString(nValueNumber) + ") should be a non null multiple of the number of attributes (" + IntToString(nAttributeNumber) + ")");
+					bOk = false;
+				}
+
+				// les attributs doivent etre references par des operandes de type attribut, et les centroides par des constantes
+				for (int i = 2; bOk and i < GetOperandNumber(); i++) {
+
+					const boolean bIsAttributeOperand = (i < 2 + nAttributeNumber);
+
+					if (bIsAttributeOperand and GetOperandAt(i)->GetOrigin() == KWDerivationRuleOperand::OriginConstant) {
+						AddError(sTmp + "Operand " + IntToString(i + 1) + " should be an attribute");
+						bOk = false;
+					}
+					else
+						if (not bIsAttributeOperand and GetOperandAt(i)->GetOrigin() != KWDerivationRuleOperand::OriginConstant) {
+							AddError(sTmp + "Operand " + IntToString(i + 1) + " should be a constant centroid value");
+							bOk = false;
+						}
+				}
+			}
+	}
+
+	return bOk;
+}
+
+void KMDRNearestCentroid::Compile(KWClass* kwcOwnerClass)
+{
+	// Appel de la methode ancetre
+	KWDerivationRule::Compile(kwcOwnerClass);
+
+	CleanCompiledValues();
+
+	const ALString sDistanceLabel = GetDistanceLabel();
+
+	if (sDistanceLabel == "L1")
+		compiledDistanceType = KMParameters::L1Norm;
+	else
+		if (sDistanceLabel == "CO")
+			compiledDistanceType = KMParameters::CosineNorm;
+		else
+			compiledDistanceType = KMParameters::L2Norm;
+
+	nCompiledAttributeNumber = GetAttributeNumber();
+	nCompiledCentroidNumber = GetCentroidNumber();
+
+	// table des centroides contigue, construite une seule fois pour toutes les instances a evaluer
+	cCompiledCentroids = new Continuous[(longint)nCompiledCentroidNumber * nCompiledAttributeNumber];
+	cInstanceValues = new Continuous[nCompiledAttributeNumber];
+
+	for (int k = 0; k < nCompiledCentroidNumber; k++) {
+		const int nFirstOperand = GetCentroidFirstOperandIndex(k);
+		for (int i = 0; i < nCompiledAttributeNumber; i++)
+			cCompiledCentroids[(longint)k * nCompiledAttributeNumber + i] = GetOperandAt(nFirstOperand + i)->GetContinuousConstant();
+	}
+
+	// l'elagage par inegalite triangulaire n'est valide que pour des distances metriques (L1, et L2 non elevee au carre)
+	bPruning = (compiledDistanceType != KMParameters::CosineNorm and nCompiledCentroidNumber > 1);
+
+	if (bPruning) {
+
+		tmCentroidsDistances.SetSize(nCompiledCentroidNumber);
+
+		for (int k = 1; k < nCompiledCentroidNumber; k++) {
+			for (int l = 0; l < k; l++) {
+				Continuous distance = KMDistanceKernel::ComputeDistance(cCompiledCentroids + (longint)k * nCompiledAttributeNumber,
+					cCompiledCentroids + (longint)l * nCompiledAttributeNumber, nCompiledAttributeNumber, compiledDistanceType);
+				if (compiledDistanceType == KMParameters::L2Norm)
+					distance = sqrt(distance);
+				tmCentroidsDistances.SetAt(k, l, distance);
+			}
+		}
+	}
+}
+
+longint KMDRNearestCentroid::GetUsedMemory() const
+{
+	longint lUsedMemory = KWDerivationRule::GetUsedMemory();
+
+	lUsedMemory += sizeof(KMDRNearestCentroid) - sizeof(KWDerivationRule);
+	lUsedMemory += ((longint)nCompiledCentroidNumber + 1) * nCompiledAttributeNumber * sizeof(Continuous);
+	lUsedMemory += tmCentroidsDistances.GetUsedMemory() - sizeof(KMTriangularMatrix);
+
+	return lUsedMemory;
+}
+
+const ALString KMDRNearestCentroid::GetDistanceLabel(const KMParameters::DistanceType distanceType)
+{
+	if (distanceType == KMParameters::L1Norm)
+		return "L1";
+	else
+		if (distanceType == KMParameters::CosineNorm)
+			return "CO";
+		else
+			return "L2";
+}
+
+void KMDRNearestCentroid::CleanCompiledValues()
+{
+	if (cCompiledCentroids != NULL)
+		delete[] cCompiledCentroids;
+	if (cInstanceValues != NULL)
+		delete[] cInstanceValues;
+
+	cCompiledCentroids = NULL;
+	cInstanceValues = NULL;
+	nCompiledAttributeNumber = 0;
+	nCompiledCentroidNumber = 0;
+	tmCentroidsDistances.RemoveAll();
+	bPruning = false;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "KWDerivationRule.h"
+#include "KMParameters.h"
+#include "KMTriangularMatrix.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Regle de derivation calculant l'index (a partir de 1) du centroide le plus proche d'une instance, a partir d'une table de centroides constante.
+/// Operandes : libelle de la distance ("L1", "L2" ou "CO"), nombre d'attributs K-Means d, puis les d attributs K-Means,
+/// puis les valeurs des centroides, un centroide apres l'autre (d valeurs par centroide), par exemple :
+///		NearestCentroid("L2", 2, Info1Page, Info2Page, 0.3553613, 0.2474993, 0.8558611, 0.6916485)
+/// A la compilation, les centroides sont recopies dans une matrice contigue : la recherche utilise les noyaux de distance vectorises,
+/// et, pour les distances L1 et L2, un elagage par inegalite triangulaire a partir des distances entre centroides.
+/// Renvoie une valeur manquante si l'une des valeurs K-Means de l'instance est manquante.
+
+class KMDRNearestCentroid : public KWDerivationRule
+{
+public:
+
+	KMDRNearestCentroid();
+	~KMDRNearestCentroid();
+
+	KWDerivationRule* Create() const override;
+
+	/** parametrage de la regle : type de distance, attributs K-Means (noms) et valeurs des centroides (un ContinuousVector de d valeurs par centroide) */
+	void Initialize(const KMParameters::DistanceType distanceType, const StringVector& svAttributeNames, const ObjectArray& oaCentroids);
+
+	/** nombre d'attributs K-Means et de centroides */
+	int GetAttributeNumber() const;
+	int GetCentroidNumber() const;
+
+	/** acces aux operandes constants, pour la relecture d'un dictionnaire de modelisation (regle verifiee) */
+	const ALString GetDistanceLabel() const;
+	const ALString GetAttributeNameAt(const int nAttribute) const;
+	Continuous GetCentroidValueAt(const int nCentroid, const int nAttribute) const;
+
+	Continuous ComputeContinuousResult(const KWObject* kwoObject) const override;
+
+	boolean CheckOperandsCompleteness(const KWClass* kwcOwnerClass) const override;
+
+	void Compile(KWClass* kwcOwnerClass) override;
+
+	longint GetUsedMemory() const override;
+
+	/** libelle de distance, tel qu'utilise dans les dictionnaires de modelisation */
+	static const ALString GetDistanceLabel(const KMParameters::DistanceType distanceType);
+
+protected:
+
+	/** index de l'operande portant la premiere valeur d'un centroide */
+	int GetCentroidFirstOperandIndex(const int nCentroid) const;
+
+	/** liberation des donnees compilees */
+	void CleanCompiledValues();
+
+	// donnees compilees
+	KMParameters::DistanceType compiledDistanceType;
+	int nCompiledAttributeNumber;
+	int nCompiledCentroidNumber;
+
+	/** centroides, un par ligne de nCompiledAttributeNumber valeurs */
+	Continuous* cCompiledCentroids;
+
+	/** buffer des valeurs de l'instance courante */
+	mutable Continuous* cInstanceValues;
+
+	/** distances (non au carre) entre centroides, servant a l'elagage en distances L1 et L2 */
+	KMTriangularMatrix tmCentroidsDistances;
+	boolean bPruning;
+};
+
+inline int KMDRNearestCentroid::GetAttributeNumber() const {
+	return (int)GetOperandAt(1)->GetContinuousConstant();
+}
+
+inline int KMDRNearestCentroid::GetCentroidNumber() const {
+	const int nAttributeNumber = GetAttributeNumber();
+	return (nAttributeNumber == 0 ? 0 : (GetOperandNumber() - 2 - nAttributeNumber) / nAttributeNumber);
+}
+
+inline int KMDRNearestCentroid::GetCentroidFirstOperandIndex(const int nCentroid) const {
+	return 2 + GetAttributeNumber() * (nCentroid + 1);
+}
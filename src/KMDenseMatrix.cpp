@@ -0,0 +1,217 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMDenseMatrix.h"
+#include "KMCluster.h"
+
+KMDenseMatrix::KMDenseMatrix()
+{
+	pAllocatedBlock = NULL;
+	cValues = NULL;
+	nRowNumber = 0;
+	nColumnNumber = 0;
+	nRowStride = 0;
+}
+
+KMDenseMatrix::~KMDenseMatrix()
+{
+	CleanValues();
+}
+
+void KMDenseMatrix::CleanValues()
+{
+	if (pAllocatedBlock != NULL)
+		delete[] pAllocatedBlock;
+
+	pAllocatedBlock = NULL;
+	cValues = NULL;
+	nRowNumber = 0;
+	nColumnNumber = 0;
+	nRowStride = 0;
+}
+
+int KMDenseMatrix::ComputeRowStride(const int nColumns)
+{
+	const int nValuesByAlignment = ALIGNMENT / sizeof(Continuous);
+
+	// arrondir au multiple superieur, afin que chaque ligne debute sur une frontiere d'alignement
+	return ((nColumns + nValuesByAlignment - 1) / nValuesByAlignment) * nValuesByAlignment;
+}
+
+boolean KMDenseMatrix::SetDimensions(const int nRows, const int nColumns)
+{
+	require(nRows >= 0);
+	require(nColumns >= 0);
+
+	const int nNewRowStride = ComputeRowStride(nColumns);
+
+	// reutiliser le bloc existant s'il est de taille identique
+	if (pAllocatedBlock == NULL or (longint)nRows * nNewRowStride != (longint)nRowNumber * nRowStride) {
+
+		CleanValues();
+
+		const longint lRequiredMemory = ComputeRequiredMemory(nRows, nColumns);
+
+		if (lRequiredMemory > RMResourceManager::GetRemainingAvailableMemory())
+			return false;
+
+		// on alloue ALIGNMENT octets de plus que necessaire, afin de pouvoir aligner le debut des valeurs
+		pAllocatedBlock = new char[lRequiredMemory];
+		const size_t offset = ((size_t)pAllocatedBlock) % ALIGNMENT;
+		cValues = (Continuous*)(pAllocatedBlock + (offset == 0 ? 0 : ALIGNMENT - offset));
+	}
+
+	nRowNumber = nRows;
+	nColumnNumber = nColumns;
+	nRowStride = nNewRowStride;
+
+	// initialisation a 0 de toutes les valeurs, y compris celles de bourrage en fin de ligne
+	for (longint i = 0; i < (longint)nRowNumber * nRowStride; i++)
+		cValues[i] = 0;
+
+	return true;
+}
+
+boolean KMDenseMatrix::InitializeFromInstances(const ObjectArray* instances, const KWLoadIndexVector& kmeanAttributesLoadIndexes, const boolean bWithValues)
+{
+	require(instances != NULL);
+
+	Continuous* cRowValues;
+	int nColumn;
+
+	// colonnes : uniquement les attributs K-Means valides, dans l'ordre de leurs rangs
+	ivAttributeRanks.SetSize(0);
+	for (int i = 0; i < kmeanAttributesLoadIndexes.GetSize(); i++) {
+		if (kmeanAttributesLoadIndexes.GetAt(i).IsValid())
+			ivAttributeRanks.Add(i);
+	}
+
+	oaInstances.SetSize(0);
+	ivMissingValueRows.SetSize(0);
+
+	if (bWithValues) {
+		if (not SetDimensions(instances->GetSize(), ivAttributeRanks.GetSize()))
+			return false;
+	}
+	else {
+		// lignes et colonnes seulement
+		CleanValues();
+		nRowNumber = instances->GetSize();
+		nColumnNumber = ivAttributeRanks.GetSize();
+		nRowStride = ComputeRowStride(nColumnNumber);
+	}
+
+	oaInstances.CopyFrom(instances);
+	ivMissingValueRows.SetSize(nRowNumber);
+
+	for (int nRow = 0; nRow < nRowNumber; nRow++) {
+
+		// matrice partiellement remplie : elle ne doit pas etre utilisee
+		if (nRow % 100000 == 0 and TaskProgression::IsInterruptionRequested()) {
+			CleanValues();
+			oaInstances.SetSize(0);
+			ivMissingValueRows.SetSize(0);
+			return false;
+		}
+
+		const KWObject* instance = cast(KWObject*, instances->GetAt(nRow));
+		cRowValues = (bWithValues ? GetRowAt(nRow) : NULL);
+
+		for (nColumn = 0; nColumn < nColumnNumber; nColumn++) {
+
+			const Continuous c = instance->GetContinuousValueAt(kmeanAttributesLoadIndexes.GetAt(ivAttributeRanks.GetAt(nColumn)));
+
+			if (c == KWContinuous::GetMissingValue())
+				ivMissingValueRows.SetAt(nRow, 1);
+
+			if (bWithValues)
+				cRowValues[nColumn] = c;
+		}
+	}
+
+	return true;
+}
+
+boolean KMDenseMatrix::InitializeFromCentroids(const ObjectArray* clusters, const KMDenseMatrix* instancesMatrix)
+{
+	require(clusters != NULL);
+	require(instancesMatrix != NULL);
+
+	Continuous* cRowValues;
+
+	ivAttributeRanks.CopyFrom(&instancesMatrix->ivAttributeRanks);
+	if (not SetDimensions(clusters->GetSize(), ivAttributeRanks.GetSize()))
+		return false;
+
+	for (int nRow = 0; nRow < nRowNumber; nRow++) {
+
+		const KMCluster* cluster = cast(KMCluster*, clusters->GetAt(nRow));
+		const ContinuousVector& cvCentroidValues = cluster->GetModelingCentroidValues();
+
+		// cas d'un cluster dont le centroide n'a pas encore ete calcule : on laisse les valeurs a 0
+		if (cvCentroidValues.GetSize() == 0)
+			continue;
+
+		cRowValues = GetRowAt(nRow);
+
+		for (int nColumn = 0; nColumn < nColumnNumber; nColumn++)
+			cRowValues[nColumn] = cvCentroidValues.GetAt(ivAttributeRanks.GetAt(nColumn));
+	}
+
+	return true;
+}
+
+boolean KMDenseMatrix::CopyFrom(const KMDenseMatrix* aSource)
+{
+	require(aSource != NULL);
+
+	if (not SetDimensions(aSource->nRowNumber, aSource->nColumnNumber))
+		return false;
+
+	for (longint i = 0; i < (longint)nRowNumber * nRowStride; i++)
+		cValues[i] = aSource->cValues[i];
+
+	ivAttributeRanks.CopyFrom(&aSource->ivAttributeRanks);
+	oaInstances.CopyFrom(&aSource->oaInstances);
+	ivMissingValueRows.CopyFrom(&aSource->ivMissingValueRows);
+
+	return true;
+}
+
+longint KMDenseMatrix::ComputeRequiredMemory(const longint lRowNumber, const int nColumnNumber)
+{
+	return lRowNumber * ComputeRowStride(nColumnNumber) * sizeof(Continuous) + ALIGNMENT;
+}
+
+int KMDenseMatrix::ComputeColumnNumber(const KWLoadIndexVector& kmeanAttributesLoadIndexes)
+{
+	int nColumns = 0;
+
+	for (int i = 0; i < kmeanAttributesLoadIndexes.GetSize(); i++) {
+		if (kmeanAttributesLoadIndexes.GetAt(i).IsValid())
+			nColumns++;
+	}
+	return nColumns;
+}
+
+longint KMDenseMatrix::GetUsedMemory() const
+{
+	longint lUsedMemory = sizeof(KMDenseMatrix);
+
+	if (pAllocatedBlock != NULL)
+		lUsedMemory += ComputeRequiredMemory(nRowNumber, nColumnNumber);
+
+	lUsedMemory += ivAttributeRanks.GetUsedMemory() - sizeof(IntVector);
+	lUsedMemory += oaInstances.GetUsedMemory() - sizeof(ObjectArray);
+	lUsedMemory += ivMissingValueRows.GetUsedMemory() - sizeof(IntVector);
+
+	return lUsedMemory;
+}
+
+const ALString KMDenseMatrix::GetClassLabel() const
+{
+	return "Dense matrix";
+}
+
+const int KMDenseMatrix::ALIGNMENT = 64;
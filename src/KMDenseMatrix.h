@@ -0,0 +1,143 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "Vector.h"
+#include "KWObject.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Matrice dense de valeurs Continuous, stockees ligne par ligne dans un unique bloc memoire contigu, dont chaque ligne debute sur une frontiere de 64 octets.
+/// Sert a representer de facon compacte les valeurs des attributs K-Means des instances de la base (une ligne par instance, une colonne par attribut K-Means),
+/// ou bien les centroides des clusters, afin d'eviter les acces indirects aux KWObject lors des calculs de distances.
+
+class KMDenseMatrix : public Object
+{
+public:
+
+	KMDenseMatrix();
+	~KMDenseMatrix();
+
+	/** (re)dimensionnement de la matrice, les valeurs etant remises a 0. Retourne false si la memoire disponible est insuffisante */
+	boolean SetDimensions(const int nRows, const int nColumns);
+
+	/** nombre de lignes */
+	int GetRowNumber() const;
+
+	/** nombre de colonnes utiles */
+	int GetColumnNumber() const;
+
+	/** ecart, en nombre de valeurs, entre les debuts de 2 lignes consecutives (nombre de colonnes arrondi au multiple de 64 octets superieur) */
+	int GetRowStride() const;
+
+	/** acces aux valeurs d'une ligne */
+	Continuous* GetRowAt(const int nRow);
+	const Continuous* GetRowAt(const int nRow) const;
+
+	/** rang, dans les centroides des clusters, de l'attribut K-Means correspondant a une colonne */
+	int GetAttributeRankAt(const int nColumn) const;
+
+	/** remplissage a partir des valeurs des attributs K-Means d'une liste d'instances de BDD : une ligne par instance, dans l'ordre de la liste.
+	Si bWithValues est a false, seules les lignes (instances, valeurs manquantes) et les colonnes sont renseignees, sans allouer les valeurs :
+	celles-ci sont alors portees par une matrice creuse (cf. KMSparseMatrix::InitializeFromInstances).
+	Retourne false si la memoire disponible est insuffisante, ou si l'utilisateur a demande une interruption (la matrice est alors videe) */
+	boolean InitializeFromInstances(const ObjectArray* instances, const KWLoadIndexVector& kmeanAttributesLoadIndexes, const boolean bWithValues = true);
+
+	/** indique si les valeurs de la matrice sont allouees (i.e, si GetRowAt est utilisable) */
+	boolean HasValues() const;
+
+	/** remplissage a partir des centroides de modelisation d'une liste de clusters (une ligne par cluster), selon les memes colonnes qu'une matrice d'instances deja remplie.
+	Retourne false si la memoire disponible est insuffisante */
+	boolean InitializeFromCentroids(const ObjectArray* clusters, const KMDenseMatrix* instancesMatrix);
+
+	/** copie des valeurs et des dimensions d'une autre matrice. Retourne false si la memoire disponible est insuffisante */
+	boolean CopyFrom(const KMDenseMatrix* aSource);
+
+	/** instance de BDD correspondant a une ligne (matrice remplie a partir d'instances) */
+	KWObject* GetInstanceAt(const int nRow) const;
+
+	/** indique si l'instance correspondant a une ligne a au moins une valeur K-Means manquante */
+	boolean IsMissingValueRow(const int nRow) const;
+
+	/** memoire necessaire au stockage d'une matrice d'instances */
+	static longint ComputeRequiredMemory(const longint lRowNumber, const int nColumnNumber);
+
+	/** nombre d'attributs K-Means valides, c'est a dire nombre de colonnes d'une matrice d'instances */
+	static int ComputeColumnNumber(const KWLoadIndexVector& kmeanAttributesLoadIndexes);
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+	/** alignement memoire de chaque ligne, en octets */
+	static const int ALIGNMENT;
+
+protected:
+
+	/** liberation de la memoire allouee */
+	void CleanValues();
+
+	/** calcul de l'ecart entre 2 lignes, pour un nombre de colonnes donne */
+	static int ComputeRowStride(const int nColumns);
+
+	/** bloc memoire alloue (non aligne) */
+	char* pAllocatedBlock;
+
+	/** debut des valeurs, aligne sur ALIGNMENT octets, a l'interieur du bloc alloue */
+	Continuous* cValues;
+
+	int nRowNumber;
+	int nColumnNumber;
+	int nRowStride;
+
+	/** pour chaque colonne, rang de l'attribut K-Means correspondant dans les centroides */
+	IntVector ivAttributeRanks;
+
+	/** pour chaque ligne, instance de BDD correspondante (KWObject *, non possedes) */
+	ObjectArray oaInstances;
+
+	/** pour chaque ligne, 1 si l'instance a au moins une valeur K-Means manquante, 0 sinon */
+	IntVector ivMissingValueRows;
+};
+
+inline int KMDenseMatrix::GetRowNumber() const {
+	return nRowNumber;
+}
+
+inline int KMDenseMatrix::GetColumnNumber() const {
+	return nColumnNumber;
+}
+
+inline int KMDenseMatrix::GetRowStride() const {
+	return nRowStride;
+}
+
+inline Continuous* KMDenseMatrix::GetRowAt(const int nRow) {
+	assert(nRow >= 0 and nRow < nRowNumber);
+	assert(cValues != NULL);
+	return cValues + (longint)nRow * nRowStride;
+}
+
+inline const Continuous* KMDenseMatrix::GetRowAt(const int nRow) const {
+	assert(nRow >= 0 and nRow < nRowNumber);
+	assert(cValues != NULL);
+	return cValues + (longint)nRow * nRowStride;
+}
+
+inline boolean KMDenseMatrix::HasValues() const {
+	return cValues != NULL;
+}
+
+inline int KMDenseMatrix::GetAttributeRankAt(const int nColumn) const {
+	return ivAttributeRanks.GetAt(nColumn);
+}
+
+inline KWObject* KMDenseMatrix::GetInstanceAt(const int nRow) const {
+	return cast(KWObject*, oaInstances.GetAt(nRow));
+}
+
+inline boolean KMDenseMatrix::IsMissingValueRow(const int nRow) const {
+	return ivMissingValueRows.GetAt(nRow) != 0;
+}
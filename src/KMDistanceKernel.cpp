@@ -0,0 +1,640 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMDistanceKernel.h"
+
+#include <cmath>
+
+// les implementations vectorisees ne sont compilees que sur les architectures x86 64 bits
+#if defined(__x86_64__) || defined(_M_X64)
+#define KM_DISTANCE_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// sous GCC et Clang, chaque fonction vectorisee est compilee pour son propre jeu d'instructions, independamment des options de compilation globales
+#if defined(KM_DISTANCE_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define KM_TARGET_AVX2 __attribute__((target("avx2")))
+#define KM_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define KM_TARGET_AVX2
+#define KM_TARGET_AVX512
+#endif
+
+// les fonctions de calcul sur AVX-512 necessitent un compilateur suffisamment recent
+#if defined(KM_DISTANCE_KERNEL_X86) && (defined(_MSC_VER) || (defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 7) || (defined(__clang__) && __clang_major__ >= 5))
+#define KM_DISTANCE_KERNEL_AVX512
+#endif
+
+typedef Continuous(*KMDistanceFunction)(const Continuous*, const Continuous*, const int);
+typedef void (*KMCosineTermsFunction)(const Continuous*, const Continuous*, const int, Continuous&, Continuous&, Continuous&);
+
+/** table des noyaux retenus pour le processeur courant */
+struct KMDistanceKernelTable
+{
+	KMDistanceKernel::InstructionSet instructionSet;
+	KMDistanceFunction l1;
+	KMDistanceFunction squaredL2;
+	KMCosineTermsFunction cosineTerms;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// implementations scalaires
+
+static Continuous ComputeL1Scalar(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	Continuous cResult = 0;
+
+	for (int i = 0; i < nSize; i++)
+		cResult += fabs(v1[i] - v2[i]);
+
+	return cResult;
+}
+
+static Continuous ComputeSquaredL2Scalar(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	Continuous cResult = 0;
+
+	for (int i = 0; i < nSize; i++) {
+		const Continuous cDelta = v1[i] - v2[i];
+		cResult += cDelta * cDelta;
+	}
+
+	return cResult;
+}
+
+static void ComputeCosineTermsScalar(const Continuous* v1, const Continuous* v2, const int nSize,
+	Continuous& cDotProduct, Continuous& cSquaredNorm1, Continuous& cSquaredNorm2)
+{
+	cDotProduct = 0;
+	cSquaredNorm1 = 0;
+	cSquaredNorm2 = 0;
+
+	for (int i = 0; i < nSize; i++) {
+		cDotProduct += v1[i] * v2[i];
+		cSquaredNorm1 += v1[i] * v1[i];
+		cSquaredNorm2 += v2[i] * v2[i];
+	}
+}
+
+#ifdef KM_DISTANCE_KERNEL_X86
+
+////////////////////////////////////////////////////////////////////////////////
+// implementations SSE2 (toujours disponible en x86 64 bits)
+
+static inline Continuous HorizontalSumSSE2(const __m128d v)
+{
+	return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static Continuous ComputeL1SSE2(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	const __m128d signMask = _mm_set1_pd(-0.0);
+	__m128d sum = _mm_setzero_pd();
+	int i = 0;
+
+	for (; i + 2 <= nSize; i += 2)
+		sum = _mm_add_pd(sum, _mm_andnot_pd(signMask, _mm_sub_pd(_mm_loadu_pd(v1 + i), _mm_loadu_pd(v2 + i))));
+
+	Continuous cResult = HorizontalSumSSE2(sum);
+
+	for (; i < nSize; i++)
+		cResult += fabs(v1[i] - v2[i]);
+
+	return cResult;
+}
+
+static Continuous ComputeSquaredL2SSE2(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	__m128d sum = _mm_setzero_pd();
+	int i = 0;
+
+	for (; i + 2 <= nSize; i += 2) {
+		const __m128d delta = _mm_sub_pd(_mm_loadu_pd(v1 + i), _mm_loadu_pd(v2 + i));
+		sum = _mm_add_pd(sum, _mm_mul_pd(delta, delta));
+	}
+
+	Continuous cResult = HorizontalSumSSE2(sum);
+
+	for (; i < nSize; i++) {
+		const Continuous cDelta = v1[i] - v2[i];
+		cResult += cDelta * cDelta;
+	}
+
+	return cResult;
+}
+
+static void ComputeCosineTermsSSE2(const Continuous* v1, const Continuous* v2, const int nSize,
+	Continuous& cDotProduct, Continuous& cSquaredNorm1, Continuous& cSquaredNorm2)
+{
+	__m128d dot = _mm_setzero_pd();
+	__m128d norm1 = _mm_setzero_pd();
+	__m128d norm2 = _mm_setzero_pd();
+	int i = 0;
+
+	for (; i + 2 <= nSize; i += 2) {
+		const __m128d a = _mm_loadu_pd(v1 + i);
+		const __m128d b = _mm_loadu_pd(v2 + i);
+		dot = _mm_add_pd(dot, _mm_mul_pd(a, b));
+		norm1 = _mm_add_pd(norm1, _mm_mul_pd(a, a));
+		norm2 = _mm_add_pd(norm2, _mm_mul_pd(b, b));
+	}
+
+	cDotProduct = HorizontalSumSSE2(dot);
+	cSquaredNorm1 = HorizontalSumSSE2(norm1);
+	cSquaredNorm2 = HorizontalSumSSE2(norm2);
+
+	for (; i < nSize; i++) {
+		cDotProduct += v1[i] * v2[i];
+		cSquaredNorm1 += v1[i] * v1[i];
+		cSquaredNorm2 += v2[i] * v2[i];
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// implementations AVX2
+
+KM_TARGET_AVX2 static inline Continuous HorizontalSumAVX2(const __m256d v)
+{
+	return HorizontalSumSSE2(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+KM_TARGET_AVX2 static Continuous ComputeL1AVX2(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	const __m256d signMask = _mm256_set1_pd(-0.0);
+	__m256d sum = _mm256_setzero_pd();
+	int i = 0;
+
+	for (; i + 4 <= nSize; i += 4)
+		sum = _mm256_add_pd(sum, _mm256_andnot_pd(signMask, _mm256_sub_pd(_mm256_loadu_pd(v1 + i), _mm256_loadu_pd(v2 + i))));
+
+	Continuous cResult = HorizontalSumAVX2(sum);
+
+	for (; i < nSize; i++)
+		cResult += fabs(v1[i] - v2[i]);
+
+	return cResult;
+}
+
+KM_TARGET_AVX2 static Continuous ComputeSquaredL2AVX2(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	__m256d sum = _mm256_setzero_pd();
+	int i = 0;
+
+	for (; i + 4 <= nSize; i += 4) {
+		const __m256d delta = _mm256_sub_pd(_mm256_loadu_pd(v1 + i), _mm256_loadu_pd(v2 + i));
+		sum = _mm256_add_pd(sum, _mm256_mul_pd(delta, delta));
+	}
+
+	Continuous cResult = HorizontalSumAVX2(sum);
+
+	for (; i < nSize; i++) {
+		const Continuous cDelta = v1[i] - v2[i];
+		cResult += cDelta * cDelta;
+	}
+
+	return cResult;
+}
+
+KM_TARGET_AVX2 static void ComputeCosineTermsAVX2(const Continuous* v1, const Continuous* v2, const int nSize,
+	Continuous& cDotProduct, Continuous& cSquaredNorm1, Continuous& cSquaredNorm2)
+{
+	__m256d dot = _mm256_setzero_pd();
+	__m256d norm1 = _mm256_setzero_pd();
+	__m256d norm2 = _mm256_setzero_pd();
+	int i = 0;
+
+	for (; i + 4 <= nSize; i += 4) {
+		const __m256d a = _mm256_loadu_pd(v1 + i);
+		const __m256d b = _mm256_loadu_pd(v2 + i);
+		dot = _mm256_add_pd(dot, _mm256_mul_pd(a, b));
+		norm1 = _mm256_add_pd(norm1, _mm256_mul_pd(a, a));
+		norm2 = _mm256_add_pd(norm2, _mm256_mul_pd(b, b));
+	}
+
+	cDotProduct = HorizontalSumAVX2(dot);
+	cSquaredNorm1 = HorizontalSumAVX2(norm1);
+	cSquaredNorm2 = HorizontalSumAVX2(norm2);
+
+	for (; i < nSize; i++) {
+		cDotProduct += v1[i] * v2[i];
+		cSquaredNorm1 += v1[i] * v1[i];
+		cSquaredNorm2 += v2[i] * v2[i];
+	}
+}
+
+#ifdef KM_DISTANCE_KERNEL_AVX512
+
+////////////////////////////////////////////////////////////////////////////////
+// implementations AVX-512
+
+KM_TARGET_AVX512 static inline Continuous HorizontalSumAVX512(const __m512d v)
+{
+	return _mm512_reduce_add_pd(v);
+}
+
+KM_TARGET_AVX512 static Continuous ComputeL1AVX512(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	__m512d sum = _mm512_setzero_pd();
+	int i = 0;
+
+	for (; i + 8 <= nSize; i += 8)
+		sum = _mm512_add_pd(sum, _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(v1 + i), _mm512_loadu_pd(v2 + i))));
+
+	Continuous cResult = HorizontalSumAVX512(sum);
+
+	for (; i < nSize; i++)
+		cResult += fabs(v1[i] - v2[i]);
+
+	return cResult;
+}
+
+KM_TARGET_AVX512 static Continuous ComputeSquaredL2AVX512(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	__m512d sum = _mm512_setzero_pd();
+	int i = 0;
+
+	for (; i + 8 <= nSize; i += 8) {
+		const __m512d delta = _mm512_sub_pd(_mm512_loadu_pd(v1 + i), _mm512_loadu_pd(v2 + i));
+		sum = _mm512_add_pd(sum, _mm512_mul_pd(delta, delta));
+	}
+
+	Continuous cResult = HorizontalSumAVX512(sum);
+
+	for (; i < nSize; i++) {
+		const Continuous cDelta = v1[i] - v2[i];
+		cResult += cDelta * cDelta;
+	}
+
+	return cResult;
+}
+
+KM_TARGET_AVX512 static void ComputeCosineTermsAVX512(const Continuous* v1, const Continuous* v2, const int nSize,
+	Continuous& cDotProduct, Continuous& cSquaredNorm1, Continuous& cSquaredNorm2)
+{
+	__m512d dot = _mm512_setzero_pd();
+	__m512d norm1 = _mm512_setzero_pd();
+	__m512d norm2 = _mm512_setzero_pd();
+	int i = 0;
+
+	for (; i + 8 <= nSize; i += 8) {
+		const __m512d a = _mm512_loadu_pd(v1 + i);
+		const __m512d b = _mm512_loadu_pd(v2 + i);
+		dot = _mm512_add_pd(dot, _mm512_mul_pd(a, b));
+		norm1 = _mm512_add_pd(norm1, _mm512_mul_pd(a, a));
+		norm2 = _mm512_add_pd(norm2, _mm512_mul_pd(b, b));
+	}
+
+	cDotProduct = HorizontalSumAVX512(dot);
+	cSquaredNorm1 = HorizontalSumAVX512(norm1);
+	cSquaredNorm2 = HorizontalSumAVX512(norm2);
+
+	for (; i < nSize; i++) {
+		cDotProduct += v1[i] * v2[i];
+		cSquaredNorm1 += v1[i] * v1[i];
+		cSquaredNorm2 += v2[i] * v2[i];
+	}
+}
+
+#endif // KM_DISTANCE_KERNEL_AVX512
+
+////////////////////////////////////////////////////////////////////////////////
+// detection du jeu d'instructions supporte par le processeur et par le systeme
+
+static boolean IsAVX2Supported()
+{
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// AVX et OSXSAVE, puis sauvegarde des registres YMM par le systeme
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 or (info[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+static boolean IsAVX512Supported()
+{
+#ifndef KM_DISTANCE_KERNEL_AVX512
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+
+	if (not IsAVX2Supported())
+		return false;
+
+	// sauvegarde des registres ZMM et des masques par le systeme
+	if ((_xgetbv(0) & 0xe6) != 0xe6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 16)) != 0;
+#else
+	return __builtin_cpu_supports("avx512f") != 0;
+#endif
+}
+
+#endif // KM_DISTANCE_KERNEL_X86
+
+static KMDistanceKernelTable BuildKernelTable()
+{
+	KMDistanceKernelTable table;
+
+	table.instructionSet = KMDistanceKernel::Scalar;
+	table.l1 = ComputeL1Scalar;
+	table.squaredL2 = ComputeSquaredL2Scalar;
+	table.cosineTerms = ComputeCosineTermsScalar;
+
+#ifdef KM_DISTANCE_KERNEL_X86
+	table.instructionSet = KMDistanceKernel::SSE2;
+	table.l1 = ComputeL1SSE2;
+	table.squaredL2 = ComputeSquaredL2SSE2;
+	table.cosineTerms = ComputeCosineTermsSSE2;
+
+	if (IsAVX2Supported()) {
+		table.instructionSet = KMDistanceKernel::AVX2;
+		table.l1 = ComputeL1AVX2;
+		table.squaredL2 = ComputeSquaredL2AVX2;
+		table.cosineTerms = ComputeCosineTermsAVX2;
+	}
+#ifdef KM_DISTANCE_KERNEL_AVX512
+	if (IsAVX512Supported()) {
+		table.instructionSet = KMDistanceKernel::AVX512;
+		table.l1 = ComputeL1AVX512;
+		table.squaredL2 = ComputeSquaredL2AVX512;
+		table.cosineTerms = ComputeCosineTermsAVX512;
+	}
+#endif
+#endif
+
+	return table;
+}
+
+static const KMDistanceKernelTable& GetKernelTable()
+{
+	// initialisation unique et thread-safe (C++11), au premier appel
+	static const KMDistanceKernelTable table = BuildKernelTable();
+	return table;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Classe KMDistanceKernel
+
+Continuous KMDistanceKernel::ComputeL1(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	require(v1 != NULL and v2 != NULL);
+	require(nSize >= 0);
+
+	return GetKernelTable().l1(v1, v2, nSize);
+}
+
+Continuous KMDistanceKernel::ComputeSquaredL2(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	require(v1 != NULL and v2 != NULL);
+	require(nSize >= 0);
+
+	return GetKernelTable().squaredL2(v1, v2, nSize);
+}
+
+void KMDistanceKernel::ComputeCosineTerms(const Continuous* v1, const Continuous* v2, const int nSize,
+	Continuous& cDotProduct, Continuous& cSquaredNorm1, Continuous& cSquaredNorm2)
+{
+	require(v1 != NULL and v2 != NULL);
+	require(nSize >= 0);
+
+	GetKernelTable().cosineTerms(v1, v2, nSize, cDotProduct, cSquaredNorm1, cSquaredNorm2);
+}
+
+Continuous KMDistanceKernel::ComputeCosine(const Continuous* v1, const Continuous* v2, const int nSize)
+{
+	Continuous cDotProduct;
+	Continuous cSquaredNorm1;
+	Continuous cSquaredNorm2;
+
+	ComputeCosineTerms(v1, v2, nSize, cDotProduct, cSquaredNorm1, cSquaredNorm2);
+
+	// meme convention que le calcul sur les KWObject : cosinus nul si l'une des normes est nulle
+	const Continuous cDenominator = sqrt(cSquaredNorm1) * sqrt(cSquaredNorm2);
+
+	return 1 - (cDenominator == 0 ? 0 : cDotProduct / cDenominator);
+}
+
+Continuous KMDistanceKernel::ComputeDistance(const Continuous* v1, const Continuous* v2, const int nSize, const KMParameters::DistanceType distanceType)
+{
+	if (distanceType == KMParameters::L2Norm)
+		return ComputeSquaredL2(v1, v2, nSize);
+	else if (distanceType == KMParameters::L1Norm)
+		return ComputeL1(v1, v2, nSize);
+	else
+		return ComputeCosine(v1, v2, nSize);
+}
+
+Continuous KMDistanceKernel::ComputeSparseL1(const int* nColumns, const Continuous* cValues, const int nNonZeroNumber, const Continuous* v2, const Continuous cL1Norm2)
+{
+	Continuous cResult = cL1Norm2;
+
+	// seules les colonnes non nulles du vecteur creux modifient la contribution |v2[j]| de la norme L1 du vecteur dense
+	for (int i = 0; i < nNonZeroNumber; i++) {
+		const Continuous c = v2[nColumns[i]];
+		cResult += fabs(cValues[i] - c) - fabs(c);
+	}
+	return (cResult < 0 ? 0 : cResult);
+}
+
+Continuous KMDistanceKernel::ComputeSparseSquaredL2(const int* nColumns, const Continuous* cValues, const int nNonZeroNumber, const Continuous* v2,
+	const Continuous cSquaredNorm2)
+{
+	Continuous cDifferences = 0;
+	Continuous cNonZeroSquaredNorm2 = 0;
+
+	// ecarts exacts sur les colonnes non nulles du vecteur creux, et contribution de ces colonnes a la norme du vecteur dense
+	for (int i = 0; i < nNonZeroNumber; i++) {
+		const Continuous c = v2[nColumns[i]];
+		const Continuous d = cValues[i] - c;
+		cDifferences += d * d;
+		cNonZeroSquaredNorm2 += c * c;
+	}
+
+	// les autres colonnes contribuent par les seules valeurs du vecteur dense : pas de compensation entre les normes des deux vecteurs,
+	// et le reste, qui ne peut etre negatif qu'a cause des erreurs d'arrondi, est ramene a 0
+	const Continuous cRemainder = cSquaredNorm2 - cNonZeroSquaredNorm2;
+
+	return cDifferences + (cRemainder < 0 ? 0 : cRemainder);
+}
+
+Continuous KMDistanceKernel::ComputeSparseCosine(const int* nColumns, const Continuous* cValues, const int nNonZeroNumber, const Continuous cSquaredNorm1,
+	const Continuous* v2, const Continuous cSquaredNorm2)
+{
+	Continuous cDotProduct = 0;
+
+	for (int i = 0; i < nNonZeroNumber; i++)
+		cDotProduct += cValues[i] * v2[nColumns[i]];
+
+	// meme convention que le calcul sur les vecteurs denses : cosinus nul si l'une des normes est nulle
+	const Continuous cDenominator = sqrt(cSquaredNorm1) * sqrt(cSquaredNorm2);
+
+	return 1 - (cDenominator == 0 ? 0 : cDotProduct / cDenominator);
+}
+
+Continuous KMDistanceKernel::ComputeSparseDistance(const int* nColumns, const Continuous* cValues, const int nNonZeroNumber, const Continuous cSquaredNorm1,
+	const Continuous* v2, const Continuous cL1Norm2, const Continuous cSquaredNorm2, const KMParameters::DistanceType distanceType)
+{
+	if (distanceType == KMParameters::L2Norm)
+		return ComputeSparseSquaredL2(nColumns, cValues, nNonZeroNumber, v2, cSquaredNorm2);
+	else if (distanceType == KMParameters::L1Norm)
+		return ComputeSparseL1(nColumns, cValues, nNonZeroNumber, v2, cL1Norm2);
+	else
+		return ComputeSparseCosine(nColumns, cValues, nNonZeroNumber, cSquaredNorm1, v2, cSquaredNorm2);
+}
+
+void KMDistanceKernel::ComputeDistancesToRows(const Continuous* instanceValues, const KMDenseMatrix* centroids,
+	const KMParameters::DistanceType distanceType, Continuous* cDistances)
+{
+	require(instanceValues != NULL);
+	require(centroids != NULL);
+	require(cDistances != NULL);
+
+	const KMDistanceKernelTable& table = GetKernelTable();
+	const int nSize = centroids->GetRowStride();
+	const int nRowNumber = centroids->GetRowNumber();
+	int nRow;
+
+	// on resout le noyau une seule fois pour l'ensemble des lignes
+	if (distanceType == KMParameters::L2Norm) {
+		for (nRow = 0; nRow < nRowNumber; nRow++)
+			cDistances[nRow] = table.squaredL2(instanceValues, centroids->GetRowAt(nRow), nSize);
+	}
+	else if (distanceType == KMParameters::L1Norm) {
+		for (nRow = 0; nRow < nRowNumber; nRow++)
+			cDistances[nRow] = table.l1(instanceValues, centroids->GetRowAt(nRow), nSize);
+	}
+	else {
+		Continuous cDotProduct;
+		Continuous cSquaredNorm1;
+		Continuous cSquaredNorm2;
+
+		for (nRow = 0; nRow < nRowNumber; nRow++) {
+			table.cosineTerms(instanceValues, centroids->GetRowAt(nRow), nSize, cDotProduct, cSquaredNorm1, cSquaredNorm2);
+			const Continuous cDenominator = sqrt(cSquaredNorm1) * sqrt(cSquaredNorm2);
+			cDistances[nRow] = 1 - (cDenominator == 0 ? 0 : cDotProduct / cDenominator);
+		}
+	}
+}
+
+// defini avant son utilisation comme taille de tableaux
+const int KMDistanceKernel::GATHER_BLOCK_SIZE = 256;
+
+template <class ValueGetter>
+Continuous KMDistanceKernel::ComputeGatheredDistance(const ValueGetter& getValue, const ContinuousVector& cvCentroid, const KWLoadIndexVector& kmeanAttributesLoadIndexes,
+	const KMParameters::DistanceType distanceType)
+{
+	const KMDistanceKernelTable& table = GetKernelTable();
+	alignas(64) Continuous cBlockValues[GATHER_BLOCK_SIZE];
+	alignas(64) Continuous cBlockCentroid[GATHER_BLOCK_SIZE];
+	Continuous cResult = 0;
+	Continuous cDotProduct = 0;
+	Continuous cSquaredNorm1 = 0;
+	Continuous cSquaredNorm2 = 0;
+	int nBlockSize = 0;
+
+	for (int i = 0; i <= kmeanAttributesLoadIndexes.GetSize(); i++) {
+
+		// rassemblement des valeurs des attributs valides
+		if (i < kmeanAttributesLoadIndexes.GetSize()) {
+			if (not kmeanAttributesLoadIndexes.GetAt(i).IsValid())
+				continue;
+			cBlockValues[nBlockSize] = getValue(i);
+			cBlockCentroid[nBlockSize] = cvCentroid.GetAt(i);
+			nBlockSize++;
+			if (nBlockSize < GATHER_BLOCK_SIZE)
+				continue;
+		}
+
+		// traitement d'un bloc plein, ou du dernier bloc
+		if (nBlockSize > 0) {
+			if (distanceType == KMParameters::L2Norm)
+				cResult += table.squaredL2(cBlockValues, cBlockCentroid, nBlockSize);
+			else if (distanceType == KMParameters::L1Norm)
+				cResult += table.l1(cBlockValues, cBlockCentroid, nBlockSize);
+			else {
+				Continuous cBlockDotProduct;
+				Continuous cBlockSquaredNorm1;
+				Continuous cBlockSquaredNorm2;
+				table.cosineTerms(cBlockValues, cBlockCentroid, nBlockSize, cBlockDotProduct, cBlockSquaredNorm1, cBlockSquaredNorm2);
+				cDotProduct += cBlockDotProduct;
+				cSquaredNorm1 += cBlockSquaredNorm1;
+				cSquaredNorm2 += cBlockSquaredNorm2;
+			}
+			nBlockSize = 0;
+		}
+	}
+
+	if (distanceType == KMParameters::CosineNorm) {
+		// meme convention que le calcul sur les vecteurs denses : cosinus nul si l'une des normes est nulle
+		const Continuous cDenominator = sqrt(cSquaredNorm1) * sqrt(cSquaredNorm2);
+		cResult = 1 - (cDenominator == 0 ? 0 : cDotProduct / cDenominator);
+	}
+	return cResult;
+}
+
+Continuous KMDistanceKernel::ComputeDistance(const KWObject* instance, const ContinuousVector& cvCentroid, const KWLoadIndexVector& kmeanAttributesLoadIndexes,
+	const KMParameters::DistanceType distanceType)
+{
+	require(instance != NULL);
+	require(cvCentroid.GetSize() >= kmeanAttributesLoadIndexes.GetSize());
+
+	return ComputeGatheredDistance([instance, &kmeanAttributesLoadIndexes](const int i) { return instance->GetContinuousValueAt(kmeanAttributesLoadIndexes.GetAt(i)); },
+		cvCentroid, kmeanAttributesLoadIndexes, distanceType);
+}
+
+Continuous KMDistanceKernel::ComputeDistance(const KMClusterInstance* instance, const ContinuousVector& cvCentroid, const KWLoadIndexVector& kmeanAttributesLoadIndexes,
+	const KMParameters::DistanceType distanceType)
+{
+	require(instance != NULL);
+	require(cvCentroid.GetSize() >= kmeanAttributesLoadIndexes.GetSize());
+
+	return ComputeGatheredDistance([instance, &kmeanAttributesLoadIndexes](const int i) { return instance->GetContinuousValueAt(kmeanAttributesLoadIndexes.GetAt(i)); },
+		cvCentroid, kmeanAttributesLoadIndexes, distanceType);
+}
+
+Continuous KMDistanceKernel::ComputeDistance(const ContinuousVector& cvValues, const ContinuousVector& cvCentroid, const KWLoadIndexVector& kmeanAttributesLoadIndexes,
+	const KMParameters::DistanceType distanceType)
+{
+	require(cvValues.GetSize() >= kmeanAttributesLoadIndexes.GetSize());
+	require(cvCentroid.GetSize() >= kmeanAttributesLoadIndexes.GetSize());
+
+	return ComputeGatheredDistance([&cvValues](const int i) { return cvValues.GetAt(i); }, cvCentroid, kmeanAttributesLoadIndexes, distanceType);
+}
+
+KMDistanceKernel::InstructionSet KMDistanceKernel::GetInstructionSet()
+{
+	return GetKernelTable().instructionSet;
+}
+
+const ALString KMDistanceKernel::GetInstructionSetLabel()
+{
+	switch (GetKernelTable().instructionSet) {
+	case SSE2:
+		return "SSE2";
+	case AVX2:
+		return "AVX2";
+	case AVX512:
+		return "AVX-512";
+	default:
+		return "scalar";
+	}
+}
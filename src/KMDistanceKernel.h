@@ -0,0 +1,88 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "KMParameters.h"
+#include "KMDenseMatrix.h"
+#include "KMClusterInstance.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Noyaux de calcul de distances (L1, L2 au carre, cosinus) entre vecteurs de valeurs Continuous contigues, tels que les lignes d'une KMDenseMatrix.
+/// Plusieurs implementations sont disponibles (scalaire, SSE2, AVX2, AVX-512) : la plus performante supportee par le processeur est choisie a l'execution.
+/// NB. les lignes d'une KMDenseMatrix sont completees par des 0 jusqu'a GetRowStride(), ce qui n'a pas d'impact sur les distances :
+/// on peut donc passer GetRowStride() comme taille des vecteurs, afin d'eviter le traitement des fins de vecteurs.
+
+class KMDistanceKernel
+{
+public:
+
+	/** jeux d'instructions pouvant etre utilises par les noyaux */
+	enum InstructionSet {
+		Scalar,
+		SSE2,
+		AVX2,
+		AVX512
+	};
+
+	/** distance L1 entre deux vecteurs */
+	static Continuous ComputeL1(const Continuous* v1, const Continuous* v2, const int nSize);
+
+	/** distance L2 au carre entre deux vecteurs */
+	static Continuous ComputeSquaredL2(const Continuous* v1, const Continuous* v2, const int nSize);
+
+	/** termes de la distance cosinus entre deux vecteurs : produit scalaire, et carres des normes de chaque vecteur */
+	static void ComputeCosineTerms(const Continuous* v1, const Continuous* v2, const int nSize,
+		Continuous& cDotProduct, Continuous& cSquaredNorm1, Continuous& cSquaredNorm2);
+
+	/** distance cosinus (1 - cosinus de l'angle) entre deux vecteurs */
+	static Continuous ComputeCosine(const Continuous* v1, const Continuous* v2, const int nSize);
+
+	/** distance entre deux vecteurs, pour un type de distance donne (NB. en L2, la distance est au carre, comme dans le reste du clustering) */
+	static Continuous ComputeDistance(const Continuous* v1, const Continuous* v2, const int nSize, const KMParameters::DistanceType distanceType);
+
+	/** distances entre un vecteur creux (valeurs non nulles et numeros de colonnes correspondants) et un vecteur dense, calculees a partir des seules valeurs
+	non nulles du vecteur creux et des normes precalculees : ||v2||1 + somme(|x - v2| - |v2|) en L1, somme((x - v2)^2) + (||v2||2 - somme(v2^2)) en L2 au carre
+	(sommes sur les colonnes non nulles du vecteur creux : les ecarts sont calcules exactement, seul le reste de la norme du vecteur dense est obtenu par difference),
+	et 1 - <x, v2> / (||x|| ||v2||) en cosinus */
+	static Continuous ComputeSparseL1(const int* nColumns, const Continuous* cValues, const int nNonZeroNumber, const Continuous* v2, const Continuous cL1Norm2);
+	static Continuous ComputeSparseSquaredL2(const int* nColumns, const Continuous* cValues, const int nNonZeroNumber, const Continuous* v2, const Continuous cSquaredNorm2);
+	static Continuous ComputeSparseCosine(const int* nColumns, const Continuous* cValues, const int nNonZeroNumber, const Continuous cSquaredNorm1,
+		const Continuous* v2, const Continuous cSquaredNorm2);
+
+	/** distance entre un vecteur creux et un vecteur dense, pour un type de distance donne (cL1Norm2 : norme L1 du vecteur dense, cSquaredNorm2 : carre de sa norme L2) */
+	static Continuous ComputeSparseDistance(const int* nColumns, const Continuous* cValues, const int nNonZeroNumber, const Continuous cSquaredNorm1,
+		const Continuous* v2, const Continuous cL1Norm2, const Continuous cSquaredNorm2, const KMParameters::DistanceType distanceType);
+
+	/** distance entre les valeurs K-Means d'une instance de BDD (ou d'une instance de cluster, ou d'un centroide) et un centroide (postes = rangs des attributs K-Means).
+	Les valeurs des attributs K-Means valides sont rassemblees par blocs de taille fixe sur la pile, puis traitees par les noyaux vectorises :
+	pas d'allocation memoire, ces methodes peuvent donc etre appelees dans des threads */
+	static Continuous ComputeDistance(const KWObject* instance, const ContinuousVector& cvCentroid, const KWLoadIndexVector& kmeanAttributesLoadIndexes,
+		const KMParameters::DistanceType distanceType);
+	static Continuous ComputeDistance(const KMClusterInstance* instance, const ContinuousVector& cvCentroid, const KWLoadIndexVector& kmeanAttributesLoadIndexes,
+		const KMParameters::DistanceType distanceType);
+	static Continuous ComputeDistance(const ContinuousVector& cvValues, const ContinuousVector& cvCentroid, const KWLoadIndexVector& kmeanAttributesLoadIndexes,
+		const KMParameters::DistanceType distanceType);
+
+	/** distances d'un vecteur d'instance a chacune des lignes d'une matrice de centroides (resultats dans cDistances, de taille au moins GetRowNumber()) */
+	static void ComputeDistancesToRows(const Continuous* instanceValues, const KMDenseMatrix* centroids,
+		const KMParameters::DistanceType distanceType, Continuous* cDistances);
+
+	/** jeu d'instructions utilise */
+	static InstructionSet GetInstructionSet();
+
+	/** libelle du jeu d'instructions utilise */
+	static const ALString GetInstructionSetLabel();
+
+	/** nombre de valeurs des blocs rassembles sur la pile par les methodes ComputeDistance a partir de valeurs non contigues */
+	static const int GATHER_BLOCK_SIZE;
+
+protected:
+
+	/** calcul par blocs d'une distance a partir de valeurs non contigues : getValue(i) donne la valeur du i-eme attribut K-Means (rang dans les centroides) */
+	template <class ValueGetter>
+	static Continuous ComputeGatheredDistance(const ValueGetter& getValue, const ContinuousVector& cvCentroid, const KWLoadIndexVector& kmeanAttributesLoadIndexes,
+		const KMParameters::DistanceType distanceType);
+};
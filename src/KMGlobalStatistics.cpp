@@ -0,0 +1,238 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMGlobalStatistics.h"
+
+KMGlobalStatistics::KMGlobalStatistics()
+{
+	parameters = NULL;
+	distanceType = KMParameters::L2Norm;
+	lFrequency = 0;
+	cCentroidNorm = 0;
+	cL1DistanceSum = 0;
+	nearestInstance = NULL;
+	cNearestDistance = 0;
+	lNearestPosition = -1;
+}
+
+KMGlobalStatistics::~KMGlobalStatistics()
+{
+}
+
+void KMGlobalStatistics::Initialize(const KMParameters* _parameters)
+{
+	require(_parameters != NULL);
+
+	parameters = _parameters;
+	distanceType = parameters->GetDistanceType();
+
+	const int nbAttr = parameters->GetKMeanAttributesLoadIndexes().GetSize();
+
+	lFrequency = 0;
+	cvMeans.SetSize(nbAttr);
+	cvMeans.Initialize();
+	cvSquaredDeviationsSums.SetSize(nbAttr);
+	cvSquaredDeviationsSums.Initialize();
+	cvUnitInstancesSums.SetSize(nbAttr);
+	cvUnitInstancesSums.Initialize();
+
+	cvCentroid.SetSize(nbAttr);
+	cvCentroid.Initialize();
+	cCentroidNorm = 0;
+	cL1DistanceSum = 0;
+	nearestInstance = NULL;
+	cNearestDistance = 0;
+	lNearestPosition = -1;
+}
+
+void KMGlobalStatistics::AddInstance(const KWObject* instance)
+{
+	require(parameters != NULL);
+	require(instance != NULL);
+
+	const KWLoadIndexVector& loadIndexes = parameters->GetKMeanAttributesLoadIndexes();
+	const int nbAttr = loadIndexes.GetSize();
+
+	lFrequency++;
+
+	// norme de l'instance, pour la norme cosinus
+	Continuous norm = 0;
+	for (int i = 0; i < nbAttr; i++) {
+		const KWLoadIndex loadIndex = loadIndexes.GetAt(i);
+		if (not loadIndex.IsValid())
+			continue;
+		const Continuous value = instance->GetContinuousValueAt(loadIndex);
+		norm += value * value;
+	}
+	norm = sqrt(norm);
+
+	for (int i = 0; i < nbAttr; i++) {
+
+		const KWLoadIndex loadIndex = loadIndexes.GetAt(i);
+		if (not loadIndex.IsValid())
+			continue;
+
+		const Continuous value = instance->GetContinuousValueAt(loadIndex);
+
+		// algorithme de Welford
+		const Continuous delta = value - cvMeans.GetAt(i);
+		cvMeans.UpgradeAt(i, delta / lFrequency);
+		cvSquaredDeviationsSums.UpgradeAt(i, delta * (value - cvMeans.GetAt(i)));
+
+		// une instance nulle est a distance cosinus 1 de tout centroide, et ne contribue pas a la somme des instances normees
+		if (norm > 0)
+			cvUnitInstancesSums.UpgradeAt(i, value / norm);
+	}
+}
+
+void KMGlobalStatistics::Merge(const KMGlobalStatistics* source)
+{
+	require(source != NULL);
+	require(source->cvMeans.GetSize() == cvMeans.GetSize());
+
+	if (source->lFrequency == 0)
+		return;
+
+	const longint lTotalFrequency = lFrequency + source->lFrequency;
+
+	// fusion de moyennes et de sommes de carres d'ecarts (Chan et al.)
+	for (int i = 0; i < cvMeans.GetSize(); i++) {
+
+		const Continuous delta = source->cvMeans.GetAt(i) - cvMeans.GetAt(i);
+
+		cvSquaredDeviationsSums.UpgradeAt(i, source->cvSquaredDeviationsSums.GetAt(i) +
+			delta * delta * ((Continuous)lFrequency * source->lFrequency / lTotalFrequency));
+		cvMeans.UpgradeAt(i, delta * source->lFrequency / lTotalFrequency);
+		cvUnitInstancesSums.UpgradeAt(i, source->cvUnitInstancesSums.GetAt(i));
+	}
+	lFrequency = lTotalFrequency;
+}
+
+void KMGlobalStatistics::ComputeCentroid(ContinuousVector& cvResult) const
+{
+	const KWLoadIndexVector& loadIndexes = parameters->GetKMeanAttributesLoadIndexes();
+
+	cvResult.SetSize(cvMeans.GetSize());
+	cvResult.Initialize();
+
+	for (int i = 0; i < cvMeans.GetSize(); i++) {
+		if (loadIndexes.GetAt(i).IsValid())
+			cvResult.SetAt(i, cvMeans.GetAt(i));
+	}
+}
+
+Continuous KMGlobalStatistics::GetL2DistanceSum() const
+{
+	// le centroide etant la moyenne des instances, la somme des carres des distances est la somme des carres des ecarts
+	Continuous sum = 0;
+	for (int i = 0; i < cvSquaredDeviationsSums.GetSize(); i++)
+		sum += cvSquaredDeviationsSums.GetAt(i);
+	return sum;
+}
+
+Continuous KMGlobalStatistics::ComputeCosineDistanceSum() const
+{
+	// somme des (1 - <x, c> / (||x|| ||c||)) = n - <somme des x / ||x||, c> / ||c||
+	Continuous numerator = 0;
+	Continuous centroidNorm = 0;
+
+	for (int i = 0; i < cvMeans.GetSize(); i++) {
+		numerator += cvUnitInstancesSums.GetAt(i) * cvMeans.GetAt(i);
+		centroidNorm += cvMeans.GetAt(i) * cvMeans.GetAt(i);
+	}
+	return lFrequency - (centroidNorm > 0 ? numerator / sqrt(centroidNorm) : 0);
+}
+
+void KMGlobalStatistics::SetCentroid(const ContinuousVector& cvNewCentroid)
+{
+	require(cvNewCentroid.GetSize() == cvMeans.GetSize());
+
+	cvCentroid.CopyFrom(&cvNewCentroid);
+
+	cCentroidNorm = 0;
+	for (int i = 0; i < cvCentroid.GetSize(); i++) {
+		if (parameters->GetKMeanAttributesLoadIndexes().GetAt(i).IsValid())
+			cCentroidNorm += cvCentroid.GetAt(i) * cvCentroid.GetAt(i);
+	}
+	cCentroidNorm = sqrt(cCentroidNorm);
+
+	cL1DistanceSum = 0;
+	nearestInstance = NULL;
+	cNearestDistance = 0;
+	lNearestPosition = -1;
+}
+
+boolean KMGlobalStatistics::AddInstanceDistances(const KWObject* instance, const longint lPosition)
+{
+	require(parameters != NULL);
+	require(instance != NULL);
+
+	const KWLoadIndexVector& loadIndexes = parameters->GetKMeanAttributesLoadIndexes();
+	const int nbAttr = loadIndexes.GetSize();
+
+	Continuous distanceL1 = 0;
+	Continuous distanceL2 = 0;
+	Continuous numerator = 0;
+	Continuous instanceNorm = 0;
+
+	for (int i = 0; i < nbAttr; i++) {
+
+		const KWLoadIndex loadIndex = loadIndexes.GetAt(i);
+		if (not loadIndex.IsValid())
+			continue;
+
+		const Continuous value = instance->GetContinuousValueAt(loadIndex);
+		const Continuous d = cvCentroid.GetAt(i) - value;
+
+		distanceL1 += fabs(d);
+		distanceL2 += d * d;
+		numerator += cvCentroid.GetAt(i) * value;
+		instanceNorm += value * value;
+	}
+
+	cL1DistanceSum += distanceL1;
+
+	Continuous distance;
+	if (distanceType == KMParameters::L1Norm)
+		distance = distanceL1;
+	else if (distanceType == KMParameters::L2Norm)
+		distance = distanceL2;
+	else {
+		const Continuous denominator = sqrt(instanceNorm) * cCentroidNorm;
+		distance = 1 - (denominator == 0 ? 0 : numerator / denominator);
+	}
+
+	if (nearestInstance == NULL or distance < cNearestDistance or (distance == cNearestDistance and lPosition < lNearestPosition)) {
+		nearestInstance = (KWObject*)instance;
+		cNearestDistance = distance;
+		lNearestPosition = lPosition;
+		return true;
+	}
+	return false;
+}
+
+void KMGlobalStatistics::MergeDistances(const KMGlobalStatistics* source)
+{
+	require(source != NULL);
+
+	cL1DistanceSum += source->cL1DistanceSum;
+
+	if (source->nearestInstance != NULL and (nearestInstance == NULL or source->cNearestDistance < cNearestDistance or
+		(source->cNearestDistance == cNearestDistance and source->lNearestPosition < lNearestPosition))) {
+		nearestInstance = source->nearestInstance;
+		cNearestDistance = source->cNearestDistance;
+		lNearestPosition = source->lNearestPosition;
+	}
+}
+
+longint KMGlobalStatistics::GetUsedMemory() const
+{
+	return sizeof(KMGlobalStatistics) + cvMeans.GetUsedMemory() - sizeof(ContinuousVector) + cvSquaredDeviationsSums.GetUsedMemory() - sizeof(ContinuousVector) +
+	       cvUnitInstancesSums.GetUsedMemory() - sizeof(ContinuousVector) + cvCentroid.GetUsedMemory() - sizeof(ContinuousVector);
+}
+
+const ALString KMGlobalStatistics::GetClassLabel() const
+{
+	return "Global statistics";
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "Vector.h"
+#include "KWObject.h"
+#include "KMParameters.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Calcul en flux des statistiques du cluster global (toutes les instances sans valeur K-Means manquante), sans stocker les instances.
+/// Premiere passe : effectif, moyennes et sommes des carres des ecarts a la moyenne (algorithme de Welford), et sommes des instances normees (x / ||x||),
+/// par attribut K-Means. Elle donne le centroide, et les sommes exactes des distances au centroide en normes L2 et cosinus.
+/// Seconde passe, le centroide etant connu : somme des distances en norme L1, et instance la plus proche du centroide.
+/// Les accumulateurs de deux parties distinctes de la base se fusionnent (threads) ; une fois dimensionne, un accumulateur ne fait plus d'allocation memoire.
+
+class KMGlobalStatistics : public Object
+{
+public:
+
+	KMGlobalStatistics();
+	~KMGlobalStatistics();
+
+	/** dimensionnement et remise a zero, pour les attributs K-Means et la norme d'un parametrage */
+	void Initialize(const KMParameters* parameters);
+
+	// premiere passe
+
+	/** ajout d'une instance sans valeur K-Means manquante */
+	void AddInstance(const KWObject* instance);
+
+	/** ajout des statistiques de premiere passe d'un autre accumulateur, portant sur d'autres instances */
+	void Merge(const KMGlobalStatistics* source);
+
+	/** nombre d'instances ajoutees */
+	longint GetFrequency() const;
+
+	/** centroide (moyenne des instances), au format des centroides de clusters (postes = rangs des attributs K-Means) */
+	void ComputeCentroid(ContinuousVector& cvCentroid) const;
+
+	/** somme des distances au centroide, en norme L2 (carres des distances) */
+	Continuous GetL2DistanceSum() const;
+
+	/** somme des distances au centroide, en norme cosinus */
+	Continuous ComputeCosineDistanceSum() const;
+
+	// seconde passe
+
+	/** centroide de reference de la seconde passe (normalement, celui issu de la premiere passe). Remet a zero les statistiques de seconde passe */
+	void SetCentroid(const ContinuousVector& cvCentroid);
+
+	/** prise en compte d'une instance sans valeur K-Means manquante, a une position donnee dans la base (qui departage les instances a egale distance).
+	Retourne true si l'instance devient la plus proche du centroide (utile si les instances sont lues en flux, et detruites apres traitement) */
+	boolean AddInstanceDistances(const KWObject* instance, const longint lPosition);
+
+	/** ajout des statistiques de seconde passe d'un autre accumulateur, portant sur d'autres instances */
+	void MergeDistances(const KMGlobalStatistics* source);
+
+	/** somme des distances au centroide, en norme L1 */
+	Continuous GetL1DistanceSum() const;
+
+	/** instance la plus proche du centroide, pour la norme du parametrage (NULL si aucune). Valide tant que les instances traitees existent */
+	KWObject* GetInstanceNearestToCentroid() const;
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	const KMParameters* parameters;
+	KMParameters::DistanceType distanceType;
+
+	longint lFrequency;
+
+	/** par attribut K-Means : moyennes, sommes des carres des ecarts a la moyenne, et sommes des instances normees */
+	ContinuousVector cvMeans;
+	ContinuousVector cvSquaredDeviationsSums;
+	ContinuousVector cvUnitInstancesSums;
+
+	/** centroide de reference de la seconde passe, et sa norme */
+	ContinuousVector cvCentroid;
+	Continuous cCentroidNorm;
+
+	Continuous cL1DistanceSum;
+
+	/** instance la plus proche du centroide, sa distance et sa position */
+	KWObject* nearestInstance;
+	Continuous cNearestDistance;
+	longint lNearestPosition;
+};
+
+inline longint KMGlobalStatistics::GetFrequency() const {
+	return lFrequency;
+}
+
+inline Continuous KMGlobalStatistics::GetL1DistanceSum() const {
+	return cL1DistanceSum;
+}
+
+inline KWObject* KMGlobalStatistics::GetInstanceNearestToCentroid() const {
+	return nearestInstance;
+}
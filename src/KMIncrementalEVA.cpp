@@ -0,0 +1,189 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMIncrementalEVA.h"
+#include "KWStat.h"
+#include "KMClusteringQuality.h"
+#include <cmath>
+
+const double KMIncrementalEVA::CHECK_RELATIVE_PRECISION = 1e-9;
+
+KMIncrementalEVA::KMIncrementalEVA()
+{
+	referenceFrequencies = NULL;
+	dTerms = 0;
+}
+
+KMIncrementalEVA::~KMIncrementalEVA()
+{
+}
+
+void KMIncrementalEVA::Initialize(const KWFrequencyTable* frequencies)
+{
+	require(frequencies != NULL);
+	require(frequencies->GetFrequencyVectorNumber() > 0);
+	require(frequencies->GetFrequencyVectorSize() > 0);
+
+	referenceFrequencies = frequencies;
+
+	const int J = frequencies->GetFrequencyVectorSize();
+	const int nRowNumber = frequencies->GetFrequencyVectorNumber();
+
+	ivRowFrequencies.SetSize(nRowNumber);
+	cvRowTerms.SetSize(nRowNumber);
+
+	int nTotalFrequency = 0;
+	for (int nRow = 0; nRow < nRowNumber; nRow++) {
+
+		const IntVector* ivFrequencies = cast(KWDenseFrequencyVector*, frequencies->GetFrequencyVectorAt(nRow))->GetFrequencyVector();
+		int nRowFrequency = 0;
+		for (int j = 0; j < J; j++)
+			nRowFrequency += ivFrequencies->GetAt(j);
+
+		ivRowFrequencies.SetAt(nRow, nRowFrequency);
+		nTotalFrequency += nRowFrequency;
+	}
+
+	// table des log factorielles, jusqu'a logf(N + J - 1)
+	if (cvLnFactorials.GetSize() < nTotalFrequency + J) {
+		const int nFirstValue = cvLnFactorials.GetSize();
+		cvLnFactorials.SetSize(nTotalFrequency + J);
+		for (int n = nFirstValue; n < cvLnFactorials.GetSize(); n++)
+			cvLnFactorials.SetAt(n, KWStat::LnFactorial(n));
+	}
+
+	dTerms = 0;
+	for (int nRow = 0; nRow < nRowNumber; nRow++) {
+		cvRowTerms.SetAt(nRow, ComputeRowTerms(nRow, NULL));
+		dTerms += cvRowTerms.GetAt(nRow);
+	}
+
+	// les contributions de lignes doivent correspondre au calcul de reference de KMClusteringQuality
+	assert(CheckTerms(dTerms, frequencies));
+}
+
+double KMIncrementalEVA::ComputeTermsAfterMoves(const int nEmptiedRow, const KMEVAMoves* moves) const
+{
+	require(referenceFrequencies != NULL);
+	require(moves != NULL);
+	require(nEmptiedRow >= -1 and nEmptiedRow < GetRowNumber());
+
+	double dResult = dTerms;
+
+	if (nEmptiedRow != -1)
+		dResult -= cvRowTerms.GetAt(nEmptiedRow);
+
+	for (int i = 0; i < moves->GetTouchedRowNumber(); i++) {
+
+		const int nRow = moves->GetTouchedRowAt(i);
+		assert(nRow != nEmptiedRow);
+
+		dResult += ComputeRowTerms(nRow, moves) - cvRowTerms.GetAt(nRow);
+	}
+	return dResult;
+}
+
+double KMIncrementalEVA::ComputeRowTerms(const int nRow, const KMEVAMoves* moves) const
+{
+	const int J = referenceFrequencies->GetFrequencyVectorSize();
+	const IntVector* ivFrequencies = cast(KWDenseFrequencyVector*, referenceFrequencies->GetFrequencyVectorAt(nRow))->GetFrequencyVector();
+	const int nRowFrequency = ivRowFrequencies.GetAt(nRow) + (moves == NULL ? 0 : moves->GetRowMoveNumber(nRow));
+
+	if (nRowFrequency == 0)
+		return 0;
+
+	// 2eme terme : logf(Nk + J - 1) - logf(J - 1) - logf(Nk) ; 3eme terme : logf(Nk) - somme(j = 1 a J) logf(Nkj)
+	double dResult = GetLnFactorial(nRowFrequency + J - 1) - GetLnFactorial(J - 1);
+
+	for (int j = 0; j < J; j++) {
+		const int nFrequency = ivFrequencies->GetAt(j) + (moves == NULL ? 0 : moves->GetMoveNumber(nRow, j));
+		dResult -= GetLnFactorial(nFrequency);
+	}
+	return dResult;
+}
+
+double KMIncrementalEVA::ComputeTermsFromScratch(const KWFrequencyTable* frequencies)
+{
+	require(frequencies != NULL);
+
+	KMClusteringQuality clusteringQuality;
+
+	// les methodes de KMClusteringQuality ne modifient pas la table, meme si elles la recoivent en non const
+	KWFrequencyTable* table = (KWFrequencyTable*)frequencies;
+
+	return clusteringQuality.ComputeEVASecondTerm(table->GetFrequencyVectorNumber(), table) +
+	       clusteringQuality.ComputeEVAThirdTerm(table->GetFrequencyVectorNumber(), table);
+}
+
+boolean KMIncrementalEVA::CheckTerms(const double dIncrementalTerms, const KWFrequencyTable* frequencies)
+{
+	require(frequencies != NULL);
+
+	const double dTermsFromScratch = ComputeTermsFromScratch(frequencies);
+
+	return fabs(dIncrementalTerms - dTermsFromScratch) <= CHECK_RELATIVE_PRECISION * (1 + fabs(dTermsFromScratch));
+}
+
+longint KMIncrementalEVA::GetUsedMemory() const
+{
+	return sizeof(KMIncrementalEVA) + ivRowFrequencies.GetUsedMemory() - sizeof(IntVector) + cvRowTerms.GetUsedMemory() - sizeof(ContinuousVector) +
+	       cvLnFactorials.GetUsedMemory() - sizeof(ContinuousVector);
+}
+
+const ALString KMIncrementalEVA::GetClassLabel() const
+{
+	return "Incremental EVA";
+}
+
+//////////////////////////////////////////////////
+// Classe KMEVAMoves
+
+KMEVAMoves::KMEVAMoves()
+{
+	nTargetValueNumber = 0;
+	nTouchedRowNumber = 0;
+}
+
+KMEVAMoves::~KMEVAMoves()
+{
+}
+
+void KMEVAMoves::Initialize(const int nRowNumber, const int nValueNumber)
+{
+	require(nRowNumber >= 0);
+	require(nValueNumber >= 0);
+
+	nTargetValueNumber = nValueNumber;
+
+	ivMoves.SetSize(0);
+	ivMoves.SetSize(nRowNumber * nTargetValueNumber);
+	ivRowMoves.SetSize(0);
+	ivRowMoves.SetSize(nRowNumber);
+	ivTouchedRows.SetSize(nRowNumber);
+	nTouchedRowNumber = 0;
+}
+
+void KMEVAMoves::Reset()
+{
+	for (int i = 0; i < nTouchedRowNumber; i++) {
+
+		const int nRow = ivTouchedRows.GetAt(i);
+
+		for (int j = 0; j < nTargetValueNumber; j++)
+			ivMoves.SetAt(nRow * nTargetValueNumber + j, 0);
+		ivRowMoves.SetAt(nRow, 0);
+	}
+	nTouchedRowNumber = 0;
+}
+
+longint KMEVAMoves::GetUsedMemory() const
+{
+	return sizeof(KMEVAMoves) + ivMoves.GetUsedMemory() - sizeof(IntVector) + ivRowMoves.GetUsedMemory() - sizeof(IntVector) +
+	       ivTouchedRows.GetUsedMemory() - sizeof(IntVector);
+}
+
+const ALString KMEVAMoves::GetClassLabel() const
+{
+	return "EVA moves";
+}
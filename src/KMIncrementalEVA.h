@@ -0,0 +1,172 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "Vector.h"
+#include "KWFrequencyTable.h"
+
+class KMEVAMoves;
+
+////////////////////////////////////////////////////////////////////////////////
+/// Evaluation incrementale des 2eme et 3eme termes de l'EVA (cf. KMClusteringQuality), pour une table de frequences de reference
+/// (lignes = clusters, colonnes = modalites cibles). Pour un cluster k non vide, d'effectif Nk et d'effectifs Nkj par modalite cible, ces deux termes
+/// se cumulent en une contribution de ligne : logf(Nk + J - 1) - logf(J - 1) - somme(j = 1 a J) logf(Nkj).
+/// Les contributions de lignes de la table de reference sont memorisees : l'effet d'un deplacement d'instances vers quelques lignes (KMEVAMoves)
+/// se calcule en ne reevaluant que les lignes touchees. Les log factorielles sont lues dans une table precalculee.
+/// Les methodes d'evaluation ne font que lire l'evaluateur, et peuvent etre appelees dans des threads (un KMEVAMoves par thread).
+
+class KMIncrementalEVA : public Object
+{
+public:
+
+	KMIncrementalEVA();
+	~KMIncrementalEVA();
+
+	/** initialisation a partir d'une table de frequences de reference, a refaire a chaque modification de la table. La table des log factorielles
+	n'est recalculee que si l'effectif total ou le nombre de modalites cibles augmente */
+	void Initialize(const KWFrequencyTable* frequencies);
+
+	/** nombre de lignes (clusters) et de colonnes (modalites cibles) de la table de reference */
+	int GetRowNumber() const;
+	int GetTargetValueNumber() const;
+
+	/** somme des 2eme et 3eme termes de l'EVA, pour la table de reference */
+	double GetTerms() const;
+
+	/** somme des 2eme et 3eme termes de l'EVA, pour la table de reference dont on aurait vide une ligne (-1 si aucune), et a laquelle on aurait
+	ajoute les deplacements d'instances memorises. Seules la ligne videe et les lignes touchees par les deplacements sont reevaluees */
+	double ComputeTermsAfterMoves(const int nEmptiedRow, const KMEVAMoves* moves) const;
+
+	/** log factorielle, lue dans la table precalculee */
+	double GetLnFactorial(const int n) const;
+
+	/** calcul direct (non incremental) de la somme des 2eme et 3eme termes de l'EVA d'une table de frequences, par KMClusteringQuality.
+	Sert a verifier l'evaluation incrementale en mode debug */
+	static double ComputeTermsFromScratch(const KWFrequencyTable* frequencies);
+
+	/** verification d'une somme des 2eme et 3eme termes obtenue par evaluation incrementale, par comparaison avec le calcul direct sur la table
+	correspondante (par exemple, la table de reference apres application des deplacements evalues par ComputeTermsAfterMoves) */
+	static boolean CheckTerms(const double dIncrementalTerms, const KWFrequencyTable* frequencies);
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	/** contribution d'une ligne aux 2eme et 3eme termes de l'EVA, la ligne etant augmentee de deplacements eventuels (NULL si aucun) */
+	double ComputeRowTerms(const int nRow, const KMEVAMoves* moves) const;
+
+	const KWFrequencyTable* referenceFrequencies;
+
+	/** effectif de chaque ligne de la table de reference */
+	IntVector ivRowFrequencies;
+
+	/** contribution de chaque ligne de la table de reference (0 pour une ligne vide) */
+	ContinuousVector cvRowTerms;
+
+	double dTerms;
+
+	/** log factorielles de 0 a l'effectif total + nombre de modalites cibles */
+	ContinuousVector cvLnFactorials;
+
+	/** ecart relatif tolere entre l'evaluation incrementale et le calcul direct (les sommes ne sont pas effectuees dans le meme ordre) */
+	static const double CHECK_RELATIVE_PRECISION;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// Deplacements d'instances vers des lignes d'une table de frequences, exprimes en effectifs ajoutes par ligne et modalite cible.
+/// La memoire est reservee une fois pour toutes (methode Initialize) : l'ajout de deplacements et la remise a zero ne font aucune allocation,
+/// et ne parcourent que les lignes touchees.
+
+class KMEVAMoves : public Object
+{
+public:
+
+	KMEVAMoves();
+	~KMEVAMoves();
+
+	/** reservation de la memoire, pour une table de dimensions donnees. Tous les effectifs ajoutes sont a zero */
+	void Initialize(const int nRowNumber, const int nTargetValueNumber);
+
+	/** ajout d'une instance a une ligne, pour une modalite cible */
+	void AddMove(const int nRow, const int nTargetValue);
+
+	/** nombre de lignes touchees, et acces a ces lignes */
+	int GetTouchedRowNumber() const;
+	int GetTouchedRowAt(const int nIndex) const;
+
+	/** effectifs ajoutes a une ligne */
+	int GetRowMoveNumber(const int nRow) const;
+	int GetMoveNumber(const int nRow, const int nTargetValue) const;
+
+	/** remise a zero des seules lignes touchees */
+	void Reset();
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	int nTargetValueNumber;
+
+	/** effectifs ajoutes, ligne par ligne (nRowNumber * nTargetValueNumber valeurs) */
+	IntVector ivMoves;
+
+	/** effectif total ajoute a chaque ligne */
+	IntVector ivRowMoves;
+
+	/** lignes touchees (seuls les nTouchedRowNumber premiers elements sont utilises) */
+	IntVector ivTouchedRows;
+	int nTouchedRowNumber;
+};
+
+inline int KMIncrementalEVA::GetRowNumber() const {
+	return ivRowFrequencies.GetSize();
+}
+
+inline int KMIncrementalEVA::GetTargetValueNumber() const {
+	return (referenceFrequencies == NULL ? 0 : referenceFrequencies->GetFrequencyVectorSize());
+}
+
+inline double KMIncrementalEVA::GetTerms() const {
+	return dTerms;
+}
+
+inline double KMIncrementalEVA::GetLnFactorial(const int n) const {
+	assert(n >= 0 and n < cvLnFactorials.GetSize());
+	return cvLnFactorials.GetAt(n);
+}
+
+inline void KMEVAMoves::AddMove(const int nRow, const int nTargetValue) {
+	assert(nTargetValue >= 0 and nTargetValue < nTargetValueNumber);
+
+	if (ivRowMoves.GetAt(nRow) == 0) {
+		ivTouchedRows.SetAt(nTouchedRowNumber, nRow);
+		nTouchedRowNumber++;
+	}
+	ivRowMoves.UpgradeAt(nRow, 1);
+	ivMoves.UpgradeAt(nRow * nTargetValueNumber + nTargetValue, 1);
+}
+
+inline int KMEVAMoves::GetTouchedRowNumber() const {
+	return nTouchedRowNumber;
+}
+
+inline int KMEVAMoves::GetTouchedRowAt(const int nIndex) const {
+	assert(nIndex >= 0 and nIndex < nTouchedRowNumber);
+	return ivTouchedRows.GetAt(nIndex);
+}
+
+inline int KMEVAMoves::GetRowMoveNumber(const int nRow) const {
+	return ivRowMoves.GetAt(nRow);
+}
+
+inline int KMEVAMoves::GetMoveNumber(const int nRow, const int nTargetValue) const {
+	assert(nTargetValue >= 0 and nTargetValue < nTargetValueNumber);
+	return ivMoves.GetAt(nRow * nTargetValueNumber + nTargetValue);
+}
@@ -6,8 +6,10 @@
 #include "KMClassifierEvaluationTask.h"
 #include "KMPredictorEvaluationTask.h"
 #include "KMRandomInitialisationTask.h"
+#include "KMMiniBatchTask.h"
 #include "KMPredictorKNNView.h"
 #include "KMDRRegisterAllRules.h"
+#include "KMDRNearestCentroid.h"
 
 KMLearningProject::KMLearningProject()
 {
@@ -40,6 +42,7 @@ void KMLearningProject::OpenLearningEnvironnement()
 	// enregistrements specifiques MLClusters
 
 	KMDRRegisterAllRules(); // regles de derivation
+	KWDerivationRule::RegisterDerivationRule(new KMDRNearestCentroid);
 	KWPredictor::RegisterPredictor(new KMPredictor);
 	KWPredictor::RegisterPredictor(new KMPredictorKNN);
 	KWPredictorView::RegisterPredictorView(new KMPredictorView);
@@ -47,5 +50,6 @@ void KMLearningProject::OpenLearningEnvironnement()
 	PLParallelTask::RegisterTask(new KMClassifierEvaluationTask);
 	PLParallelTask::RegisterTask(new KMPredictorEvaluationTask);
 	PLParallelTask::RegisterTask(new KMRandomInitialisationTask);
+	PLParallelTask::RegisterTask(new KMMiniBatchTask);
 }
 
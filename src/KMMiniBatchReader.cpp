@@ -0,0 +1,169 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMMiniBatchReader.h"
+
+KMMiniBatchReader::KMMiniBatchReader()
+{
+	database = NULL;
+	nMiniBatchSize = 1;
+	nBlockMiniBatchesNumber = 1;
+	nBlockPosition = 0;
+	bIsOpened = false;
+	nEpochNumber = 0;
+}
+
+KMMiniBatchReader::~KMMiniBatchReader()
+{
+	Close();
+}
+
+void KMMiniBatchReader::SetDatabase(KWDatabase* d)
+{
+	require(not bIsOpened);
+	database = d;
+}
+
+void KMMiniBatchReader::SetMiniBatchSize(const int nSize)
+{
+	require(nSize > 0);
+	nMiniBatchSize = nSize;
+}
+
+void KMMiniBatchReader::SetBlockMiniBatchesNumber(const int nNumber)
+{
+	require(nNumber > 0);
+	nBlockMiniBatchesNumber = nNumber;
+}
+
+boolean KMMiniBatchReader::Open()
+{
+	require(database != NULL);
+	require(not bIsOpened);
+
+	bIsOpened = database->OpenForRead();
+	nEpochNumber = (bIsOpened ? 1 : 0);
+
+	return bIsOpened;
+}
+
+boolean KMMiniBatchReader::ReadNextMiniBatch(ObjectArray* oaResult)
+{
+	require(bIsOpened);
+	require(oaResult != NULL);
+
+	oaResult->SetSize(0);
+
+	// les instances du mini-batch precedent ne sont plus utilisees
+	oaMiniBatch.DeleteAll();
+
+	if (nBlockPosition == oaBlock.GetSize()) {
+
+		if (not ReadNextBlock())
+			return false;
+
+		// fin de la base : nouvelle passe
+		if (oaBlock.GetSize() == 0) {
+
+			database->Close();
+			if (not database->OpenForRead()) {
+				bIsOpened = false;
+				return false;
+			}
+			nEpochNumber++;
+
+			if (not ReadNextBlock())
+				return false;
+
+			// base vide
+			if (oaBlock.GetSize() == 0)
+				return false;
+		}
+	}
+
+	// distribution des instances suivantes du bloc
+	while (nBlockPosition < oaBlock.GetSize() and oaMiniBatch.GetSize() < nMiniBatchSize) {
+		oaMiniBatch.Add(oaBlock.GetAt(nBlockPosition));
+		oaBlock.SetAt(nBlockPosition, NULL);
+		nBlockPosition++;
+	}
+
+	oaResult->CopyFrom(&oaMiniBatch);
+
+	return true;
+}
+
+void KMMiniBatchReader::Close()
+{
+	if (bIsOpened)
+		database->Close();
+
+	oaMiniBatch.DeleteAll();
+
+	// NB. les instances deja distribuees ont ete retirees du bloc
+	for (int i = nBlockPosition; i < oaBlock.GetSize(); i++)
+		delete oaBlock.GetAt(i);
+	oaBlock.SetSize(0);
+	nBlockPosition = 0;
+
+	bIsOpened = false;
+}
+
+boolean KMMiniBatchReader::ReadNextBlock()
+{
+	require(bIsOpened);
+	require(nBlockPosition == oaBlock.GetSize());
+
+	const int nBlockSize = nMiniBatchSize * nBlockMiniBatchesNumber;
+	boolean bOk = true;
+
+	oaBlock.SetSize(0);
+	nBlockPosition = 0;
+
+	Global::ActivateErrorFlowControl();
+
+	while (oaBlock.GetSize() < nBlockSize and not database->IsEnd()) {
+
+		KWObject* kwoObject = database->Read();
+
+		if (kwoObject != NULL)
+			oaBlock.Add(kwoObject);
+		else
+			if (TaskProgression::IsInterruptionRequested()) {
+				bOk = false;
+				break;
+			}
+
+		if (database->IsError()) {
+			bOk = false;
+			break;
+		}
+	}
+
+	Global::DesactivateErrorFlowControl();
+
+	// les instances sont lues dans l'ordre de la base : le melange du bloc evite que les mini-batches n'en dependent
+	if (bOk)
+		oaBlock.Shuffle();
+
+	return bOk;
+}
+
+longint KMMiniBatchReader::GetUsedMemory() const
+{
+	longint lUsedMemory = sizeof(KMMiniBatchReader) + oaBlock.GetUsedMemory() + oaMiniBatch.GetUsedMemory();
+
+	for (int i = nBlockPosition; i < oaBlock.GetSize(); i++)
+		lUsedMemory += oaBlock.GetAt(i)->GetUsedMemory();
+
+	for (int i = 0; i < oaMiniBatch.GetSize(); i++)
+		lUsedMemory += oaMiniBatch.GetAt(i)->GetUsedMemory();
+
+	return lUsedMemory;
+}
+
+const ALString KMMiniBatchReader::GetClassLabel() const
+{
+	return "Mini-batch reader";
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "KWDatabase.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Lecture en flux d'une base, sous la forme de mini-batches de taille fixe.
+/// La base est lue sequentiellement, par blocs de plusieurs mini-batches : chaque bloc est melange avant d'etre decoupe en mini-batches.
+/// Lorsque la fin de la base est atteinte, une nouvelle passe (epoque) est entamee : quel que soit le nombre de mini-batches demandes,
+/// chaque passe ne coute donc qu'une seule lecture de la base, et seul un bloc est present en memoire.
+
+class KMMiniBatchReader : public Object
+{
+public:
+
+	KMMiniBatchReader();
+	~KMMiniBatchReader();
+
+	/** base a lire (non possedee), avec son parametrage d'echantillonnage */
+	void SetDatabase(KWDatabase*);
+	KWDatabase* GetDatabase() const;
+
+	/** nombre d'instances d'un mini-batch */
+	void SetMiniBatchSize(const int nSize);
+	int GetMiniBatchSize() const;
+
+	/** nombre de mini-batches lus et melanges ensemble */
+	void SetBlockMiniBatchesNumber(const int nNumber);
+	int GetBlockMiniBatchesNumber() const;
+
+	/** ouverture de la base en lecture */
+	boolean Open();
+
+	/** lecture du mini-batch suivant, dans le tableau passe en parametre (qui est vide au prealable).
+	Les instances restent possedees par le lecteur, et ne sont valides que jusqu'a la lecture du mini-batch suivant.
+	Le dernier mini-batch d'une passe peut etre incomplet. Renvoie false en cas d'erreur, ou si la base ne contient aucune instance */
+	boolean ReadNextMiniBatch(ObjectArray* oaMiniBatch);
+
+	/** fermeture de la base, et destruction des instances lues */
+	void Close();
+
+	/** nombre de passes sur la base entamees depuis l'ouverture */
+	int GetEpochNumber() const;
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	/** lecture et melange du bloc suivant. Renvoie false en cas d'erreur de lecture */
+	boolean ReadNextBlock();
+
+	KWDatabase* database;
+	int nMiniBatchSize;
+	int nBlockMiniBatchesNumber;
+
+	/** instances du bloc courant (possedees), dont celles situees a partir de nBlockPosition restent a distribuer */
+	ObjectArray oaBlock;
+	int nBlockPosition;
+
+	/** instances du mini-batch courant (possedees) */
+	ObjectArray oaMiniBatch;
+
+	boolean bIsOpened;
+	int nEpochNumber;
+};
+
+inline KWDatabase* KMMiniBatchReader::GetDatabase() const {
+	return database;
+}
+
+inline int KMMiniBatchReader::GetMiniBatchSize() const {
+	return nMiniBatchSize;
+}
+
+inline int KMMiniBatchReader::GetBlockMiniBatchesNumber() const {
+	return nBlockMiniBatchesNumber;
+}
+
+inline int KMMiniBatchReader::GetEpochNumber() const {
+	return nEpochNumber;
+}
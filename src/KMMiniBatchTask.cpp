@@ -0,0 +1,265 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMMiniBatchTask.h"
+#include "KMDistanceKernel.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Classe KMMiniBatchTask
+
+const int KMMiniBatchTask::MIN_ROWS_BY_TASK = 1000;
+
+KMMiniBatchTask::KMMiniBatchTask()
+{
+	master_instancesMatrix = NULL;
+	master_centroidsMatrix = NULL;
+	master_clustersNumber = 0;
+	master_distanceType = 0;
+	master_nextRow = 0;
+	master_rowsByTask = 0;
+	slave_centroidsValues = NULL;
+	slave_instanceValues = NULL;
+
+	DeclareSharedParameter(&shared_distanceType);
+	DeclareSharedParameter(&shared_clustersNumber);
+	DeclareSharedParameter(&shared_columnsNumber);
+	DeclareSharedParameter(&shared_centroids);
+	DeclareTaskInput(&input_instancesValues);
+	DeclareTaskOutput(&output_clustersSums);
+	DeclareTaskOutput(&output_clustersFrequencies);
+}
+
+KMMiniBatchTask::~KMMiniBatchTask()
+{
+	if (slave_centroidsValues != NULL)
+		delete[] slave_centroidsValues;
+	if (slave_instanceValues != NULL)
+		delete[] slave_instanceValues;
+	master_tasksSums.DeleteAll();
+}
+
+boolean KMMiniBatchTask::ComputeClustersSums(const KMDenseMatrix* instancesMatrix, const KMDenseMatrix* centroidsMatrix, const int nClustersNumber,
+	const KMParameters::DistanceType distanceType)
+{
+	require(instancesMatrix != NULL);
+	require(centroidsMatrix != NULL);
+	require(nClustersNumber > 0 and nClustersNumber <= centroidsMatrix->GetRowNumber());
+	require(instancesMatrix->GetColumnNumber() == centroidsMatrix->GetColumnNumber());
+
+	master_instancesMatrix = instancesMatrix;
+	master_centroidsMatrix = centroidsMatrix;
+	master_clustersNumber = nClustersNumber;
+	master_distanceType = distanceType;
+
+	return Run();
+}
+
+boolean KMMiniBatchTask::MasterInitialize()
+{
+	assert(master_instancesMatrix != NULL);
+	assert(master_centroidsMatrix != NULL);
+
+	const int nbColumns = master_instancesMatrix->GetColumnNumber();
+
+	shared_distanceType = master_distanceType;
+	shared_clustersNumber = master_clustersNumber;
+	shared_columnsNumber = nbColumns;
+
+	// les centroides sont transmis aux esclaves sous la forme d'un vecteur unique, un centroide a la suite de l'autre (sans les colonnes de remplissage)
+	ContinuousVector* cvCentroids = shared_centroids.GetContinuousVector();
+	cvCentroids->SetSize(master_clustersNumber * nbColumns);
+
+	for (int idxCluster = 0; idxCluster < master_clustersNumber; idxCluster++) {
+
+		const Continuous* cCentroidValues = master_centroidsMatrix->GetRowAt(idxCluster);
+
+		for (int nColumn = 0; nColumn < nbColumns; nColumn++)
+			cvCentroids->SetAt(idxCluster * nbColumns + nColumn, cCentroidValues[nColumn]);
+	}
+
+	// une tranche de lignes par processus, sans descendre en deca d'une taille minimale
+	const int nProcessNumber = (GetProcessNumber() > 0 ? GetProcessNumber() : 1);
+	master_rowsByTask = (master_instancesMatrix->GetRowNumber() + nProcessNumber - 1) / nProcessNumber;
+	if (master_rowsByTask < MIN_ROWS_BY_TASK)
+		master_rowsByTask = MIN_ROWS_BY_TASK;
+	master_nextRow = 0;
+
+	master_tasksSums.DeleteAll();
+	master_clustersSums.SetSize(master_clustersNumber * nbColumns);
+	master_clustersSums.Initialize();
+	master_clustersFrequencies.SetSize(master_clustersNumber);
+	master_clustersFrequencies.Initialize();
+
+	return true;
+}
+
+boolean KMMiniBatchTask::MasterPrepareTaskInput(double& dTaskPercent, boolean& bIsTaskFinished)
+{
+	const int nbRows = master_instancesMatrix->GetRowNumber();
+	const int nbColumns = master_instancesMatrix->GetColumnNumber();
+
+	if (master_nextRow >= nbRows) {
+		bIsTaskFinished = true;
+		return true;
+	}
+
+	int nLastRow = master_nextRow + master_rowsByTask;
+	if (nLastRow > nbRows)
+		nLastRow = nbRows;
+
+	// recopie des lignes de la tranche, en ignorant celles qui comportent des valeurs manquantes
+	ContinuousVector* cvValues = input_instancesValues.GetContinuousVector();
+	cvValues->SetSize(0);
+
+	for (int nRow = master_nextRow; nRow < nLastRow; nRow++) {
+
+		if (master_instancesMatrix->IsMissingValueRow(nRow))
+			continue;
+
+		const Continuous* cRowValues = master_instancesMatrix->GetRowAt(nRow);
+
+		for (int nColumn = 0; nColumn < nbColumns; nColumn++)
+			cvValues->Add(cRowValues[nColumn]);
+	}
+
+	dTaskPercent = (nLastRow - master_nextRow) / (double)nbRows;
+	master_nextRow = nLastRow;
+
+	return true;
+}
+
+boolean KMMiniBatchTask::MasterAggregateResults()
+{
+	const ContinuousVector* cvSlaveSums = output_clustersSums.GetConstContinuousVector();
+	const IntVector* ivSlaveFrequencies = output_clustersFrequencies.GetConstIntVector();
+
+	assert(cvSlaveSums->GetSize() == master_clustersSums.GetSize());
+	assert(ivSlaveFrequencies->GetSize() == master_clustersFrequencies.GetSize());
+
+	// les sommes sont memorisees selon l'index de la tranche, et ne sont cumulees qu'en fin de tache
+	if (master_tasksSums.GetSize() <= GetTaskIndex())
+		master_tasksSums.SetSize(GetTaskIndex() + 1);
+	master_tasksSums.SetAt(GetTaskIndex(), cvSlaveSums->Clone());
+
+	for (int i = 0; i < ivSlaveFrequencies->GetSize(); i++)
+		master_clustersFrequencies.SetAt(i, master_clustersFrequencies.GetAt(i) + ivSlaveFrequencies->GetAt(i));
+
+	return true;
+}
+
+boolean KMMiniBatchTask::MasterFinalize(boolean bProcessEndedCorrectly)
+{
+	// cumul des sommes partielles dans l'ordre des tranches
+	if (bProcessEndedCorrectly) {
+
+		for (int nTask = 0; nTask < master_tasksSums.GetSize(); nTask++) {
+
+			const ContinuousVector* cvTaskSums = cast(ContinuousVector*, master_tasksSums.GetAt(nTask));
+			assert(cvTaskSums != NULL);
+
+			for (int i = 0; i < cvTaskSums->GetSize(); i++)
+				master_clustersSums.SetAt(i, master_clustersSums.GetAt(i) + cvTaskSums->GetAt(i));
+		}
+	}
+
+	master_tasksSums.DeleteAll();
+
+	return bProcessEndedCorrectly;
+}
+
+boolean KMMiniBatchTask::SlaveInitialize()
+{
+	const int nbClusters = shared_clustersNumber;
+	const int nbColumns = shared_columnsNumber;
+	const ContinuousVector* cvCentroids = shared_centroids.GetConstContinuousVector();
+
+	assert(cvCentroids->GetSize() == nbClusters * nbColumns);
+
+	// les buffers sont alloues une seule fois par esclave, et reutilises pour toutes les tranches traitees
+	slave_centroidsValues = new Continuous[nbClusters * nbColumns];
+	slave_instanceValues = new Continuous[nbColumns];
+
+	for (int i = 0; i < nbClusters * nbColumns; i++)
+		slave_centroidsValues[i] = cvCentroids->GetAt(i);
+
+	return true;
+}
+
+boolean KMMiniBatchTask::SlaveProcess()
+{
+	const int nbClusters = shared_clustersNumber;
+	const int nbColumns = shared_columnsNumber;
+	const ContinuousVector* cvValues = input_instancesValues.GetConstContinuousVector();
+
+	assert(nbColumns > 0);
+	assert(cvValues->GetSize() % nbColumns == 0);
+
+	ContinuousVector* cvSums = output_clustersSums.GetContinuousVector();
+	IntVector* ivFrequencies = output_clustersFrequencies.GetIntVector();
+
+	cvSums->SetSize(nbClusters * nbColumns);
+	cvSums->Initialize();
+	ivFrequencies->SetSize(nbClusters);
+	ivFrequencies->Initialize();
+
+	for (int nRow = 0; nRow < cvValues->GetSize() / nbColumns; nRow++) {
+
+		for (int nColumn = 0; nColumn < nbColumns; nColumn++)
+			slave_instanceValues[nColumn] = cvValues->GetAt(nRow * nbColumns + nColumn);
+
+		const int idxCluster = FindNearestCentroidIndex();
+
+		for (int nColumn = 0; nColumn < nbColumns; nColumn++)
+			cvSums->UpgradeAt(idxCluster * nbColumns + nColumn, slave_instanceValues[nColumn]);
+
+		ivFrequencies->UpgradeAt(idxCluster, 1);
+	}
+
+	return not TaskProgression::IsInterruptionRequested();
+}
+
+boolean KMMiniBatchTask::SlaveFinalize(boolean bProcessEndedCorrectly)
+{
+	if (slave_centroidsValues != NULL)
+		delete[] slave_centroidsValues;
+	if (slave_instanceValues != NULL)
+		delete[] slave_instanceValues;
+	slave_centroidsValues = NULL;
+	slave_instanceValues = NULL;
+
+	return true;
+}
+
+int KMMiniBatchTask::FindNearestCentroidIndex() const
+{
+	const int nbClusters = shared_clustersNumber;
+	const int nbColumns = shared_columnsNumber;
+	const int iDistanceType = shared_distanceType;
+	const KMParameters::DistanceType distanceType = static_cast<KMParameters::DistanceType>(iDistanceType);
+
+	int nearestClusterIndex = 0;
+	Continuous minimumDistance = KWContinuous::GetMaxValue();
+
+	for (int idxCluster = 0; idxCluster < nbClusters; idxCluster++) {
+
+		const Continuous distance = KMDistanceKernel::ComputeDistance(slave_instanceValues, slave_centroidsValues + idxCluster * nbColumns, nbColumns, distanceType);
+
+		if (distance < minimumDistance) {
+			minimumDistance = distance;
+			nearestClusterIndex = idxCluster;
+		}
+	}
+
+	return nearestClusterIndex;
+}
+
+const ALString KMMiniBatchTask::GetTaskName() const
+{
+	return "MLClusters mini-batch clustering";
+}
+
+PLParallelTask* KMMiniBatchTask::Create() const
+{
+	return new KMMiniBatchTask;
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "PLParallelTask.h"
+#include "KMParameters.h"
+#include "KMDenseMatrix.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Tache parallelisee de traitement d'un mini-batch deja lu en memoire (cf. KMMiniBatchReader) : le maitre decoupe les lignes de la matrice dense
+/// du mini-batch en tranches, chaque esclave affecte les instances de sa tranche au centroide le plus proche, et renvoie les sommes des valeurs K-Means
+/// et les effectifs des instances affectees a chaque cluster. Les resultats partiels sont cumules dans l'ordre des tranches, afin que le resultat
+/// ne depende pas de l'ordre de terminaison des esclaves. La base n'est pas relue : seules les valeurs K-Means du mini-batch sont transmises.
+
+class KMMiniBatchTask : public PLParallelTask
+{
+public:
+	// Constructeur
+	KMMiniBatchTask();
+	~KMMiniBatchTask();
+
+	/** calcul des sommes et effectifs des instances d'un mini-batch (lignes de la matrice dense, hors lignes ayant des valeurs manquantes)
+	affectees a chacun des centroides (lignes de la matrice des centroides, de memes colonnes) */
+	boolean ComputeClustersSums(const KMDenseMatrix* instancesMatrix, const KMDenseMatrix* centroidsMatrix, const int nClustersNumber,
+		const KMParameters::DistanceType distanceType);
+
+	/** sommes des valeurs K-Means des instances de chaque cluster : la valeur de la colonne j pour le cluster i est a l'index (i * nombre de colonnes + j) */
+	const ContinuousVector& GetClustersSums() const;
+
+	/** effectifs des instances affectees a chaque cluster */
+	const IntVector& GetClustersFrequencies() const;
+
+	/** nombre minimal de lignes d'une tranche : en deca, la transmission des valeurs coute plus que le calcul des distances */
+	static const int MIN_ROWS_BY_TASK;
+
+	//////////////////////////////////////////////////////////////////////////////
+	///// Implementation
+protected:
+
+	// Reimplementation des etapes du ParallelTask (methodes virtuelles)
+	const ALString GetTaskName() const override;
+	PLParallelTask* Create() const override;
+	boolean MasterInitialize() override;
+	boolean MasterPrepareTaskInput(double& dTaskPercent, boolean& bIsTaskFinished) override;
+	boolean MasterAggregateResults() override;
+	boolean MasterFinalize(boolean bProcessEndedCorrectly) override;
+	boolean SlaveInitialize() override;
+	boolean SlaveProcess() override;
+	boolean SlaveFinalize(boolean bProcessEndedCorrectly) override;
+
+	/** index du centroide le plus proche des valeurs de l'instance courante (slave_instanceValues) */
+	int FindNearestCentroidIndex() const;
+
+	// variables membres du maitre
+	const KMDenseMatrix* master_instancesMatrix;
+	const KMDenseMatrix* master_centroidsMatrix;
+	int master_clustersNumber;
+	int master_distanceType;
+
+	/** premiere ligne de la prochaine tranche, et nombre de lignes par tranche */
+	int master_nextRow;
+	int master_rowsByTask;
+
+	/** sommes partielles de chaque tranche (ContinuousVector *), rangees selon l'index de tache, et cumulees en fin de tache */
+	ObjectArray master_tasksSums;
+
+	ContinuousVector master_clustersSums;
+	IntVector master_clustersFrequencies;
+
+	// variables membres des esclaves
+	/** copie contigue des centroides (un centroide par ligne) et des valeurs K-Means de l'instance courante, pour le calcul vectorise des distances */
+	Continuous* slave_centroidsValues;
+	Continuous* slave_instanceValues;
+
+	// variables partagees
+	PLShared_Int shared_distanceType;
+	PLShared_Int shared_clustersNumber;
+	PLShared_Int shared_columnsNumber;
+	PLShared_ContinuousVector shared_centroids;
+
+	/** valeurs K-Means des instances de la tranche, une ligne a la suite de l'autre */
+	PLShared_ContinuousVector input_instancesValues;
+
+	PLShared_ContinuousVector output_clustersSums;
+	PLShared_IntVector output_clustersFrequencies;
+};
+
+inline const ContinuousVector& KMMiniBatchTask::GetClustersSums() const {
+	return master_clustersSums;
+}
+
+inline const IntVector& KMMiniBatchTask::GetClustersFrequencies() const {
+	return master_clustersFrequencies;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMMissingValuesIndex.h"
+#include "KMParameters.h"
+
+const int KMMissingValuesIndex::MAX_INDEX_BY_INSTANCE = 16;
+
+KMMissingValuesIndex::KMMissingValuesIndex()
+{
+	oaSourceInstances = NULL;
+	nInstanceNumber = 0;
+}
+
+KMMissingValuesIndex::~KMMissingValuesIndex()
+{
+}
+
+boolean KMMissingValuesIndex::Initialize(const ObjectArray* instances, const KMParameters* parameters)
+{
+	require(instances != NULL);
+	require(parameters != NULL);
+
+	RemoveAll();
+
+	// dimensionnement selon le plus grand index de creation
+	longint lMaxIndex = -1;
+	for (int i = 0; i < instances->GetSize(); i++) {
+
+		const longint lIndex = cast(KWObject*, instances->GetAt(i))->GetCreationIndex();
+
+		if (lIndex < 0)
+			return false;
+		if (lIndex > lMaxIndex)
+			lMaxIndex = lIndex;
+	}
+
+	if (lMaxIndex >= (longint)MAX_INDEX_BY_INSTANCE * instances->GetSize() + MAX_INDEX_BY_INSTANCE)
+		return false;
+
+	const int nIndexNumber = (int)(lMaxIndex + 1);
+
+	oaIndexedInstances.SetSize(nIndexNumber);
+	ivMissingKMeanValueBits.SetSize((nIndexNumber + 31) / 32);
+	ivMissingNativeValueBits.SetSize((nIndexNumber + 31) / 32);
+
+	const boolean bHasNativeAttributes = (parameters->GetNativeAttributesLoadIndexes().GetSize() > 0);
+
+	for (int i = 0; i < instances->GetSize(); i++) {
+
+		KWObject* instance = cast(KWObject*, instances->GetAt(i));
+		const int nIndex = (int)instance->GetCreationIndex();
+
+		// un index de creation en double ne permet pas de retrouver les instances
+		if (oaIndexedInstances.GetAt(nIndex) != NULL) {
+			RemoveAll();
+			return false;
+		}
+		oaIndexedInstances.SetAt(nIndex, instance);
+
+		if (parameters->HasMissingKMeanValue(instance))
+			SetBit(ivMissingKMeanValueBits, nIndex);
+		else
+			oaCompleteInstances.Add(instance);
+
+		if (bHasNativeAttributes and parameters->HasMissingNativeValue(instance))
+			SetBit(ivMissingNativeValueBits, nIndex);
+	}
+
+	oaSourceInstances = instances;
+	nInstanceNumber = instances->GetSize();
+
+	return true;
+}
+
+boolean KMMissingValuesIndex::IsIndexing(const ObjectArray* instances) const
+{
+	return instances != NULL and instances == oaSourceInstances and instances->GetSize() == nInstanceNumber;
+}
+
+void KMMissingValuesIndex::RemoveAll()
+{
+	oaIndexedInstances.SetSize(0);
+	ivMissingKMeanValueBits.SetSize(0);
+	ivMissingNativeValueBits.SetSize(0);
+	oaCompleteInstances.SetSize(0);
+	oaSourceInstances = NULL;
+	nInstanceNumber = 0;
+}
+
+void KMMissingValuesIndex::SetBit(IntVector& ivBits, const int nIndex)
+{
+	const unsigned int nWord = (unsigned int)ivBits.GetAt(nIndex / 32) | (1u << (nIndex % 32));
+	ivBits.SetAt(nIndex / 32, (int)nWord);
+}
+
+longint KMMissingValuesIndex::GetUsedMemory() const
+{
+	return sizeof(KMMissingValuesIndex) + oaIndexedInstances.GetUsedMemory() - sizeof(ObjectArray) + ivMissingKMeanValueBits.GetUsedMemory() - sizeof(IntVector) +
+	       ivMissingNativeValueBits.GetUsedMemory() - sizeof(IntVector) + oaCompleteInstances.GetUsedMemory() - sizeof(ObjectArray);
+}
+
+const ALString KMMissingValuesIndex::GetClassLabel() const
+{
+	return "Missing values index";
+}
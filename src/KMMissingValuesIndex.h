@@ -0,0 +1,107 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "Vector.h"
+#include "KWObject.h"
+
+class KMParameters;
+
+////////////////////////////////////////////////////////////////////////////////
+/// Valeurs manquantes des instances d'une base, calculees une fois pour toutes apres la lecture de la base : pour chaque instance, un bit indique
+/// la presence d'une valeur manquante parmi les attributs K-Means, et un autre parmi les attributs natifs (bitmaps de 32 instances par entier).
+/// Les instances sont reperees par leur index de creation, qui sert d'index dans les bitmaps : la recherche d'une instance se fait en temps constant,
+/// sans parcours de ses attributs. Une instance non indexee (issue d'une autre lecture de base, par exemple) n'est pas reconnue.
+/// La liste des instances completes (sans valeur K-Means manquante) est egalement memorisee, dans l'ordre de la base.
+
+class KMMissingValuesIndex : public Object
+{
+public:
+
+	KMMissingValuesIndex();
+	~KMMissingValuesIndex();
+
+	/** calcul des valeurs manquantes des instances d'une base, selon les attributs K-Means et natifs du parametrage.
+	Retourne false si les index de creation des instances ne permettent pas de les indexer (index en double, ou trop disperses) */
+	boolean Initialize(const ObjectArray* instances, const KMParameters* parameters);
+
+	/** index d'une instance dans les bitmaps (-1 si l'instance n'est pas indexee) */
+	int GetInstanceIndex(const KWObject* instance) const;
+
+	/** presence d'une valeur manquante parmi les attributs K-Means, ou parmi les attributs natifs, pour un index d'instance valide */
+	boolean HasMissingKMeanValueAt(const int nIndex) const;
+	boolean HasMissingNativeValueAt(const int nIndex) const;
+
+	/** indique si les instances d'un tableau sont celles qui ont ete indexees (eventuellement dans un autre ordre) */
+	boolean IsIndexing(const ObjectArray* instances) const;
+
+	/** instances sans valeur K-Means manquante, dans l'ordre de la base */
+	const ObjectArray* GetCompleteInstances() const;
+
+	/** nombre d'instances indexees */
+	int GetInstanceNumber() const;
+
+	/** suppression de l'index */
+	void RemoveAll();
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+	/** dispersion maximale des index de creation : au dela de MAX_INDEX_BY_INSTANCE index par instance, l'indexation est abandonnee */
+	static const int MAX_INDEX_BY_INSTANCE;
+
+protected:
+
+	/** positionnement d'un bit d'un bitmap */
+	static void SetBit(IntVector& ivBits, const int nIndex);
+	static boolean GetBit(const IntVector& ivBits, const int nIndex);
+
+	/** tableau indexe par les index de creation : instance correspondante (NULL si aucune) */
+	ObjectArray oaIndexedInstances;
+
+	/** bitmaps des instances ayant une valeur manquante, parmi les attributs K-Means et parmi les attributs natifs */
+	IntVector ivMissingKMeanValueBits;
+	IntVector ivMissingNativeValueBits;
+
+	/** instances sans valeur K-Means manquante */
+	ObjectArray oaCompleteInstances;
+
+	/** tableau d'instances indexe, et son nombre d'instances lors de l'indexation */
+	const ObjectArray* oaSourceInstances;
+	int nInstanceNumber;
+};
+
+inline int KMMissingValuesIndex::GetInstanceIndex(const KWObject* instance) const {
+	assert(instance != NULL);
+
+	const longint lIndex = instance->GetCreationIndex();
+
+	if (lIndex < 0 or lIndex >= oaIndexedInstances.GetSize() or oaIndexedInstances.GetAt((int)lIndex) != instance)
+		return -1;
+
+	return (int)lIndex;
+}
+
+inline boolean KMMissingValuesIndex::GetBit(const IntVector& ivBits, const int nIndex) {
+	return (ivBits.GetAt(nIndex / 32) & (1u << (nIndex % 32))) != 0;
+}
+
+inline boolean KMMissingValuesIndex::HasMissingKMeanValueAt(const int nIndex) const {
+	return GetBit(ivMissingKMeanValueBits, nIndex);
+}
+
+inline boolean KMMissingValuesIndex::HasMissingNativeValueAt(const int nIndex) const {
+	return GetBit(ivMissingNativeValueBits, nIndex);
+}
+
+inline const ObjectArray* KMMissingValuesIndex::GetCompleteInstances() const {
+	return &oaCompleteInstances;
+}
+
+inline int KMMissingValuesIndex::GetInstanceNumber() const {
+	return nInstanceNumber;
+}
@@ -4,6 +4,9 @@
 
 #include "KMParameters.h"
 #include "KMParametersView.h"
+#include "KMDRNearestCentroid.h"
+#include "KMQuantileSketch.h"
+#include <thread>
 
 
 KMParameters::KMParameters()
@@ -29,11 +32,21 @@ KMParameters::KMParameters()
 	iLearningNumberOfReplicates = REPLICATE_NUMBER_DEFAULT_VALUE;
 	iMiniBatchSize = MINI_BATCH_SIZE_DEFAULT_VALUE;
 	iPostOptimizationVnsLevel = 0;
+	iPostOptimizationNeighborsNumber = POST_OPTIMIZATION_NEIGHBORS_DEFAULT_VALUE;
+	iPostOptimizationVnsTimeLimit = 0;
+	iMedianSketchCapacity = KMQuantileSketch::DEFAULT_CAPACITY;
 	iBisectingNumberOfReplicates = REPLICATE_NUMBER_DEFAULT_VALUE;
 	replicateChoice = ReplicateChoice::ReplicateChoiceAutomaticallyComputed;
 	localModelType = LocalModelType::None;
 	bVerboseMode = false;
 	bParallelMode = false;
+	bDenseInstancesMatrix = true;
+	bSparseInstancesMatrix = true;
+	bBoundsPruning = false;
+	bKMeanParallelSeeding = false;
+	bSinglePassEvaluation = false;
+	bDistanceAttributesOutput = false;
+	nThreadsNumber = 0;
 	bMiniBatchMode = false;
 	replicatePostOptimization = NoOptimization;
 	bBisectingVerboseMode = false;
@@ -41,6 +54,7 @@ KMParameters::KMParameters()
 	bLocalModelUseMODL = true;
 	iMaxEvaluatedAttributesNumber = 0;
 	idClusterAttribute = NULL;
+	missingValuesIndex = NULL;
 	bKeepNulLevelVariables = false;
 }
 
@@ -190,6 +204,13 @@ void KMParameters::CopyFrom(const KMParameters* aSource)
 	bSupervisedMode = aSource->bSupervisedMode;
 	bVerboseMode = aSource->bVerboseMode;
 	bParallelMode = aSource->bParallelMode;
+	bDenseInstancesMatrix = aSource->bDenseInstancesMatrix;
+	bSparseInstancesMatrix = aSource->bSparseInstancesMatrix;
+	bBoundsPruning = aSource->bBoundsPruning;
+	bKMeanParallelSeeding = aSource->bKMeanParallelSeeding;
+	bSinglePassEvaluation = aSource->bSinglePassEvaluation;
+	bDistanceAttributesOutput = aSource->bDistanceAttributesOutput;
+	nThreadsNumber = aSource->nThreadsNumber;
 	bMiniBatchMode = aSource->bMiniBatchMode;
 	replicatePostOptimization = aSource->replicatePostOptimization;
 	bBisectingVerboseMode = aSource->bBisectingVerboseMode;
@@ -214,6 +235,9 @@ void KMParameters::CopyFrom(const KMParameters* aSource)
 	iLearningNumberOfReplicates = aSource->iLearningNumberOfReplicates;
 	iMiniBatchSize = aSource->iMiniBatchSize;
 	iPostOptimizationVnsLevel = aSource->iPostOptimizationVnsLevel;
+	iPostOptimizationNeighborsNumber = aSource->iPostOptimizationNeighborsNumber;
+	iPostOptimizationVnsTimeLimit = aSource->iPostOptimizationVnsTimeLimit;
+	iMedianSketchCapacity = aSource->iMedianSketchCapacity;
 	iBisectingNumberOfReplicates = aSource->iBisectingNumberOfReplicates;
 	replicateChoice = aSource->replicateChoice;
 	localModelType = aSource->localModelType;
@@ -831,14 +855,30 @@ const ALString KMParameters::GetClassLabel() const
 
 void KMParameters::PrepareDeploymentClass(KWClass* modelingClass) {
 
+	// les attributs de distance aux clusters ne sont indispensables que pour les dictionnaires dont l'attribut d'identifiant
+	// de cluster est calcule par une regle ArgMin : avec une regle NearestCentroid, les distances ne sont calculees que si elles sont utilisees
+	boolean bDistanceAttributesNeeded = true;
+
 	KWAttribute* attribute = modelingClass->GetHeadAttribute();
 
+	while (attribute != NULL) {
+
+		if (attribute->GetConstMetaData()->IsKeyPresent(KMPredictor::ID_CLUSTER_METADATA) and
+			attribute->GetDerivationRule() != NULL and
+			attribute->GetDerivationRule()->GetName() == KMDRNearestCentroid().GetName())
+			bDistanceAttributesNeeded = false;
+
+		modelingClass->GetNextAttribute(attribute);
+	}
+
+	attribute = modelingClass->GetHeadAttribute();
+
 	while (attribute != NULL) {
 
 		// charger les attributs supplementaires indispensables a l'evaluation
 		if (attribute->GetConstMetaData()->IsKeyPresent(KM_ATTRIBUTE_LABEL) or
 			attribute->GetConstMetaData()->IsKeyPresent(KMPredictor::ID_CLUSTER_METADATA) or
-			attribute->GetConstMetaData()->IsKeyPresent(KMPredictor::DISTANCE_CLUSTER_LABEL)) {
+			(bDistanceAttributesNeeded and attribute->GetConstMetaData()->IsKeyPresent(KMPredictor::DISTANCE_CLUSTER_LABEL))) {
 
 			attribute->SetUsed(true);
 			attribute->SetLoaded(true);
@@ -897,6 +937,81 @@ void  KMParameters::SetVerboseMode(boolean b) {
 void  KMParameters::SetParallelMode(boolean b) {
 	bParallelMode = b;
 }
+const boolean  KMParameters::GetDenseInstancesMatrix() const {
+	return bDenseInstancesMatrix;
+}
+void  KMParameters::SetDenseInstancesMatrix(boolean b) {
+	bDenseInstancesMatrix = b;
+}
+const boolean  KMParameters::GetSparseInstancesMatrix() const {
+	return bSparseInstancesMatrix;
+}
+void  KMParameters::SetSparseInstancesMatrix(boolean b) {
+	bSparseInstancesMatrix = b;
+}
+const boolean  KMParameters::GetBoundsPruning() const {
+	return bBoundsPruning;
+}
+void  KMParameters::SetBoundsPruning(boolean b) {
+	bBoundsPruning = b;
+}
+const boolean  KMParameters::GetKMeanParallelSeeding() const {
+	return bKMeanParallelSeeding;
+}
+void  KMParameters::SetKMeanParallelSeeding(boolean b) {
+	bKMeanParallelSeeding = b;
+}
+const boolean  KMParameters::GetSinglePassEvaluation() const {
+	return bSinglePassEvaluation;
+}
+void  KMParameters::SetSinglePassEvaluation(boolean b) {
+	bSinglePassEvaluation = b;
+}
+const boolean  KMParameters::GetDistanceAttributesOutput() const {
+	return bDistanceAttributesOutput;
+}
+void  KMParameters::SetDistanceAttributesOutput(boolean b) {
+	bDistanceAttributesOutput = b;
+}
+const int  KMParameters::GetThreadsNumber() const {
+	return nThreadsNumber;
+}
+void  KMParameters::SetThreadsNumber(int n) {
+	nThreadsNumber = n;
+}
+const int  KMParameters::GetEffectiveThreadsNumber() const {
+
+	// un nombre de threads explicite s'applique independamment du mode parallele
+	if (nThreadsNumber > 0)
+		return (nThreadsNumber > THREADS_NUMBER_MAX_VALUE ? THREADS_NUMBER_MAX_VALUE : nThreadsNumber);
+
+	// nombre de threads automatique : tous les coeurs en mode parallele, un seul sinon
+	if (not bParallelMode)
+		return 1;
+
+	const int nCores = (int)std::thread::hardware_concurrency();
+	if (nCores <= 0)
+		return 1;
+	return (nCores > THREADS_NUMBER_MAX_VALUE ? THREADS_NUMBER_MAX_VALUE : nCores);
+}
+const int  KMParameters::GetPostOptimizationNeighborsNumber() const {
+	return iPostOptimizationNeighborsNumber;
+}
+void  KMParameters::SetPostOptimizationNeighborsNumber(int n) {
+	iPostOptimizationNeighborsNumber = n;
+}
+const int  KMParameters::GetPostOptimizationVnsTimeLimit() const {
+	return iPostOptimizationVnsTimeLimit;
+}
+void  KMParameters::SetPostOptimizationVnsTimeLimit(int n) {
+	iPostOptimizationVnsTimeLimit = n;
+}
+const int  KMParameters::GetMedianSketchCapacity() const {
+	return iMedianSketchCapacity;
+}
+void  KMParameters::SetMedianSketchCapacity(int n) {
+	iMedianSketchCapacity = n;
+}
 const KMParameters::ReplicatePostOptimization  KMParameters::GetReplicatePostOptimization() const {
 	return replicatePostOptimization;
 }
@@ -1024,6 +1139,22 @@ boolean KMParameters::Check()
 		AddError("Post optimization VNS level must be >= 0.");
 		bOk = false;
 	}
+	if (GetPostOptimizationNeighborsNumber() < 0) {
+		AddError("Post optimization nearest clusters number must be >= 0.");
+		bOk = false;
+	}
+	if (GetThreadsNumber() < 0 or GetThreadsNumber() > THREADS_NUMBER_MAX_VALUE) {
+		AddError("Threads number must be between 0 and " + ALString(IntToString(THREADS_NUMBER_MAX_VALUE)) + ".");
+		bOk = false;
+	}
+	if (GetPostOptimizationVnsTimeLimit() < 0) {
+		AddError("Post optimization VNS time limit must be >= 0.");
+		bOk = false;
+	}
+	if (GetMedianSketchCapacity() < 2) {
+		AddError("Median sketch capacity must be >= 2.");
+		bOk = false;
+	}
 
 	return bOk;
 }
@@ -1067,6 +1198,10 @@ const ALString KMParameters::SELECTED_NATIVE_ATTRIBUTE_LABEL = "SelectedNativeAt
 const int KMParameters::K_MAX_VALUE = 50000;
 const int KMParameters::REPLICATE_NUMBER_MAX_VALUE = 1000;
 const int KMParameters::MINI_BATCH_SIZE_MAX_VALUE = 10000000;
+const int KMParameters::THREADS_NUMBER_MAX_VALUE = 256;
+const int KMParameters::POST_OPTIMIZATION_NEIGHBORS_DEFAULT_VALUE = 16;
+const int KMParameters::KMEAN_PARALLEL_ROUNDS = 5;
+const int KMParameters::MINI_BATCHES_BY_SHUFFLED_BLOCK = 4;
 const int KMParameters::K_DEFAULT_VALUE = 1;
 const int KMParameters::MAX_ITERATIONS = 1000;
 const int KMParameters::EPSILON_MAX_ITERATIONS_DEFAULT_VALUE = 5;
@@ -7,6 +7,7 @@
 #include "Object.h"
 #include "KWClass.h"
 #include "KWPredictorReport.h"
+#include "KMMissingValuesIndex.h"
 
 int KMCompareLabels(const void* elem1, const void* elem2);
 
@@ -209,6 +210,21 @@ public:
 	const int GetPostOptimizationVnsLevel() const;
 	void SetPostOptimizationVnsLevel(int nValue);
 
+	/** duree maximale de la post-optimisation VNS, en secondes (0 = pas de limite). La recherche VNS reste sequentielle (une seule chaine) :
+	seule sa duree est bornee */
+	const int GetPostOptimizationVnsTimeLimit() const;
+	void SetPostOptimizationVnsTimeLimit(int nValue);
+
+	/** capacite des resumes de quantiles servant au calcul des medianes des statistiques detaillees (cf. KMQuantileSketch) :
+	l'erreur de rang des medianes est de l'ordre de 1 / capacite, pour une memoire de moins de 3 * capacite valeurs par cluster et par attribut natif */
+	const int GetMedianSketchCapacity() const;
+	void SetMedianSketchCapacity(int nValue);
+
+	/** nombre de clusters les plus proches memorises par instance, pour la post-optimisation (0 = tous les clusters).
+	Les listes epuisees par les suppressions de clusters sont recalculees a la demande */
+	const int GetPostOptimizationNeighborsNumber() const;
+	void SetPostOptimizationNeighborsNumber(int nValue);
+
 	/** nbre de fois que les replicates bisecting doivent etre executes */
 	const int GetBisectingNumberOfReplicates() const;
 	void SetBisectingNumberOfReplicates(int nValue);
@@ -225,6 +241,43 @@ public:
 	const boolean GetParallelMode() const;
 	void SetParallelMode(boolean nValue);
 
+	/** flag d'utilisation d'une matrice dense des valeurs K-Means des instances, lors des iterations des replicates (si la memoire disponible le permet) */
+	const boolean GetDenseInstancesMatrix() const;
+	void SetDenseInstancesMatrix(boolean nValue);
+
+	/** flag d'utilisation d'une matrice creuse a la place des valeurs de la matrice dense des instances, lorsque la proportion de valeurs K-Means non nulles
+	est faible (pretraitements Binarization, HammingConditionalInfo ou EntropyWithPriors sur des attributs categoriels, par exemple) : distances, centroides
+	et statistiques d'iterations sont alors calcules a partir des seules valeurs non nulles, et les valeurs denses ne sont pas allouees.
+	Active par defaut (sans effet si la matrice dense des instances n'est pas utilisee) */
+	const boolean GetSparseInstancesMatrix() const;
+	void SetSparseInstancesMatrix(boolean nValue);
+
+	/** flag d'utilisation de bornes de distances (algorithme de Hamerly) pour eviter des calculs de distances lors de l'affectation des instances aux clusters
+	(normes L1 et L2, et matrice dense des instances utilisee) */
+	const boolean GetBoundsPruning() const;
+	void SetBoundsPruning(boolean nValue);
+
+	/** flag d'utilisation de l'algorithme KMean|| (sur-echantillonnage des centres candidats en quelques passes sur les instances) pour les initialisations KMean++ et KMean++R, adapte aux grandes valeurs de K */
+	const boolean GetKMeanParallelSeeding() const;
+	void SetKMeanParallelSeeding(boolean nValue);
+
+	/** flag d'evaluation en une seule lecture de base : les sommes de distances et inerties intra sont deduites de statistiques suffisantes
+	collectees lors de la lecture (exactes en normes L2 et cosinus, estimees en norme L1), au lieu d'une seconde lecture de base */
+	const boolean GetSinglePassEvaluation() const;
+	void SetSinglePassEvaluation(boolean nValue);
+
+	/** flag de generation, dans le dictionnaire de modelisation, d'un attribut de distance par cluster (DistanceCluster_*). L'affectation au cluster
+	et la relecture des centroides n'en dependent pas : ces K attributs, de d operandes chacun, ne sont generes que s'ils sont explicitement demandes */
+	const boolean GetDistanceAttributesOutput() const;
+	void SetDistanceAttributesOutput(boolean nValue);
+
+	/** nombre de threads utilises pour les calculs en memoire partagee (0 = automatique : nombre de coeurs de la machine en mode parallele, un seul thread sinon) */
+	const int GetThreadsNumber() const;
+	void SetThreadsNumber(int nValue);
+
+	/** nombre de threads effectivement utilisable (tient compte du mode parallele et du nombre de coeurs, si nombre de threads automatique) */
+	const int GetEffectiveThreadsNumber() const;
+
 	/** post-optimisation de replicate */
 	const ReplicatePostOptimization GetReplicatePostOptimization() const;
 	void SetReplicatePostOptimization(ReplicatePostOptimization);
@@ -285,6 +338,11 @@ public:
 	/** retrouver le rang d'un attribut (dans les centroides) a partir de son index de chargement valide */
 	const int GetAttributeRankFromLoadIndex(const KWLoadIndex&) const;
 
+	/** index des valeurs manquantes des instances de la base d'apprentissage, calcule apres sa lecture (non possede, NULL si aucun).
+	Pour les instances indexees, HasMissingKMeanValue et HasMissingNativeValue le consultent au lieu de parcourir les attributs */
+	void SetMissingValuesIndex(const KMMissingValuesIndex*);
+	const KMMissingValuesIndex* GetMissingValuesIndex() const;
+
 	/** determine si l'objet pass en parametre a une valeur manquante parmi ses attributs aprs recodage */
 	bool HasMissingKMeanValue(const KWObject*) const;
 
@@ -328,6 +386,10 @@ public:
 	static const int K_DEFAULT_VALUE;
 	static const int REPLICATE_NUMBER_MAX_VALUE;
 	static const int MINI_BATCH_SIZE_MAX_VALUE;
+	static const int THREADS_NUMBER_MAX_VALUE;
+	static const int POST_OPTIMIZATION_NEIGHBORS_DEFAULT_VALUE;
+	static const int KMEAN_PARALLEL_ROUNDS;
+	static const int MINI_BATCHES_BY_SHUFFLED_BLOCK;
 	static const int MAX_ITERATIONS;
 	static const int EPSILON_MAX_ITERATIONS;
 	static const int EPSILON_MAX_ITERATIONS_DEFAULT_VALUE;
@@ -388,6 +450,13 @@ protected:
 	boolean bSupervisedMode;
 	boolean bVerboseMode;
 	boolean bParallelMode;
+	boolean bDenseInstancesMatrix;
+	boolean bSparseInstancesMatrix;
+	boolean bBoundsPruning;
+	boolean bKMeanParallelSeeding;
+	boolean bSinglePassEvaluation;
+	boolean bDistanceAttributesOutput;
+	int nThreadsNumber;
 	boolean bMiniBatchMode;
 	boolean bBisectingVerboseMode;
 	boolean bWriteDetailedStatistics;
@@ -403,6 +472,9 @@ protected:
 	int iLearningNumberOfReplicates;
 	int iMiniBatchSize;
 	int iPostOptimizationVnsLevel;
+	int iPostOptimizationNeighborsNumber;
+	int iPostOptimizationVnsTimeLimit;
+	int iMedianSketchCapacity;
 	int iBisectingNumberOfReplicates;
 	ClusteringType clusteringType;
 	DistanceType distanceType;
@@ -435,6 +507,8 @@ protected:
 	ALString asMainTargetModality;
 
 	KWAttribute* idClusterAttribute;
+
+	const KMMissingValuesIndex* missingValuesIndex;
 };
 
 
@@ -681,8 +755,23 @@ inline const KWAttribute* KMParameters::GetIdClusterAttribute() const {
 	return idClusterAttribute;
 }
 
+inline void KMParameters::SetMissingValuesIndex(const KMMissingValuesIndex* index) {
+	missingValuesIndex = index;
+}
+
+inline const KMMissingValuesIndex* KMParameters::GetMissingValuesIndex() const {
+	return missingValuesIndex;
+}
+
 inline bool KMParameters::HasMissingKMeanValue(const KWObject* o) const {
 
+	// valeur precalculee, pour une instance de la base d'apprentissage
+	if (missingValuesIndex != NULL) {
+		const int nIndex = missingValuesIndex->GetInstanceIndex(o);
+		if (nIndex != -1)
+			return missingValuesIndex->HasMissingKMeanValueAt(nIndex);
+	}
+
 	// controle des valeurs manquantes, parmi les attributs servant  calculer le K-Means
 	// (ce sont des continuous, en principe recods, sauf si on a choisi de ne pas faire de pretraitement)
 
@@ -699,6 +788,13 @@ inline bool KMParameters::HasMissingKMeanValue(const KWObject* o) const {
 
 inline bool KMParameters::HasMissingNativeValue(const KWObject* o) const {
 
+	// valeur precalculee, pour une instance de la base d'apprentissage
+	if (missingValuesIndex != NULL) {
+		const int nIndex = missingValuesIndex->GetInstanceIndex(o);
+		if (nIndex != -1)
+			return missingValuesIndex->HasMissingNativeValueAt(nIndex);
+	}
+
 	// controle des valeurs manquantes, parmi les attributs natifs :
 
 	const int size = GetNativeAttributesLoadIndexes().GetSize();
@@ -3,6 +3,7 @@
 // at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
 
 #include "KMParametersView.h"
+#include "KMQuantileSketch.h"
 
 KMParametersView::KMParametersView()
 {
@@ -39,6 +40,16 @@ KMParametersView::KMParametersView()
 	AddIntField(BISECTING_MAX_ITERATIONS_FIELD_NAME, BISECTING_MAX_ITERATIONS_LABEL, 0);
 	AddBooleanField(KEEP_NUL_LEVEL_FIELD_NAME, KEEP_NUL_LEVEL_LABEL, false);
 	AddBooleanField(PARALLEL_MODE_FIELD_NAME, PARALLEL_MODE_LABEL, false);
+	AddBooleanField(DENSE_INSTANCES_MATRIX_FIELD_NAME, DENSE_INSTANCES_MATRIX_LABEL, true);
+	AddBooleanField(SPARSE_INSTANCES_MATRIX_FIELD_NAME, SPARSE_INSTANCES_MATRIX_LABEL, true);
+	AddIntField(THREADS_NUMBER_FIELD_NAME, THREADS_NUMBER_LABEL, 0);
+	AddBooleanField(BOUNDS_PRUNING_FIELD_NAME, BOUNDS_PRUNING_LABEL, false);
+	AddBooleanField(KMEAN_PARALLEL_SEEDING_FIELD_NAME, KMEAN_PARALLEL_SEEDING_LABEL, false);
+	AddBooleanField(SINGLE_PASS_EVALUATION_FIELD_NAME, SINGLE_PASS_EVALUATION_LABEL, false);
+	AddBooleanField(DISTANCE_ATTRIBUTES_OUTPUT_FIELD_NAME, DISTANCE_ATTRIBUTES_OUTPUT_LABEL, false);
+	AddIntField(POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME, POST_OPTIMIZATION_NEIGHBORS_NUMBER_LABEL, KMParameters::POST_OPTIMIZATION_NEIGHBORS_DEFAULT_VALUE);
+	AddIntField(POST_OPTIMIZATION_VNS_TIME_LIMIT_FIELD_NAME, POST_OPTIMIZATION_VNS_TIME_LIMIT_LABEL, 0);
+	AddIntField(MEDIAN_SKETCH_CAPACITY_FIELD_NAME, MEDIAN_SKETCH_CAPACITY_LABEL, KMQuantileSketch::DEFAULT_CAPACITY);
 
 	// Parametrage des styles;
 	GetFieldAt(K_FIELD_NAME)->SetStyle("Spinner");
@@ -57,6 +68,10 @@ KMParametersView::KMParametersView()
 	GetFieldAt(MAX_ITERATIONS_FIELD_NAME)->SetStyle("Spinner");
 	GetFieldAt(BISECTING_MAX_ITERATIONS_FIELD_NAME)->SetStyle("Spinner");
 	GetFieldAt(BISECTING_REPLICATE_NUMBER_FIELD_NAME)->SetStyle("Spinner");
+	GetFieldAt(THREADS_NUMBER_FIELD_NAME)->SetStyle("Spinner");
+	GetFieldAt(POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME)->SetStyle("Spinner");
+	GetFieldAt(POST_OPTIMIZATION_VNS_TIME_LIMIT_FIELD_NAME)->SetStyle("Spinner");
+	GetFieldAt(MEDIAN_SKETCH_CAPACITY_FIELD_NAME)->SetStyle("Spinner");
 	GetFieldAt(CLUSTERS_CENTERS_FIELD_NAME)->SetStyle("ComboBox");
 	GetFieldAt(EPSILON_MAX_ITERATIONS_FIELD_NAME)->SetStyle("Spinner");
 	GetFieldAt(PREPROCESSING_MAX_INTERVAL_FIELD_NAME)->SetStyle("Spinner");
@@ -161,6 +176,13 @@ KMParametersView::KMParametersView()
 
 	cast(UIIntElement*, GetFieldAt(POST_OPTIMIZATION_VNS_LEVEL_FIELD_NAME))->SetMinValue(0);
 
+	cast(UIIntElement*, GetFieldAt(POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME))->SetMinValue(0);
+	cast(UIIntElement*, GetFieldAt(POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME))->SetMaxValue(KMParameters::K_MAX_VALUE);
+
+	cast(UIIntElement*, GetFieldAt(POST_OPTIMIZATION_VNS_TIME_LIMIT_FIELD_NAME))->SetMinValue(0);
+
+	cast(UIIntElement*, GetFieldAt(MEDIAN_SKETCH_CAPACITY_FIELD_NAME))->SetMinValue(2);
+
 	cast(UIDoubleElement*, GetFieldAt(EPSILON_VALUE_FIELD_NAME))->SetMinValue(0);
 
 	cast(UIIntElement*, GetFieldAt(EPSILON_MAX_ITERATIONS_FIELD_NAME))->SetMinValue(0);
@@ -175,6 +197,9 @@ KMParametersView::KMParametersView()
 	cast(UIIntElement*, GetFieldAt(BISECTING_REPLICATE_NUMBER_FIELD_NAME))->SetMinValue(1);
 	cast(UIIntElement*, GetFieldAt(BISECTING_REPLICATE_NUMBER_FIELD_NAME))->SetMaxValue(KMParameters::REPLICATE_NUMBER_MAX_VALUE);
 
+	cast(UIIntElement*, GetFieldAt(THREADS_NUMBER_FIELD_NAME))->SetMinValue(0);
+	cast(UIIntElement*, GetFieldAt(THREADS_NUMBER_FIELD_NAME))->SetMaxValue(KMParameters::THREADS_NUMBER_MAX_VALUE);
+
 	cast(UIIntElement*, GetFieldAt(PREPROCESSING_SUPERVISED_MAX_INTERVAL_FIELD_NAME))->SetMinValue(0);
 	cast(UIIntElement*, GetFieldAt(PREPROCESSING_SUPERVISED_MAX_GROUP_FIELD_NAME))->SetMinValue(0);
 
@@ -217,6 +242,16 @@ KMParametersView::KMParametersView()
 	GetFieldAt(PREPROCESSING_SUPERVISED_MAX_GROUP_FIELD_NAME)->SetVisible(GetLearningExpertMode());
 	GetFieldAt(MINI_BATCH_MODE_FIELD_NAME)->SetVisible(GetLearningExpertMode());
 	GetFieldAt(PARALLEL_MODE_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(DENSE_INSTANCES_MATRIX_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(SPARSE_INSTANCES_MATRIX_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(THREADS_NUMBER_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(BOUNDS_PRUNING_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(KMEAN_PARALLEL_SEEDING_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(SINGLE_PASS_EVALUATION_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(DISTANCE_ATTRIBUTES_OUTPUT_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(POST_OPTIMIZATION_VNS_TIME_LIMIT_FIELD_NAME)->SetVisible(GetLearningExpertMode());
+	GetFieldAt(MEDIAN_SKETCH_CAPACITY_FIELD_NAME)->SetVisible(GetLearningExpertMode());
 }
 
 
@@ -253,6 +288,16 @@ void KMParametersView::EventUpdate(Object* object)
 	editedObject->SetEpsilonMaxIterations(GetIntValueAt(EPSILON_MAX_ITERATIONS_FIELD_NAME));
 	editedObject->SetVerboseMode(GetBooleanValueAt(VERBOSE_MODE_FIELD_NAME));
 	editedObject->SetParallelMode(GetBooleanValueAt(PARALLEL_MODE_FIELD_NAME));
+	editedObject->SetDenseInstancesMatrix(GetBooleanValueAt(DENSE_INSTANCES_MATRIX_FIELD_NAME));
+	editedObject->SetSparseInstancesMatrix(GetBooleanValueAt(SPARSE_INSTANCES_MATRIX_FIELD_NAME));
+	editedObject->SetThreadsNumber(GetIntValueAt(THREADS_NUMBER_FIELD_NAME));
+	editedObject->SetBoundsPruning(GetBooleanValueAt(BOUNDS_PRUNING_FIELD_NAME));
+	editedObject->SetKMeanParallelSeeding(GetBooleanValueAt(KMEAN_PARALLEL_SEEDING_FIELD_NAME));
+	editedObject->SetSinglePassEvaluation(GetBooleanValueAt(SINGLE_PASS_EVALUATION_FIELD_NAME));
+	editedObject->SetDistanceAttributesOutput(GetBooleanValueAt(DISTANCE_ATTRIBUTES_OUTPUT_FIELD_NAME));
+	editedObject->SetPostOptimizationNeighborsNumber(GetIntValueAt(POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME));
+	editedObject->SetPostOptimizationVnsTimeLimit(GetIntValueAt(POST_OPTIMIZATION_VNS_TIME_LIMIT_FIELD_NAME));
+	editedObject->SetMedianSketchCapacity(GetIntValueAt(MEDIAN_SKETCH_CAPACITY_FIELD_NAME));
 	editedObject->SetReplicatePostOptimization(GetStringValueAt(REPLICATE_POST_OPTIMIZATION_FIELD_NAME));
 	editedObject->SetReplicateChoice(GetStringValueAt(REPLICATE_CHOICE_FIELD_NAME));
 	editedObject->SetClustersCentersInitializationMethod(GetStringValueAt(CLUSTERS_CENTERS_FIELD_NAME));
@@ -284,6 +329,16 @@ void KMParametersView::EventRefresh(Object* object)
 	SetStringValueAt(CONTINUOUS_PREPROCESSING_FIELD_NAME, editedObject->GetContinuousPreprocessingTypeLabel());
 	SetBooleanValueAt(VERBOSE_MODE_FIELD_NAME, editedObject->GetVerboseMode());
 	SetBooleanValueAt(PARALLEL_MODE_FIELD_NAME, editedObject->GetParallelMode());
+	SetBooleanValueAt(DENSE_INSTANCES_MATRIX_FIELD_NAME, editedObject->GetDenseInstancesMatrix());
+	SetBooleanValueAt(SPARSE_INSTANCES_MATRIX_FIELD_NAME, editedObject->GetSparseInstancesMatrix());
+	SetIntValueAt(THREADS_NUMBER_FIELD_NAME, editedObject->GetThreadsNumber());
+	SetBooleanValueAt(BOUNDS_PRUNING_FIELD_NAME, editedObject->GetBoundsPruning());
+	SetBooleanValueAt(KMEAN_PARALLEL_SEEDING_FIELD_NAME, editedObject->GetKMeanParallelSeeding());
+	SetBooleanValueAt(SINGLE_PASS_EVALUATION_FIELD_NAME, editedObject->GetSinglePassEvaluation());
+	SetBooleanValueAt(DISTANCE_ATTRIBUTES_OUTPUT_FIELD_NAME, editedObject->GetDistanceAttributesOutput());
+	SetIntValueAt(POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME, editedObject->GetPostOptimizationNeighborsNumber());
+	SetIntValueAt(POST_OPTIMIZATION_VNS_TIME_LIMIT_FIELD_NAME, editedObject->GetPostOptimizationVnsTimeLimit());
+	SetIntValueAt(MEDIAN_SKETCH_CAPACITY_FIELD_NAME, editedObject->GetMedianSketchCapacity());
 	SetStringValueAt(REPLICATE_POST_OPTIMIZATION_FIELD_NAME, editedObject->GetReplicatePostOptimizationLabel());
 	SetBooleanValueAt(DETAILED_STATISTICS_FIELD_NAME, editedObject->GetWriteDetailedStatistics());
 	SetIntValueAt(PREPROCESSING_SUPERVISED_MAX_INTERVAL_FIELD_NAME, editedObject->GetPreprocessingSupervisedMaxIntervalNumber());
@@ -350,6 +405,13 @@ const char* KMParametersView::PREPROCESSING_SUPERVISED_MAX_INTERVAL_LABEL = "Sup
 const char* KMParametersView::PREPROCESSING_SUPERVISED_MAX_GROUP_LABEL = "Supervised mode: max groups number (0 = no max)";
 const char* KMParametersView::VERBOSE_MODE_LABEL = "Verbose mode";
 const char* KMParametersView::PARALLEL_MODE_LABEL = "Parallel mode";
+const char* KMParametersView::DENSE_INSTANCES_MATRIX_LABEL = "Dense instances matrix";
+const char* KMParametersView::SPARSE_INSTANCES_MATRIX_LABEL = "Sparse instances matrix, for mostly zero K-Means values";
+const char* KMParametersView::THREADS_NUMBER_LABEL = "Threads number (0 = number of cores in parallel mode, 1 otherwise)";
+const char* KMParametersView::BOUNDS_PRUNING_LABEL = "Distance bounds pruning (L1 and L2 norms)";
+const char* KMParametersView::KMEAN_PARALLEL_SEEDING_LABEL = "KMean|| seeding, for KMean++ and KMean++R initializations";
+const char* KMParametersView::SINGLE_PASS_EVALUATION_LABEL = "Single pass evaluation (L1 distances are estimated)";
+const char* KMParametersView::DISTANCE_ATTRIBUTES_OUTPUT_LABEL = "Output the distance to each cluster (one variable per cluster)";
 const char* KMParametersView::BISECTING_VERBOSE_MODE_LABEL = "Bisecting/class decomposition verbose mode";
 const char* KMParametersView::DETAILED_STATISTICS_LABEL = "Write detailed statistics in reports";
 const char* KMParametersView::MAX_EVALUATED_ATTRIBUTES_NUMBER_LABEL = "Max number of used variables (supervised mode only, 0 = no max)";
@@ -357,6 +419,9 @@ const char* KMParametersView::LOCAL_MODEL_SNB_LABEL = "Selective Naive Bayes";
 const char* KMParametersView::LOCAL_MODEL_NB_LABEL = "Naive Bayes";
 const char* KMParametersView::REPLICATE_POST_OPTIMIZATION_LABEL = "Best replicate post-optimization";
 const char* KMParametersView::VNS_LEVEL_LABEL = "Post-optimization VNS level (0 = no VNS)";
+const char* KMParametersView::POST_OPTIMIZATION_NEIGHBORS_NUMBER_LABEL = "Post-optimization nearest clusters by instance (0 = all clusters)";
+const char* KMParametersView::POST_OPTIMIZATION_VNS_TIME_LIMIT_LABEL = "Post-optimization VNS time limit in seconds (0 = no limit)";
+const char* KMParametersView::MEDIAN_SKETCH_CAPACITY_LABEL = "Median sketches capacity (median rank error about 1 / capacity)";
 const char* KMParametersView::REPLICATE_POST_OPTIMIZATION_FAST_LABEL = "Fast post-optimization";
 const char* KMParametersView::KEEP_NUL_LEVEL_LABEL = "Keep all variables in case of unsupervised preprocessing (supervised mode only)";
 
@@ -382,12 +447,22 @@ const char* KMParametersView::BISECTING_REPLICATE_NUMBER_FIELD_NAME = "Bisecting
 const char* KMParametersView::REPLICATE_CHOICE_FIELD_NAME = "ReplicateChoice";
 const char* KMParametersView::REPLICATE_POST_OPTIMIZATION_FIELD_NAME = "ReplicatePostOptimization";
 const char* KMParametersView::POST_OPTIMIZATION_VNS_LEVEL_FIELD_NAME = "PostOptimizationVnsLevel";
+const char* KMParametersView::POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME = "PostOptimizationNeighborsNumber";
+const char* KMParametersView::POST_OPTIMIZATION_VNS_TIME_LIMIT_FIELD_NAME = "PostOptimizationVnsTimeLimit";
+const char* KMParametersView::MEDIAN_SKETCH_CAPACITY_FIELD_NAME = "MedianSketchCapacity";
 const char* KMParametersView::PREPROCESSING_MAX_INTERVAL_FIELD_NAME = "p";
 const char* KMParametersView::PREPROCESSING_MAX_GROUP_FIELD_NAME = "q";
 const char* KMParametersView::PREPROCESSING_SUPERVISED_MAX_INTERVAL_FIELD_NAME = "SupervisedMaxInterval";
 const char* KMParametersView::PREPROCESSING_SUPERVISED_MAX_GROUP_FIELD_NAME = "SupervisedMaxGroup";
 const char* KMParametersView::VERBOSE_MODE_FIELD_NAME = "VerboseMode";
 const char* KMParametersView::PARALLEL_MODE_FIELD_NAME = "ParallelMode";
+const char* KMParametersView::DENSE_INSTANCES_MATRIX_FIELD_NAME = "DenseInstancesMatrix";
+const char* KMParametersView::SPARSE_INSTANCES_MATRIX_FIELD_NAME = "SparseInstancesMatrix";
+const char* KMParametersView::THREADS_NUMBER_FIELD_NAME = "ThreadsNumber";
+const char* KMParametersView::BOUNDS_PRUNING_FIELD_NAME = "BoundsPruning";
+const char* KMParametersView::KMEAN_PARALLEL_SEEDING_FIELD_NAME = "KMeanParallelSeeding";
+const char* KMParametersView::SINGLE_PASS_EVALUATION_FIELD_NAME = "SinglePassEvaluation";
+const char* KMParametersView::DISTANCE_ATTRIBUTES_OUTPUT_FIELD_NAME = "DistanceAttributesOutput";
 const char* KMParametersView::BISECTING_VERBOSE_MODE_FIELD_NAME = "BisectingVerboseMode";
 const char* KMParametersView::DETAILED_STATISTICS_FIELD_NAME = "WriteDetailedStatistics";
 const char* KMParametersView::MAX_EVALUATED_ATTRIBUTES_NUMBER_FIELD_NAME = "MaxEvaluatedAttributesNumber";
@@ -77,6 +77,9 @@ public:
 	static const char* REPLICATE_CHOICE_LABEL;
 	static const char* REPLICATE_POST_OPTIMIZATION_LABEL;
 	static const char* VNS_LEVEL_LABEL;
+	static const char* POST_OPTIMIZATION_NEIGHBORS_NUMBER_LABEL;
+	static const char* POST_OPTIMIZATION_VNS_TIME_LIMIT_LABEL;
+	static const char* MEDIAN_SKETCH_CAPACITY_LABEL;
 	static const char* REPLICATE_POST_OPTIMIZATION_FAST_LABEL;
 	static const char* PREPROCESSING_MAX_INTERVAL_LABEL;
 	static const char* PREPROCESSING_MAX_GROUP_LABEL;
@@ -84,6 +87,13 @@ public:
 	static const char* PREPROCESSING_SUPERVISED_MAX_GROUP_LABEL;
 	static const char* VERBOSE_MODE_LABEL;
 	static const char* PARALLEL_MODE_LABEL;
+	static const char* DENSE_INSTANCES_MATRIX_LABEL;
+	static const char* SPARSE_INSTANCES_MATRIX_LABEL;
+	static const char* THREADS_NUMBER_LABEL;
+	static const char* BOUNDS_PRUNING_LABEL;
+	static const char* KMEAN_PARALLEL_SEEDING_LABEL;
+	static const char* SINGLE_PASS_EVALUATION_LABEL;
+	static const char* DISTANCE_ATTRIBUTES_OUTPUT_LABEL;
 	static const char* BISECTING_VERBOSE_MODE_LABEL;
 	static const char* DETAILED_STATISTICS_LABEL;
 	static const char* MAX_EVALUATED_ATTRIBUTES_NUMBER_LABEL;
@@ -114,12 +124,22 @@ public:
 	static const char* REPLICATE_CHOICE_FIELD_NAME;
 	static const char* REPLICATE_POST_OPTIMIZATION_FIELD_NAME;
 	static const char* POST_OPTIMIZATION_VNS_LEVEL_FIELD_NAME;
+	static const char* POST_OPTIMIZATION_NEIGHBORS_NUMBER_FIELD_NAME;
+	static const char* POST_OPTIMIZATION_VNS_TIME_LIMIT_FIELD_NAME;
+	static const char* MEDIAN_SKETCH_CAPACITY_FIELD_NAME;
 	static const char* PREPROCESSING_MAX_INTERVAL_FIELD_NAME;
 	static const char* PREPROCESSING_MAX_GROUP_FIELD_NAME;
 	static const char* PREPROCESSING_SUPERVISED_MAX_INTERVAL_FIELD_NAME;
 	static const char* PREPROCESSING_SUPERVISED_MAX_GROUP_FIELD_NAME;
 	static const char* VERBOSE_MODE_FIELD_NAME;
 	static const char* PARALLEL_MODE_FIELD_NAME;
+	static const char* DENSE_INSTANCES_MATRIX_FIELD_NAME;
+	static const char* SPARSE_INSTANCES_MATRIX_FIELD_NAME;
+	static const char* THREADS_NUMBER_FIELD_NAME;
+	static const char* BOUNDS_PRUNING_FIELD_NAME;
+	static const char* KMEAN_PARALLEL_SEEDING_FIELD_NAME;
+	static const char* SINGLE_PASS_EVALUATION_FIELD_NAME;
+	static const char* DISTANCE_ATTRIBUTES_OUTPUT_FIELD_NAME;
 	static const char* BISECTING_VERBOSE_MODE_FIELD_NAME;
 	static const char* DETAILED_STATISTICS_FIELD_NAME;
 	static const char* MAX_EVALUATED_ATTRIBUTES_NUMBER_FIELD_NAME;
@@ -5,6 +5,8 @@
 #include "KMPredictor.h"
 #include "KMParametersView.h"
 #include "KMClusteringQuality.h"
+#include "KMDistanceKernel.h"
+#include "KMDRNearestCentroid.h"
 
 #include <KWPredictorUnivariate.h>
 #include "KWSTDatabaseTextFile.h"
@@ -142,6 +144,7 @@ boolean KMPredictor::InternalTrain()
 	GetClass()->RemoveAllAttributesMetaDataKey(KMPredictor::ID_CLUSTER_METADATA);
 	GetClass()->RemoveAllAttributesMetaDataKey(KMPredictor::CELL_INDEX_METADATA);
 	GetClass()->RemoveAllAttributesMetaDataKey(KMParametersView::DETAILED_STATISTICS_FIELD_NAME);
+	GetClass()->RemoveAllAttributesMetaDataKey(KMParametersView::SINGLE_PASS_EVALUATION_FIELD_NAME);
 	GetClass()->RemoveAllAttributesMetaDataKey(KMParametersView::MAX_EVALUATED_ATTRIBUTES_NUMBER_FIELD_NAME);
 	GetClass()->RemoveAllAttributesMetaDataKey(KMParametersView::CONTINUOUS_PREPROCESSING_FIELD_NAME);
 	GetClass()->RemoveAllAttributesMetaDataKey(KMParametersView::CATEGORICAL_PREPROCESSING_FIELD_NAME);
@@ -371,6 +374,72 @@ bool KMPredictor::ComputeAllReplicates(KWDataPreparationClass* dataPreparationCl
 		parameters->SetKValue(nbInstances);
 	}
 
+	// reperer une fois pour toutes les instances ayant des valeurs manquantes, afin que les replicates n'aient plus a parcourir leurs attributs
+	KMMissingValuesIndex* missingValuesIndex = new KMMissingValuesIndex;
+
+	if (nbInstances > 0 and missingValuesIndex->Initialize(instances, parameters)) {
+		parameters->SetMissingValuesIndex(missingValuesIndex);
+		if (parameters->GetVerboseMode())
+			AddSimpleMessage("Missing values index : " + ALString(IntToString(nbInstances - missingValuesIndex->GetCompleteInstances()->GetSize())) +
+				" instances with missing K-Means values, out of " + ALString(IntToString(nbInstances)));
+	}
+	else {
+		delete missingValuesIndex;
+		missingValuesIndex = NULL;
+	}
+
+	// si possible, recopier une fois pour toutes les valeurs K-Means des instances dans une matrice, qui sera partagee par tous les replicates.
+	// Si ces valeurs comportent peu de valeurs non nulles (binarisation des attributs categoriels, etc), elles sont stockees dans une matrice creuse,
+	// qui permet de calculer les distances aux centroides a partir des seules valeurs non nulles : la matrice dense ne porte alors que les lignes
+	// (instances, valeurs manquantes) et les colonnes, sans allouer ses valeurs
+	KMDenseMatrix* instancesMatrix = NULL;
+	KMSparseMatrix* instancesSparseMatrix = NULL;
+
+	if (parameters->GetDenseInstancesMatrix() and nbInstances > 0) {
+
+		instancesMatrix = new KMDenseMatrix;
+
+		if (parameters->GetSparseInstancesMatrix() and
+			instancesMatrix->InitializeFromInstances(instances, parameters->GetKMeanAttributesLoadIndexes(), false)) {
+
+			const double dDensity = KMSparseMatrix::ComputeDensity(instancesMatrix, parameters->GetKMeanAttributesLoadIndexes());
+
+			if (dDensity <= KMSparseMatrix::MAX_DENSITY) {
+
+				instancesSparseMatrix = new KMSparseMatrix;
+
+				if (not instancesSparseMatrix->InitializeFromInstances(instancesMatrix, parameters->GetKMeanAttributesLoadIndexes())) {
+					delete instancesSparseMatrix;
+					instancesSparseMatrix = NULL;
+					if (parameters->GetVerboseMode() and not TaskProgression::IsInterruptionRequested())
+						AddSimpleMessage("Not enough memory to build the sparse instances matrix : the dense instances matrix will be used");
+				}
+				else
+					if (parameters->GetVerboseMode())
+						AddSimpleMessage("Sparse instances matrix : " + ALString(IntToString(instancesSparseMatrix->GetRowNumber())) + " rows, " +
+							ALString(IntToString(instancesSparseMatrix->GetColumnNumber())) + " columns, " +
+							ALString(LongintToString(instancesSparseMatrix->GetNonZeroNumber())) + " non-zero values (density " + ALString(DoubleToString(dDensity)) + ", " +
+							ALString(LongintToString((instancesSparseMatrix->GetUsedMemory() + instancesMatrix->GetUsedMemory()) / 1024)) + " KB)");
+			}
+		}
+
+		// matrice dense complete, si les valeurs ne sont pas stockees dans une matrice creuse
+		if (instancesSparseMatrix == NULL) {
+
+			if (not instancesMatrix->InitializeFromInstances(instances, parameters->GetKMeanAttributesLoadIndexes())) {
+				delete instancesMatrix;
+				instancesMatrix = NULL;
+				if (parameters->GetVerboseMode() and not TaskProgression::IsInterruptionRequested())
+					AddSimpleMessage("Not enough memory to build the dense instances matrix : K-Means values will be read from database instances");
+			}
+			else
+				if (parameters->GetVerboseMode())
+					AddSimpleMessage("Dense instances matrix : " + ALString(IntToString(instancesMatrix->GetRowNumber())) + " rows, " +
+						ALString(IntToString(instancesMatrix->GetColumnNumber())) + " columns (" + ALString(LongintToString(instancesMatrix->GetUsedMemory() / 1024)) + " KB), " +
+						KMDistanceKernel::GetInstructionSetLabel() + " distance kernels");
+		}
+	}
+
 	const bool bSelectReplicatesOnEVA = (parameters->GetReplicateChoice() == KMParameters::EVA ? true : false);
 	const bool bSelectReplicatesOnARIByClusters = (parameters->GetReplicateChoice() == KMParameters::ARIByClusters ? true : false);
 	const bool bSelectReplicatesOnARIByClasses = (parameters->GetReplicateChoice() == KMParameters::ARIByClasses ? true : false);
@@ -386,6 +455,8 @@ bool KMPredictor::ComputeAllReplicates(KWDataPreparationClass* dataPreparationCl
 
 		KMClustering* currentClustering = new KMClustering(parameters);
 		currentClustering->SetUsedSampleNumberPercentage(GetDatabase()->GetSampleNumberPercentage());
+		currentClustering->SetInstancesMatrix(instancesMatrix);
+		currentClustering->SetInstancesSparseMatrix(instancesSparseMatrix);
 
 		// si ce n'est pas le premier replicate, recuperer les infos precedemment calculees, et dont ont est
 		// sur qu'elles seront identiques lors des replicates suivants, afin de ne pas les recalculer inutilement
@@ -552,6 +623,18 @@ bool KMPredictor::ComputeAllReplicates(KWDataPreparationClass* dataPreparationCl
 			break;
 	}
 
+	// les matrices des instances et l'index des valeurs manquantes ne sont utilises que lors du calcul des replicates
+	if (instancesMatrix != NULL)
+		delete instancesMatrix;
+
+	if (instancesSparseMatrix != NULL)
+		delete instancesSparseMatrix;
+
+	if (missingValuesIndex != NULL) {
+		parameters->SetMissingValuesIndex(NULL);
+		delete missingValuesIndex;
+	}
+
 	if (bOk and parameters->GetLearningNumberOfReplicates() > 1 and parameters->GetVerboseMode()) {
 
 		AddSimpleMessage(" ");
@@ -649,7 +732,7 @@ bool KMPredictor::ComputeAllReplicates(KWDataPreparationClass* dataPreparationCl
 
 bool KMPredictor::ComputeAllMiniBatchesReplicates(KWDataPreparationClass* dataPreparationClass) {
 
-	// modification de la valeur de l'echantillonnage de la base, pour qu'elle corresponde au nombre d'instances d'1 minibatch
+	// taux d'echantillonnage de la base correspondant au nombre d'instances d'1 minibatch, servant a determiner le nombre de mini-batches
 	const int originalSamplePercentage = GetDatabase()->GetSampleNumberPercentage();// sauvegarder valeur originale
 	int minibatchSamplePercentage = ((double)parameters->GetMiniBatchSize() / (double)GetDatabase()->GetSampleEstimatedObjectNumber()) * 100;
 
@@ -658,7 +741,8 @@ bool KMPredictor::ComputeAllMiniBatchesReplicates(KWDataPreparationClass* dataPr
 		return false;
 	}
 
-	if (not HasSufficientMemoryForTraining(dataPreparationClass, parameters->GetMiniBatchSize())) {
+	// les mini-batches sont lus par blocs melanges, qui doivent tenir en memoire, en plus de l'echantillon d'initialisation (de la taille d'un bloc)
+	if (not HasSufficientMemoryForTraining(dataPreparationClass, 2 * parameters->GetMiniBatchSize() * KMParameters::MINI_BATCHES_BY_SHUFFLED_BLOCK)) {
 		AddWarning("Not enough memory to use a mini-batch size of " + ALString(IntToString(parameters->GetMiniBatchSize())) + ", please try to decrease it.");
 		return false;
 	}
@@ -666,10 +750,6 @@ bool KMPredictor::ComputeAllMiniBatchesReplicates(KWDataPreparationClass* dataPr
 	if (minibatchSamplePercentage == 0)
 		minibatchSamplePercentage = 1;
 
-	if (parameters->GetVerboseMode()) {
-		AddMessage("Downsizing database sample to " + ALString(IntToString(minibatchSamplePercentage)) + "%, for mini-batches computing.");
-	}
-
 	int miniBatchesNumber = (originalSamplePercentage / minibatchSamplePercentage) + 1;// arrondir a l'entier superieur, et en faire au moins 2
 
 	Timer timer;
@@ -712,9 +792,10 @@ bool KMPredictor::ComputeAllMiniBatchesReplicates(KWDataPreparationClass* dataPr
 	const bool bSelectReplicatesOnNormalizedMutualInformationByClusters = (parameters->GetReplicateChoice() == KMParameters::NormalizedMutualInformationByClusters ? true : false);
 	const bool bSelectReplicatesOnNormalizedMutualInformationByClasses = (parameters->GetReplicateChoice() == KMParameters::NormalizedMutualInformationByClasses ? true : false);
 
-	// calcul des stats globales sur le sample initial de la base
+	// calcul des stats globales sur le sample initial de la base, et constitution de l'echantillon d'initialisation des clusters, commun a tous les replicates
+	ObjectArray oaInitializationSample;
 	KMClusteringMiniBatch* currentClustering = new KMClusteringMiniBatch(parameters);
-	currentClustering->ComputeGlobalClusterStatistics(GetDatabase(), targetAttribute);
+	currentClustering->ComputeGlobalClusterStatistics(GetDatabase(), targetAttribute, &oaInitializationSample);
 
 	// on effectue plusieurs replicates (chacun d'entre eux executera n iterations de mini-batchs), et on garde le meilleur resultat obtenu
 	for (int iNumberOfReplicates = 0; iNumberOfReplicates < parameters->GetLearningNumberOfReplicates(); iNumberOfReplicates++) {
@@ -787,7 +868,7 @@ bool KMPredictor::ComputeAllMiniBatchesReplicates(KWDataPreparationClass* dataPr
 		TaskProgression::DisplayLabel(progressionLabel);
 
 		// calcul kmean par mini-batch
-		bOk = currentClustering->ComputeReplicate(GetDatabase(), targetAttribute, miniBatchesNumber, originalSamplePercentage, minibatchSamplePercentage);
+		bOk = currentClustering->ComputeReplicate(GetDatabase(), targetAttribute, miniBatchesNumber, &oaInitializationSample);
 
 		if (bOk) {
 
@@ -877,6 +958,9 @@ bool KMPredictor::ComputeAllMiniBatchesReplicates(KWDataPreparationClass* dataPr
 			break;
 	}
 
+	// l'echantillon d'initialisation n'est utilise que lors du calcul des replicates
+	oaInitializationSample.DeleteAll();
+
 	if (bOk and parameters->GetLearningNumberOfReplicates() > 1 and parameters->GetVerboseMode()) {
 
 		AddSimpleMessage(" ");
@@ -1390,43 +1474,109 @@ boolean KMPredictor::GenerateUnsupervisedModelingDictionary(KWDataPreparationCla
 
 	KWClass* kwModelingClass = dataPreparationClass->GetDataPreparationClass();
 
-	KWDerivationRule* argminRule = new KWDRArgMin;
-	argminRule->DeleteAllOperands();
+	// l'affectation au cluster est calculee par une regle NearestCentroid, dont les operandes portent les centroides. Les attributs
+	// DistanceCluster1 a DistanceClusterK (K regles de d operandes) ne sont crees que si la sortie des distances est demandee
+	if (parameters->GetDistanceAttributesOutput()) {
 
-	// creation des attributs DistanceCluster1 � DistanceClusterK dans le dico,
-	// puis ajout de ces attributs, comme operandes a la regle argminRule
-	bOk = CreateDistanceClusterAttributes(argminRule, kwModelingClass);
+		bOk = CreateDistanceClusterAttributes(NULL, kwModelingClass);
 
-	if (not bOk)
-		return false;
+		if (not bOk)
+			return false;
+	}
 
-	argminRule->SetClassName(kwModelingClass->GetName());
-	argminRule->CompleteTypeInfo(kwModelingClass);
-	argminRule->Check();
+	KWDerivationRule* nearestCentroidRule = CreateNearestCentroidRule(kwModelingClass);
 
 	KWAttribute* idClusterAttribute = new KWAttribute;
 
 	idClusterAttribute->SetName(kwModelingClass->BuildAttributeName(ID_CLUSTER_LABEL));
 	idClusterAttribute->GetMetaData()->SetNoValueAt(KMPredictor::ID_CLUSTER_METADATA);
-	if (parameters->GetWriteDetailedStatistics())
+	if (parameters->GetWriteDetailedStatistics()) {
 		idClusterAttribute->GetMetaData()->SetNoValueAt(KMParametersView::DETAILED_STATISTICS_FIELD_NAME);
 
+		// la capacite des resumes de quantiles doit etre connue des esclaves de l'evaluation, qui reconstituent les parametres a partir du dictionnaire
+		idClusterAttribute->GetMetaData()->SetDoubleValueAt(KMParametersView::MEDIAN_SKETCH_CAPACITY_FIELD_NAME, parameters->GetMedianSketchCapacity());
+	}
+
 	if (parameters->GetVerboseMode())
 		idClusterAttribute->GetMetaData()->SetNoValueAt(KMParametersView::VERBOSE_MODE_FIELD_NAME);
 
+	if (parameters->GetSinglePassEvaluation())
+		idClusterAttribute->GetMetaData()->SetNoValueAt(KMParametersView::SINGLE_PASS_EVALUATION_FIELD_NAME);
+
 	idClusterAttribute->GetMetaData()->SetStringValueAt(KMParametersView::CONTINUOUS_PREPROCESSING_FIELD_NAME, parameters->GetContinuousPreprocessingTypeLabel(false));
 	idClusterAttribute->GetMetaData()->SetStringValueAt(KMParametersView::CATEGORICAL_PREPROCESSING_FIELD_NAME, parameters->GetCategoricalPreprocessingTypeLabel(false));
+	AddClusterLabelsMetaData(idClusterAttribute);
 
-	idClusterAttribute->SetDerivationRule(argminRule);
+	idClusterAttribute->SetDerivationRule(nearestCentroidRule);
 
 	AddPredictionAttributeToClass(trainedPredictor, idClusterAttribute, kwModelingClass, ID_CLUSTER_METADATA);
 
 	return bOk;
 
 }
+void KMPredictor::AddClusterLabelsMetaData(KWAttribute* idClusterAttribute)
+{
+	require(idClusterAttribute != NULL);
+
+	// seuls les libelles differents du libelle par defaut (rang du cluster, a partir de 1) sont memorises
+	for (int k = 0; k < kmBestTrainedClustering->GetClusters()->GetSize(); k++) {
+
+		KMCluster* cluster = cast(KMCluster*, kmBestTrainedClustering->GetClusters()->GetAt(k));
+
+		if (cluster->GetLabel() != ALString(IntToString(k + 1)))
+			idClusterAttribute->GetMetaData()->SetStringValueAt(ALString(CLUSTER_LABEL) + "_" + IntToString(k + 1), cluster->GetLabel());
+	}
+}
+
+KWDerivationRule* KMPredictor::CreateNearestCentroidRule(KWClass* kwModelingClass)
+{
+	// regle de la forme :
+	// NearestCentroid("L2", 2, Info1Page, Info2Page, 0.3553613, 0.2474993, 0.8558611, 0.6916485)
+
+	require(kwModelingClass != NULL);
+	require(kwModelingClass->IsCompiled());
+
+	StringVector svAttributeNames;
+	IntVector ivAttributeRanks;
+	ObjectArray oaCentroids;
+
+	KWAttribute* attribute = kwModelingClass->GetHeadAttribute();
+
+	while (attribute != NULL)
+	{
+		if (parameters->IsKMAttributeName(attribute->GetName()))
+		{
+			svAttributeNames.Add(attribute->GetName());
+			ivAttributeRanks.Add(parameters->GetAttributeRankFromLoadIndex(attribute->GetLoadIndex()));
+		}
+		kwModelingClass->GetNextAttribute(attribute);
+	}
+
+	for (int k = 0; k < kmBestTrainedClustering->GetClusters()->GetSize(); k++) {
+
+		KMCluster* cluster = cast(KMCluster*, kmBestTrainedClustering->GetClusters()->GetAt(k));
+		ContinuousVector* cvCentroid = new ContinuousVector;
+		cvCentroid->SetSize(ivAttributeRanks.GetSize());
+
+		for (int i = 0; i < ivAttributeRanks.GetSize(); i++)
+			cvCentroid->SetAt(i, cluster->GetModelingCentroidValues().GetAt(ivAttributeRanks.GetAt(i)));
+
+		oaCentroids.Add(cvCentroid);
+	}
+
+	KMDRNearestCentroid* nearestCentroidRule = new KMDRNearestCentroid;
+	nearestCentroidRule->Initialize(parameters->GetDistanceType(), svAttributeNames, oaCentroids);
+	oaCentroids.DeleteAll();
+
+	nearestCentroidRule->SetClassName(kwModelingClass->GetName());
+	nearestCentroidRule->CompleteTypeInfo(kwModelingClass);
+	nearestCentroidRule->Check();
+
+	return nearestCentroidRule;
+}
+
 boolean KMPredictor::CreateDistanceClusterAttributes(KWDerivationRule* argminRule, KWClass* kwModelingClass)
 {
-	require(argminRule != NULL);
 	require(kwModelingClass != NULL);
 	require(kwModelingClass->IsIndexed());
 
@@ -1457,7 +1607,6 @@ boolean KMPredictor::CreateDistanceClusterAttributesL1(KWDerivationRule* argminR
 	//		Abs(Diff(Info1Pworkclass, 0.8558611)),
 	//		Abs(Diff(Info2Pworkclass, 0.6916485))...)	;
 
-	require(argminRule != NULL);
 	require(kwModelingClass != NULL);
 	require(kwModelingClass->IsIndexed());
 	assert(parameters->GetDistanceType() == KMParameters::L1Norm);
@@ -1516,12 +1665,14 @@ boolean KMPredictor::CreateDistanceClusterAttributesL1(KWDerivationRule* argminR
 
 		AddPredictionAttributeToClass(trainedPredictor, distanceAttribute, kwModelingClass, attrName);
 
-		// ajout du nouvel attribut DistanceCluster, en tant qu'operande de la regle argMin
-		KWDerivationRuleOperand* argMinOperand = new KWDerivationRuleOperand;
-		argMinOperand->SetOrigin(KWDerivationRuleOperand::OriginAttribute);
-		argMinOperand->SetType(KWType::Continuous);
-		argMinOperand->SetAttributeName(distanceAttribute->GetName());
-		argminRule->AddOperand(argMinOperand);
+		// ajout du nouvel attribut DistanceCluster, en tant qu'operande de la regle argMin (si elle est fournie)
+		if (argminRule != NULL) {
+			KWDerivationRuleOperand* argMinOperand = new KWDerivationRuleOperand;
+			argMinOperand->SetOrigin(KWDerivationRuleOperand::OriginAttribute);
+			argMinOperand->SetType(KWType::Continuous);
+			argMinOperand->SetAttributeName(distanceAttribute->GetName());
+			argminRule->AddOperand(argMinOperand);
+		}
 
 		// evaluer si on aura assez de memoire pour generer tous les attributs DistanceCluster suivants
 		if (k == 0) {
@@ -1578,7 +1729,6 @@ KWDerivationRule* KMPredictor::GetL1NormDerivationRule(KWAttribute* attribute, c
 
 boolean KMPredictor::CreateDistanceClusterAttributesL2(KWDerivationRule* argminRule, KWClass* kwModelingClass)
 {
-	require(argminRule != NULL);
 	require(kwModelingClass != NULL);
 	require(kwModelingClass->IsIndexed());
 	assert(parameters->GetDistanceType() == KMParameters::L2Norm);
@@ -1637,12 +1787,14 @@ boolean KMPredictor::CreateDistanceClusterAttributesL2(KWDerivationRule* argminR
 		distanceAttribute->SetDerivationRule(sumRule);
 		AddPredictionAttributeToClass(trainedPredictor, distanceAttribute, kwModelingClass, attrName);
 
-		// ajout du nouvel attribut DistanceCluster, en tant qu'operande de la regle argMin
-		KWDerivationRuleOperand* argMinOperand = new KWDerivationRuleOperand;
-		argMinOperand->SetOrigin(KWDerivationRuleOperand::OriginAttribute);
-		argMinOperand->SetType(KWType::Continuous);
-		argMinOperand->SetAttributeName(distanceAttribute->GetName());
-		argminRule->AddOperand(argMinOperand);
+		// ajout du nouvel attribut DistanceCluster, en tant qu'operande de la regle argMin (si elle est fournie)
+		if (argminRule != NULL) {
+			KWDerivationRuleOperand* argMinOperand = new KWDerivationRuleOperand;
+			argMinOperand->SetOrigin(KWDerivationRuleOperand::OriginAttribute);
+			argMinOperand->SetType(KWType::Continuous);
+			argMinOperand->SetAttributeName(distanceAttribute->GetName());
+			argminRule->AddOperand(argMinOperand);
+		}
 
 		// evaluer si on aura assez de memoire pour generer tous les attributs DistanceCluster suivants
 		if (k == 0) {
@@ -1706,7 +1858,6 @@ boolean KMPredictor::CreateDistanceClusterAttributesCosinus(KWDerivationRule* ar
 				//					Power(Sum(Product(8.659907,8.659907),Product(0.6488839,0.6488839)),0.5),
 				//					Power(Sum(Product(Info1PSepalLength,Info1PSepalLength),Product(Info2PSepalLength,Info2PSepalLength)),0.5)))
 
-	require(argminRule != NULL);
 	require(kwModelingClass != NULL);
 	require(kwModelingClass->IsIndexed());
 	assert(parameters->GetDistanceType() == KMParameters::CosineNorm);
@@ -1782,12 +1933,14 @@ boolean KMPredictor::CreateDistanceClusterAttributesCosinus(KWDerivationRule* ar
 		distanceAttribute->SetDerivationRule(substractRule);
 		AddPredictionAttributeToClass(trainedPredictor, distanceAttribute, kwModelingClass, attrName);
 
-		// ajout du nouvel attribut DistanceCluster, en tant qu'operande de la regle argMin
-		KWDerivationRuleOperand* argMinOperand = new KWDerivationRuleOperand;
-		argMinOperand->SetOrigin(KWDerivationRuleOperand::OriginAttribute);
-		argMinOperand->SetType(KWType::Continuous);
-		argMinOperand->SetAttributeName(distanceAttribute->GetName());
-		argminRule->AddOperand(argMinOperand);
+		// ajout du nouvel attribut DistanceCluster, en tant qu'operande de la regle argMin (si elle est fournie)
+		if (argminRule != NULL) {
+			KWDerivationRuleOperand* argMinOperand = new KWDerivationRuleOperand;
+			argMinOperand->SetOrigin(KWDerivationRuleOperand::OriginAttribute);
+			argMinOperand->SetType(KWType::Continuous);
+			argMinOperand->SetAttributeName(distanceAttribute->GetName());
+			argminRule->AddOperand(argMinOperand);
+		}
 
 		// evaluer si on aura assez de memoire pour generer tous les attributs DistanceCluster suivants
 		if (k == 0) {
@@ -2070,33 +2223,39 @@ boolean KMPredictor::GenerateSupervisedModelingDictionary(KWTrainedClassifier* t
 
 	KWClass* kwModelingClass = dataPreparationClass->GetDataPreparationClass();
 
-	KWDerivationRule* argminRule = new KWDRArgMin;
-	argminRule->DeleteAllOperands();
+	// l'affectation au cluster est calculee par une regle NearestCentroid, dont les operandes portent les centroides. Les attributs
+	// DistanceCluster1 a DistanceClusterK (K regles de d operandes) ne sont crees que si la sortie des distances est demandee
+	if (parameters->GetDistanceAttributesOutput()) {
 
-	// creation des attributs DistanceCluster1 � DistanceClusterK dans le dico,
-	// puis ajout de ces attributs, comme operandes a la regle argminRule
-	bOk = CreateDistanceClusterAttributes(argminRule, kwModelingClass);
+		bOk = CreateDistanceClusterAttributes(NULL, kwModelingClass);
 
-	if (not bOk)
-		return false;
+		if (not bOk)
+			return false;
+	}
 
-	argminRule->SetClassName(kwModelingClass->GetName());
-	argminRule->CompleteTypeInfo(kwModelingClass);
-	argminRule->Check();
+	KWDerivationRule* nearestCentroidRule = CreateNearestCentroidRule(kwModelingClass);
 
 	KWAttribute* idClusterAttribute = new KWAttribute;
 
 	idClusterAttribute->SetName(kwModelingClass->BuildAttributeName(ID_CLUSTER_LABEL));
-	idClusterAttribute->SetDerivationRule(argminRule);
+	idClusterAttribute->SetDerivationRule(nearestCentroidRule);
 
-	if (parameters->GetWriteDetailedStatistics())
+	if (parameters->GetWriteDetailedStatistics()) {
 		idClusterAttribute->GetMetaData()->SetNoValueAt(KMParametersView::DETAILED_STATISTICS_FIELD_NAME);
 
+		// la capacite des resumes de quantiles doit etre connue des esclaves de l'evaluation, qui reconstituent les parametres a partir du dictionnaire
+		idClusterAttribute->GetMetaData()->SetDoubleValueAt(KMParametersView::MEDIAN_SKETCH_CAPACITY_FIELD_NAME, parameters->GetMedianSketchCapacity());
+	}
+
 	if (parameters->GetVerboseMode())
 		idClusterAttribute->GetMetaData()->SetNoValueAt(KMParametersView::VERBOSE_MODE_FIELD_NAME);
 
+	if (parameters->GetSinglePassEvaluation())
+		idClusterAttribute->GetMetaData()->SetNoValueAt(KMParametersView::SINGLE_PASS_EVALUATION_FIELD_NAME);
+
 	idClusterAttribute->GetMetaData()->SetStringValueAt(KMParametersView::CONTINUOUS_PREPROCESSING_FIELD_NAME, parameters->GetContinuousPreprocessingTypeLabel(false));
 	idClusterAttribute->GetMetaData()->SetStringValueAt(KMParametersView::CATEGORICAL_PREPROCESSING_FIELD_NAME, parameters->GetCategoricalPreprocessingTypeLabel(false));
+	AddClusterLabelsMetaData(idClusterAttribute);
 
 	// Completion automatique des informations de la classe (nom de classe par regle...)
 	trainedKMean->GetPredictorClass()->CompleteTypeInfo();
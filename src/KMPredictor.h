@@ -121,7 +121,15 @@ protected:
 	/** apprentissage : clustering mini-batch kmean */
 	bool ComputeAllMiniBatchesReplicates(KWDataPreparationClass*);
 
-	/** creation des attributs de distance, dans le dico de modelisation */
+	/** creation de la regle d'affectation des instances au centroide le plus proche, a partir des centroides du meilleur clustering */
+	KWDerivationRule* CreateNearestCentroidRule(KWClass* kwClass);
+
+	/** memorisation des libelles des clusters dans les meta-donnees de l'attribut d'affectation (cles ClusterLabel_1 a ClusterLabel_K),
+	pour la relecture du modele a partir de la regle NearestCentroid */
+	void AddClusterLabelsMetaData(KWAttribute* idClusterAttribute);
+
+	/** creation des attributs de distance, dans le dico de modelisation (et ajout en tant qu'operandes de la regle argMin, si elle n'est pas NULL).
+	Ils ne sont crees que si la sortie des distances est demandee (cf. KMParameters::GetDistanceAttributesOutput) */
 	boolean CreateDistanceClusterAttributes(KWDerivationRule* argminRule, KWClass* kwClass);
 
 	/** creation des attributs de distance L1, dans le dico de modelisation */
@@ -809,11 +809,11 @@ void KMPredictorEvaluation::WriteContinuousMeanValues(ostream& ost, const KMClus
 	}
 }
 
-void KMPredictorEvaluation::WriteContinuousMedianValues(ostream& ost, const KMClustering* clustering, const ObjectArray* oaAttributesList, const longint iReadInstancesForMedianComputation, const longint lInstanceEvaluationNumber) {
+void KMPredictorEvaluation::WriteContinuousMedianValues(ostream& ost, const KMClustering* clustering, const ObjectArray* oaAttributesList, const longint lReadInstancesForMedianComputation, const longint lInstanceEvaluationNumber) {
 
 	// ecriture du tableau des medianes de valeurs continues, par cluster, pour chaque attribut natif
 
-	if (iReadInstancesForMedianComputation == 0)
+	if (lReadInstancesForMedianComputation == 0)
 		return; // pas assez de memoire pour stocker les instances servant a calculer les medianes
 
 	if (clustering->GetParameters()->GetVerboseMode())
@@ -831,8 +831,8 @@ void KMPredictorEvaluation::WriteContinuousMedianValues(ostream& ost, const KMCl
 		if (firstLine) { // ligne d'entete
 
 			ost << endl << "Median values for Numerical attributes ";
-			if (iReadInstancesForMedianComputation < lInstanceEvaluationNumber)
-				ost << "(approximation, based on " << iReadInstancesForMedianComputation << " instances) ";
+			if (lReadInstancesForMedianComputation < lInstanceEvaluationNumber)
+				ost << "(approximation, based on " << lReadInstancesForMedianComputation << " instances) ";
 			ost << ": " << endl;
 			ost << "Var name\t";
 
@@ -1061,8 +1061,7 @@ void KMPredictorEvaluation::WriteClustersDistancesUnnormalized(ostream& ost, KMC
 
 	ost << endl << endl << "Unnormalized distances between clusters centroids (" << parameters->GetDistanceTypeLabel() << ") :" << endl;
 
-	Continuous** clustersCentersDistances = clustering->GetClustersCentersDistances();
-	assert(clustersCentersDistances != NULL);
+	const KMTriangularMatrix& clustersCentersDistances = clustering->GetClustersCentersDistances();
 
 	const int nbClusters = clustering->GetClusters()->GetSize();
 
@@ -1081,11 +1080,9 @@ void KMPredictorEvaluation::WriteClustersDistancesUnnormalized(ostream& ost, KMC
 
 		ost << "cluster " << cluster->GetLabel() << "\t";
 
-		Continuous* line = clustersCentersDistances[i];
-
 		for (int j = 0; j < nbClusters; j++) {
 
-			ost << line[j] << "\t";
+			ost << clustersCentersDistances.GetAt(i, j) << "\t";
 		}
 
 		// distance de ce cluster avec le cluster global
@@ -1125,8 +1122,7 @@ void KMPredictorEvaluation::WriteClustersDistancesNormalized(ostream& ost, KMClu
 
 	ost << endl << endl << "Normalized distances between clusters centroids (" << parameters->GetDistanceTypeLabel() << ") :" << endl;
 
-	Continuous** clustersCentersDistances = clustering->GetClustersCentersDistances();
-	assert(clustersCentersDistances != NULL);
+	const KMTriangularMatrix& clustersCentersDistances = clustering->GetClustersCentersDistances();
 
 	const int nbClusters = clustering->GetClusters()->GetSize();
 
@@ -1162,11 +1158,9 @@ void KMPredictorEvaluation::WriteClustersDistancesNormalized(ostream& ost, KMClu
 
 		ost << "cluster " << cluster->GetLabel() << "\t";
 
-		Continuous* line = clustersCentersDistances[i];
-
 		for (int j = 0; j < nbClusters; j++) {
 
-			ost << (maxDistanceBetweenGlobalCluster > 0 ? line[j] / maxDistanceBetweenGlobalCluster : 0) << "\t";
+			ost << (maxDistanceBetweenGlobalCluster > 0 ? clustersCentersDistances.GetAt(i, j) / maxDistanceBetweenGlobalCluster : 0) << "\t";
 		}
 
 		// distance de ce cluster avec le cluster global
@@ -1261,29 +1255,6 @@ void KMPredictorEvaluation::WriteTrainTestCentroidsShifting(ostream& ost, KMClus
 	ost << endl;
 }
 
-int KMPredictorEvaluation::ComputeReadPercentageForMedianComputation(const boolean bDetailedStatistics, const longint estimatedInstancesNumber, KWClass* kwc) {
-
-	const longint dAvailableMemory = RMResourceManager::GetRemainingAvailableMemory();
-	longint dAdditionalMemory = KMPredictor::ComputeRequiredMemory(estimatedInstancesNumber, kwc);
-
-	if (bDetailedStatistics)
-		dAdditionalMemory *= 2; // constat empirique
-
-	if (dAdditionalMemory > dAvailableMemory) {
-
-		// memoire insuffisante : on calcule les medianes sur un sous-ensemble des donnees
-		const double newInstancesNumber = ((double)(dAvailableMemory / dAdditionalMemory)) * estimatedInstancesNumber;
-
-		int readpercentage = (((double)newInstancesNumber / (double)estimatedInstancesNumber)) * 100;
-
-		assert(readpercentage > 0 and readpercentage < 100);
-
-		return readpercentage;
-	}
-	else
-		return 100;
-}
-
 // ecriture du rapport d evaluation JSON (train ou test)
 void KMPredictorEvaluation::WriteJSONKMeanStatistics(JSONFile* fJSON) {
 
@@ -1415,11 +1386,11 @@ void KMPredictorEvaluation::WriteJSONContinuousMeanValues(JSONFile* fJSON, const
 	fJSON->EndArray();
 }
 
-void KMPredictorEvaluation::WriteJSONContinuousMedianValues(JSONFile* fJSON, const KMClustering* clustering, const ObjectArray* oaAttributesList, const longint iReadInstancesForMedianComputation, const longint lInstanceEvaluationNumber) {
+void KMPredictorEvaluation::WriteJSONContinuousMedianValues(JSONFile* fJSON, const KMClustering* clustering, const ObjectArray* oaAttributesList, const longint lReadInstancesForMedianComputation, const longint lInstanceEvaluationNumber) {
 
 	// ecriture du tableau des medianes de valeurs continues, par cluster, pour chaque attribut natif
 
-	if (iReadInstancesForMedianComputation == 0)
+	if (lReadInstancesForMedianComputation == 0)
 		return; // pas assez de memoire pour stocker les instances servant a calculer les medianes
 
 	if (clustering->GetParameters()->GetVerboseMode())
@@ -68,7 +68,7 @@ public:
 	static void WriteContinuousMeanValues(ostream& ost, const KMClustering* result, const ObjectArray* oaAttributesList);
 
 	/** tableau des medianes de valeurs continues, par cluster, pour chaque attribut natif */
-	static void WriteContinuousMedianValues(ostream& ost, const KMClustering* result, const ObjectArray* oaAttributesList, const longint iReadInstancesForMedianComputation, const longint lInstanceEvaluationNumber);
+	static void WriteContinuousMedianValues(ostream& ost, const KMClustering* result, const ObjectArray* oaAttributesList, const longint lReadInstancesForMedianComputation, const longint lInstanceEvaluationNumber);
 
 	/** tableau des % d'instances de clusters ayant une valeur de modalit donne */
 	static void WriteCategoricalModeValues(ostream& ost, const KMClustering* result, const ObjectDictionary& atomicModalitiesFrequencyTables, const ObjectArray* oaAttributesList, const KWClass*);
@@ -76,9 +76,6 @@ public:
 	/** tableau des probas des attributs natifs, % par cluster et par modalite */
 	static void WritePercentagePerLineModeValues(ostream& ost, const KMClustering*, const ObjectDictionary& groupedModalitiesFrequencyTables, const ObjectArray* oaAttributesList);
 
-	/** si memoire insuffisante : on calcule les medianes sur un sous-ensemble des donnees */
-	static int ComputeReadPercentageForMedianComputation(const boolean bDetailedStatistics, const longint estimatedObjectsNumber, KWClass* kwc);
-
 	static void CleanPredictorClass(KWClass* predictorClass);
 
 	/** gestion du rapport JSON */
@@ -87,7 +84,7 @@ public:
 	static void WriteJSONContinuousMeanValues(JSONFile* fJSON, const KMClustering* result, const ObjectArray* oaAttributesList);
 
 	/** tableau des medianes de valeurs continues, par cluster, pour chaque attribut natif */
-	static void WriteJSONContinuousMedianValues(JSONFile* fJSON, const KMClustering* result, const ObjectArray* oaAttributesList, const longint iReadInstancesForMedianComputation, const longint lInstanceEvaluationNumber);
+	static void WriteJSONContinuousMedianValues(JSONFile* fJSON, const KMClustering* result, const ObjectArray* oaAttributesList, const longint lReadInstancesForMedianComputation, const longint lInstanceEvaluationNumber);
 
 	/** tableau des probas des attributs natifs */
 	static void WriteJSONNativeAttributesProbs(JSONFile* fJSON, const KMClustering*, const ObjectDictionary& groupedModalitiesFrequencyTables, const ObjectArray* oaAttributesList);
@@ -5,6 +5,7 @@
 #include "KMPredictorEvaluationTask.h"
 #include "KMClusteringQuality.h"
 #include "KMLearningProject.h"
+#include "KMQuantileSketch.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // Classe KMPredictorEvaluationTask
@@ -13,42 +14,60 @@ KMPredictorEvaluationTask::KMPredictorEvaluationTask()
 {
 	predictorEvaluation = NULL;
 	kmGlobalCluster = NULL;
-	iReadInstancesForMedianComputation = 0;
+	lReadInstancesForMedianComputation = 0;
 	kmEvaluationClustering = NULL;
 	lInstancesWithMissingValues = 0;
 	lInstanceEvaluationNumber = 0;
 	odAttributesPartitions = NULL;
 	odAtomicModalities = NULL;
+	master_nDatabasePass = 1;
+	slave_trainedPredictor = NULL;
+	slave_bUpdateModalitiesProbs = false;
+
+	shared_oaEvaluationCentroids = new PLShared_ObjectArray(new PLShared_ContinuousVector);
+	output_oaClusters = new PLShared_ObjectArray(new PLShared_Cluster);
+	output_oaGroupedModalitiesFrequencies = new PLShared_ObjectArray(new PLShared_IntVector);
+	output_oaAtomicModalitiesFrequencies = new PLShared_ObjectArray(new PLShared_IntVector);
+	output_oaMedianSketches = new PLShared_ObjectArray(new PLShared_QuantileSketch);
+
+	DeclareSharedParameter(&shared_sEvaluationClassName);
+	DeclareSharedParameter(&shared_nDatabasePass);
+	DeclareSharedParameter(&shared_bMedianComputation);
+	DeclareSharedParameter(shared_oaEvaluationCentroids);
+	DeclareTaskOutput(&output_lInstanceEvaluationNumber);
+	DeclareTaskOutput(&output_lInstancesWithMissingValues);
+	DeclareTaskOutput(&output_lReadInstancesForMedianComputation);
+	DeclareTaskOutput(output_oaClusters);
+	DeclareTaskOutput(output_oaGroupedModalitiesFrequencies);
+	DeclareTaskOutput(output_oaAtomicModalitiesFrequencies);
+	DeclareTaskOutput(output_oaMedianSketches);
 }
 
 KMPredictorEvaluationTask::~KMPredictorEvaluationTask()
 {
 	odGroupedModalitiesFrequencyTables.DeleteAll();
 	odAtomicModalitiesFrequencyTables.DeleteAll();
+	master_oaMedianSketches.DeleteAll();
+	slave_oaMedianSketches.DeleteAll();
 
 	if (kmEvaluationClustering != NULL)
 		delete kmEvaluationClustering;
-}
-
-boolean KMPredictorEvaluationTask::MasterInitialize()
-{
 
-	AddSimpleMessage("MLClusters internal version is " + ALString(INTERNAL_VERSION));
-	return KWPredictorEvaluationTask::MasterInitialize();
+	if (slave_trainedPredictor != NULL)
+		delete slave_trainedPredictor;
 
+	delete shared_oaEvaluationCentroids;
+	delete output_oaClusters;
+	delete output_oaGroupedModalitiesFrequencies;
+	delete output_oaAtomicModalitiesFrequencies;
+	delete output_oaMedianSketches;
 }
 
-
 boolean KMPredictorEvaluationTask::Evaluate(KWPredictor* predictor,
 	KWDatabase* evaluationDatabase,
 	KWPredictorEvaluation* requesterPredictorEvaluation)
 {
 	boolean bOk;
-	const double dMinNecessaryMemory = 16 * 1024 * 1024;
-	KWObject* kwoObject;
-	longint nObject;
-	KWLearningSpec currentLearningSpec;
-	ALString sTmp;
 	KMTrainedPredictor* trainedPredictor;
 
 	require(predictor != NULL);
@@ -56,12 +75,6 @@ boolean KMPredictorEvaluationTask::Evaluate(KWPredictor* predictor,
 	require(evaluationDatabase != NULL);
 	require(evaluationDatabase->GetObjects()->GetSize() == 0);
 
-	// l'evaluation ne fait pas appel a la parallelisation, et se deroule entierement dans le master (i.e, on ne fait pas appel a RunDatabaseTask()  )
-
-	Timer timer;
-	timer.Start();
-
-
 	// Initialisation des variables necessaires pour l'evaluation
 
 	trainedPredictor = cast(KMTrainedPredictor*, predictor->GetTrainedPredictor());
@@ -74,20 +87,21 @@ boolean KMPredictorEvaluationTask::Evaluate(KWPredictor* predictor,
 
 	kmEvaluationClustering = clustering->Clone();
 
-	predictorEvaluation = requesterPredictorEvaluation;
-	InitializePredictorSharedVariables(predictor);
-
 	kmGlobalCluster = kmEvaluationClustering->GetGlobalCluster();
 
 	assert(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute() != NULL);
 	assert(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute()->GetLoadIndex().IsValid());
 
 	lInstancesWithMissingValues = 0;
+	lInstanceEvaluationNumber = 0;
+	lReadInstancesForMedianComputation = 0;
+	master_oaMedianSketches.DeleteAll();
 
 	odAttributesPartitions = ((ObjectDictionary*)&kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions());
 	odAtomicModalities = ((ObjectDictionary*)&kmEvaluationClustering->GetAttributesPartitioningManager()->GetAtomicModalities());
 
-	lInstanceEvaluationNumber = 0;
+	if (kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions().GetCount() > 0)
+		InitializeModalitiesProbs();
 
 	/////////////////////////////////////////////////////////////////////
 	// Chargement de la base pour evaluation des criteres specifiques
@@ -95,215 +109,287 @@ boolean KMPredictorEvaluationTask::Evaluate(KWPredictor* predictor,
 	AddSimpleMessage(ALString("Evaluate database ") + evaluationDatabase->GetDatabaseName() +
 		ALString(" with predictor ") + predictor->GetObjectLabel());
 
-	// Debut de suivi de tache
-	TaskProgression::BeginTask();
-	TaskProgression::DisplayMainLabel("Evaluate database " + evaluationDatabase->GetDatabaseName());
+	predictorEvaluation = requesterPredictorEvaluation;
+	InitializePredictorSharedVariables(predictor);
+	shared_sEvaluationClassName.SetValue(evaluationDatabase->GetClassName());
 
-	const longint estimatedObjectsNumber = evaluationDatabase->GetEstimatedObjectNumber();
+	// 1ere lecture de base : affectation des instances aux clusters, et maj des centroides d'evaluation MOYENNES (sans toucher aux centroides initiaux, issus du modele)
+	master_nDatabasePass = 1;
+	bOk = RunDatabaseTask(evaluationDatabase);
 
-	// Ouverture de la base en lecture
-	bOk = evaluationDatabase->OpenForRead();
+	if (bOk and lInstanceEvaluationNumber > 0) {
 
-	const bool updateModalitiesProbs = (kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions().GetCount() > 0 ? true : false);
+		if (kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics())
+			ComputeMedianValues(&master_oaMedianSketches, kmEvaluationClustering);
 
-	if (updateModalitiesProbs)
-		InitializeModalitiesProbs();
+		// les resumes ayant servi au calcul des medianes sont maintenant inutiles (gain memoire)
+		master_oaMedianSketches.DeleteAll();
 
-	// Lecture d'objets dans la base
-	if (bOk)
-	{
-		boolean bComputeMedians = kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics();
+		// recalculer les distances entre clusters, sur la base des centroides d'evaluation qui viennent d'etre calcules
+		kmEvaluationClustering->ComputeClustersCentersDistances(true);
+
+		if (kmEvaluationClustering->GetParameters()->GetSinglePassEvaluation()) {
+
+			// les stats qui dependent des centroides d'evaluation sont deduites des statistiques suffisantes de la 1ere lecture
+			for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
+				kmEvaluationClustering->GetCluster(i)->ComputeDistancesFromSufficientStatistics(true);
 
-		int iReadPercentageForMedianComputation = KMPredictorEvaluation::ComputeReadPercentageForMedianComputation(kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics(),
-			estimatedObjectsNumber, trainedPredictor->GetPredictorClass());
-		if (GetLearningExpertMode() and bComputeMedians and iReadPercentageForMedianComputation < 100) {
-			AddWarning("Not enough memory : can't store 100% of database instances for median values computing. Median will be computed on "
-				+ ALString(IntToString(iReadPercentageForMedianComputation)) + "% of database. Other statistics will still be computed on 100% of database instances.");
+			kmGlobalCluster->ComputeDistancesFromSufficientStatistics(false);
 		}
+		else {
+			// 2eme lecture de base, afin de mettre a jour les stats qui dependent des centroides d'evaluation
+			master_nDatabasePass = 2;
+			bOk = RunDatabaseTask(evaluationDatabase);
+		}
+	}
 
-		iReadInstancesForMedianComputation = 0;
+	AddSimpleMessage(ALString("Evaluation instances number (with no missing values after preprocessing) : ") + LongintToString(lInstanceEvaluationNumber));
+	AddSimpleMessage(ALString("Instances with missing values : ") + LongintToString(lInstancesWithMissingValues));
 
-		Global::ActivateErrorFlowControl();
+	if (lInstanceEvaluationNumber > 0) {
 
-		nObject = 0;
-		while (not evaluationDatabase->IsEnd())
+		kmGlobalCluster->FinalizeStatisticsUpdateFromInstances();
+
+		for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
 		{
-			if (nObject % 100 == 0)
-			{
-				// Arret si plus assez de memoire
-				if (RMResourceManager::GetRemainingAvailableMemory() < dMinNecessaryMemory)
-				{
-					bOk = false;
-					AddError(sTmp + "Not enough memory: interrupted after evaluation of " + LongintToString(nObject) + " instances (remaining available memory = "
-						+ LongintToHumanReadableString(RMResourceManager::GetRemainingAvailableMemory()) + ", min necessary memory = " + LongintToHumanReadableString(dMinNecessaryMemory));
-					break;
-				}
-			}
+			KMCluster* c = cast(KMCluster*, kmEvaluationClustering->GetClusters()->GetAt(i));
+			c->FinalizeStatisticsUpdateFromInstances();
+			c->ComputeInertyInter(KMParameters::L2Norm, kmGlobalCluster->GetEvaluationCentroidValues(), kmGlobalCluster->GetFrequency(), true);
+			c->ComputeInertyInter(KMParameters::L1Norm, kmGlobalCluster->GetEvaluationCentroidValues(), kmGlobalCluster->GetFrequency(), true);
+			c->ComputeInertyInter(KMParameters::CosineNorm, kmGlobalCluster->GetEvaluationCentroidValues(), kmGlobalCluster->GetFrequency(), true);
+		}
 
-			// controle memoire additionnel pour plus de securite (tenir compte de l'evolution de l'occupation memoire due a d'autres applications)
-			// Arret du stockage des instances en vue du calcul des medianes, si le seuil de memoire dispo est devenu dangereusement bas
-			if (bComputeMedians and nObject % 5 == 0 and RMResourceManager::GetRemainingAvailableMemory() < dMinNecessaryMemory * 2) {
+		kmEvaluationClustering->UpdateGlobalDistancesSum();
 
-				if (GetLearningExpertMode()) {
-					AddWarning("Not enough memory : can't store any more database instances for median values computing. Instances number stored so far : "
-						+ ALString(LongintToString(iReadInstancesForMedianComputation)) +
-						", total number of read instances : " + ALString(LongintToString(nObject)));
-				}
-				bComputeMedians = false;
-			}
+		TaskProgression::DisplayLabel("Computing clusters quality indicators");
 
-			// Traitement d'un nouvel objet
-			kwoObject = evaluationDatabase->Read();
-
-			if (kwoObject != NULL)
-			{
-				nObject++;
-
-				// Mise a jour de l'evaluation : affecte l'instance au cluster correspondant, et maj, le cas echeant, des centroides d'evaluation MOYENNES (sans toucher aux centroides initiaux, issus du modele)
-				KMCluster* cluster = UpdateEvaluationFirstDatabaseRead(predictor, kwoObject, updateModalitiesProbs);
-
-				if (cluster == NULL) {
-					// pas d'affectation possible, passer a l'instance suivante
-					delete kwoObject;
-					continue;
-				}
-
-				bool bKeepInstanceForMedianComputing = false;
-
-				if (bComputeMedians) {
-
-					// On teste si on garde ou non l'exemple afin de calculer les medianes (valeurs par attributs)
-					// NB. si le cluster est encore vide a ce stade, on lui affecte l'instance sans faire de tirage aleatoire
-
-					if (cluster->GetCount() == 0)
-						bKeepInstanceForMedianComputing = true;
-					else {
-						const int nRandom = 1 + IthRandomInt(nObject, 99);
-						bKeepInstanceForMedianComputing = (nRandom <= iReadPercentageForMedianComputation ? true : false);
-					}
-				}
-
-				if (not bKeepInstanceForMedianComputing)
-					delete kwoObject;
-				else {
-					// stocker cette instance dans le cluster, afin d'effectuer par la suite le calcul des medianes
-					iReadInstancesForMedianComputation++;
-					cluster->AddInstance(kwoObject);
-					kmGlobalCluster->AddInstance(kwoObject);
-				}
-			}
+		kmEvaluationClustering->GetClusteringQuality()->ComputeDaviesBouldin();
 
-			// Arret si erreur ou interruption
-			if (evaluationDatabase->IsError() or
-				(nObject % 100 == 0 and TaskProgression::IsInterruptionRequested()))
-			{
-				bOk = false;
-				break;
-			}
-		}
+	}
 
-		if (bOk) {
+	CleanPredictorSharedVariables();
 
-			if (kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics() and kmGlobalCluster->GetCount() > 0)
-				kmGlobalCluster->ComputeNativeAttributesContinuousMedianValues();
+	return bOk;
+}
 
-			for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
-			{
-				KMCluster* c = cast(KMCluster*, kmEvaluationClustering->GetClusters()->GetAt(i));
-
-				if (c->GetCount() > 0) {
-					if (kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics())
-						c->ComputeNativeAttributesContinuousMedianValues();
-					c->DeleteAll(); // suppression des KWObject du cluster, ayant servi au calcul des medianes (gain memoire, car ils sont maintenant devenus inutiles)
-				}
-			}
+boolean KMPredictorEvaluationTask::MasterInitialize()
+{
+	boolean bOk;
 
-			// recalculer les distances entre clusters, sur la base des centroides d'evaluation qui viennent d'etre calcules
-			kmEvaluationClustering->ComputeClustersCentersDistances(true);
+	// les evaluations standard du predicteur ne sont mises a jour que lors de la 1ere lecture de base
+	if (master_nDatabasePass == 1) {
+		AddSimpleMessage("MLClusters internal version is " + ALString(INTERNAL_VERSION));
+		bOk = KWPredictorEvaluationTask::MasterInitialize();
+	}
+	else
+		bOk = KWDatabaseTask::MasterInitialize();
 
-			// 2eme lecture de base, afin de mettre a jour les stats qui dependent des centroides d'evaluation
+	shared_nDatabasePass = master_nDatabasePass;
+	shared_bMedianComputation = (master_nDatabasePass == 1 and kmEvaluationClustering->GetParameters()->GetWriteDetailedStatistics());
 
-			evaluationDatabase->Close();
-			evaluationDatabase->OpenForRead();
+	// lors de la 2eme lecture, les esclaves ont besoin des centroides d'evaluation (ceux des clusters, puis celui du cluster global)
+	shared_oaEvaluationCentroids->GetObjectArray()->DeleteAll();
 
-			nObject = 0;
-			while (not evaluationDatabase->IsEnd())
-			{
-				kwoObject = evaluationDatabase->Read();
+	if (master_nDatabasePass == 2) {
 
-				if (kwoObject != NULL)
-				{
-					nObject++;
+		for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
+			shared_oaEvaluationCentroids->GetObjectArray()->Add(kmEvaluationClustering->GetCluster(i)->GetEvaluationCentroidValues().Clone());
 
-					// Mise a jour de l'evaluation : affecte l'instance au cluster correspondant, et maj la somme des distances ainsi que les inerties intra, en fonction des nouveaux centroides
-					UpdateEvaluationSecondDatabaseRead(kwoObject);
+		shared_oaEvaluationCentroids->GetObjectArray()->Add(kmGlobalCluster->GetEvaluationCentroidValues().Clone());
+	}
 
-					delete kwoObject;
+	return bOk;
+}
 
-				}
+boolean KMPredictorEvaluationTask::MasterAggregateResults()
+{
+	IntVector ivTargetValueIndexes; // pas de valeurs cibles en mode non supervise
+
+	lInstanceEvaluationNumber += output_lInstanceEvaluationNumber;
+	lInstancesWithMissingValues += output_lInstancesWithMissingValues;
+	lReadInstancesForMedianComputation += output_lReadInstancesForMedianComputation;
+
+	AggregateClusters(output_oaClusters->GetObjectArray(), ivTargetValueIndexes, kmEvaluationClustering);
+	AggregateFrequencyTables(output_oaGroupedModalitiesFrequencies->GetObjectArray(), odGroupedModalitiesFrequencyTables);
+	AggregateFrequencyTables(output_oaAtomicModalitiesFrequencies->GetObjectArray(), odAtomicModalitiesFrequencyTables);
+	AggregateMedianSketches(output_oaMedianSketches->GetObjectArray(), kmEvaluationClustering->GetParameters(), &master_oaMedianSketches);
+
+	// Appel a la methode ancetre
+	if (master_nDatabasePass == 1)
+		return KWPredictorEvaluationTask::MasterAggregateResults();
+	else
+		return KWDatabaseTask::MasterAggregateResults();
+}
 
-				// Arret si erreur ou interruption
-				if (evaluationDatabase->IsError() or
-					(nObject % 100 == 0 and TaskProgression::IsInterruptionRequested()))
-				{
-					bOk = false;
-					break;
-				}
-			}
-		}
+boolean KMPredictorEvaluationTask::MasterFinalize(boolean bProcessEndedCorrectly)
+{
+	boolean bOk;
+
+	if (master_nDatabasePass == 2)
+		return KWDatabaseTask::MasterFinalize(bProcessEndedCorrectly);
+
+	KMPredictorEvaluation* kmPredictorEvaluation = cast(KMPredictorEvaluation*, predictorEvaluation);
+
+	bOk = KWPredictorEvaluationTask::MasterFinalize(bProcessEndedCorrectly);
+
+	// seules les instances sans valeur manquante K-Means sont evaluees
+	kmPredictorEvaluation->SetInstanceEvaluationNumber(lInstanceEvaluationNumber);
+
+	return bOk;
+}
+
+boolean KMPredictorEvaluationTask::SlaveInitialize()
+{
+	boolean bOk;
+	KWClass* kwcEvaluationClass;
 
-		Global::DesactivateErrorFlowControl();
+	if (shared_nDatabasePass == 1)
+		bOk = KWPredictorEvaluationTask::SlaveInitialize();
+	else
+		bOk = KWDatabaseTask::SlaveInitialize();
 
-		TaskProgression::EndTask();
+	// reconstitution du modele K-Means a partir du dictionnaire, deja prepare pour le deploiement par le maitre
+	if (bOk) {
 
-		AddSimpleMessage(ALString("Evaluation instances number (with no missing values after preprocessing) : ") + IntToString(lInstanceEvaluationNumber));
-		AddSimpleMessage(ALString("Instances with missing values : ") + IntToString(kmEvaluationClustering->GetInstancesWithMissingValues()));
+		kwcEvaluationClass = KWClassDomain::GetCurrentDomain()->LookupClass(shared_sEvaluationClassName.GetValue());
+		assert(kwcEvaluationClass != NULL);
 
-		// Fermeture
-		bOk = evaluationDatabase->Close() and bOk;
+		slave_trainedPredictor = new KMTrainedPredictor;
+		bOk = slave_trainedPredictor->CreateEvaluationClustering(kwcEvaluationClass) != NULL;
 	}
 
-	if (lInstanceEvaluationNumber > 0) {
+	return bOk;
+}
 
-		kmGlobalCluster->FinalizeStatisticsUpdateFromInstances();
+boolean KMPredictorEvaluationTask::SlaveProcessExploitDatabase()
+{
+	boolean bOk;
 
-		for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
-		{
-			KMCluster* c = cast(KMCluster*, kmEvaluationClustering->GetClusters()->GetAt(i));
-			c->FinalizeStatisticsUpdateFromInstances();
-			c->ComputeInertyInter(KMParameters::L2Norm, kmGlobalCluster->GetEvaluationCentroidValues(), kmGlobalCluster->GetFrequency(), true);
-			c->ComputeInertyInter(KMParameters::L1Norm, kmGlobalCluster->GetEvaluationCentroidValues(), kmGlobalCluster->GetFrequency(), true);
-			c->ComputeInertyInter(KMParameters::CosineNorm, kmGlobalCluster->GetEvaluationCentroidValues(), kmGlobalCluster->GetFrequency(), true);
-		}
+	// clustering d'evaluation de la portion de base, initialise a partir du modele
+	if (kmEvaluationClustering != NULL)
+		delete kmEvaluationClustering;
 
-		kmEvaluationClustering->UpdateGlobalDistancesSum();
+	kmEvaluationClustering = slave_trainedPredictor->GetModelingClustering()->Clone();
+	kmGlobalCluster = kmEvaluationClustering->GetGlobalCluster();
+	odAttributesPartitions = ((ObjectDictionary*)&kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions());
+	odAtomicModalities = ((ObjectDictionary*)&kmEvaluationClustering->GetAttributesPartitioningManager()->GetAtomicModalities());
 
-		TaskProgression::DisplayLabel("Computing clusters quality indicators");
+	lInstanceEvaluationNumber = 0;
+	lInstancesWithMissingValues = 0;
+	lReadInstancesForMedianComputation = 0;
+	slave_oaMedianSketches.DeleteAll();
+	odGroupedModalitiesFrequencyTables.DeleteAll();
+	odAtomicModalitiesFrequencyTables.DeleteAll();
 
-		kmEvaluationClustering->GetClusteringQuality()->ComputeDaviesBouldin();
+	if (shared_nDatabasePass == 1) {
+
+		slave_bUpdateModalitiesProbs = (kmEvaluationClustering->GetAttributesPartitioningManager()->GetPartitions().GetCount() > 0 ? true : false);
+
+		if (slave_bUpdateModalitiesProbs)
+			InitializeModalitiesProbs();
 
+		// Appel a la methode ancetre, qui parcourt les objets de la portion de base
+		bOk = KWPredictorEvaluationTask::SlaveProcessExploitDatabase();
 	}
+	else {
+		// centroides d'evaluation calcules par le maitre, a l'issue de la 1ere lecture
+		const ObjectArray* oaCentroids = shared_oaEvaluationCentroids->GetConstObjectArray();
+		assert(oaCentroids->GetSize() == kmEvaluationClustering->GetClusters()->GetSize() + 1);
 
-	bOk = MasterFinalize(bOk); // appele directement car on n'utilise pas le service d'execution parallele des taches
+		for (int i = 0; i < kmEvaluationClustering->GetClusters()->GetSize(); i++)
+			kmEvaluationClustering->GetCluster(i)->SetEvaluationCentroidValues(*cast(ContinuousVector*, oaCentroids->GetAt(i)));
 
-	CleanPredictorSharedVariables();
+		kmGlobalCluster->SetEvaluationCentroidValues(*cast(ContinuousVector*, oaCentroids->GetAt(oaCentroids->GetSize() - 1)));
+
+		// Appel a la methode ancetre
+		bOk = KWDatabaseTask::SlaveProcessExploitDatabase();
+	}
+
+	// envoi des stats de la portion de base au maitre
+	if (bOk) {
+
+		output_lInstanceEvaluationNumber = lInstanceEvaluationNumber;
+		output_lInstancesWithMissingValues = lInstancesWithMissingValues;
+		output_lReadInstancesForMedianComputation = lReadInstancesForMedianComputation;
+
+		ExportClusters(kmEvaluationClustering, output_oaClusters->GetObjectArray());
+		ExportFrequencyTables(odGroupedModalitiesFrequencyTables, output_oaGroupedModalitiesFrequencies->GetObjectArray());
+		ExportFrequencyTables(odAtomicModalitiesFrequencyTables, output_oaAtomicModalitiesFrequencies->GetObjectArray());
+
+		// les resumes de quantiles sont transmis, et non recopies
+		for (int i = 0; i < slave_oaMedianSketches.GetSize(); i++)
+			output_oaMedianSketches->GetObjectArray()->Add(slave_oaMedianSketches.GetAt(i));
+		slave_oaMedianSketches.SetSize(0);
+	}
 
 	return bOk;
 }
 
-KMCluster* KMPredictorEvaluationTask::UpdateEvaluationFirstDatabaseRead(KWPredictor* predictor, KWObject* kwoObject, const bool updateModalitiesProbs)
+boolean KMPredictorEvaluationTask::SlaveProcessExploitDatabaseObject(const KWObject* kwoObject)
+{
+	require(kwoObject != NULL);
+
+	if (shared_nDatabasePass == 2) {
+
+		// maj de la somme des distances ainsi que des inerties intra, en fonction des centroides d'evaluation
+		UpdateEvaluationSecondDatabaseRead(kwoObject);
+		return true;
+	}
+
+	KMCluster* cluster = UpdateEvaluationFirstDatabaseRead(kwoObject, slave_bUpdateModalitiesProbs);
+
+	// pas d'affectation possible : l'instance n'est pas evaluee
+	if (cluster == NULL)
+		return true;
+
+	// les valeurs de toutes les instances alimentent les resumes de quantiles, dont la taille est bornee quel que soit le volume de la base
+	if (shared_bMedianComputation) {
+		lReadInstancesForMedianComputation++;
+		UpdateMedianSketches(kwoObject, kmEvaluationClustering->GetParameters(),
+			(int)kwoObject->GetContinuousValueAt(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute()->GetLoadIndex()) - 1,
+			&slave_oaMedianSketches);
+	}
+
+	// Appel a la methode ancetre, pour les evaluations standard du predicteur
+	return KWPredictorEvaluationTask::SlaveProcessExploitDatabaseObject(kwoObject);
+}
+
+boolean KMPredictorEvaluationTask::SlaveFinalize(boolean bProcessEndedCorrectly)
+{
+	if (kmEvaluationClustering != NULL) {
+		delete kmEvaluationClustering;
+		kmEvaluationClustering = NULL;
+	}
+	kmGlobalCluster = NULL;
+	odAttributesPartitions = NULL;
+	odAtomicModalities = NULL;
+	odGroupedModalitiesFrequencyTables.DeleteAll();
+	odAtomicModalitiesFrequencyTables.DeleteAll();
+	slave_oaMedianSketches.DeleteAll();
+
+	// NB. le clustering d'evaluation reference les parametres du predicteur : il doit etre detruit avant lui
+	delete slave_trainedPredictor;
+	slave_trainedPredictor = NULL;
+
+	// Appel a la methode ancetre
+	if (shared_nDatabasePass == 1)
+		return KWPredictorEvaluationTask::SlaveFinalize(bProcessEndedCorrectly);
+	else
+		return KWDatabaseTask::SlaveFinalize(bProcessEndedCorrectly);
+}
+
+KMCluster* KMPredictorEvaluationTask::UpdateEvaluationFirstDatabaseRead(const KWObject* kwoObject, const bool updateModalitiesProbs)
 {
-	require(predictor != NULL);
 	require(kwoObject != NULL);
 
 	if (kmEvaluationClustering->GetParameters()->HasMissingKMeanValue(kwoObject)) {
-		kmEvaluationClustering->IncrementInstancesWithMissingValuesNumber();
+		lInstancesWithMissingValues++;
 		return NULL;
 	}
 
 	const int idCluster = (int)kwoObject->GetContinuousValueAt(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute()->GetLoadIndex()) - 1;
 
-	if (idCluster > kmEvaluationClustering->GetClusters()->GetSize()) {
+	if (idCluster < 0 or idCluster >= kmEvaluationClustering->GetClusters()->GetSize()) {
 		AddError("UpdateEvaluation : Cluster number " + ALString(IntToString(idCluster + 1)) + " does not exist.");
 		// ne doit pas arriver, sauf si on a utilis� par erreur un dico de modelisation en mode benchmark, a la place d'un dico natif
 		return NULL;
@@ -319,10 +405,14 @@ KMCluster* KMPredictorEvaluationTask::UpdateEvaluationFirstDatabaseRead(KWPredic
 	}
 
 	kmGlobalCluster->SetFrequency(kmGlobalCluster->GetFrequency() + 1);
+	if (kmEvaluationClustering->GetParameters()->GetSinglePassEvaluation())
+		kmGlobalCluster->UpdateEvaluationSufficientStatistics(kwoObject);
 	kmGlobalCluster->UpdateMeanCentroidValues(kwoObject, (ContinuousVector&)kmGlobalCluster->GetEvaluationCentroidValues());
 	kmGlobalCluster->UpdateNativeAttributesContinuousMeanValues(kwoObject);
 
 	cluster->SetFrequency(cluster->GetFrequency() + 1);
+	if (kmEvaluationClustering->GetParameters()->GetSinglePassEvaluation())
+		cluster->UpdateEvaluationSufficientStatistics(kwoObject);
 	cluster->UpdateMeanCentroidValues(kwoObject, (ContinuousVector&)cluster->GetEvaluationCentroidValues());
 	cluster->UpdateNativeAttributesContinuousMeanValues(kwoObject);
 
@@ -334,7 +424,7 @@ KMCluster* KMPredictorEvaluationTask::UpdateEvaluationFirstDatabaseRead(KWPredic
 	return cluster;
 }
 
-KMCluster* KMPredictorEvaluationTask::UpdateEvaluationSecondDatabaseRead(KWObject* kwoObject)
+KMCluster* KMPredictorEvaluationTask::UpdateEvaluationSecondDatabaseRead(const KWObject* kwoObject)
 {
 	require(kwoObject != NULL);
 	assert(kmEvaluationClustering != NULL);
@@ -345,7 +435,7 @@ KMCluster* KMPredictorEvaluationTask::UpdateEvaluationSecondDatabaseRead(KWObjec
 
 	const int idCluster = (int)kwoObject->GetContinuousValueAt(kmEvaluationClustering->GetParameters()->GetIdClusterAttribute()->GetLoadIndex()) - 1;
 
-	if (idCluster > kmEvaluationClustering->GetClusters()->GetSize()) {
+	if (idCluster < 0 or idCluster >= kmEvaluationClustering->GetClusters()->GetSize()) {
 		AddError("UpdateEvaluation : Cluster number " + ALString(IntToString(idCluster + 1)) + " does not exist.");
 		// ne doit pas arriver, sauf si on a utilis� par erreur un dico de modelisation en mode benchmark, a la place d'un dico natif
 		return NULL;
@@ -455,15 +545,6 @@ void KMPredictorEvaluationTask::UpdateModalitiesProbs(const KWObject* kwoObject,
 		}
 	}
 }
-boolean KMPredictorEvaluationTask::MasterFinalize(boolean bProcessEndedCorrectly)
-{
-	// reimplemente, car on ne fait pas appel a l'execution parallele des taches
-
-	KMPredictorEvaluation* kmPredictorEvaluation = cast(KMPredictorEvaluation*, predictorEvaluation);
-	kmPredictorEvaluation->SetInstanceEvaluationNumber(lInstanceEvaluationNumber);
-	return bProcessEndedCorrectly;
-}
-
 void KMPredictorEvaluationTask::InitializeModalitiesProbs() {
 
 	// initialiser le dictionnaire contenant les probas de modalit�s : chaque poste pointe sur un objet KWFrequencyTable, correspondant aux intervalles d'un attribut)
@@ -512,6 +593,200 @@ void KMPredictorEvaluationTask::InitializeModalitiesProbs() {
 }
 
 
+void KMPredictorEvaluationTask::ExportClusters(const KMClustering* clustering, ObjectArray* oaClusters)
+{
+	require(clustering != NULL);
+	require(oaClusters != NULL);
+
+	for (int i = 0; i < clustering->GetClusters()->GetSize(); i++)
+		oaClusters->Add(clustering->GetCluster(i)->Clone());
+
+	oaClusters->Add(clustering->GetGlobalCluster()->Clone());
+}
+
+void KMPredictorEvaluationTask::AggregateClusters(const ObjectArray* oaClusters, const IntVector& ivTargetValueIndexes, KMClustering* clustering)
+{
+	require(oaClusters != NULL);
+	require(clustering != NULL);
+	require(oaClusters->GetSize() == clustering->GetClusters()->GetSize() + 1);
+
+	for (int i = 0; i < clustering->GetClusters()->GetSize(); i++)
+		clustering->GetCluster(i)->AggregateEvaluationStatistics(cast(KMCluster*, oaClusters->GetAt(i)), ivTargetValueIndexes);
+
+	clustering->GetGlobalCluster()->AggregateEvaluationStatistics(cast(KMCluster*, oaClusters->GetAt(oaClusters->GetSize() - 1)), ivTargetValueIndexes);
+}
+
+void KMPredictorEvaluationTask::ExportFrequencyTables(const ObjectDictionary& odFrequencyTables, ObjectArray* oaFrequencies)
+{
+	StringVector svKeys;
+	POSITION position;
+	ALString key;
+	Object* oCurrent;
+
+	require(oaFrequencies != NULL);
+
+	// les cles sont triees, afin que l'ordre des tables soit le meme dans le maitre et dans les esclaves
+	position = odFrequencyTables.GetStartPosition();
+	while (position != NULL) {
+		odFrequencyTables.GetNextAssoc(position, key, oCurrent);
+		svKeys.Add(key);
+	}
+	svKeys.Sort();
+
+	for (int i = 0; i < svKeys.GetSize(); i++) {
+
+		const KWFrequencyTable* table = cast(KWFrequencyTable*, odFrequencyTables.Lookup(svKeys.GetAt(i)));
+		IntVector* ivFrequencies = new IntVector;
+
+		for (int j = 0; j < table->GetFrequencyVectorNumber(); j++) {
+			const IntVector* ivVector = cast(KWDenseFrequencyVector*, table->GetFrequencyVectorAt(j))->GetFrequencyVector();
+			for (int k = 0; k < ivVector->GetSize(); k++)
+				ivFrequencies->Add(ivVector->GetAt(k));
+		}
+		oaFrequencies->Add(ivFrequencies);
+	}
+}
+
+void KMPredictorEvaluationTask::AggregateFrequencyTables(const ObjectArray* oaFrequencies, ObjectDictionary& odFrequencyTables)
+{
+	StringVector svKeys;
+	POSITION position;
+	ALString key;
+	Object* oCurrent;
+
+	require(oaFrequencies != NULL);
+	require(oaFrequencies->GetSize() == 0 or oaFrequencies->GetSize() == odFrequencyTables.GetCount());
+
+	if (oaFrequencies->GetSize() == 0)
+		return;
+
+	position = odFrequencyTables.GetStartPosition();
+	while (position != NULL) {
+		odFrequencyTables.GetNextAssoc(position, key, oCurrent);
+		svKeys.Add(key);
+	}
+	svKeys.Sort();
+
+	for (int i = 0; i < svKeys.GetSize(); i++) {
+
+		KWFrequencyTable* table = cast(KWFrequencyTable*, odFrequencyTables.Lookup(svKeys.GetAt(i)));
+		const IntVector* ivFrequencies = cast(IntVector*, oaFrequencies->GetAt(i));
+		int nFrequency = 0;
+
+		for (int j = 0; j < table->GetFrequencyVectorNumber(); j++) {
+			IntVector* ivVector = cast(KWDenseFrequencyVector*, table->GetFrequencyVectorAt(j))->GetFrequencyVector();
+			for (int k = 0; k < ivVector->GetSize(); k++) {
+				ivVector->SetAt(k, ivVector->GetAt(k) + ivFrequencies->GetAt(nFrequency));
+				nFrequency++;
+			}
+		}
+		assert(nFrequency == ivFrequencies->GetSize());
+	}
+}
+
+void KMPredictorEvaluationTask::UpdateMedianSketches(const KWObject* kwoObject, const KMParameters* parameters, const int idCluster, ObjectArray* oaMedianSketches)
+{
+	require(kwoObject != NULL);
+	require(parameters != NULL);
+	require(idCluster >= 0 and idCluster < parameters->GetKValue());
+	require(oaMedianSketches != NULL);
+
+	const KWLoadIndexVector& nativeAttributesLoadIndexes = parameters->GetNativeAttributesLoadIndexes();
+	const int nbNativeAttributes = nativeAttributesLoadIndexes.GetSize();
+
+	// premiere instance : creation d'un resume de quantiles par cluster et par attribut natif
+	if (oaMedianSketches->GetSize() == 0) {
+		oaMedianSketches->SetSize(parameters->GetKValue() * nbNativeAttributes);
+		for (int i = 0; i < oaMedianSketches->GetSize(); i++)
+			oaMedianSketches->SetAt(i, CreateMedianSketch(parameters));
+	}
+
+	for (int i = 0; i < nbNativeAttributes; i++) {
+
+		const KWLoadIndex loadIndex = nativeAttributesLoadIndexes.GetAt(i);
+		if (not loadIndex.IsValid())
+			continue;
+
+		KWAttribute* native = kwoObject->GetClass()->GetAttributeAtLoadIndex(loadIndex);
+		assert(native != NULL);
+
+		if (native->GetType() == KWType::Continuous and kwoObject->GetContinuousValueAt(loadIndex) != KWContinuous::GetMissingValue())
+			cast(KMQuantileSketch*, oaMedianSketches->GetAt(idCluster * nbNativeAttributes + i))->Add(kwoObject->GetContinuousValueAt(loadIndex));
+	}
+}
+
+void KMPredictorEvaluationTask::AggregateMedianSketches(const ObjectArray* oaSourceSketches, const KMParameters* parameters, ObjectArray* oaMedianSketches)
+{
+	require(oaSourceSketches != NULL);
+	require(parameters != NULL);
+	require(oaMedianSketches != NULL);
+	require(oaMedianSketches->GetSize() == 0 or oaSourceSketches->GetSize() == 0 or oaMedianSketches->GetSize() == oaSourceSketches->GetSize());
+
+	if (oaSourceSketches->GetSize() == 0)
+		return;
+
+	if (oaMedianSketches->GetSize() == 0) {
+		oaMedianSketches->SetSize(oaSourceSketches->GetSize());
+		for (int i = 0; i < oaMedianSketches->GetSize(); i++)
+			oaMedianSketches->SetAt(i, CreateMedianSketch(parameters));
+	}
+
+	for (int i = 0; i < oaSourceSketches->GetSize(); i++)
+		cast(KMQuantileSketch*, oaMedianSketches->GetAt(i))->Merge(cast(KMQuantileSketch*, oaSourceSketches->GetAt(i)));
+}
+
+void KMPredictorEvaluationTask::ComputeMedianValues(const ObjectArray* oaMedianSketches, KMClustering* clustering)
+{
+	ObjectArray oaClusterSketches;
+	ObjectArray oaGlobalSketches;
+
+	require(oaMedianSketches != NULL);
+	require(clustering != NULL);
+
+	if (oaMedianSketches->GetSize() == 0)
+		return;
+
+	const int nbClusters = clustering->GetClusters()->GetSize();
+	const int nbNativeAttributes = oaMedianSketches->GetSize() / nbClusters;
+	assert(oaMedianSketches->GetSize() == nbClusters * nbNativeAttributes);
+
+	// le resume du cluster global est la fusion des resumes de l'ensemble des clusters
+	oaGlobalSketches.SetSize(nbNativeAttributes);
+	for (int i = 0; i < nbNativeAttributes; i++)
+		oaGlobalSketches.SetAt(i, CreateMedianSketch(clustering->GetParameters()));
+
+	oaClusterSketches.SetSize(nbNativeAttributes);
+
+	for (int idxCluster = 0; idxCluster < nbClusters; idxCluster++) {
+
+		for (int i = 0; i < nbNativeAttributes; i++) {
+
+			KMQuantileSketch* sketch = cast(KMQuantileSketch*, oaMedianSketches->GetAt(idxCluster * nbNativeAttributes + i));
+			cast(KMQuantileSketch*, oaGlobalSketches.GetAt(i))->Merge(sketch);
+			oaClusterSketches.SetAt(i, sketch);
+		}
+
+		KMCluster* c = clustering->GetCluster(idxCluster);
+		if (c->GetFrequency() > 0)
+			c->ComputeNativeAttributesContinuousMedianValues(oaClusterSketches);
+	}
+
+	if (clustering->GetGlobalCluster()->GetFrequency() > 0)
+		clustering->GetGlobalCluster()->ComputeNativeAttributesContinuousMedianValues(oaGlobalSketches);
+
+	oaGlobalSketches.DeleteAll();
+}
+
+KMQuantileSketch* KMPredictorEvaluationTask::CreateMedianSketch(const KMParameters* parameters)
+{
+	require(parameters != NULL);
+
+	// les resumes des esclaves et du maitre doivent avoir la meme capacite pour pouvoir etre fusionnes
+	KMQuantileSketch* sketch = new KMQuantileSketch;
+	sketch->SetCapacity(parameters->GetMedianSketchCapacity());
+	return sketch;
+}
+
 const ALString KMPredictorEvaluationTask::GetTaskName() const
 {
 	return "MLClusters Predictor evaluation";
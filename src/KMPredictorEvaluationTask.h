@@ -8,9 +8,13 @@
 #include "KMPredictorEvaluation.h"
 
 class KMPredictorEvaluation;
+class KMQuantileSketch;
 
 //////////////////////////////////////////////
 /// tache d'evaluation d'un predicteur KMeans
+/// L'evaluation se fait en deux passes paralleles sur la base : la premiere calcule les frequences, les centroides d'evaluation
+/// et les moyennes, la seconde les sommes de distances et les inerties par rapport a ces centroides. Chaque esclave reconstitue
+/// le clustering a partir du dictionnaire de modelisation, et renvoie au maitre les statistiques de sa portion de base.
 //
 
 class KMPredictorEvaluationTask : public KWPredictorEvaluationTask
@@ -40,21 +44,53 @@ public:
 	/** cle = nom d'attribut. Valeur = objet KWFrequencyTable, contenant le comptage des modalits non groupes pour un attribut donn */
 	const ObjectDictionary& GetAtomicModalitiesFrequencyTables() const;
 
+	// echanges de statistiques entre esclaves et maitre (services egalement utilises par la classe KMClassifierEvaluationTask)
+
+	/** export des stats incrementales des clusters, puis du cluster global */
+	static void ExportClusters(const KMClustering* clustering, ObjectArray* oaClusters);
+
+	/** ajout des stats exportees par ExportClusters, aux clusters et au cluster global. ivTargetValueIndexes donne, pour chaque
+	valeur cible des clusters exportes, l'index de la valeur correspondante dans le clustering (vide en l'absence de cible) */
+	static void AggregateClusters(const ObjectArray* oaClusters, const IntVector& ivTargetValueIndexes, KMClustering* clustering);
+
+	/** export des comptages d'un dictionnaire de KWFrequencyTable : un IntVector par table (dans l'ordre des cles), contenant les
+	vecteurs de frequences de la table mis bout a bout */
+	static void ExportFrequencyTables(const ObjectDictionary& odFrequencyTables, ObjectArray* oaFrequencies);
+
+	/** ajout des comptages exportes par ExportFrequencyTables, a un dictionnaire de tables de meme structure */
+	static void AggregateFrequencyTables(const ObjectArray* oaFrequencies, ObjectDictionary& odFrequencyTables);
+
+	/** ajout des valeurs non manquantes des attributs natifs continus d'une instance aux resumes de quantiles de son cluster.
+	oaMedianSketches contient un KMQuantileSketch par cluster et par rang d'attribut natif (index = cluster * nombre d'attributs natifs + rang),
+	de capacite KMParameters::GetMedianSketchCapacity() */
+	static void UpdateMedianSketches(const KWObject* kwoObject, const KMParameters* parameters, const int idCluster, ObjectArray* oaMedianSketches);
+
+	/** fusion des resumes alimentes par UpdateMedianSketches (par exemple, dans un esclave) avec un autre tableau de resumes */
+	static void AggregateMedianSketches(const ObjectArray* oaSourceSketches, const KMParameters* parameters, ObjectArray* oaMedianSketches);
+
+	/** calcul des medianes des clusters et du cluster global, a partir des resumes de quantiles */
+	static void ComputeMedianValues(const ObjectArray* oaMedianSketches, KMClustering* clustering);
+
 	//////////////////////////////////////////////////////////////////////////////
 	///// Implementation
 protected:
 
-	// Reimplementation des methodes virtuelles. NB. pour le moment, on ne traite pas en parallele
+	// Reimplementation des methodes virtuelles
 	const ALString GetTaskName() const override;
 	PLParallelTask* Create() const override;
 	boolean MasterInitialize() override;
+	boolean MasterAggregateResults() override;
 	boolean MasterFinalize(boolean bProcessEndedCorrectly) override;
+	boolean SlaveInitialize() override;
+	boolean SlaveProcessExploitDatabase() override;
+	boolean SlaveProcessExploitDatabaseObject(const KWObject* kwoObject) override;
+	boolean SlaveFinalize(boolean bProcessEndedCorrectly) override;
 
 	/** evaluation lors de la premiere passe de lecture */
-	KMCluster* UpdateEvaluationFirstDatabaseRead(KWPredictor* predictor, KWObject* kwoObject, const bool updateModalitiesProbs);
+	KMCluster* UpdateEvaluationFirstDatabaseRead(const KWObject* kwoObject, const bool updateModalitiesProbs);
 
 	/** evaluation lors de la seconde passe de lecture */
-	KMCluster* UpdateEvaluationSecondDatabaseRead(KWObject* kwoObject);
+	KMCluster* UpdateEvaluationSecondDatabaseRead(const KWObject* kwoObject);
 
 	/** initialiser le dictionnaire contenant les probas de modalites : chaque poste pointe sur un objet KWFrequencyTable, correspondant aux intervalles d'un attribut */
 	void InitializeModalitiesProbs();
@@ -62,6 +98,9 @@ protected:
 	/** a partir d'une unsiatnce, mise a jour des frequences des modalites goupees et 'atomiques' (non groupees) */
 	void UpdateModalitiesProbs(const KWObject* kwoObject, const int idCluster);
 
+	/** creation d'un resume de quantiles vide, de la capacite specifiee dans les parametres */
+	static KMQuantileSketch* CreateMedianSketch(const KMParameters* parameters);
+
 	////////////////////////////////////  variables membres ///////////////////////////////
 
 	/** nombre d'instances ayant des valeurs manquantes parmi leurs attributs */
@@ -91,12 +130,44 @@ protected:
 	ObjectDictionary odAtomicModalitiesFrequencyTables;
 
 	/** nbre d'instances lues pour le calcul des valeurs medianes */
-	longint iReadInstancesForMedianComputation;
+	longint lReadInstancesForMedianComputation;
+
+	// variables membres du maitre
+
+	/** passe de lecture de la base en cours (1 ou 2) */
+	int master_nDatabasePass;
+
+	/** resumes de quantiles renvoyes par les esclaves pour le calcul des medianes (cf. UpdateMedianSketches) */
+	ObjectArray master_oaMedianSketches;
+
+	// variables membres des esclaves
+
+	/** predicteur servant a reconstituer le modele a partir du dictionnaire */
+	KMTrainedPredictor* slave_trainedPredictor;
+
+	/** indique si les frequences de modalites sont a mettre a jour */
+	boolean slave_bUpdateModalitiesProbs;
+
+	/** resumes de quantiles de la portion de base pour le calcul des medianes */
+	ObjectArray slave_oaMedianSketches;
+
+	// variables partagees
+	PLShared_String shared_sEvaluationClassName;
+	PLShared_Int shared_nDatabasePass;
+	PLShared_Boolean shared_bMedianComputation;
+	PLShared_ObjectArray* shared_oaEvaluationCentroids;
+	PLShared_Longint output_lInstanceEvaluationNumber;
+	PLShared_Longint output_lInstancesWithMissingValues;
+	PLShared_Longint output_lReadInstancesForMedianComputation;
+	PLShared_ObjectArray* output_oaClusters;
+	PLShared_ObjectArray* output_oaGroupedModalitiesFrequencies;
+	PLShared_ObjectArray* output_oaAtomicModalitiesFrequencies;
+	PLShared_ObjectArray* output_oaMedianSketches;
 };
 
 
 inline 	longint KMPredictorEvaluationTask::GetReadInstancesForMedianComputation() const {
-	return iReadInstancesForMedianComputation;
+	return lReadInstancesForMedianComputation;
 }
 
 inline KMClustering* KMPredictorEvaluationTask::GetClustering() const {
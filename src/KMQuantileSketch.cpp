@@ -0,0 +1,305 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMQuantileSketch.h"
+
+const int KMQuantileSketch::DEFAULT_CAPACITY = 200;
+
+KMQuantileSketch::KMQuantileSketch()
+{
+	nCapacity = DEFAULT_CAPACITY;
+	lCount = 0;
+}
+
+KMQuantileSketch::~KMQuantileSketch()
+{
+	oaLevels.DeleteAll();
+}
+
+void KMQuantileSketch::SetCapacity(const int nValue)
+{
+	require(nValue >= 2);
+	require(lCount == 0);
+
+	nCapacity = nValue;
+}
+
+void KMQuantileSketch::Add(const Continuous cValue)
+{
+	ContinuousVector* cvLevel = GetLevelAt(0);
+
+	cvLevel->Add(cValue);
+	lCount++;
+
+	if (cvLevel->GetSize() >= GetLevelCapacity(0))
+		CompactLevels();
+}
+
+void KMQuantileSketch::Merge(const KMQuantileSketch* source)
+{
+	require(source != NULL);
+	require(source != this);
+	require(source->nCapacity == nCapacity);
+
+	for (int nLevel = 0; nLevel < source->oaLevels.GetSize(); nLevel++) {
+
+		const ContinuousVector* cvSourceLevel = cast(ContinuousVector*, source->oaLevels.GetAt(nLevel));
+		ContinuousVector* cvLevel = GetLevelAt(nLevel);
+
+		for (int i = 0; i < cvSourceLevel->GetSize(); i++)
+			cvLevel->Add(cvSourceLevel->GetAt(i));
+	}
+
+	lCount += source->lCount;
+
+	CompactLevels();
+}
+
+Continuous KMQuantileSketch::ComputeQuantile(const double dRank) const
+{
+	require(lCount > 0);
+	require(dRank >= 0 and dRank <= 1);
+
+	longint lRank = (longint)(dRank * lCount);
+	if (lRank > lCount - 1)
+		lRank = lCount - 1;
+
+	return ComputeValueAtRank(lRank);
+}
+
+Continuous KMQuantileSketch::ComputeMedian() const
+{
+	require(lCount > 0);
+
+	if (lCount % 2 == 1)
+		return ComputeValueAtRank(lCount / 2);
+	else
+		return (ComputeValueAtRank(lCount / 2 - 1) + ComputeValueAtRank(lCount / 2)) / 2;
+}
+
+int KMQuantileSketch::GetStoredValueNumber() const
+{
+	int nValueNumber = 0;
+
+	for (int nLevel = 0; nLevel < oaLevels.GetSize(); nLevel++)
+		nValueNumber += cast(ContinuousVector*, oaLevels.GetAt(nLevel))->GetSize();
+
+	return nValueNumber;
+}
+
+void KMQuantileSketch::CopyFrom(const KMQuantileSketch* source)
+{
+	require(source != NULL);
+
+	RemoveAll();
+
+	nCapacity = source->nCapacity;
+	lCount = source->lCount;
+
+	for (int nLevel = 0; nLevel < source->oaLevels.GetSize(); nLevel++)
+		oaLevels.Add(cast(ContinuousVector*, source->oaLevels.GetAt(nLevel))->Clone());
+
+	ivCompactionOffsets.CopyFrom(&source->ivCompactionOffsets);
+}
+
+KMQuantileSketch* KMQuantileSketch::Clone() const
+{
+	KMQuantileSketch* aClone = new KMQuantileSketch;
+	aClone->CopyFrom(this);
+	return aClone;
+}
+
+void KMQuantileSketch::RemoveAll()
+{
+	oaLevels.DeleteAll();
+	ivCompactionOffsets.SetSize(0);
+	lCount = 0;
+}
+
+int KMQuantileSketch::GetLevelCapacity(const int nLevel) const
+{
+	require(nLevel >= 0 and nLevel < oaLevels.GetSize());
+
+	double dLevelCapacity = nCapacity;
+
+	// chaque niveau sous le niveau le plus haut a une capacite 2/3 de celle du niveau superieur
+	for (int i = nLevel + 1; i < oaLevels.GetSize(); i++)
+		dLevelCapacity *= 2.0 / 3.0;
+
+	return dLevelCapacity < 2 ? 2 : (int)dLevelCapacity;
+}
+
+ContinuousVector* KMQuantileSketch::GetLevelAt(const int nLevel)
+{
+	require(nLevel >= 0);
+
+	while (oaLevels.GetSize() <= nLevel) {
+		oaLevels.Add(new ContinuousVector);
+		ivCompactionOffsets.Add(0);
+	}
+
+	return cast(ContinuousVector*, oaLevels.GetAt(nLevel));
+}
+
+void KMQuantileSketch::CompactLevels()
+{
+	// la compaction d'un niveau peut creer un nouveau niveau, d'ou l'evaluation de la taille a chaque iteration
+	for (int nLevel = 0; nLevel < oaLevels.GetSize(); nLevel++) {
+
+		if (cast(ContinuousVector*, oaLevels.GetAt(nLevel))->GetSize() >= GetLevelCapacity(nLevel))
+			CompactLevel(nLevel);
+	}
+}
+
+void KMQuantileSketch::CompactLevel(const int nLevel)
+{
+	require(nLevel >= 0 and nLevel < oaLevels.GetSize());
+
+	ContinuousVector* cvUpperLevel = GetLevelAt(nLevel + 1);
+	ContinuousVector* cvLevel = cast(ContinuousVector*, oaLevels.GetAt(nLevel));
+	const int nValueNumber = cvLevel->GetSize();
+	const int nPairedValueNumber = nValueNumber - nValueNumber % 2;
+
+	cvLevel->Sort();
+
+	// une valeur sur deux, de poids double, represente chaque paire de valeurs consecutives
+	for (int i = ivCompactionOffsets.GetAt(nLevel); i < nPairedValueNumber; i += 2)
+		cvUpperLevel->Add(cvLevel->GetAt(i));
+
+	ivCompactionOffsets.SetAt(nLevel, 1 - ivCompactionOffsets.GetAt(nLevel));
+
+	// si le nombre de valeurs est impair, la derniere valeur reste dans le niveau
+	if (nPairedValueNumber < nValueNumber) {
+		const Continuous cLastValue = cvLevel->GetAt(nValueNumber - 1);
+		cvLevel->SetSize(1);
+		cvLevel->SetAt(0, cLastValue);
+	}
+	else
+		cvLevel->SetSize(0);
+}
+
+Continuous KMQuantileSketch::ComputeValueAtRank(const longint lRank) const
+{
+	require(lRank >= 0 and lRank < lCount);
+
+	ObjectArray oaSortedLevels;
+	IntVector ivPositions;
+	longint lCumulatedWeight = 0;
+	Continuous cValue = 0;
+
+	for (int nLevel = 0; nLevel < oaLevels.GetSize(); nLevel++) {
+		ContinuousVector* cvSortedLevel = cast(ContinuousVector*, oaLevels.GetAt(nLevel))->Clone();
+		cvSortedLevel->Sort();
+		oaSortedLevels.Add(cvSortedLevel);
+	}
+	ivPositions.SetSize(oaSortedLevels.GetSize());
+
+	// fusion des niveaux tries : chaque valeur du niveau h compte pour 2^h valeurs du flux
+	while (lCumulatedWeight <= lRank) {
+
+		int nMinLevel = -1;
+
+		for (int nLevel = 0; nLevel < oaSortedLevels.GetSize(); nLevel++) {
+
+			const ContinuousVector* cvSortedLevel = cast(ContinuousVector*, oaSortedLevels.GetAt(nLevel));
+
+			if (ivPositions.GetAt(nLevel) < cvSortedLevel->GetSize() and
+			    (nMinLevel == -1 or cvSortedLevel->GetAt(ivPositions.GetAt(nLevel)) <
+						    cast(ContinuousVector*, oaSortedLevels.GetAt(nMinLevel))->GetAt(ivPositions.GetAt(nMinLevel))))
+				nMinLevel = nLevel;
+		}
+		assert(nMinLevel != -1);
+
+		cValue = cast(ContinuousVector*, oaSortedLevels.GetAt(nMinLevel))->GetAt(ivPositions.GetAt(nMinLevel));
+		ivPositions.UpgradeAt(nMinLevel, 1);
+		lCumulatedWeight += ((longint)1) << nMinLevel;
+	}
+
+	oaSortedLevels.DeleteAll();
+
+	return cValue;
+}
+
+longint KMQuantileSketch::GetUsedMemory() const
+{
+	longint lUsedMemory = sizeof(KMQuantileSketch) + oaLevels.GetUsedMemory() - sizeof(ObjectArray) + ivCompactionOffsets.GetUsedMemory() - sizeof(IntVector);
+
+	for (int nLevel = 0; nLevel < oaLevels.GetSize(); nLevel++)
+		lUsedMemory += cast(ContinuousVector*, oaLevels.GetAt(nLevel))->GetUsedMemory();
+
+	return lUsedMemory;
+}
+
+const ALString KMQuantileSketch::GetClassLabel() const
+{
+	return "Quantile sketch";
+}
+
+//////////////////////////////////////////////////
+// Classe PLShared_QuantileSketch
+
+PLShared_QuantileSketch::PLShared_QuantileSketch()
+{
+}
+
+PLShared_QuantileSketch::~PLShared_QuantileSketch()
+{
+}
+
+void PLShared_QuantileSketch::SetQuantileSketch(KMQuantileSketch* sketch)
+{
+	require(sketch != NULL);
+	SetObject(sketch);
+}
+
+KMQuantileSketch* PLShared_QuantileSketch::GetQuantileSketch()
+{
+	return cast(KMQuantileSketch*, GetObject());
+}
+
+void PLShared_QuantileSketch::SerializeObject(PLSerializer* serializer, const Object* object) const
+{
+	KMQuantileSketch* sketch;
+	PLShared_ContinuousVector sharedContinuousVector;
+	PLShared_IntVector sharedIntVector;
+
+	require(serializer != NULL);
+	require(serializer->IsOpenForWrite());
+	require(object != NULL);
+
+	sketch = cast(KMQuantileSketch*, object);
+	serializer->PutInt(sketch->nCapacity);
+	serializer->PutLongint(sketch->lCount);
+	serializer->PutInt(sketch->oaLevels.GetSize());
+	for (int nLevel = 0; nLevel < sketch->oaLevels.GetSize(); nLevel++)
+		sharedContinuousVector.SerializeObject(serializer, sketch->oaLevels.GetAt(nLevel));
+	sharedIntVector.SerializeObject(serializer, &(sketch->ivCompactionOffsets));
+}
+
+void PLShared_QuantileSketch::DeserializeObject(PLSerializer* serializer, Object* object) const
+{
+	KMQuantileSketch* sketch;
+	PLShared_ContinuousVector sharedContinuousVector;
+	PLShared_IntVector sharedIntVector;
+	int nLevelNumber;
+
+	require(serializer->IsOpenForRead());
+
+	sketch = cast(KMQuantileSketch*, object);
+	sketch->RemoveAll();
+	sketch->nCapacity = serializer->GetInt();
+	sketch->lCount = serializer->GetLongint();
+	nLevelNumber = serializer->GetInt();
+	for (int nLevel = 0; nLevel < nLevelNumber; nLevel++) {
+		ContinuousVector* cvLevel = new ContinuousVector;
+		sharedContinuousVector.DeserializeObject(serializer, cvLevel);
+		sketch->oaLevels.Add(cvLevel);
+	}
+	sharedIntVector.DeserializeObject(serializer, &(sketch->ivCompactionOffsets));
+}
+
+Object* PLShared_QuantileSketch::Create() const
+{
+	return new KMQuantileSketch;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "Vector.h"
+#include "PLSharedObject.h"
+#include "PLSharedVector.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Resume d'un flux de valeurs Continuous, permettant d'en estimer les quantiles (typiquement, la mediane) en memoire bornee (algorithme KLL).
+/// Les valeurs sont rangees par niveaux : une valeur du niveau h represente 2^h valeurs du flux. Quand un niveau est plein, il est trie et une valeur
+/// sur deux est promue au niveau superieur (compaction). La capacite des niveaux decroit geometriquement (facteur 2/3) du niveau le plus haut au niveau 0,
+/// de sorte que le resume garde moins de 3 * capacite valeurs, quel que soit le nombre de valeurs du flux.
+/// L'erreur de rang d'un quantile est de l'ordre de 1 / capacite ; le resume est exact tant que le nombre de valeurs reste inferieur a la capacite.
+/// Deux resumes de meme capacite peuvent etre fusionnes (threads, esclaves d'une tache parallele), avec la meme garantie d'erreur.
+
+class KMQuantileSketch : public Object
+{
+public:
+
+	KMQuantileSketch();
+	~KMQuantileSketch();
+
+	/** capacite du niveau le plus haut, qui fixe le compromis entre memoire et precision. A fixer avant le premier ajout de valeur */
+	void SetCapacity(const int nValue);
+	int GetCapacity() const;
+
+	/** ajout d'une valeur du flux */
+	void Add(const Continuous cValue);
+
+	/** ajout des valeurs resumees par un autre resume, de meme capacite */
+	void Merge(const KMQuantileSketch* source);
+
+	/** nombre de valeurs du flux resumees */
+	longint GetCount() const;
+
+	/** estimation du quantile d'ordre dRank (entre 0 et 1). Le resume ne doit pas etre vide */
+	Continuous ComputeQuantile(const double dRank) const;
+
+	/** estimation de la mediane (moyenne des deux valeurs centrales si le nombre de valeurs est pair, comme pour un calcul exact). Le resume ne doit pas etre vide */
+	Continuous ComputeMedian() const;
+
+	/** nombre de valeurs effectivement stockees */
+	int GetStoredValueNumber() const;
+
+	void CopyFrom(const KMQuantileSketch* source);
+	KMQuantileSketch* Clone() const;
+
+	/** suppression de toutes les valeurs (la capacite est conservee) */
+	void RemoveAll();
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+	/** capacite par defaut : erreur de rang de l'ordre de 1%, pour moins de 600 valeurs stockees */
+	static const int DEFAULT_CAPACITY;
+
+protected:
+
+	/** capacite courante d'un niveau, fonction du nombre de niveaux */
+	int GetLevelCapacity(const int nLevel) const;
+
+	/** acces a un niveau, cree si necessaire */
+	ContinuousVector* GetLevelAt(const int nLevel);
+
+	/** compaction des niveaux pleins, du niveau 0 vers le niveau le plus haut */
+	void CompactLevels();
+
+	/** promotion d'une valeur sur deux d'un niveau au niveau superieur */
+	void CompactLevel(const int nLevel);
+
+	/** valeur de rang donne (entre 0 et GetCount() - 1), dans la suite ordonnee des valeurs resumees */
+	Continuous ComputeValueAtRank(const longint lRank) const;
+
+	int nCapacity;
+	longint lCount;
+
+	/** un ContinuousVector par niveau */
+	ObjectArray oaLevels;
+
+	/** pour chaque niveau, parite des valeurs promues lors de la prochaine compaction (alternee d'une compaction a l'autre, pour ne pas biaiser les quantiles) */
+	IntVector ivCompactionOffsets;
+
+	friend class PLShared_QuantileSketch;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// Serialisation de la classe KMQuantileSketch
+
+class PLShared_QuantileSketch : public PLSharedObject
+{
+public:
+
+	PLShared_QuantileSketch();
+	~PLShared_QuantileSketch();
+
+	// Acces au resume
+	void SetQuantileSketch(KMQuantileSketch*);
+	KMQuantileSketch* GetQuantileSketch();
+
+	// Reimplementation des methodes virtuelles
+	void DeserializeObject(PLSerializer*, Object*) const override;
+	void SerializeObject(PLSerializer*, const Object*) const override;
+
+protected:
+
+	// Creation d'un objet (type d'objet a serialiser)
+	Object* Create() const override;
+};
+
+inline int KMQuantileSketch::GetCapacity() const {
+	return nCapacity;
+}
+
+inline longint KMQuantileSketch::GetCount() const {
+	return lCount;
+}
@@ -0,0 +1,191 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMSortedNeighbors.h"
+#include "KMCluster.h"
+
+int KMSortedNeighborsCompareAddresses(const void* elem1, const void* elem2)
+{
+	const Object* o1 = *(Object**)elem1;
+	const Object* o2 = *(Object**)elem2;
+
+	if (o1 < o2)
+		return -1;
+	else if (o1 > o2)
+		return 1;
+	else
+		return 0;
+}
+
+KMSortedNeighbors::KMSortedNeighbors()
+{
+	nRequestedNeighborNumber = 0;
+	nNeighborNumber = 0;
+	nRefillNumber = 0;
+	oaClusters = NULL;
+	parameters = NULL;
+	nNeighbors = NULL;
+}
+
+KMSortedNeighbors::~KMSortedNeighbors()
+{
+	RemoveAll();
+}
+
+void KMSortedNeighbors::SetNeighborNumber(const int nValue)
+{
+	require(nValue >= 0);
+	require(oaInstances.GetSize() == 0);
+
+	nRequestedNeighborNumber = nValue;
+}
+
+void KMSortedNeighbors::Initialize(const ObjectArray* instances, const ObjectArray* clusters, const KMParameters* _parameters)
+{
+	require(instances != NULL);
+	require(clusters != NULL);
+	require(clusters->GetSize() > 0);
+	require(_parameters != NULL);
+
+	RemoveAll();
+
+	oaClusters = clusters;
+	parameters = _parameters;
+
+	oaInstances.CopyFrom(instances);
+	oaInstances.SetCompareFunction(KMSortedNeighborsCompareAddresses);
+	oaInstances.Sort();
+
+	// au moins deux clusters par liste, afin qu'une liste garde un cluster disponible apres la suppression d'un autre
+	nNeighborNumber = nRequestedNeighborNumber;
+	if (nNeighborNumber == 0 or nNeighborNumber > clusters->GetSize())
+		nNeighborNumber = clusters->GetSize();
+	else if (nNeighborNumber < 2)
+		nNeighborNumber = (clusters->GetSize() < 2 ? clusters->GetSize() : 2);
+
+	const longint lValueNumber = (longint)oaInstances.GetSize() * nNeighborNumber;
+	nNeighbors = new int[lValueNumber > 0 ? lValueNumber : 1];
+	cvNeighborDistances.SetSize(nNeighborNumber);
+
+	for (int nInstance = 0; nInstance < oaInstances.GetSize(); nInstance++)
+		ComputeNeighbors(nInstance, NULL);
+}
+
+int KMSortedNeighbors::GetInstanceIndex(const KWObject* instance) const
+{
+	int nLower = 0;
+	int nUpper = oaInstances.GetSize() - 1;
+
+	require(instance != NULL);
+
+	while (nLower <= nUpper) {
+
+		const int nMiddle = (nLower + nUpper) / 2;
+		const Object* o = oaInstances.GetAt(nMiddle);
+
+		if (o == instance)
+			return nMiddle;
+		else if (o < instance)
+			nLower = nMiddle + 1;
+		else
+			nUpper = nMiddle - 1;
+	}
+	return -1;
+}
+
+void KMSortedNeighbors::Refill(const IntVector* ivAvailableClusters, const int nMinAvailableNeighbors)
+{
+	int nAvailableClusterNumber = 0;
+
+	require(ivAvailableClusters != NULL);
+	require(oaClusters != NULL);
+	require(ivAvailableClusters->GetSize() == oaClusters->GetSize());
+	require(nMinAvailableNeighbors >= 1);
+
+	for (int nCluster = 0; nCluster < ivAvailableClusters->GetSize(); nCluster++) {
+		if (ivAvailableClusters->GetAt(nCluster) != 0)
+			nAvailableClusterNumber++;
+	}
+
+	// une liste ne peut contenir plus de nNeighborNumber clusters, ni plus que le nombre de clusters disponibles
+	int nMinNeighbors = (nAvailableClusterNumber < nMinAvailableNeighbors ? nAvailableClusterNumber : nMinAvailableNeighbors);
+	if (nMinNeighbors > nNeighborNumber)
+		nMinNeighbors = nNeighborNumber;
+
+	for (int nInstance = 0; nInstance < oaInstances.GetSize(); nInstance++) {
+
+		const int* nList = nNeighbors + ComputeOffset(nInstance);
+		int nAvailableNeighborNumber = 0;
+
+		for (int i = 0; i < nNeighborNumber and nList[i] != -1; i++) {
+			if (ivAvailableClusters->GetAt(nList[i]) != 0)
+				nAvailableNeighborNumber++;
+		}
+
+		if (nAvailableNeighborNumber < nMinNeighbors) {
+			ComputeNeighbors(nInstance, ivAvailableClusters);
+			nRefillNumber++;
+		}
+	}
+}
+
+void KMSortedNeighbors::RemoveAll()
+{
+	if (nNeighbors != NULL)
+		delete[] nNeighbors;
+
+	nNeighbors = NULL;
+	nNeighborNumber = 0;
+	nRefillNumber = 0;
+	oaInstances.SetSize(0);
+	oaClusters = NULL;
+	parameters = NULL;
+	cvNeighborDistances.SetSize(0);
+}
+
+void KMSortedNeighbors::ComputeNeighbors(const int nInstance, const IntVector* ivAvailableClusters)
+{
+	int* nList = nNeighbors + ComputeOffset(nInstance);
+	KWObject* instance = GetInstanceAt(nInstance);
+	int nFilledNumber = 0;
+
+	for (int nCluster = 0; nCluster < oaClusters->GetSize(); nCluster++) {
+
+		if (ivAvailableClusters != NULL and ivAvailableClusters->GetAt(nCluster) == 0)
+			continue;
+
+		KMCluster* cluster = cast(KMCluster*, oaClusters->GetAt(nCluster));
+		const Continuous cDistance = cluster->FindDistanceFromCentroid(instance, cluster->GetModelingCentroidValues(), parameters->GetDistanceType());
+
+		if (nFilledNumber == nNeighborNumber and cDistance >= cvNeighborDistances.GetAt(nNeighborNumber - 1))
+			continue;
+
+		// insertion dans la liste triee : a distance egale, le cluster de plus petit rang reste devant
+		int nPosition = (nFilledNumber < nNeighborNumber ? nFilledNumber : nNeighborNumber - 1);
+		while (nPosition > 0 and cvNeighborDistances.GetAt(nPosition - 1) > cDistance) {
+			cvNeighborDistances.SetAt(nPosition, cvNeighborDistances.GetAt(nPosition - 1));
+			nList[nPosition] = nList[nPosition - 1];
+			nPosition--;
+		}
+		cvNeighborDistances.SetAt(nPosition, cDistance);
+		nList[nPosition] = nCluster;
+
+		if (nFilledNumber < nNeighborNumber)
+			nFilledNumber++;
+	}
+
+	for (int i = nFilledNumber; i < nNeighborNumber; i++)
+		nList[i] = -1;
+}
+
+longint KMSortedNeighbors::GetUsedMemory() const
+{
+	return sizeof(KMSortedNeighbors) + oaInstances.GetUsedMemory() - sizeof(ObjectArray) + cvNeighborDistances.GetUsedMemory() - sizeof(ContinuousVector) +
+	       (longint)oaInstances.GetSize() * nNeighborNumber * sizeof(int);
+}
+
+const ALString KMSortedNeighbors::GetClassLabel() const
+{
+	return "Sorted neighbors";
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "Vector.h"
+#include "KWObject.h"
+#include "KMParameters.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Pour chaque instance d'une base, liste des index des m clusters les plus proches, tries par distance croissante (utilisee par la post-optimisation,
+/// qui ne cherche que le cluster disponible le plus proche d'une instance). Les listes sont stockees bout a bout dans un unique bloc d'entiers,
+/// de taille N * m, au lieu d'un tableau de K clusters par instance.
+/// Quand des clusters ne sont plus disponibles, les listes qui n'en contiennent plus assez sont recalculees a la demande (methode Refill).
+/// Les instances sont rangees par adresse croissante : l'index d'une instance s'obtient par recherche dichotomique, sans dictionnaire.
+
+class KMSortedNeighbors : public Object
+{
+public:
+
+	KMSortedNeighbors();
+	~KMSortedNeighbors();
+
+	/** nombre de clusters memorises par instance (0 = tous les clusters, valeur par defaut). A fixer avant l'initialisation */
+	void SetNeighborNumber(const int nValue);
+	int GetNeighborNumber() const;
+
+	/** calcul des listes de clusters les plus proches, pour chaque instance. Les clusters sont references par leur rang dans le tableau,
+	qui doit rester valide pendant toute l'utilisation des listes */
+	void Initialize(const ObjectArray* instances, const ObjectArray* clusters, const KMParameters* parameters);
+
+	/** nombre d'instances indexees */
+	int GetInstanceNumber() const;
+
+	/** acces a une instance, par son index */
+	KWObject* GetInstanceAt(const int nInstance) const;
+
+	/** index d'une instance (-1 si l'instance n'est pas indexee) */
+	int GetInstanceIndex(const KWObject* instance) const;
+
+	/** rang du cluster le plus proche d'une instance, parmi les clusters memorises dans sa liste et disponibles (valeur non nulle dans ivAvailableClusters),
+	en excluant un cluster (-1 pour n'en exclure aucun). Renvoie -1 si la liste ne contient aucun cluster disponible.
+	Methode sans allocation memoire, pouvant etre appelee dans des threads */
+	int GetNearestAvailableCluster(const int nInstance, const IntVector* ivAvailableClusters, const int nExcludedCluster) const;
+
+	/** recalcul des listes contenant moins de nMinAvailableNeighbors clusters disponibles (borne par la taille des listes), alors que d'autres
+	clusters disponibles existent. Les listes recalculees ne contiennent que des clusters disponibles */
+	void Refill(const IntVector* ivAvailableClusters, const int nMinAvailableNeighbors);
+
+	/** nombre de listes recalculees depuis l'initialisation */
+	int GetRefillNumber() const;
+
+	/** suppression de toutes les listes */
+	void RemoveAll();
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	/** calcul de la liste d'une instance, parmi les clusters disponibles (tous si ivAvailableClusters est NULL) */
+	void ComputeNeighbors(const int nInstance, const IntVector* ivAvailableClusters);
+
+	/** position du debut de la liste d'une instance, dans le bloc memoire */
+	longint ComputeOffset(const int nInstance) const;
+
+	int nRequestedNeighborNumber;
+
+	/** nombre effectif de clusters par liste (borne par le nombre de clusters). Les fins de listes inutilisees valent -1 */
+	int nNeighborNumber;
+
+	int nRefillNumber;
+
+	/** instances, triees par adresse croissante */
+	ObjectArray oaInstances;
+
+	const ObjectArray* oaClusters;
+	const KMParameters* parameters;
+
+	int* nNeighbors;
+
+	/** tampon de distances de travail, de taille nNeighborNumber */
+	ContinuousVector cvNeighborDistances;
+};
+
+inline int KMSortedNeighbors::GetNeighborNumber() const {
+	return nRequestedNeighborNumber;
+}
+
+inline int KMSortedNeighbors::GetInstanceNumber() const {
+	return oaInstances.GetSize();
+}
+
+inline KWObject* KMSortedNeighbors::GetInstanceAt(const int nInstance) const {
+	return cast(KWObject*, oaInstances.GetAt(nInstance));
+}
+
+inline int KMSortedNeighbors::GetRefillNumber() const {
+	return nRefillNumber;
+}
+
+inline longint KMSortedNeighbors::ComputeOffset(const int nInstance) const {
+	assert(nInstance >= 0 and nInstance < oaInstances.GetSize());
+	return (longint)nInstance * nNeighborNumber;
+}
+
+inline int KMSortedNeighbors::GetNearestAvailableCluster(const int nInstance, const IntVector* ivAvailableClusters, const int nExcludedCluster) const {
+	assert(ivAvailableClusters != NULL);
+
+	const int* nList = nNeighbors + ComputeOffset(nInstance);
+
+	for (int i = 0; i < nNeighborNumber; i++) {
+
+		const int nCluster = nList[i];
+
+		if (nCluster == -1)
+			break;
+
+		if (nCluster != nExcludedCluster and ivAvailableClusters->GetAt(nCluster) != 0)
+			return nCluster;
+	}
+	return -1;
+}
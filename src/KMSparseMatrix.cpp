@@ -0,0 +1,154 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMSparseMatrix.h"
+#include "TaskProgression.h"
+
+const double KMSparseMatrix::MAX_DENSITY = 0.1;
+
+KMSparseMatrix::KMSparseMatrix()
+{
+	lRowStarts = NULL;
+	nColumns = NULL;
+	cValues = NULL;
+	cRowSquaredNorms = NULL;
+	nRowNumber = 0;
+	nColumnNumber = 0;
+}
+
+KMSparseMatrix::~KMSparseMatrix()
+{
+	CleanValues();
+}
+
+void KMSparseMatrix::CleanValues()
+{
+	if (lRowStarts != NULL)
+		delete[] lRowStarts;
+	if (nColumns != NULL)
+		delete[] nColumns;
+	if (cValues != NULL)
+		delete[] cValues;
+	if (cRowSquaredNorms != NULL)
+		delete[] cRowSquaredNorms;
+
+	lRowStarts = NULL;
+	nColumns = NULL;
+	cValues = NULL;
+	cRowSquaredNorms = NULL;
+	nRowNumber = 0;
+	nColumnNumber = 0;
+}
+
+boolean KMSparseMatrix::InitializeFromInstances(const KMDenseMatrix* rowsMatrix, const KWLoadIndexVector& kmeanAttributesLoadIndexes)
+{
+	require(rowsMatrix != NULL);
+
+	longint lNonZeroNumber;
+	int nRow;
+	int nColumn;
+
+	CleanValues();
+
+	// premiere passe : denombrement des valeurs non nulles, pour allouer la memoire en une seule fois
+	lNonZeroNumber = ComputeNonZeroNumber(rowsMatrix, kmeanAttributesLoadIndexes);
+
+	if (lNonZeroNumber < 0 or ComputeRequiredMemory(rowsMatrix->GetRowNumber(), lNonZeroNumber) > RMResourceManager::GetRemainingAvailableMemory())
+		return false;
+
+	nRowNumber = rowsMatrix->GetRowNumber();
+	nColumnNumber = rowsMatrix->GetColumnNumber();
+
+	lRowStarts = new longint[nRowNumber + 1];
+	nColumns = new int[lNonZeroNumber];
+	cValues = new Continuous[lNonZeroNumber];
+	cRowSquaredNorms = new Continuous[nRowNumber];
+
+	// seconde passe : rangement des valeurs non nulles, ligne par ligne
+	longint lPosition = 0;
+
+	for (nRow = 0; nRow < nRowNumber; nRow++) {
+
+		const KWObject* instance = rowsMatrix->GetInstanceAt(nRow);
+		Continuous cSquaredNorm = 0;
+
+		lRowStarts[nRow] = lPosition;
+
+		for (nColumn = 0; nColumn < nColumnNumber; nColumn++) {
+
+			const Continuous c = instance->GetContinuousValueAt(kmeanAttributesLoadIndexes.GetAt(rowsMatrix->GetAttributeRankAt(nColumn)));
+
+			if (c != 0) {
+				nColumns[lPosition] = nColumn;
+				cValues[lPosition] = c;
+				lPosition++;
+				cSquaredNorm += c * c;
+			}
+		}
+		cRowSquaredNorms[nRow] = cSquaredNorm;
+	}
+	lRowStarts[nRowNumber] = lPosition;
+
+	ensure(lPosition == lNonZeroNumber);
+
+	return true;
+}
+
+double KMSparseMatrix::ComputeDensity(const KMDenseMatrix* rowsMatrix, const KWLoadIndexVector& kmeanAttributesLoadIndexes)
+{
+	require(rowsMatrix != NULL);
+
+	if (rowsMatrix->GetRowNumber() == 0 or rowsMatrix->GetColumnNumber() == 0)
+		return 0;
+
+	const longint lNonZeroNumber = ComputeNonZeroNumber(rowsMatrix, kmeanAttributesLoadIndexes);
+
+	// interruption demandee : densite maximale, la matrice creuse ne sera pas construite
+	if (lNonZeroNumber < 0)
+		return 1;
+
+	return (double)lNonZeroNumber / ((double)rowsMatrix->GetRowNumber() * rowsMatrix->GetColumnNumber());
+}
+
+longint KMSparseMatrix::ComputeNonZeroNumber(const KMDenseMatrix* rowsMatrix, const KWLoadIndexVector& kmeanAttributesLoadIndexes)
+{
+	require(rowsMatrix != NULL);
+
+	longint lNonZeroNumber = 0;
+
+	for (int nRow = 0; nRow < rowsMatrix->GetRowNumber(); nRow++) {
+
+		if (nRow % 100000 == 0 and TaskProgression::IsInterruptionRequested())
+			return -1;
+
+		const KWObject* instance = rowsMatrix->GetInstanceAt(nRow);
+
+		for (int nColumn = 0; nColumn < rowsMatrix->GetColumnNumber(); nColumn++) {
+			if (instance->GetContinuousValueAt(kmeanAttributesLoadIndexes.GetAt(rowsMatrix->GetAttributeRankAt(nColumn))) != 0)
+				lNonZeroNumber++;
+		}
+	}
+
+	return lNonZeroNumber;
+}
+
+longint KMSparseMatrix::ComputeRequiredMemory(const longint lRowNumber, const longint lNonZeroNumber)
+{
+	return (lRowNumber + 1) * sizeof(longint) + lRowNumber * sizeof(Continuous) + lNonZeroNumber * (sizeof(int) + sizeof(Continuous));
+}
+
+longint KMSparseMatrix::GetUsedMemory() const
+{
+	longint lUsedMemory = sizeof(KMSparseMatrix);
+
+	if (lRowStarts != NULL)
+		lUsedMemory += ComputeRequiredMemory(nRowNumber, GetNonZeroNumber());
+
+	return lUsedMemory;
+}
+
+const ALString KMSparseMatrix::GetClassLabel() const
+{
+	return "Sparse matrix";
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+#include "KMDenseMatrix.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Matrice creuse de valeurs Continuous, au format CSR (Compressed Sparse Row) : pour chaque ligne, seules les valeurs non nulles sont stockees,
+/// avec leurs numeros de colonnes, de facon contigue. Elle reprend les lignes et les colonnes d'une matrice dense des instances, et la remplace pour le stockage
+/// des valeurs lorsque celles-ci comportent une faible proportion de valeurs non nulles (attributs K-Means issus d'une binarisation des attributs categoriels,
+/// par exemple) : la matrice dense ne porte alors que la correspondance entre lignes et instances.
+/// Le carre de la norme de chaque ligne est precalcule, pour le calcul des distances L2 et cosinus a partir des seules valeurs non nulles.
+
+class KMSparseMatrix : public Object
+{
+public:
+
+	KMSparseMatrix();
+	~KMSparseMatrix();
+
+	/** remplissage a partir des valeurs K-Means des instances des lignes d'une matrice dense, selon les memes lignes et colonnes (les valeurs de la matrice dense
+	ne sont pas utilisees, et peuvent ne pas etre allouees). Retourne false si la memoire disponible est insuffisante, ou en cas d'interruption */
+	boolean InitializeFromInstances(const KMDenseMatrix* rowsMatrix, const KWLoadIndexVector& kmeanAttributesLoadIndexes);
+
+	/** nombre de lignes */
+	int GetRowNumber() const;
+
+	/** nombre de colonnes */
+	int GetColumnNumber() const;
+
+	/** nombre total de valeurs non nulles */
+	longint GetNonZeroNumber() const;
+
+	/** nombre de valeurs non nulles d'une ligne */
+	int GetRowNonZeroNumberAt(const int nRow) const;
+
+	/** numeros de colonnes des valeurs non nulles d'une ligne, par ordre croissant */
+	const int* GetRowColumnsAt(const int nRow) const;
+
+	/** valeurs non nulles d'une ligne, dans l'ordre de leurs numeros de colonnes */
+	const Continuous* GetRowValuesAt(const int nRow) const;
+
+	/** carre de la norme L2 d'une ligne */
+	Continuous GetRowSquaredNormAt(const int nRow) const;
+
+	/** proportion de valeurs K-Means non nulles des instances des lignes d'une matrice dense (1 en cas d'interruption) */
+	static double ComputeDensity(const KMDenseMatrix* rowsMatrix, const KWLoadIndexVector& kmeanAttributesLoadIndexes);
+
+	/** memoire necessaire au stockage d'une matrice creuse */
+	static longint ComputeRequiredMemory(const longint lRowNumber, const longint lNonZeroNumber);
+
+	/** proportion maximale de valeurs non nulles, au dela de laquelle les calculs de distances sur la matrice dense sont plus rapides */
+	static const double MAX_DENSITY;
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	/** liberation de la memoire allouee */
+	void CleanValues();
+
+	/** nombre de valeurs K-Means non nulles des instances des lignes d'une matrice dense (-1 en cas d'interruption) */
+	static longint ComputeNonZeroNumber(const KMDenseMatrix* rowsMatrix, const KWLoadIndexVector& kmeanAttributesLoadIndexes);
+
+	/** pour chaque ligne, debut de ses valeurs dans cValues et nColumns (nombre de lignes + 1 valeurs) */
+	longint* lRowStarts;
+
+	/** numeros de colonnes et valeurs non nulles, ligne par ligne */
+	int* nColumns;
+	Continuous* cValues;
+
+	/** pour chaque ligne, carre de sa norme L2 */
+	Continuous* cRowSquaredNorms;
+
+	int nRowNumber;
+	int nColumnNumber;
+};
+
+inline int KMSparseMatrix::GetRowNumber() const {
+	return nRowNumber;
+}
+
+inline int KMSparseMatrix::GetColumnNumber() const {
+	return nColumnNumber;
+}
+
+inline longint KMSparseMatrix::GetNonZeroNumber() const {
+	return (lRowStarts == NULL ? 0 : lRowStarts[nRowNumber]);
+}
+
+inline int KMSparseMatrix::GetRowNonZeroNumberAt(const int nRow) const {
+	assert(nRow >= 0 and nRow < nRowNumber);
+	return (int)(lRowStarts[nRow + 1] - lRowStarts[nRow]);
+}
+
+inline const int* KMSparseMatrix::GetRowColumnsAt(const int nRow) const {
+	assert(nRow >= 0 and nRow < nRowNumber);
+	return nColumns + lRowStarts[nRow];
+}
+
+inline const Continuous* KMSparseMatrix::GetRowValuesAt(const int nRow) const {
+	assert(nRow >= 0 and nRow < nRowNumber);
+	return cValues + lRowStarts[nRow];
+}
+
+inline Continuous KMSparseMatrix::GetRowSquaredNormAt(const int nRow) const {
+	assert(nRow >= 0 and nRow < nRowNumber);
+	return cRowSquaredNorms[nRow];
+}
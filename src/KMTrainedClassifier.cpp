@@ -22,7 +22,7 @@ KMTrainedClassifier::~KMTrainedClassifier() {
 		delete parameters;
 }
 
-KMClustering* KMTrainedClassifier::CreateModelingClustering()
+KMClustering* KMTrainedClassifier::CreateModelingClustering(const boolean bPrepareDeploymentClass)
 {
 	// reconstruire un resultat K-Means et les parametres correspondants,  partir du dictionnaire de modelisation.
 
@@ -48,8 +48,9 @@ KMClustering* KMTrainedClassifier::CreateModelingClustering()
 
 	parameters->SetVerboseMode(parameters->GetIdClusterAttribute()->GetConstMetaData()->IsKeyPresent(KMParametersView::VERBOSE_MODE_FIELD_NAME));
 	parameters->SetWriteDetailedStatistics(parameters->GetIdClusterAttribute()->GetConstMetaData()->IsKeyPresent(KMParametersView::DETAILED_STATISTICS_FIELD_NAME));
+	parameters->SetSinglePassEvaluation(parameters->GetIdClusterAttribute()->GetConstMetaData()->IsKeyPresent(KMParametersView::SINGLE_PASS_EVALUATION_FIELD_NAME));
 
-	if (parameters->GetWriteDetailedStatistics()) {
+	if (bPrepareDeploymentClass and parameters->GetWriteDetailedStatistics()) {
 		// creer les attributs CellIndex, servant a produire les rapports de frequences de modalits
 		if (parameters->GetContinuousPreprocessingType() == KMParameters::PreprocessingType::AutomaticallyComputed and
 			parameters->GetCategoricalPreprocessingType() == KMParameters::PreprocessingType::AutomaticallyComputed) {
@@ -61,7 +62,10 @@ KMClustering* KMTrainedClassifier::CreateModelingClustering()
 
 	// passer automatiquement en "used" et "loaded" les attributs supplementaires necessaires a l'evaluation, et memoriser
 	// les index de chargement des attributs utiliss
-	parameters->PrepareDeploymentClass(predictorClass);
+	if (bPrepareDeploymentClass)
+		parameters->PrepareDeploymentClass(predictorClass);
+	else
+		parameters->AddAttributes(predictorClass);
 
 	// creation du cluster "unique" des donnes, servant au calcul des stats globales
 	kmModelingClustering->CreateGlobalCluster();
@@ -77,6 +81,22 @@ KMClustering* KMTrainedClassifier::CreateModelingClustering()
 
 }
 
+KMClustering* KMTrainedClassifier::CreateEvaluationClustering(KWClass* kwcPreparedClass)
+{
+	require(kwcPreparedClass != NULL);
+	require(kwcPreparedClass->IsCompiled());
+
+	// le dico est deja prepare (par le maitre) : on ne fait que le relire
+	KWClass* kwcInitialClass = predictorClass;
+	predictorClass = kwcPreparedClass;
+
+	KMClustering* clustering = CreateModelingClustering(false);
+
+	predictorClass = kwcInitialClass;
+
+	return clustering;
+}
+
 bool KMTrainedClassifier::CreateTargetValues() {
 
 	assert(kmModelingClustering != NULL);
@@ -23,8 +23,13 @@ public:
 	KMTrainedClassifier();
 	~KMTrainedClassifier();
 
-	/** reconstituer un resultat K-Means a partir du dico de modelisation */
-	KMClustering* CreateModelingClustering();
+	/** reconstituer un resultat K-Means a partir du dico de modelisation. Si bPrepareDeploymentClass est faux, le dico est
+	suppose deja prepare pour le deploiement (attributs CellIndex crees, attributs necessaires charges et compiles), et n'est pas modifie */
+	KMClustering* CreateModelingClustering(const boolean bPrepareDeploymentClass = true);
+
+	/** reconstituer un resultat K-Means a partir d'un dico de modelisation deja prepare pour le deploiement, par exemple dans
+	un esclave de tache d'evaluation parallele. Le dico n'est pas memorise par le predicteur */
+	KMClustering* CreateEvaluationClustering(KWClass* kwcPreparedClass);
 
 	/** extraire les intervalles/modalites des attributs necessaires, a partir d'un dico */
 	void ExtractPartitions(KWClass* aClass);
@@ -4,6 +4,7 @@
 
 #include "KMTrainedPredictor.h"
 #include "KMParametersView.h"
+#include "KMDRNearestCentroid.h"
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -29,7 +30,7 @@ int KMTrainedPredictor::GetTargetType() const
 	return KWType::None;
 }
 
-KMClustering* KMTrainedPredictor::CreateModelingClustering()
+KMClustering* KMTrainedPredictor::CreateModelingClustering(const boolean bPrepareDeploymentClass)
 {
 	// reconstruire un resultat K-Means et les parametres correspondants,  partir du dictionnaire de modelisation.
 
@@ -59,8 +60,12 @@ KMClustering* KMTrainedPredictor::CreateModelingClustering()
 
 	parameters->SetVerboseMode(parameters->GetIdClusterAttribute()->GetConstMetaData()->IsKeyPresent(KMParametersView::VERBOSE_MODE_FIELD_NAME));
 	parameters->SetWriteDetailedStatistics(parameters->GetIdClusterAttribute()->GetConstMetaData()->IsKeyPresent(KMParametersView::DETAILED_STATISTICS_FIELD_NAME));
+	parameters->SetSinglePassEvaluation(parameters->GetIdClusterAttribute()->GetConstMetaData()->IsKeyPresent(KMParametersView::SINGLE_PASS_EVALUATION_FIELD_NAME));
 
-	if (parameters->GetWriteDetailedStatistics()) {
+	if (parameters->GetIdClusterAttribute()->GetConstMetaData()->IsKeyPresent(KMParametersView::MEDIAN_SKETCH_CAPACITY_FIELD_NAME))
+		parameters->SetMedianSketchCapacity((int)parameters->GetIdClusterAttribute()->GetConstMetaData()->GetDoubleValueAt(KMParametersView::MEDIAN_SKETCH_CAPACITY_FIELD_NAME));
+
+	if (bPrepareDeploymentClass and parameters->GetWriteDetailedStatistics()) {
 		// creer les attributs CellIndex, servant a produire les rapports de frequences de modalits
 		if (parameters->GetContinuousPreprocessingType() == KMParameters::PreprocessingType::AutomaticallyComputed and
 			parameters->GetCategoricalPreprocessingType() == KMParameters::PreprocessingType::AutomaticallyComputed) {
@@ -72,7 +77,10 @@ KMClustering* KMTrainedPredictor::CreateModelingClustering()
 
 	// passer automatiquement en "used" et "loaded" les attributs supplementaires necessaires a l'evaluation, et memoriser
 	// les index de chargement des attributs utiliss
-	parameters->PrepareDeploymentClass(predictorClass);
+	if (bPrepareDeploymentClass)
+		parameters->PrepareDeploymentClass(predictorClass);
+	else
+		parameters->AddAttributes(predictorClass);
 
 	// creation cluster "unique" des donnes, servant au calcul des stats globales
 	kmModelingClustering->CreateGlobalCluster();
@@ -89,6 +97,22 @@ KMClustering* KMTrainedPredictor::CreateModelingClustering()
 }
 
 
+KMClustering* KMTrainedPredictor::CreateEvaluationClustering(KWClass* kwcPreparedClass)
+{
+	require(kwcPreparedClass != NULL);
+	require(kwcPreparedClass->IsCompiled());
+
+	// le dico est deja prepare (par le maitre) : on ne fait que le relire
+	KWClass* kwcInitialClass = predictorClass;
+	predictorClass = kwcPreparedClass;
+
+	KMClustering* clustering = CreateModelingClustering(false);
+
+	predictorClass = kwcInitialClass;
+
+	return clustering;
+}
+
 bool KMTrainedPredictor::CreateClusters(KWClass* predictorClass, KMClustering* clustering) {
 
 	KMParameters* parameters = (KMParameters*)clustering->GetParameters();
@@ -98,10 +122,27 @@ bool KMTrainedPredictor::CreateClusters(KWClass* predictorClass, KMClustering* c
 	require(globalCentroid.GetSize() != 0);
 	globalCentroid.Initialize();
 
+	// les centroides sont relus dans les operandes de la regle NearestCentroid de l'attribut d'affectation. Les attributs "DistanceCluster"
+	// ne sont relus que pour les dictionnaires de modelisation anterieurs a cette regle
+	KWAttribute* idClusterAttribute = NULL;
 	KWAttribute* attribute = predictorClass->GetHeadAttribute();
 	while (attribute != NULL)
 	{
-		if (attribute->GetConstMetaData()->IsKeyPresent(KMPredictor::DISTANCE_CLUSTER_LABEL)) {
+		if (attribute->GetConstMetaData()->IsKeyPresent(KMPredictor::ID_CLUSTER_METADATA) and
+			attribute->GetDerivationRule() != NULL and
+			attribute->GetDerivationRule()->GetName() == KMDRNearestCentroid().GetName())
+			idClusterAttribute = attribute;
+
+		predictorClass->GetNextAttribute(attribute);
+	}
+
+	if (idClusterAttribute != NULL and not CreateClustersFromNearestCentroidRule(idClusterAttribute, clustering, predictorClass))
+		return false;
+
+	attribute = predictorClass->GetHeadAttribute();
+	while (attribute != NULL)
+	{
+		if (idClusterAttribute == NULL and attribute->GetConstMetaData()->IsKeyPresent(KMPredictor::DISTANCE_CLUSTER_LABEL)) {
 
 			KMCluster* cluster = KMTrainedPredictor::CreateCluster(attribute, parameters, predictorClass);
 
@@ -137,6 +178,67 @@ bool KMTrainedPredictor::CreateClusters(KWClass* predictorClass, KMClustering* c
 
 }
 
+bool KMTrainedPredictor::CreateClustersFromNearestCentroidRule(KWAttribute* idClusterAttribute, KMClustering* clustering, KWClass* predictorClass) {
+
+	assert(idClusterAttribute != NULL);
+	assert(clustering != NULL);
+
+	KMParameters* parameters = (KMParameters*)clustering->GetParameters();
+	const KMDRNearestCentroid* nearestCentroidRule = cast(KMDRNearestCentroid*, idClusterAttribute->GetDerivationRule());
+
+	const ALString distanceLabel = nearestCentroidRule->GetDistanceLabel();
+	assert(distanceLabel == "L1" or distanceLabel == "L2" or distanceLabel == "CO");
+
+	if (distanceLabel == "L1")
+		parameters->SetDistanceType(KMParameters::L1Norm);
+	else
+		if (distanceLabel == "L2")
+			parameters->SetDistanceType(KMParameters::L2Norm);
+		else
+			if (distanceLabel == "CO")
+				parameters->SetDistanceType(KMParameters::CosineNorm);
+
+	// rang de chaque operande attribut dans les centroides des clusters
+	IntVector ivAttributeRanks;
+
+	for (int i = 0; i < nearestCentroidRule->GetAttributeNumber(); i++) {
+
+		KWAttribute* centroidAttribute = predictorClass->LookupAttribute(nearestCentroidRule->GetAttributeNameAt(i));
+		if (centroidAttribute == NULL or not centroidAttribute->GetLoaded() or not centroidAttribute->GetUsed())
+			return false;
+
+		assert(parameters->IsKMeanAttributeLoadIndex(centroidAttribute->GetLoadIndex()));
+
+		ivAttributeRanks.Add(parameters->GetAttributeRankFromLoadIndex(centroidAttribute->GetLoadIndex()));
+	}
+
+	for (int k = 0; k < nearestCentroidRule->GetCentroidNumber(); k++) {
+
+		ContinuousVector clusterCentroids;
+		clusterCentroids.SetSize(predictorClass->GetLoadedAttributeNumber());
+		require(clusterCentroids.GetSize() != 0);
+		clusterCentroids.Initialize();
+
+		for (int i = 0; i < ivAttributeRanks.GetSize(); i++)
+			clusterCentroids.SetAt(ivAttributeRanks.GetAt(i), nearestCentroidRule->GetCentroidValueAt(k, i));
+
+		KMCluster* cluster = new KMCluster(parameters);
+		cluster->SetModelingCentroidValues(clusterCentroids);
+
+		// libelle memorise dans les meta-donnees si different du libelle par defaut (cf. KMPredictor::AddClusterLabelsMetaData)
+		const ALString sLabelKey = ALString(KMPredictor::CLUSTER_LABEL) + "_" + IntToString(k + 1);
+
+		if (idClusterAttribute->GetConstMetaData()->IsKeyPresent(sLabelKey))
+			cluster->SetLabel(idClusterAttribute->GetConstMetaData()->GetStringValueAt(sLabelKey));
+		else
+			cluster->SetLabel(IntToString(k + 1));
+
+		clustering->GetClusters()->Add(cluster);
+	}
+
+	return true;
+}
+
 KMCluster* KMTrainedPredictor::CreateCluster(KWAttribute* distanceClusterAttribute, KMParameters* parameters,
 	KWClass* predictorClass) {
 
@@ -24,8 +24,13 @@ public:
 
 	int GetTargetType() const;
 
-	/** reconstituer un resultat K-Means a partir du dico de modelisation */
-	KMClustering* CreateModelingClustering();
+	/** reconstituer un resultat K-Means a partir du dico de modelisation. Si bPrepareDeploymentClass est faux, le dico est
+	suppose deja prepare pour le deploiement (attributs CellIndex crees, attributs necessaires charges et compiles), et n'est pas modifie */
+	KMClustering* CreateModelingClustering(const boolean bPrepareDeploymentClass = true);
+
+	/** reconstituer un resultat K-Means a partir d'un dico de modelisation deja prepare pour le deploiement, par exemple dans
+	un esclave de tache d'evaluation parallele. Le dico n'est pas memorise par le predicteur */
+	KMClustering* CreateEvaluationClustering(KWClass* kwcPreparedClass);
 
 	/** extraire les intervalles/modalites des attributs necessaires, a partir d'un dico */
 	void ExtractPartitions(KWClass* aClass);
@@ -43,7 +48,10 @@ public:
 	///// Implementation
 protected:
 
-	/** creer les clusters dans un resultat kmean, a partir d'un attribut "DistanceCluster" */
+	/** creer les clusters dans un resultat kmean, a partir des operandes de la regle NearestCentroid de l'attribut d'affectation au cluster */
+	static bool CreateClustersFromNearestCentroidRule(KWAttribute* idClusterAttribute, KMClustering*, KWClass* predictorClass);
+
+	/** creer les clusters dans un resultat kmean, a partir d'un attribut "DistanceCluster" (dictionnaires sans regle NearestCentroid) */
 	static KMCluster* CreateCluster(KWAttribute* distanceClusterAttribute, KMParameters*, KWClass* predictorClass);
 
 	/** creer des clusters a partir d'un modele, crees selon la norme L1 ou L2 */
@@ -0,0 +1,74 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#include "KMTriangularMatrix.h"
+
+KMTriangularMatrix::KMTriangularMatrix()
+{
+	cValues = NULL;
+	nSize = 0;
+	nCapacity = 0;
+}
+
+KMTriangularMatrix::~KMTriangularMatrix()
+{
+	RemoveAll();
+}
+
+void KMTriangularMatrix::Reserve(const int nNewCapacity)
+{
+	require(nNewCapacity >= 0);
+
+	Continuous* cNewValues;
+
+	if (nNewCapacity <= nCapacity)
+		return;
+
+	const longint lValueNumber = ComputeValueNumber(nNewCapacity);
+	cNewValues = new Continuous[lValueNumber > 0 ? lValueNumber : 1];
+
+	// les lignes etant stockees bout a bout, les valeurs existantes conservent leur position
+	for (longint i = 0; i < ComputeValueNumber(nSize); i++)
+		cNewValues[i] = cValues[i];
+
+	if (cValues != NULL)
+		delete[] cValues;
+
+	cValues = cNewValues;
+	nCapacity = nNewCapacity;
+}
+
+void KMTriangularMatrix::SetSize(const int nNewSize)
+{
+	require(nNewSize >= 0);
+
+	// croissance geometrique de la capacite, pour amortir les ajouts successifs de lignes
+	if (nNewSize > nCapacity)
+		Reserve(nNewSize > 2 * nCapacity ? nNewSize : 2 * nCapacity);
+
+	for (longint i = ComputeValueNumber(nSize); i < ComputeValueNumber(nNewSize); i++)
+		cValues[i] = 0;
+
+	nSize = nNewSize;
+}
+
+void KMTriangularMatrix::RemoveAll()
+{
+	if (cValues != NULL)
+		delete[] cValues;
+
+	cValues = NULL;
+	nSize = 0;
+	nCapacity = 0;
+}
+
+longint KMTriangularMatrix::GetUsedMemory() const
+{
+	return sizeof(KMTriangularMatrix) + (cValues == NULL ? 0 : ComputeValueNumber(nCapacity) * sizeof(Continuous));
+}
+
+const ALString KMTriangularMatrix::GetClassLabel() const
+{
+	return "Triangular matrix";
+}
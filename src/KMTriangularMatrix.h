@@ -0,0 +1,92 @@
+// Copyright (c) 2023-2025 Orange. All rights reserved.
+// This software is distributed under the BSD 3-Clause-clear License, the text of which is available
+// at https://spdx.org/licenses/BSD-3-Clause-Clear.html or see the "LICENSE" file for more details.
+
+#pragma once
+
+#include "Object.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// Matrice carree symetrique de valeurs Continuous, a diagonale nulle (typiquement, les distances entre centres de clusters).
+/// Seul le triangle inferieur strict est stocke, ligne par ligne, dans un unique bloc memoire contigu : la ligne i contient les i valeurs (i, 0) .. (i, i-1).
+/// Ajouter une ligne revient donc a ajouter ses valeurs en fin de bloc, et la capacite reservee n'est reallouee que si elle devient insuffisante.
+
+class KMTriangularMatrix : public Object
+{
+public:
+
+	KMTriangularMatrix();
+	~KMTriangularMatrix();
+
+	/** reservation de la memoire necessaire a une matrice de taille donnee, en conservant les valeurs existantes */
+	void Reserve(const int nCapacity);
+
+	/** capacite reservee (nombre de lignes) */
+	int GetCapacity() const;
+
+	/** (re)dimensionnement de la matrice : les valeurs des lignes conservees sont inchangees, celles des nouvelles lignes sont a 0 */
+	void SetSize(const int nNewSize);
+
+	/** taille de la matrice (nombre de lignes, egal au nombre de colonnes) */
+	int GetSize() const;
+
+	/** acces aux valeurs (la matrice etant symetrique, l'ordre des indices est indifferent) */
+	Continuous GetAt(const int i, const int j) const;
+	void SetAt(const int i, const int j, const Continuous cValue);
+
+	/** suppression de toutes les valeurs et liberation de la memoire */
+	void RemoveAll();
+
+	longint GetUsedMemory() const override;
+
+	const ALString GetClassLabel() const override;
+
+protected:
+
+	/** nombre de valeurs stockees pour une matrice de taille donnee */
+	static longint ComputeValueNumber(const int nSize);
+
+	/** position d'une valeur dans le bloc memoire, pour i > j */
+	static longint ComputeOffset(const int i, const int j);
+
+	Continuous* cValues;
+	int nSize;
+	int nCapacity;
+};
+
+inline int KMTriangularMatrix::GetCapacity() const {
+	return nCapacity;
+}
+
+inline int KMTriangularMatrix::GetSize() const {
+	return nSize;
+}
+
+inline longint KMTriangularMatrix::ComputeValueNumber(const int nSize) {
+	return (longint)nSize * (nSize - 1) / 2;
+}
+
+inline longint KMTriangularMatrix::ComputeOffset(const int i, const int j) {
+	return (longint)i * (i - 1) / 2 + j;
+}
+
+inline Continuous KMTriangularMatrix::GetAt(const int i, const int j) const {
+	assert(i >= 0 and i < nSize);
+	assert(j >= 0 and j < nSize);
+
+	if (i == j)
+		return 0;
+	else
+		return (i > j ? cValues[ComputeOffset(i, j)] : cValues[ComputeOffset(j, i)]);
+}
+
+inline void KMTriangularMatrix::SetAt(const int i, const int j, const Continuous cValue) {
+	assert(i >= 0 and i < nSize);
+	assert(j >= 0 and j < nSize);
+	assert(i != j);
+
+	if (i > j)
+		cValues[ComputeOffset(i, j)] = cValue;
+	else
+		cValues[ComputeOffset(j, i)] = cValue;
+}